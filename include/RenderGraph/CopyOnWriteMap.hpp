@@ -0,0 +1,133 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <map>
+#include <memory>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	A map from resource ids to states, which copies share their content.
+	*\remarks
+	*	Copying the map is O(1).
+	*	A write to a shared map first duplicates the entries list (not the states), then the written state only.
+	*	The map is not thread safe, but two copies can be used from different threads.
+	*/
+	template< typename ValueT >
+	class CopyOnWriteMapT
+	{
+	public:
+		using ValuePtr = std::shared_ptr< ValueT >;
+		using Map = std::map< uint32_t, ValuePtr >;
+		/**
+		*\return
+		*	The state for the given id, \p nullptr if there is none.
+		*/
+		ValueT const * find( uint32_t key )const noexcept
+		{
+			if ( !m_map )
+				return nullptr;
+
+			auto it = m_map->find( key );
+			return it == m_map->end()
+				? nullptr
+				: it->second.get();
+		}
+		/**
+		*\return
+		*	The state for the given id, created if needed, which this map owns alone.
+		*/
+		ValueT & edit( uint32_t key )
+		{
+			auto & value = doEditMap()[key];
+
+			if ( !value )
+				value = std::make_shared< ValueT >();
+			else if ( value.use_count() > 1 )
+				value = std::make_shared< ValueT >( *value );
+
+			return *value;
+		}
+		/**
+		*\brief
+		*	Adds the states of \p rhs which ids are not in this map, sharing them.
+		*/
+		void addMissing( CopyOnWriteMapT const & rhs )
+		{
+			if ( !rhs.m_map || rhs.m_map == m_map )
+				return;
+
+			if ( empty() )
+			{
+				m_map = rhs.m_map;
+				return;
+			}
+
+			auto & map = doEditMap();
+
+			for ( auto & [key, value] : *rhs.m_map )
+				map.try_emplace( key, value );
+		}
+
+		template< typename FuncT >
+		void forEach( FuncT && func )const
+		{
+			if ( !m_map )
+				return;
+
+			for ( auto & [key, value] : *m_map )
+				func( key, *value );
+		}
+
+		bool empty()const noexcept
+		{
+			return !m_map || m_map->empty();
+		}
+
+		size_t size()const noexcept
+		{
+			return m_map ? m_map->size() : 0u;
+		}
+
+	private:
+		Map & doEditMap()
+		{
+			if ( !m_map )
+				m_map = std::make_shared< Map >();
+			else if ( m_map.use_count() > 1 )
+				m_map = std::make_shared< Map >( *m_map );
+
+			return *m_map;
+		}
+
+		friend bool operator==( CopyOnWriteMapT const & lhs, CopyOnWriteMapT const & rhs )
+		{
+			if ( lhs.m_map == rhs.m_map )
+				return true;
+
+			if ( lhs.size() != rhs.size() )
+				return false;
+
+			if ( lhs.empty() )
+				return true;
+
+			// Shared states are equal without being compared.
+			return std::equal( lhs.m_map->begin(), lhs.m_map->end(), rhs.m_map->begin()
+				, []( typename Map::value_type const & lhsValue, typename Map::value_type const & rhsValue )
+				{
+					return lhsValue.first == rhsValue.first
+						&& ( lhsValue.second == rhsValue.second
+							|| *lhsValue.second == *rhsValue.second );
+				} );
+		}
+
+	private:
+		std::shared_ptr< Map > m_map;
+	};
+}
@@ -13,11 +13,42 @@ See LICENSE file in root folder.
 #include "ImageViewData.hpp"
 #include "RecordContext.hpp"
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
 namespace crg
 {
+	/**
+	*\brief
+	*	What was left out during the last compilation of a FrameGraph.
+	*/
+	struct CompileReport
+	{
+		/**
+		*\brief
+		*	The passes which are not part of the compiled graph, because nothing uses their outputs.
+		*/
+		FramePassArray culledPasses;
+		/**
+		*\brief
+		*	The number of image layout and buffer access transitions in the compiled graph.
+		*/
+		size_t transitionCount{};
+		/**
+		*\brief
+		*	The number of transitions the depth first order of the passes needs.
+		*\remarks
+		*	When the graph is loaded from a cache file, it is the one stored with the graph.
+		*/
+		size_t depthFirstTransitionCount{};
+		/**
+		*\brief
+		*	Tells if the nodes and transitions were loaded from a cache file, instead of being built.
+		*/
+		bool loadedFromCache{};
+	};
+
 	class FrameGraph
 	{
 		friend class RunnableGraph;
@@ -45,6 +76,15 @@ namespace crg
 		CRG_API BufferViewId createView( BufferViewData const & view );
 		CRG_API ImageId createImage( ImageData const & img );
 		CRG_API ImageViewId createView( ImageViewData const & view );
+		/**
+		*\brief
+		*	Creates an image which content doesn't need to be kept between its first and last use in the graph.
+		*\remarks
+		*	When compiled, transient images with non overlapping lifetimes share the same memory.
+		*	Their content is therefore undefined outside of the passes using them,
+		*	so they must not be registered as graph inputs or outputs, or be read by another graph.
+		*/
+		CRG_API ImageId createTransientImage( ImageData const & img );
 		/**@}*/
 		/**
 		*\name
@@ -92,6 +132,110 @@ namespace crg
 		*/
 		/**@{*/
 		CRG_API RunnableGraphPtr compile( GraphContext & context );
+		/**
+		*\brief
+		*	Compiles the graph, loading the nodes and their transitions from the given cache file.
+		*\remarks
+		*	If the file doesn't exist, or was written for a graph with another structural hash,
+		*	the graph is built as usual, and the cache file is (re)written.
+		*/
+		CRG_API RunnableGraphPtr compile( GraphContext & context
+			, std::string const & cacheFilePath );
+		/**
+		*\brief
+		*	Updates a RunnableGraph previously compiled from this graph, after passes were added or removed.
+		*\remarks
+		*	The runnable passes whose FramePass and attachments did not change are kept as is,
+		*	the other ones are created again.
+		*/
+		CRG_API void recompile( RunnableGraph & runnable );
+		/**
+		*\brief
+		*	Enables or disables the culling of the passes which outputs are not used.
+		*\remarks
+		*	When enabled, only the passes contributing to a graph output (see addOutput),
+		*	or to a kept alive pass (see FramePass::setKeptAlive), are compiled.
+		*	The images read by dependent graphs must therefore be registered as outputs.
+		*/
+		void setPassCulling( bool enable )noexcept
+		{
+			m_passCulling = enable;
+		}
+
+		bool hasPassCulling()const noexcept
+		{
+			return m_passCulling;
+		}
+		/**
+		*\brief
+		*	Sets the way the passes are ordered, when their dependencies allow several orders.
+		*/
+		void setPassScheduling( PassScheduling value )noexcept
+		{
+			m_passScheduling = value;
+		}
+
+		PassScheduling getPassScheduling()const noexcept
+		{
+			return m_passScheduling;
+		}
+
+		/**
+		*\brief
+		*	Enables or disables the split barriers.
+		*\remarks
+		*	When enabled, a resource written by a pass and read by a later pass, with unrelated passes in between,
+		*	is released with an event after the writer and acquired before the reader,
+		*	so that the passes in between are not serialised with them.
+		*	Taken into account when the graph is compiled.
+		*/
+		void setSplitBarriers( bool enable )noexcept
+		{
+			m_splitBarriers = enable;
+		}
+
+		bool hasSplitBarriers()const noexcept
+		{
+			return m_splitBarriers;
+		}
+		/**
+		*\brief
+		*	Sets the number of threads recording the passes, 0 or 1 to record them on the calling thread only.
+		*\remarks
+		*	The passes are then split in chunks, each one recorded into its own secondary command buffer.
+		*	A chunk starts from the states the last serial recording had before its first pass.
+		*	If the previous chunk doesn't end with these states, the graph is recorded serially again.
+		*/
+		void setRecordThreadCount( uint32_t value )noexcept
+		{
+			m_recordThreadCount = value;
+		}
+
+		uint32_t getRecordThreadCount()const noexcept
+		{
+			return m_recordThreadCount;
+		}
+		/**
+		*\brief
+		*	Sets the number of frames the runnable graph can record while the previous ones are still executed.
+		*\remarks
+		*	Each frame has its own command buffers, fence, semaphores, and timers queries.
+		*	Taken into account when the graph is (re)compiled.
+		*/
+		void setFramesInFlight( uint32_t value )noexcept
+		{
+			m_framesInFlight = std::max( 1u, value );
+		}
+
+		uint32_t getFramesInFlight()const noexcept
+		{
+			return m_framesInFlight;
+		}
+
+		CompileReport const & getCompileReport()const noexcept
+		{
+			return m_compileReport;
+		}
 		/**@}*/
 		/**
 		*\name
@@ -138,6 +282,11 @@ namespace crg
 			, ImageSubresourceRange const & range )const;
 		CRG_API LayoutState getOutputLayoutState( ImageViewId view )const;
 		CRG_API LayerLayoutStatesMap const & getOutputLayoutStates()const;
+		/**
+		*\brief
+		*	Computes a hash of the passes, their groups and attachments, which is stable between launches.
+		*/
+		CRG_API uint64_t getStructuralHash()const;
 
 		ResourceHandler & getHandler()noexcept
 		{
@@ -166,6 +315,19 @@ namespace crg
 		/**@}*/
 
 	private:
+		FramePassArray doListPasses()const;
+		/**
+		*\return
+		*	The number of transitions the depth first order of the passes needs.
+		*/
+		size_t doBuildGraph( GraphContext const & context
+			, FramePassArray const & passes
+			, RootNode & root
+			, GraphNodePtrArray & nodes )const;
+		void doReport( FramePassArray const & passes
+			, GraphNodePtrArray const & nodes
+			, size_t depthFirstTransitionCount
+			, bool loadedFromCache );
 		void registerFinalState( RecordContext const & context );
 
 	private:
@@ -175,6 +337,7 @@ namespace crg
 		std::set< BufferId > m_buffers;
 		std::set< BufferViewId > m_bufferViews;
 		std::set< ImageId > m_images;
+		std::set< ImageId > m_transientImages;
 		std::set< ImageViewId > m_imageViews;
 		std::map< std::string, ImageViewId, std::less<> > m_attachViews;
 		RecordContext m_finalState;
@@ -182,5 +345,11 @@ namespace crg
 		LayerLayoutStatesHandler m_inputs;
 		LayerLayoutStatesHandler m_outputs;
 		std::unordered_map< size_t, AttachmentPtr > m_mergedAttachments;
+		bool m_passCulling{};
+		PassScheduling m_passScheduling{ PassScheduling::eDepthFirst };
+		bool m_splitBarriers{};
+		uint32_t m_recordThreadCount{};
+		uint32_t m_framesInFlight{ 1u };
+		CompileReport m_compileReport;
 	};
 }
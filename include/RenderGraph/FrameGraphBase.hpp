@@ -45,7 +45,10 @@ namespace crg
 	struct ImageViewData;
 	struct IndexBuffer;
 	struct IndirectBuffer;
+	class LayerLayoutStates;
+	struct LayerLayoutStatesHandler;
 	struct LayoutState;
+	struct MemoryAllocation;
 	struct PipelineState;
 	struct RootNode;
 	struct SamplerDesc;
@@ -61,6 +64,8 @@ namespace crg
 	class FramePassTimer;
 	class GraphVisitor;
 	class ImageCopy;
+	class MemoryAllocator;
+	class MemoryTracker;
 	class PipelinePass;
 	class RecordContext;
 	class RenderPass;
@@ -69,9 +74,13 @@ namespace crg
 	class ResourcesCache;
 	class RunnableGraph;
 	class RunnablePass;
+	class TimerHistory;
+	class TraceRecorder;
 
 	template< typename DataT >
 	struct Id;
+	template< typename DataT, typename ValueT >
+	class IdSlotMapT;
 	template< typename DataT >
 	struct DataTransitionT;
 	template< typename DataT >
@@ -96,6 +105,7 @@ namespace crg
 	using FramePassPtr = std::unique_ptr< FramePass >;
 	using FramePassGroupPtr = std::unique_ptr< FramePassGroup >;
 	using GraphNodePtr = std::unique_ptr< GraphNode >;
+	using MemoryAllocatorPtr = std::unique_ptr< MemoryAllocator >;
 	using RunnableGraphPtr = std::unique_ptr< RunnableGraph >;
 	using RunnablePassPtr = std::unique_ptr< RunnablePass >;
 	using VertexBufferPtr = std::unique_ptr< VertexBuffer >;
@@ -127,10 +137,10 @@ namespace crg
 	using GraphNodePtrArray = std::vector< GraphNodePtr >;
 	using WriteDescriptorSetArray = std::vector< WriteDescriptorSet >;
 	using AttachmentsNodeMap = std::map< ConstGraphAdjacentNode, AttachmentTransitions >;
-	using BufferMemoryMap = std::map< BufferId, std::pair< VkBuffer, VkDeviceMemory > >;
-	using BufferViewMap = std::map< BufferViewId, VkBufferView >;
-	using ImageMemoryMap = std::map< ImageId, std::pair< VkImage, VkDeviceMemory > >;
-	using ImageViewMap = std::map< ImageViewId, VkImageView >;
+	using BufferMemoryMap = IdSlotMapT< BufferData, std::pair< VkBuffer, MemoryAllocation > >;
+	using BufferViewMap = IdSlotMapT< BufferViewData, VkBufferView >;
+	using ImageMemoryMap = IdSlotMapT< ImageData, std::pair< VkImage, MemoryAllocation > >;
+	using ImageViewMap = IdSlotMapT< ImageViewData, VkImageView >;
 	using ImageViewIdArray = std::vector< ImageViewId >;
 	using SemaphoreWaitArray = std::vector< SemaphoreWait >;
 
@@ -161,7 +171,7 @@ namespace crg
 	using VkWriteDescriptorSetArray = std::vector< VkWriteDescriptorSet >;
 
 	using MipLayoutStates = std::map< uint32_t, LayoutState >;
-	using LayerLayoutStates = std::map< uint32_t, MipLayoutStates >;
+	using LayerMipLayoutStates = std::map< uint32_t, MipLayoutStates >;
 	using LayoutStateMap = std::unordered_map< uint32_t, LayerLayoutStates >;
 	using LayerLayoutStatesMap = std::map< uint32_t, LayerLayoutStates >;
 	using AccessStateMap = std::unordered_map< uint32_t, AccessState >;
@@ -426,4 +426,39 @@ namespace crg
 		eA = 0x00000008,
 	};
 	CRG_MakeFlags( ColorComponentFlags )
+	/**
+	*\brief
+	*	The way the compiled passes are ordered, when several orders are valid.
+	*/
+	enum class PassScheduling : int32_t
+	{
+		/**
+		*\brief
+		*	Depth first order over the passes dependencies.
+		*/
+		eDepthFirst,
+		/**
+		*\brief
+		*	Orders the independent passes so that fewer image layout and buffer access transitions are needed.
+		*/
+		eMinimiseTransitions,
+	};
+	/**
+	*\brief
+	*	The kind of queue a pass is submitted to.
+	*/
+	enum class QueueClass : int32_t
+	{
+		eGraphics,
+		/**
+		*\brief
+		*	Asynchronous compute queue, only for compute passes.
+		*/
+		eCompute,
+		/**
+		*\brief
+		*	Transfer queue, only for passes recording copy commands.
+		*/
+		eTransfer,
+	};
  }
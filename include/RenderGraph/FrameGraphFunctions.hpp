@@ -57,6 +57,17 @@ namespace crg
 	CRG_API void convert( SemaphoreWaitArray const & toWait
 		, std::vector< VkSemaphore > & semaphores
 		, std::vector< VkPipelineStageFlags > & dstStageMasks );
+	/**
+	*\brief
+	*	Fills the semaphores to wait for, with the values to wait for.
+	*\remarks
+	*	The values are ignored by the binary semaphores.
+	*	When a timeline semaphore is waited several times, the highest value is kept.
+	*/
+	CRG_API void convert( SemaphoreWaitArray const & toWait
+		, std::vector< VkSemaphore > & semaphores
+		, std::vector< VkPipelineStageFlags > & dstStageMasks
+		, std::vector< uint64_t > & values );
 	CRG_API std::vector< VkClearValue > convert( std::vector< ClearValue > const & v );
 	CRG_API VkQueryPool createQueryPool( GraphContext & context
 		, std::string const & name
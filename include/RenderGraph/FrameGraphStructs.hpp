@@ -305,6 +305,9 @@ namespace crg
 	{
 		ImageLayout layout{};
 		PipelineState state{};
+
+	private:
+		friend bool operator==( LayoutState const & lhs, LayoutState const & rhs )noexcept = default;
 	};
 
 	template< typename VkTypeT >
@@ -341,6 +344,11 @@ namespace crg
 	{
 		VkSemaphore semaphore{};
 		PipelineStageFlags dstStageMask{};
+		/**
+		*\brief
+		*	The value to wait for, when \p semaphore is a timeline semaphore.
+		*/
+		uint64_t value{};
 	};
 
 	template< typename TypeT >
@@ -702,6 +702,36 @@ namespace crg
 
 		CRG_API std::string getFullName()const;
 		CRG_API std::string getGroupName()const;
+		/**
+		*\brief
+		*	Keeps the pass in the compiled graph, even if its outputs are not used.
+		*\remarks
+		*	Meant for passes with side effects, when the graph culls its unused passes.
+		*/
+		void setKeptAlive( bool value = true )noexcept
+		{
+			m_keptAlive = value;
+		}
+
+		bool isKeptAlive()const noexcept
+		{
+			return m_keptAlive;
+		}
+		/**
+		*\brief
+		*	Selects the queue the pass would rather run on, when the graph is run with several queues.
+		*\remarks
+		*	The pass falls back to the graphics queue when it can't run on the wanted one.
+		*/
+		void setQueueClass( QueueClass value )noexcept
+		{
+			m_queueClass = value;
+		}
+
+		QueueClass getQueueClass()const noexcept
+		{
+			return m_queueClass;
+		}
 
 		std::string const & getName()const
 		{
@@ -851,5 +881,7 @@ namespace crg
 			Attachment const * parent{};
 		};
 		std::unordered_map< Attachment const *, OwnAttachment > m_ownAttaches;
+		bool m_keptAlive{};
+		QueueClass m_queueClass{ QueueClass::eGraphics };
 	};
 }
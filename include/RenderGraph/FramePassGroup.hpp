@@ -45,6 +45,16 @@ namespace crg
 		CRG_API FramePass & createPass( std::string const & name
 			, RunnablePassCreator runnableCreator );
 		CRG_API FramePassGroup & createPassGroup( std::string const & name );
+		/**
+		*\brief
+		*	Removes the pass with given name from this group.
+		*\remarks
+		*	The RunnableGraph compiled from the FrameGraph must be updated,
+		*	through FrameGraph::recompile, before being recorded again.
+		*	The pass must not be consumed by other passes (through addInputSampled, addInOutColourTarget, ...),
+		*	they must be removed first.
+		*/
+		CRG_API void removePass( std::string const & name );
 		CRG_API bool hasPass( std::string const & name )const;
 		CRG_API void listPasses( FramePassArray & result )const;
 		/**@}*/
@@ -79,6 +89,10 @@ namespace crg
 		*/
 		CRG_API ImageId createImage( ImageData const & img )const;
 		/**
+		*\copydoc crg::FrameGraph::createTransientImage
+		*/
+		CRG_API ImageId createTransientImage( ImageData const & img )const;
+		/**
 		*\copydoc crg::FrameGraph::createView
 		*/
 		CRG_API ImageViewId createView( ImageViewData const & view )const;
@@ -156,6 +170,7 @@ namespace crg
 		FramePassPtrArray m_passes;
 		FramePassGroupPtrArray m_groups;
 		FramePassGroup * m_parent{};
+		uint32_t m_lastPassId{};
 		std::string m_name;
 		FrameGraph & m_graph;
 		std::unordered_set< uint32_t > m_inputs;
@@ -6,14 +6,14 @@ See LICENSE file in root folder
 
 #include "FrameGraphPrerequisites.hpp"
 #include "Signal.hpp"
+#include "TimerHistory.hpp"
 
 #include <array>
 #include <chrono>
+#include <vector>
 
 namespace crg
 {
-	using Clock = std::chrono::high_resolution_clock;
-	using Nanoseconds = std::chrono::nanoseconds;
 	using FramePassDestroyFunc = std::function< void( FramePassTimer & ) >;
 	using OnFramePassDestroy = Signal< FramePassDestroyFunc >;
 	using OnFramePassDestroyConnection = SignalConnection< OnFramePassDestroy >;
@@ -25,6 +25,7 @@ namespace crg
 		ePass,
 		eUpdate,
 	};
+	static constexpr size_t TimerScopeCount = size_t( TimerScope::eUpdate ) + 1u;
 
 	class FramePassTimerBlock
 	{
@@ -63,12 +64,15 @@ namespace crg
 		*	The render pass category.
 		*\param[in] name
 		*	The timer name.
+		*\param[in] frameCount
+		*	The number of frames in flight, each one having its own queries.
 		*/
 		CRG_API FramePassTimer( GraphContext & context
 			, std::string const & name
 			, TimerScope scope
 			, VkQueryPool timerQueries
-			, uint32_t & baseQueryOffset );
+			, uint32_t & baseQueryOffset
+			, uint32_t frameCount = 1u );
 		/**
 		*\brief
 		*	Owns its query pool.
@@ -97,6 +101,11 @@ namespace crg
 		CRG_API void notifyPassRender( uint32_t passIndex = 0u )noexcept;
 		/**
 		*\brief
+		*	Notifies that the commands recorded with the last beginPass/endPass are submitted again.
+		*/
+		CRG_API void notifyPassReplay()noexcept;
+		/**
+		*\brief
 		*	Reset the timer's times.
 		*/
 		CRG_API void reset()noexcept;
@@ -123,9 +132,49 @@ namespace crg
 		/**
 		*\brief
 		*	Retrieves GPU time from the query.
+		*\remarks
+		*	When GraphContext::nonBlockingTimers is set, the queries of all the frames in flight are read without waiting,
+		*	and the GPU time is the one of the most recent available frame, given by getGpuTimeFrameId.
+		*	Without GraphContext::hostQueryReset, the results of a frame are only read once its queries are reused,
+		*	the submission using them being then complete.
+		*	Otherwise, waits for the queries of the current frame.
 		*/
 		CRG_API void retrieveGpuTime()noexcept;
 		/**
+		*\brief
+		*	Reserves queries from another pool, dropping pending results.
+		*\param[in] timerQueries
+		*	The new query pool.
+		*\param[in,out] baseQueryOffset
+		*	The first query index, incremented by the number of reserved queries.
+		*\param[in] frameCount
+		*	The number of frames in flight, each one having its own queries.
+		*/
+		CRG_API void setQueryPool( VkQueryPool timerQueries
+			, uint32_t & baseQueryOffset
+			, uint32_t frameCount = 1u )noexcept;
+		/**
+		*\brief
+		*	Selects the queries used by beginPass, endPass and retrieveGpuTime.
+		*\param[in] frameIndex
+		*	The index of the frame in flight.
+		*\param[in] frameId
+		*	The tag given to the timings of the next notified render.
+		*/
+		CRG_API void setFrameIndex( uint32_t frameIndex
+			, uint64_t frameId = 0u )noexcept;
+		/**
+		*\brief
+		*	Sets the histories which also receive this timer samples, as a breakdown of its scope.
+		*/
+		CRG_API void setScopeHistories( TimerHistory * cpuHistory
+			, TimerHistory * gpuHistory )noexcept;
+		/**
+		*\brief
+		*	Sets the full name of the group enclosing this timer spans, in GraphContext::traceRecorder.
+		*/
+		CRG_API void setTracePath( std::string path );
+		/**
 		*\name
 		*	Getters.
 		*/
@@ -139,6 +188,14 @@ namespace crg
 		{
 			return m_gpuTime;
 		}
+		/**
+		*\return
+		*	The tag of the frame which GPU time is given by getGpuTime.
+		*/
+		uint64_t getGpuTimeFrameId()const noexcept
+		{
+			return m_gpuTimeFrameId;
+		}
 
 		std::string const & getName()const noexcept
 		{
@@ -154,12 +211,33 @@ namespace crg
 		{
 			return m_scope;
 		}
+		/**
+		*\return
+		*	The CPU time spent between two calls to retrieveGpuTime, for the last frames.
+		*/
+		TimerHistory const & getCpuHistory()const noexcept
+		{
+			return m_cpuHistory;
+		}
+		/**
+		*\return
+		*	The GPU time of the last frames which results were retrieved.
+		*/
+		TimerHistory const & getGpuHistory()const noexcept
+		{
+			return m_gpuHistory;
+		}
 		/**@}*/
 
 		OnFramePassDestroy onDestroy;
 
 	private:
 		void stop()noexcept;
+		bool doRetrieveGpuTime()noexcept;
+		bool doRetrieveAvailableGpuTime()noexcept;
+		void doTraceGpuTime( uint64_t begin
+			, uint64_t end
+			, uint64_t frameId )noexcept;
 
 	private:
 		GraphContext & m_context;
@@ -169,6 +247,13 @@ namespace crg
 		Clock::time_point m_cpuSaveTime{};
 		Nanoseconds m_cpuTime{};
 		Nanoseconds m_gpuTime{};
+		uint64_t m_gpuTimeFrameId{};
+		Nanoseconds m_sampledCpuTime{};
+		TimerHistory m_cpuHistory;
+		TimerHistory m_gpuHistory;
+		TimerHistory * m_cpuScopeHistory{};
+		TimerHistory * m_gpuScopeHistory{};
+		std::string m_tracePath;
 		VkQueryPool m_timerQueries{};
 		bool m_ownPool{};
 		struct Query
@@ -176,8 +261,23 @@ namespace crg
 			uint32_t offset{};
 			bool written{};
 			bool started{};
+			uint64_t frameId{};
+			// The serial of the last submission resetting and writing the queries, 0 if they were never submitted.
+			uint64_t submitted{};
+			// Reset from the host before the submission, the available results are then the submission's ones.
+			bool hostReset{};
+			// The results of the previous submission, read when the queries are reused.
+			bool retired{};
+			std::array< uint64_t, 2u > retiredValues{};
+			uint64_t retiredFrameId{};
 		};
-		std::array< Query, 2u > m_queries;
+		void doRetireQuery( Query & query )noexcept;
+
+	private:
+		std::vector< Query > m_queries;
+		uint32_t m_frameIndex{};
+		uint64_t m_frameId{};
+		uint64_t m_submission{};
 	};
 }
 
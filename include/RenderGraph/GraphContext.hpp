@@ -7,7 +7,9 @@ See LICENSE file in root folder.
 #include "FrameGraphPrerequisites.hpp"
 
 #include <array>
+#include <chrono>
 #include <functional>
+#include <span>
 #include <string>
 #include <unordered_map>
 #pragma warning( push )
@@ -342,6 +344,22 @@ namespace crg
 		std::array< float, 4 > colour;
 	};
 
+	/**
+	*\brief
+	*	A memory barrier, with its own source and destination stages.
+	*/
+	template< typename BarrierT >
+	struct StagedBarrier
+	{
+		VkPipelineStageFlags srcStageMask;
+		VkPipelineStageFlags dstStageMask;
+		BarrierT barrier;
+	};
+
+	using StagedMemoryBarrier = StagedBarrier< VkMemoryBarrier >;
+	using StagedBufferBarrier = StagedBarrier< VkBufferMemoryBarrier >;
+	using StagedImageBarrier = StagedBarrier< VkImageMemoryBarrier >;
+
 	struct DeletionQueue
 	{
 		using CDtorFunc = void( GraphContext & );
@@ -354,6 +372,11 @@ namespace crg
 			m_toDelete.push_back( std::move( func ) );
 		}
 
+		bool empty()const noexcept
+		{
+			return m_toDelete.empty();
+		}
+
 		void clear( GraphContext & context )
 		{
 			DtorFuncArray tmp{ std::move( m_toDelete ) };
@@ -390,7 +413,59 @@ namespace crg
 		VkPhysicalDeviceMemoryProperties memoryProperties{};
 		VkPhysicalDeviceProperties properties{};
 		VkPhysicalDeviceFeatures features{};
+		/**
+		*\brief
+		*	The physical device of \p device, only needed to query the memory budget.
+		*/
+		VkPhysicalDevice physicalDevice{};
 		bool separateDepthStencilLayouts;
+		/**
+		*\brief
+		*	The number of nanoseconds per timestamp tick, taken from the device properties.
+		*/
+		float timestampPeriod;
+		/**
+		*\brief
+		*	Tells if the barriers are recorded through vkCmdPipelineBarrier2, when available.
+		*/
+		bool synchronization2{};
+		/**
+		*\brief
+		*	Tells if the runnable graphs synchronise their submissions through a timeline semaphore, when available.
+		*\remarks
+		*	It is read when the runnable graph creates its frames.
+		*/
+		bool timelineSemaphores{};
+		/**
+		*\brief
+		*	Tells if the timers read their GPU results without waiting, reporting them once available.
+		*/
+		bool nonBlockingTimers{};
+		/**
+		*\brief
+		*	Tells if the device has the hostQueryReset feature enabled.
+		*\remarks
+		*	The timers then reset their queries from the host when they are reused,
+		*	so that the results of the previous submission aren't read for the new one.
+		*/
+		bool hostQueryReset{};
+		/**
+		*\brief
+		*	The number of samples kept by each timer history, 0 to disable the histories.
+		*\remarks
+		*	It is read when the timers are created, their histories don't allocate afterwards.
+		*/
+		uint32_t timerHistorySize{};
+		/**
+		*\brief
+		*	The duration above which a timer sample is counted as a hitch, 0 to disable the detection.
+		*/
+		std::chrono::nanoseconds timerHitchThreshold{};
+		/**
+		*\brief
+		*	Receives the compile phases, and the CPU and GPU spans of the timers, when set.
+		*/
+		TraceRecorder * traceRecorder{};
 		DeletionQueue delQueue;
 
 #define DECL_vkFunction( name )\
@@ -445,6 +520,7 @@ namespace crg
 		DECL_vkFunction( DestroyQueryPool );
 		DECL_vkFunction( GetQueryPoolResults );
 		DECL_vkFunction( ResetCommandBuffer );
+		DECL_vkFunction( ResetCommandPool );
 		DECL_vkFunction( CreateEvent );
 		DECL_vkFunction( DestroyEvent );
 		DECL_vkFunction( ResetEvent );
@@ -455,6 +531,11 @@ namespace crg
 		DECL_vkFunction( GetFenceStatus );
 		DECL_vkFunction( WaitForFences );
 		DECL_vkFunction( ResetFences );
+#if VK_VERSION_1_2
+		DECL_vkFunction( WaitSemaphores );
+		DECL_vkFunction( GetSemaphoreCounterValue );
+		DECL_vkFunction( ResetQueryPool );
+#endif
 
 		DECL_vkFunction( CmdBindPipeline );
 		DECL_vkFunction( CmdBindDescriptorSets );
@@ -484,6 +565,19 @@ namespace crg
 		DECL_vkFunction( CmdSetEvent );
 		DECL_vkFunction( CmdWaitEvents );
 		DECL_vkFunction( CmdFillBuffer );
+#if VK_VERSION_1_3
+		DECL_vkFunction( CmdPipelineBarrier2 );
+#endif
+#if VK_EXT_calibrated_timestamps
+		DECL_vkFunction( GetCalibratedTimestampsEXT );
+#endif
+#if VK_EXT_memory_budget
+		/**
+		*\brief
+		*	An instance function, it is not loaded from the device: set it, with physicalDevice, to query the heaps budget.
+		*/
+		DECL_vkFunction( GetPhysicalDeviceMemoryProperties2 );
+#endif
 
 #if VK_EXT_debug_utils || VK_EXT_debug_marker
 #	if VK_EXT_debug_utils
@@ -513,6 +607,33 @@ namespace crg
 		*/
 		CRG_API void vkCmdEndDebugBlock( VkCommandBuffer commandBuffer )const;
 #endif
+		/**
+		*\return
+		*	\p true if the barriers are recorded through vkCmdPipelineBarrier2.
+		*/
+		CRG_API bool hasSynchronization2()const noexcept;
+		/**
+		*\return
+		*	\p true if the runnable graphs signal and wait on timeline semaphores.
+		*/
+		CRG_API bool hasTimelineSemaphores()const noexcept;
+		/**
+		*\return
+		*	\p true if the queries can be reset from the host.
+		*/
+		CRG_API bool hasHostQueryReset()const noexcept;
+		/**
+		*\brief
+		*	Records the given barriers in a single command.
+		*\remarks
+		*	With Synchronization2, each barrier keeps its own stages.
+		*	Otherwise, vkCmdPipelineBarrier is used with the union of the barriers stages.
+		*/
+		CRG_API void vkCmdPipelineBarriers( VkCommandBuffer commandBuffer
+			, VkDependencyFlags dependencyFlags
+			, std::span< StagedMemoryBarrier const > memoryBarriers
+			, std::span< StagedBufferBarrier const > bufferBarriers
+			, std::span< StagedImageBarrier const > imageBarriers )const;
 		CRG_API std::array< float, 4u > getNextRainbowColour()const;
 		CRG_API uint32_t deduceMemoryType( uint32_t typeBits
 			, VkMemoryPropertyFlags requirements )const;
@@ -0,0 +1,156 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "Exception.hpp"
+#include "Id.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	A map from resource ids to values, stored in a dense array indexed by Id::id.
+	*\remarks
+	*	The lookups are O(1), the iteration follows the ids order, like std::map.
+	*	Each slot keeps the Id it was filled for, a lookup only succeeds when the Id data matches it.
+	*	This catches an Id from another handler that would share the same index.
+	*/
+	template< typename DataT, typename ValueT >
+	class IdSlotMapT
+	{
+	public:
+		using KeyT = Id< DataT >;
+
+		struct Slot
+		{
+			KeyT key{};
+			ValueT value{};
+		};
+		/**
+		*\return
+		*	The value for the given id, \p nullptr if there is none.
+		*/
+		ValueT * find( KeyT const & key )noexcept
+		{
+			auto slot = doFindSlot( key );
+			return slot ? &slot->value : nullptr;
+		}
+		/**
+		*\return
+		*	The value for the given id, \p nullptr if there is none.
+		*/
+		ValueT const * find( KeyT const & key )const noexcept
+		{
+			auto slot = doFindSlot( key );
+			return slot ? &slot->value : nullptr;
+		}
+		/**
+		*\brief
+		*	Adds the value for the given id, if there is none yet.
+		*\remarks
+		*	Throws if the slot is filled for another Id with the same index.
+		*\return
+		*	The value for the id, and \p true if it was added.
+		*/
+		std::pair< ValueT *, bool > tryEmplace( KeyT const & key
+			, ValueT value = {} )
+		{
+			if ( auto slot = doFindSlot( key ) )
+				return { &slot->value, false };
+
+			if ( key.id == 0u )
+				CRG_Exception( "Can't add a value for an invalid Id" );
+
+			if ( key.id > m_slots.size() )
+				m_slots.resize( key.id );
+
+			auto & slot = m_slots[key.id - 1u];
+
+			if ( slot.key.id != 0u )
+				CRG_Exception( "The slot is already filled for another Id with the same index" );
+
+			slot.key = key;
+			slot.value = std::move( value );
+			++m_size;
+			return { &slot.value, true };
+		}
+		/**
+		*\return
+		*	The value for the given id, created if needed.
+		*/
+		ValueT & operator[]( KeyT const & key )
+		{
+			return *tryEmplace( key ).first;
+		}
+		/**
+		*\brief
+		*	Removes the value for the given id.
+		*\return
+		*	\p true if there was one.
+		*/
+		bool erase( KeyT const & key )
+		{
+			auto slot = doFindSlot( key );
+
+			if ( !slot )
+				return false;
+
+			*slot = Slot{};
+			--m_size;
+
+			while ( !m_slots.empty() && m_slots.back().key.id == 0u )
+				m_slots.pop_back();
+
+			return true;
+		}
+		/**
+		*\brief
+		*	Calls \p func( key, value ) for each filled slot, by increasing id.
+		*/
+		template< typename FuncT >
+		void forEach( FuncT && func )const
+		{
+			for ( auto & slot : m_slots )
+			{
+				if ( slot.key.id != 0u )
+					func( slot.key, slot.value );
+			}
+		}
+
+		bool empty()const noexcept
+		{
+			return m_size == 0u;
+		}
+
+		size_t size()const noexcept
+		{
+			return m_size;
+		}
+
+	private:
+		Slot * doFindSlot( KeyT const & key )noexcept
+		{
+			return const_cast< Slot * >( std::as_const( *this ).doFindSlot( key ) );
+		}
+
+		Slot const * doFindSlot( KeyT const & key )const noexcept
+		{
+			if ( key.id == 0u || key.id > m_slots.size() )
+				return nullptr;
+
+			auto & slot = m_slots[key.id - 1u];
+			return ( slot.key.id == key.id && slot.key.data == key.data )
+				? &slot
+				: nullptr;
+		}
+
+	private:
+		std::vector< Slot > m_slots;
+		size_t m_size{};
+	};
+}
@@ -0,0 +1,231 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphStructs.hpp"
+
+#include <iterator>
+#include <vector>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	The layout states of the subresources of an image, indexed by array layer and mip level.
+	*\remarks
+	*	The subresources reference the distinct states in a palette, from a dense array.
+	*	When all the subresources share the same state, the array is released and the queries are O(1).
+	*	The extent grows with the ranges set, the subresources never set have no state.
+	*	It can still be used as the map of layers to MipLayoutStates it replaces, through begin, end, find and emplace.
+	*	The layers are then given by value, they can't be edited in place.
+	*/
+	class LayerLayoutStates
+	{
+	public:
+		/**
+		*\brief
+		*	Iterates over the layers having at least one state, by increasing layer.
+		*/
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair< uint32_t, MipLayoutStates >;
+			using difference_type = std::ptrdiff_t;
+			using pointer = value_type const *;
+			using reference = value_type const &;
+
+			const_iterator() = default;
+
+			const_iterator( LayerLayoutStates const & states
+				, uint32_t layer )
+				: m_states{ &states }
+			{
+				doMoveTo( layer );
+			}
+
+			reference operator*()const noexcept
+			{
+				return m_value;
+			}
+
+			pointer operator->()const noexcept
+			{
+				return &m_value;
+			}
+
+			const_iterator & operator++()
+			{
+				doMoveTo( m_value.first + 1u );
+				return *this;
+			}
+
+			const_iterator operator++( int )
+			{
+				auto result = *this;
+				++( *this );
+				return result;
+			}
+
+		private:
+			void doMoveTo( uint32_t layer )
+			{
+				m_value.first = m_states->doFindLayer( layer );
+				m_value.second = m_value.first < m_states->m_layerCount
+					? m_states->getMipLayoutStates( m_value.first )
+					: MipLayoutStates{};
+			}
+
+			friend bool operator==( const_iterator const & lhs, const_iterator const & rhs )noexcept
+			{
+				return lhs.m_states == rhs.m_states
+					&& lhs.m_value.first == rhs.m_value.first;
+			}
+
+		private:
+			LayerLayoutStates const * m_states{};
+			value_type m_value{};
+		};
+		using iterator = const_iterator;
+		using key_type = uint32_t;
+		using mapped_type = MipLayoutStates;
+		using value_type = const_iterator::value_type;
+
+		/**
+		*\brief
+		*	Sets the state of the subresources of the given range.
+		*/
+		CRG_API void setLayoutState( ImageSubresourceRange const & range
+			, LayoutState const & state );
+		/**
+		*\return
+		*	The state of the subresources of the given range, the ones with the lowest layout if they differ.
+		*	The accesses of the subresources with that layout are combined.
+		*	An undefined state if none of the subresources was set.
+		*/
+		CRG_API LayoutState getLayoutState( ImageSubresourceRange const & range )const;
+		/**
+		*\return
+		*	The state of the given subresource, \p nullptr if it was never set.
+		*/
+		CRG_API LayoutState const * find( uint32_t layer
+			, uint32_t level )const noexcept;
+		/**
+		*\return
+		*	The states of the mip levels of the given layer, by level.
+		*/
+		CRG_API MipLayoutStates getMipLayoutStates( uint32_t layer )const;
+		/**
+		*\return
+		*	The states by layer then mip level, the representation used before the dense storage.
+		*/
+		CRG_API LayerMipLayoutStates getLayerMipLayoutStates()const;
+		/**
+		*\brief
+		*	Tells if both hold the same states for the same subresources, whatever their storage.
+		*/
+		CRG_API bool isSame( LayerLayoutStates const & rhs )const noexcept;
+		/**
+		*\return
+		*	The iterator to the given layer, end() if none of its subresources has a state.
+		*/
+		CRG_API const_iterator find( uint32_t layer )const;
+		/**
+		*\brief
+		*	Sets the states of the given layer mip levels, if none of its subresources has a state yet.
+		*\return
+		*	The iterator to the layer, and \p true if the states were set.
+		*	When \p levels is empty, nothing is set and end() is returned.
+		*/
+		CRG_API std::pair< const_iterator, bool > emplace( uint32_t layer
+			, MipLayoutStates const & levels );
+		/**
+		*\return
+		*	The number of layers having at least one state.
+		*/
+		CRG_API size_t size()const noexcept;
+
+		const_iterator begin()const
+		{
+			return const_iterator{ *this, 0u };
+		}
+
+		const_iterator end()const
+		{
+			return const_iterator{ *this, m_layerCount };
+		}
+		/**
+		*\brief
+		*	Calls \p func( layer, level, state ) for each subresource with a state, layer by layer.
+		*/
+		template< typename FuncT >
+		void forEach( FuncT && func )const
+		{
+			for ( uint32_t layer = 0u; layer < m_layerCount; ++layer )
+			{
+				for ( uint32_t level = 0u; level < m_levelCount; ++level )
+				{
+					if ( auto state = find( layer, level ) )
+						func( layer, level, *state );
+				}
+			}
+		}
+
+		bool empty()const noexcept
+		{
+			return m_layerCount == 0u;
+		}
+
+		bool isUniform()const noexcept
+		{
+			return m_indices.empty() && !m_states.empty();
+		}
+
+		uint32_t getLayerCount()const noexcept
+		{
+			return m_layerCount;
+		}
+
+		uint32_t getLevelCount()const noexcept
+		{
+			return m_levelCount;
+		}
+
+	private:
+		/**
+		*\return
+		*	The first layer from \p layer having at least one state, m_layerCount if there is none.
+		*/
+		CRG_API uint32_t doFindLayer( uint32_t layer )const noexcept;
+		uint16_t doGetPaletteIndex( LayoutState const & state );
+		/**
+		*\brief
+		*	Grows the extent, switching to the dense storage.
+		*/
+		void doResize( uint32_t layerCount
+			, uint32_t levelCount );
+
+		friend bool operator==( LayerLayoutStates const & lhs, LayerLayoutStates const & rhs )noexcept
+		{
+			return lhs.isSame( rhs );
+		}
+
+	private:
+		uint32_t m_layerCount{};
+		uint32_t m_levelCount{};
+		/**
+		*\brief
+		*	The distinct states, and the number of subresources using each one.
+		*/
+		std::vector< LayoutState > m_states;
+		std::vector< uint32_t > m_counts;
+		/**
+		*\brief
+		*	One palette index + 1 per subresource, 0 for no state, layer major.
+		*	Empty when the storage is uniform.
+		*/
+		std::vector< uint16_t > m_indices;
+	};
+}
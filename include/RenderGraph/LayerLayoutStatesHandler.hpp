@@ -5,6 +5,7 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "FrameGraphPrerequisites.hpp"
+#include "LayerLayoutStates.hpp"
 
 namespace crg
 {
@@ -0,0 +1,195 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#pragma warning( push )
+#pragma warning( disable: 4365 )
+#pragma warning( disable: 5262 )
+#include <mutex>
+#pragma warning( pop )
+
+namespace crg
+{
+	/**
+	*\brief
+	*	The layout of the resource bound to an allocation.
+	*\remarks
+	*	Linear and optimal resources must be bufferImageGranularity apart when they share a memory.
+	*/
+	enum class MemoryResourceKind : uint8_t
+	{
+		// Buffers, and images with a linear tiling.
+		eLinear,
+		// Images with an optimal tiling.
+		eOptimal,
+	};
+
+	struct MemoryAllocation
+	{
+		VkDeviceMemory memory{};
+		DeviceSize offset{};
+		DeviceSize size{};
+		uint32_t memoryType{};
+		/**
+		*\brief
+		*	Tells if the allocation owns the whole device memory.
+		*/
+		bool dedicated{};
+	};
+
+	struct MemoryAllocatorStats
+	{
+		/**
+		*\brief
+		*	The live vkAllocateMemory allocations, blocks and dedicated ones.
+		*/
+		uint32_t deviceAllocations{};
+		uint32_t blocks{};
+		uint32_t dedicatedAllocations{};
+		uint32_t subAllocations{};
+		/**
+		*\brief
+		*	The total size of the blocks.
+		*/
+		DeviceSize blocksSize{};
+		/**
+		*\brief
+		*	The part of the blocks used by the sub-allocations, alignment padding included.
+		*/
+		DeviceSize subAllocatedSize{};
+		DeviceSize dedicatedSize{};
+	};
+	/**
+	*\brief
+	*	Allocates the device memory of the images and buffers created by ResourceHandler.
+	*\remarks
+	*	It can be called from several threads at once.
+	*/
+	class MemoryAllocator
+	{
+	public:
+		CRG_API virtual ~MemoryAllocator()noexcept = default;
+		/**
+		*\brief
+		*	Allocates memory fulfilling the given requirements, from the given memory type.
+		*\param[in] name
+		*	The name of the resource, for the debug names.
+		*/
+		CRG_API virtual MemoryAllocation allocate( GraphContext & context
+			, VkMemoryRequirements const & requirements
+			, uint32_t memoryType
+			, MemoryResourceKind kind
+			, std::string const & name ) = 0;
+		CRG_API virtual void free( GraphContext & context
+			, MemoryAllocation const & allocation ) = 0;
+		CRG_API virtual MemoryAllocatorStats getStats()const = 0;
+		/**
+		*\brief
+		*	Maps an allocation from a host visible memory type.
+		*\remarks
+		*	The device memory may be shared by several allocations, it must only be mapped through its allocator.
+		*	The default implementation maps the allocation range of the device memory.
+		*\return
+		*	The address of the allocation first byte.
+		*/
+		CRG_API virtual void * map( GraphContext & context
+			, MemoryAllocation const & allocation );
+		/**
+		*\brief
+		*	Unmaps an allocation mapped through map.
+		*/
+		CRG_API virtual void unmap( GraphContext & context
+			, MemoryAllocation const & allocation );
+		/**
+		*\brief
+		*	Sets the tracker which checks the heaps budget, and accounts the device memory, at each vkAllocateMemory.
+		*/
+		void setMemoryTracker( MemoryTracker * tracker )noexcept
+		{
+			m_tracker = tracker;
+		}
+
+	protected:
+		MemoryTracker * m_tracker{};
+	};
+	/**
+	*\brief
+	*	The default allocator, which sub-allocates from large blocks per memory type.
+	*\remarks
+	*	The blocks are split following a buddy scheme, so the offsets are aligned on the allocated sizes.
+	*	Linear and optimal resources use distinct blocks, they never share a bufferImageGranularity page.
+	*	The allocations above half a block get a dedicated memory.
+	*	A block is mapped once, as long as one of its allocations is mapped.
+	*	An empty block is freed at once.
+	*/
+	class BlockMemoryAllocator
+		: public MemoryAllocator
+	{
+	public:
+		static DeviceSize constexpr DefaultBlockSize = 64u * 1024u * 1024u;
+		static DeviceSize constexpr DefaultMinAllocationSize = 256u;
+		/**
+		*\param[in] blockSize, minAllocationSize
+		*	Rounded up to powers of two.
+		*/
+		CRG_API explicit BlockMemoryAllocator( DeviceSize blockSize = DefaultBlockSize
+			, DeviceSize minAllocationSize = DefaultMinAllocationSize );
+		CRG_API ~BlockMemoryAllocator()noexcept override;
+
+		CRG_API MemoryAllocation allocate( GraphContext & context
+			, VkMemoryRequirements const & requirements
+			, uint32_t memoryType
+			, MemoryResourceKind kind
+			, std::string const & name )override;
+		CRG_API void free( GraphContext & context
+			, MemoryAllocation const & allocation )override;
+		CRG_API MemoryAllocatorStats getStats()const override;
+		CRG_API void * map( GraphContext & context
+			, MemoryAllocation const & allocation )override;
+		CRG_API void unmap( GraphContext & context
+			, MemoryAllocation const & allocation )override;
+
+		DeviceSize getBlockSize()const noexcept
+		{
+			return m_blockSize;
+		}
+
+	private:
+		class Block;
+		using BlockPtr = std::unique_ptr< Block >;
+
+		struct PoolKey
+		{
+			VkDevice device;
+			uint32_t memoryType;
+			MemoryResourceKind kind;
+
+		private:
+			friend auto operator<=>( PoolKey const & lhs, PoolKey const & rhs ) = default;
+		};
+
+		Block & doFindBlock( MemoryAllocation const & allocation );
+		MemoryAllocation doAllocateDedicated( GraphContext & context
+			, VkMemoryRequirements const & requirements
+			, uint32_t memoryType
+			, std::string const & name );
+
+	private:
+		DeviceSize m_blockSize;
+		DeviceSize m_minAllocationSize;
+		mutable std::mutex m_mutex;
+		std::map< PoolKey, std::vector< BlockPtr > > m_pools;
+		std::unordered_map< VkDeviceMemory, PoolKey > m_blockPools;
+		MemoryAllocatorStats m_stats;
+	};
+}
@@ -0,0 +1,182 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#pragma warning( push )
+#pragma warning( disable: 4365 )
+#pragma warning( disable: 5262 )
+#include <mutex>
+#include <ostream>
+#pragma warning( pop )
+
+namespace crg
+{
+	struct MemoryUsage
+	{
+		DeviceSize live{};
+		DeviceSize peak{};
+		uint32_t allocations{};
+
+	private:
+		friend bool operator==( MemoryUsage const & lhs, MemoryUsage const & rhs ) = default;
+	};
+
+	struct MemoryResourceUsage
+	{
+		std::string name;
+		/**
+		*\brief
+		*	The name of the runnable graph which created the resource, empty if none did.
+		*/
+		std::string graph;
+		uint32_t heap{};
+		uint32_t memoryType{};
+		DeviceSize size{};
+	};
+
+	struct MemoryReport
+	{
+		MemoryUsage total;
+		/**
+		*\brief
+		*	The usages per memory heap and per memory type, indexed as in VkPhysicalDeviceMemoryProperties.
+		*/
+		std::vector< MemoryUsage > heaps;
+		std::vector< MemoryUsage > types;
+		/**
+		*\brief
+		*	The usages per runnable graph, the resources created outside of one are under an empty name.
+		*/
+		std::map< std::string, MemoryUsage, std::less<> > graphs;
+		/**
+		*\brief
+		*	The live allocations, by decreasing size.
+		*/
+		std::vector< MemoryResourceUsage > resources;
+
+		CRG_API void writeJson( std::ostream & stream )const;
+	};
+
+	struct MemoryBudgetEvent
+	{
+		std::string name;
+		uint32_t heap{};
+		uint32_t memoryType{};
+		/**
+		*\brief
+		*	The size about to be allocated.
+		*/
+		DeviceSize size{};
+		/**
+		*\brief
+		*	The heap usage and budget before the allocation.
+		*/
+		DeviceSize usage{};
+		DeviceSize budget{};
+	};
+	/**
+	*\brief
+	*	Accounts the device memory allocated for the resources, and checks it against the heaps budget.
+	*\remarks
+	*	The sizes are the ones given to the resources, the blocks they are sub-allocated from are in MemoryAllocatorStats.
+	*	The budget is checked by the MemoryAllocator, against the device memory it allocates.
+	*/
+	class MemoryTracker
+	{
+	public:
+		/**
+		*\brief
+		*	Identifies an allocation: the resource data, or the owner of the memory and an index.
+		*/
+		using Key = std::pair< void const *, uint32_t >;
+		/**
+		*\brief
+		*	Called before an allocation which would exceed its heap budget.
+		*\remarks
+		*	It is called from the allocation, with the resource handler locked.
+		*	It must not create nor destroy resources, it is meant to flag optional targets to shrink at the next rebuild.
+		*/
+		using BudgetCallback = std::function< void( MemoryBudgetEvent const & ) >;
+
+		void setBudgetCallback( BudgetCallback callback )
+		{
+			std::lock_guard lock{ m_mutex };
+			m_budgetCallback = std::move( callback );
+		}
+		/**
+		*\brief
+		*	Calls the budget callback if allocating \p size bytes of device memory from \p memoryType would exceed its heap budget.
+		*\remarks
+		*	The budget comes from VK_EXT_memory_budget when GraphContext::vkGetPhysicalDeviceMemoryProperties2 is set.
+		*	Otherwise, the device memory accounted through addDeviceMemory is checked against the heap size.
+		*\param[in] name
+		*	The name of the resource which needs the allocation.
+		*/
+		CRG_API void checkBudget( GraphContext & context
+			, uint32_t memoryType
+			, DeviceSize size
+			, std::string const & name );
+		/**
+		*\brief
+		*	Accounts a device memory allocation, a block shared by several resources or a dedicated one.
+		*/
+		CRG_API void addDeviceMemory( GraphContext const & context
+			, uint32_t memoryType
+			, DeviceSize size );
+		CRG_API void removeDeviceMemory( GraphContext const & context
+			, uint32_t memoryType
+			, DeviceSize size );
+		CRG_API void addAllocation( Key key
+			, std::string name
+			, std::string graph
+			, GraphContext const & context
+			, uint32_t memoryType
+			, DeviceSize size );
+		CRG_API void removeAllocation( Key key );
+		/**
+		*\return
+		*	The usages of all the tracked allocations.
+		*/
+		CRG_API MemoryReport getReport()const;
+		/**
+		*\return
+		*	The usages of the allocations made for the given runnable graph.
+		*/
+		CRG_API MemoryReport getReport( std::string const & graph )const;
+
+	private:
+		struct Allocation
+		{
+			std::string name;
+			std::string graph;
+			uint32_t heap{};
+			uint32_t memoryType{};
+			DeviceSize size{};
+		};
+
+		struct Usages
+		{
+			MemoryUsage total;
+			std::vector< MemoryUsage > heaps;
+			std::vector< MemoryUsage > types;
+		};
+
+	private:
+		mutable std::mutex m_mutex;
+		std::map< Key, Allocation > m_allocations;
+		Usages m_usages;
+		std::map< std::string, Usages, std::less<> > m_graphs;
+		// The device memory allocated per heap.
+		std::vector< DeviceSize > m_deviceMemory;
+		BudgetCallback m_budgetCallback;
+	};
+}
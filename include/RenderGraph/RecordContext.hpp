@@ -5,14 +5,24 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "Attachment.hpp"
+#include "CopyOnWriteMap.hpp"
+#include "GraphContext.hpp"
 #include "LayerLayoutStatesHandler.hpp"
+#include "RecordCounters.hpp"
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace crg
 {
+	/**
+	*\brief
+	*	The states of the resources, while recording a graph.
+	*\remarks
+	*	The copies share the states until they modify them, copying a context is O(1).
+	*/
 	class RecordContext
 	{
 	public:
@@ -43,11 +53,22 @@ namespace crg
 		//@{
 		CRG_API void addStates( RecordContext const & data );
 		/**
+		*\brief
+		*	Tells if both contexts hold the same resources and pipeline states, and the same implicit transitions.
+		*/
+		CRG_API bool hasSameStates( RecordContext const & rhs )const;
+		/**
 		*\name	Pipeline
 		*/
 		//@{
 		CRG_API void setNextPipelineState( PipelineState const & state
 			, LayerLayoutStatesMap const & imageLayouts );
+		/**
+		*\brief
+		*	Sets the next pipeline state, sharing the next image layouts instead of copying them.
+		*/
+		CRG_API void setNextPipelineState( PipelineState const & state
+			, std::shared_ptr< LayerLayoutStatesHandler const > imageLayouts );
 		//@}
 		/**
 		*\name	Images
@@ -167,6 +188,97 @@ namespace crg
 			, AccessState const & wantedState
 			, bool force = false );
 		//@}
+		/**
+		*\name	Batching
+		*/
+		//@{
+		/**
+		*\brief
+		*	From now on, the memory barriers are not recorded immediately, but gathered until the next flush.
+		*\remarks
+		*	The tracked states are still updated immediately.
+		*/
+		CRG_API void beginBarrierBatch();
+		/**
+		*\brief
+		*	Records the gathered memory barriers, in a single command.
+		*\remarks
+		*	With Synchronization2, each barrier keeps its own stages, otherwise their stages are merged.
+		*\remarks
+		*	Must be called before recording a command using a resource which barrier is pending.
+		*/
+		CRG_API void flushBarriers( VkCommandBuffer commandBuffer );
+		/**
+		*\brief
+		*	Flushes the gathered memory barriers, and goes back to recording them immediately.
+		*/
+		CRG_API void endBarrierBatch( VkCommandBuffer commandBuffer );
+		/**
+		*\brief
+		*	Records the gathered memory barriers in a vkCmdWaitEvents, waiting for the given events.
+		*\param[in] srcStages
+		*	The union of the stages given when the events were set.
+		*\param[in] dstStages
+		*	The stages waiting for the events, in addition to the barriers ones.
+		*/
+		CRG_API void waitEvents( VkCommandBuffer commandBuffer
+			, std::span< VkEvent const > events
+			, VkPipelineStageFlags srcStages
+			, VkPipelineStageFlags dstStages );
+
+		bool isBatchingBarriers()const noexcept
+		{
+			return m_batchBarriers;
+		}
+		//@}
+		/**
+		*\brief
+		*	Sets the counters increased by the recorded barriers, null to count nothing.
+		*\remarks
+		*	The counters are kept by the copies of this context.
+		*/
+		void setCounters( RecordCountersHandler * counters )noexcept
+		{
+			m_counters = counters;
+		}
+
+		RecordCountersHandler * getCounters()const noexcept
+		{
+			return m_counters;
+		}
+		/**
+		*\name	Queue family ownership
+		*/
+		//@{
+		/**
+		*\brief
+		*	Records the release half of a queue family ownership transfer, the layout is kept.
+		*\remarks
+		*	Nothing is recorded if both families are the same, or if the image content is undefined.
+		*/
+		CRG_API void releaseOwnership( VkCommandBuffer commandBuffer
+			, ImageViewId const & view
+			, uint32_t srcFamily
+			, uint32_t dstFamily );
+		CRG_API void releaseOwnership( VkCommandBuffer commandBuffer
+			, BufferViewId const & view
+			, uint32_t srcFamily
+			, uint32_t dstFamily );
+		/**
+		*\brief
+		*	Records the acquire half of a queue family ownership transfer, matching releaseOwnership.
+		*\remarks
+		*	The resource state is then reset, so that the next barrier only uses stages the new queue supports.
+		*/
+		CRG_API void acquireOwnership( VkCommandBuffer commandBuffer
+			, ImageViewId const & view
+			, uint32_t srcFamily
+			, uint32_t dstFamily );
+		CRG_API void acquireOwnership( VkCommandBuffer commandBuffer
+			, BufferViewId const & view
+			, uint32_t srcFamily
+			, uint32_t dstFamily );
+		//@}
 		//@}
 		CRG_API GraphContext & getContext()const;
 		CRG_API ContextResourcesCache & getResources()const;
@@ -264,17 +376,30 @@ namespace crg
 			return m_nextPipelineState;
 		}
 
+	private:
+		void doRunImplicitAction( ImplicitAction const & action
+			, VkCommandBuffer commandBuffer
+			, uint32_t index );
+		void doPipelineBarrier( VkCommandBuffer commandBuffer
+			, StagedImageBarrier const & barrier );
+		void doPipelineBarrier( VkCommandBuffer commandBuffer
+			, StagedBufferBarrier const & barrier );
+
 	private:
 		ResourceHandler * m_handler;
 		ContextResourcesCache * m_resources;
-		LayerLayoutStatesHandler m_images;
-		AccessStateMap m_buffers;
+		CopyOnWriteMapT< LayerLayoutStates > m_images;
+		CopyOnWriteMapT< AccessState > m_buffers;
 		std::vector< ImplicitImageTransition > m_implicitImageTransitions;
 		std::vector< ImplicitBufferTransition > m_implicitBufferTransitions;
 		PassIndexArray m_state;
 		PipelineState m_prevPipelineState{};
 		PipelineState m_currPipelineState{};
 		PipelineState m_nextPipelineState{};
-		LayerLayoutStatesHandler m_nextImages;
+		std::shared_ptr< LayerLayoutStatesHandler const > m_nextImages;
+		bool m_batchBarriers{};
+		std::vector< StagedImageBarrier > m_pendingImageBarriers;
+		std::vector< StagedBufferBarrier > m_pendingBufferBarriers;
+		RecordCountersHandler * m_counters{};
 	};
 }
@@ -0,0 +1,170 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <atomic>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	The work generated by a RunnableGraph for one frame.
+	*/
+	struct RecordCounters
+	{
+		/**
+		*\brief
+		*	The pipeline barrier and event wait commands.
+		*/
+		uint32_t barrierCommands{};
+		/**
+		*\brief
+		*	The image barriers inside these commands.
+		*/
+		uint32_t imageBarriers{};
+		/**
+		*\brief
+		*	The buffer barriers inside these commands.
+		*/
+		uint32_t bufferBarriers{};
+		/**
+		*\brief
+		*	The barriers not recorded because the resource was already in the wanted state.
+		*/
+		uint32_t skippedBarriers{};
+		/**
+		*\brief
+		*	The image barriers changing the image layout.
+		*/
+		uint32_t layoutTransitions{};
+		/**
+		*\brief
+		*	The vkUpdateDescriptorSets calls.
+		*/
+		uint32_t descriptorSetUpdates{};
+		/**
+		*\brief
+		*	The pipelines created by PipelineHolder.
+		*/
+		uint32_t pipelines{};
+		/**
+		*\brief
+		*	The render passes created by RenderPassHolder.
+		*/
+		uint32_t renderPasses{};
+		/**
+		*\brief
+		*	The command buffers recorded again through RunnablePass::reRecordCurrent.
+		*/
+		uint32_t reRecords{};
+	};
+	/**
+	*\brief
+	*	Accumulates the counters of a frame.
+	*\remarks
+	*	The counters are atomic, they can be increased from the record threads.
+	*/
+	class RecordCountersHandler
+	{
+	public:
+		void addBarrierCommand( uint32_t imageBarriers
+			, uint32_t bufferBarriers )noexcept
+		{
+			m_barrierCommands.fetch_add( 1u, std::memory_order_relaxed );
+			m_imageBarriers.fetch_add( imageBarriers, std::memory_order_relaxed );
+			m_bufferBarriers.fetch_add( bufferBarriers, std::memory_order_relaxed );
+		}
+
+		void addSkippedBarrier()noexcept
+		{
+			m_skippedBarriers.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+		void addLayoutTransition()noexcept
+		{
+			m_layoutTransitions.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+		void addDescriptorSetUpdate()noexcept
+		{
+			m_descriptorSetUpdates.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+		void addPipeline()noexcept
+		{
+			m_pipelines.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+		void addRenderPass()noexcept
+		{
+			m_renderPasses.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+		void addReRecord()noexcept
+		{
+			m_reRecords.fetch_add( 1u, std::memory_order_relaxed );
+		}
+
+		RecordCounters get()const noexcept
+		{
+			return { m_barrierCommands.load( std::memory_order_relaxed )
+				, m_imageBarriers.load( std::memory_order_relaxed )
+				, m_bufferBarriers.load( std::memory_order_relaxed )
+				, m_skippedBarriers.load( std::memory_order_relaxed )
+				, m_layoutTransitions.load( std::memory_order_relaxed )
+				, m_descriptorSetUpdates.load( std::memory_order_relaxed )
+				, m_pipelines.load( std::memory_order_relaxed )
+				, m_renderPasses.load( std::memory_order_relaxed )
+				, m_reRecords.load( std::memory_order_relaxed ) };
+		}
+		/**
+		*\brief
+		*	Resets the counters.
+		*\return
+		*	Their values before the reset.
+		*/
+		RecordCounters reset()noexcept
+		{
+			return { m_barrierCommands.exchange( 0u, std::memory_order_relaxed )
+				, m_imageBarriers.exchange( 0u, std::memory_order_relaxed )
+				, m_bufferBarriers.exchange( 0u, std::memory_order_relaxed )
+				, m_skippedBarriers.exchange( 0u, std::memory_order_relaxed )
+				, m_layoutTransitions.exchange( 0u, std::memory_order_relaxed )
+				, m_descriptorSetUpdates.exchange( 0u, std::memory_order_relaxed )
+				, m_pipelines.exchange( 0u, std::memory_order_relaxed )
+				, m_renderPasses.exchange( 0u, std::memory_order_relaxed )
+				, m_reRecords.exchange( 0u, std::memory_order_relaxed ) };
+		}
+		/**
+		*\brief
+		*	Restores the counters of the recorded commands.
+		*\remarks
+		*	Used when the recorded command buffers are discarded, the descriptor updates and created objects are kept.
+		*\param[in] saved
+		*	The values before the discarded recording.
+		*/
+		void restoreCommands( RecordCounters const & saved )noexcept
+		{
+			m_barrierCommands.store( saved.barrierCommands, std::memory_order_relaxed );
+			m_imageBarriers.store( saved.imageBarriers, std::memory_order_relaxed );
+			m_bufferBarriers.store( saved.bufferBarriers, std::memory_order_relaxed );
+			m_skippedBarriers.store( saved.skippedBarriers, std::memory_order_relaxed );
+			m_layoutTransitions.store( saved.layoutTransitions, std::memory_order_relaxed );
+		}
+
+	private:
+		std::atomic< uint32_t > m_barrierCommands{};
+		std::atomic< uint32_t > m_imageBarriers{};
+		std::atomic< uint32_t > m_bufferBarriers{};
+		std::atomic< uint32_t > m_skippedBarriers{};
+		std::atomic< uint32_t > m_layoutTransitions{};
+		std::atomic< uint32_t > m_descriptorSetUpdates{};
+		std::atomic< uint32_t > m_pipelines{};
+		std::atomic< uint32_t > m_renderPasses{};
+		std::atomic< uint32_t > m_reRecords{};
+	};
+}
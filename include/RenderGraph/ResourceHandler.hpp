@@ -4,6 +4,9 @@ See LICENSE file in root folder.
 #pragma once
 
 #include "RenderGraph/FrameGraphPrerequisites.hpp"
+#include "RenderGraph/IdSlotMap.hpp"
+#include "RenderGraph/MemoryAllocator.hpp"
+#include "RenderGraph/MemoryTracker.hpp"
 
 #pragma warning( push )
 #pragma warning( disable: 4365 )
@@ -28,7 +31,7 @@ namespace crg
 		{
 			bool created{};
 			ValueT resource{};
-			VkDeviceMemory memory{};
+			MemoryAllocation memory{};
 		};
 
 		template< typename ValueT >
@@ -43,8 +46,30 @@ namespace crg
 		ResourceHandler( ResourceHandler && )noexcept = delete;
 		ResourceHandler & operator=( ResourceHandler const & ) = delete;
 		ResourceHandler & operator=( ResourceHandler && )noexcept = delete;
-		ResourceHandler() = default;
+		CRG_API ResourceHandler();
 		CRG_API ~ResourceHandler()noexcept;
+		/**
+		*\brief
+		*	Replaces the allocator of the images and buffers memory.
+		*\remarks
+		*	No image nor buffer must be alive, the memory is freed by the allocator which allocated it.
+		*/
+		CRG_API void setMemoryAllocator( MemoryAllocatorPtr allocator );
+
+		MemoryAllocator & getMemoryAllocator()const noexcept
+		{
+			return *m_allocator;
+		}
+
+		MemoryTracker & getMemoryTracker()noexcept
+		{
+			return m_memoryTracker;
+		}
+
+		MemoryTracker const & getMemoryTracker()const noexcept
+		{
+			return m_memoryTracker;
+		}
 
 		CRG_API BufferId createBufferId( BufferData const & img );
 		CRG_API BufferViewId createViewId( BufferViewData const & view );
@@ -52,13 +77,25 @@ namespace crg
 		CRG_API ImageViewId createViewId( ImageViewData const & view );
 
 		CRG_API CreatedT< VkBuffer > createBuffer( GraphContext & context
-			, BufferId bufferId );
+			, BufferId bufferId
+			, std::string const & graph = {} );
 		CRG_API CreatedViewT< VkBufferView > createBufferView( GraphContext & context
-			, BufferViewId viewId );
+			, BufferViewId viewId
+			, std::string const & graph = {} );
 		CRG_API CreatedT< VkImage > createImage( GraphContext & context
+			, ImageId imageId
+			, std::string const & graph = {} );
+		/**
+		*\brief
+		*	Creates the image, without allocating nor binding its memory.
+		*\remarks
+		*	The memory is then owned by the caller, and is not freed when the image is destroyed.
+		*/
+		CRG_API CreatedT< VkImage > createUnboundImage( GraphContext & context
 			, ImageId imageId );
 		CRG_API CreatedViewT< VkImageView > createImageView( GraphContext & context
-			, ImageViewId viewId );
+			, ImageViewId viewId
+			, std::string const & graph = {} );
 		CRG_API VkSampler createSampler( GraphContext & context
 			, std::string const & suffix
 			, SamplerDesc const & samplerDesc );
@@ -80,16 +117,20 @@ namespace crg
 			, VertexBuffer const * buffer );
 
 	private:
+		MemoryAllocatorPtr m_allocator;
+		MemoryTracker m_memoryTracker;
 		mutable std::mutex m_buffersMutex;
 		BufferIdDataOwnerCont m_bufferIds;
 		mutable std::mutex m_bufferViewsMutex;
 		BufferViewIdDataOwnerCont m_bufferViewIds;
+		std::unordered_multimap< size_t, BufferViewId > m_bufferViewHashes;
 		BufferMemoryMap m_buffers;
 		BufferViewMap m_bufferViews;
 		mutable std::mutex m_imagesMutex;
 		ImageIdDataOwnerCont m_imageIds;
 		mutable std::mutex m_imageViewsMutex;
 		ImageViewIdDataOwnerCont m_imageViewIds;
+		std::unordered_multimap< size_t, ImageViewId > m_imageViewHashes;
 		ImageMemoryMap m_images;
 		ImageViewMap m_imageViews;
 		std::mutex m_samplersMutex;
@@ -106,18 +147,61 @@ namespace crg
 		ContextResourcesCache( ContextResourcesCache && )noexcept = delete;
 		ContextResourcesCache & operator=( ContextResourcesCache && )noexcept = delete;
 
+		/**
+		*\param[in] graph
+		*	The name of the runnable graph using the cache, the memory of the resources it creates is accounted to it.
+		*/
 		CRG_API ContextResourcesCache( ResourceHandler & handler
-			, GraphContext & context );
+			, GraphContext & context
+			, std::string graph = {} );
 		CRG_API ~ContextResourcesCache()noexcept;
 
 		CRG_API VkBuffer createBuffer( BufferId const & bufferId );
-		CRG_API VkBuffer createBuffer( BufferId const & bufferId, VkDeviceMemory & memory );
+		/**
+		*\param[out] memory
+		*	Receives the buffer's memory allocation: the device memory may be shared, the buffer lies at the allocation offset.
+		*/
+		CRG_API VkBuffer createBuffer( BufferId const & bufferId, MemoryAllocation & memory );
+		/**
+		*\param[out] memory
+		*	Receives the buffer's device memory, which may be shared: the buffer offset is lost.
+		*/
+		[[deprecated( "Use the MemoryAllocation overload, which gives the buffer offset in the memory." )]]
+		VkBuffer createBuffer( BufferId const & bufferId, VkDeviceMemory & memory )
+		{
+			MemoryAllocation allocation{};
+			auto result = createBuffer( bufferId, allocation );
+			memory = allocation.memory;
+			return result;
+		}
 		CRG_API VkBufferView createBufferView( BufferViewId const & viewId );
 		CRG_API bool destroyBuffer( BufferId const & imageId );
 		CRG_API bool destroyBufferView( BufferViewId const & viewId );
 
 		CRG_API VkImage createImage( ImageId const & imageId );
-		CRG_API VkImage createImage( ImageId const & imageId, VkDeviceMemory & memory );
+		/**
+		*\param[out] memory
+		*	Receives the image's memory allocation: the device memory may be shared, the image lies at the allocation offset.
+		*/
+		CRG_API VkImage createImage( ImageId const & imageId, MemoryAllocation & memory );
+		/**
+		*\param[out] memory
+		*	Receives the image's device memory, which may be shared: the image offset is lost.
+		*/
+		[[deprecated( "Use the MemoryAllocation overload, which gives the image offset in the memory." )]]
+		VkImage createImage( ImageId const & imageId, VkDeviceMemory & memory )
+		{
+			MemoryAllocation allocation{};
+			auto result = createImage( imageId, allocation );
+			memory = allocation.memory;
+			return result;
+		}
+		/**
+		*\copydoc crg::ResourceHandler::createUnboundImage
+		*\return
+		*	\p nullptr if the image already existed.
+		*/
+		CRG_API VkImage createUnboundImage( ImageId const & imageId );
 		CRG_API VkImageView createImageView( ImageViewId const & viewId );
 		CRG_API bool destroyImage( ImageId const & imageId );
 		CRG_API bool destroyImageView( ImageViewId const & viewId );
@@ -142,19 +226,22 @@ namespace crg
 		}
 
 	private:
-		using VkBufferIdMap = std::map< BufferId, VkBuffer >;
-		using VkBufferViewIdMap = std::map< BufferViewId, VkBufferView >;
-		using VkImageIdMap = std::map< ImageId, VkImage >;
-		using VkImageViewIdMap = std::map< ImageViewId, VkImageView >;
+		using VkBufferIdMap = IdSlotMapT< BufferData, VkBuffer >;
+		using VkBufferViewIdMap = IdSlotMapT< BufferViewData, VkBufferView >;
+		using VkImageIdMap = IdSlotMapT< ImageData, VkImage >;
+		using VkImageViewIdMap = IdSlotMapT< ImageViewData, VkImageView >;
 
 		ResourceHandler & m_handler;
 		GraphContext & m_context;
+		std::string m_graph;
 		VkBufferIdMap m_buffers;
 		VkBufferViewIdMap m_bufferViews;
 		VkImageIdMap m_images;
 		VkImageViewIdMap m_imageViews;
 		std::unordered_map< size_t, VkSampler > m_samplers;
 		std::unordered_map< size_t, VertexBuffer const * > m_vertexBuffers;
+		// The passes may be recorded from several threads.
+		std::mutex m_mutex;
 	};
 
 	class ResourcesCache
@@ -164,9 +251,23 @@ namespace crg
 
 		CRG_API VkBuffer createBuffer( GraphContext & context
 			, BufferId const & bufferId );
+		/**
+		*\remarks
+		*	\p memory.memory can be shared with other resources, the buffer then lies at \p memory.offset.
+		*/
 		CRG_API VkBuffer createBuffer( GraphContext & context
 			, BufferId const & bufferId
-			, VkDeviceMemory & memory );
+			, MemoryAllocation & memory );
+		[[deprecated( "Use the MemoryAllocation overload, which gives the buffer offset in the memory." )]]
+		VkBuffer createBuffer( GraphContext & context
+			, BufferId const & bufferId
+			, VkDeviceMemory & memory )
+		{
+			MemoryAllocation allocation{};
+			auto result = createBuffer( context, bufferId, allocation );
+			memory = allocation.memory;
+			return result;
+		}
 		CRG_API VkBufferView createBufferView( GraphContext & context
 			, BufferViewId const & viewId );
 		CRG_API bool destroyBuffer( BufferId const & bufferId );
@@ -178,9 +279,23 @@ namespace crg
 
 		CRG_API VkImage createImage( GraphContext & context
 			, ImageId const & imageId );
+		/**
+		*\remarks
+		*	\p memory.memory can be shared with other resources, the image then lies at \p memory.offset.
+		*/
 		CRG_API VkImage createImage( GraphContext & context
 			, ImageId const & imageId
-			, VkDeviceMemory & memory );
+			, MemoryAllocation & memory );
+		[[deprecated( "Use the MemoryAllocation overload, which gives the image offset in the memory." )]]
+		VkImage createImage( GraphContext & context
+			, ImageId const & imageId
+			, VkDeviceMemory & memory )
+		{
+			MemoryAllocation allocation{};
+			auto result = createImage( context, imageId, allocation );
+			memory = allocation.memory;
+			return result;
+		}
 		CRG_API VkImageView createImageView( GraphContext & context
 			, ImageViewId const & viewId );
 		CRG_API bool destroyImage( ImageId const & imageId );
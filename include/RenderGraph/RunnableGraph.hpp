@@ -9,6 +9,8 @@ See LICENSE file in root folder.
 #include "ResourceHandler.hpp"
 #include "RunnablePass.hpp"
 
+#include <unordered_map>
+
 namespace crg
 {
 	/**
@@ -39,8 +41,144 @@ namespace crg
 		}
 	};
 
+	/**
+	*\brief
+	*	The placement of a transient image, in the memory it shares with other transient images.
+	*/
+	struct TransientImage
+	{
+		ImageId image;
+		/**
+		*\brief
+		*	The index of the first pass using the image.
+		*/
+		uint32_t firstPass{};
+		/**
+		*\brief
+		*	The index of the last pass using the image.
+		*/
+		uint32_t lastPass{};
+		uint32_t memoryType{};
+		DeviceSize size{};
+		DeviceSize alignment{};
+		DeviceSize offset{};
+	};
+	using TransientImageArray = std::vector< TransientImage >;
+	/**
+	*\brief
+	*	The memory used by the transient images of a RunnableGraph.
+	*/
+	struct TransientMemoryStats
+	{
+		/**
+		*\brief
+		*	The memory the transient images would use, with one allocation per image.
+		*/
+		DeviceSize requiredSize{};
+		/**
+		*\brief
+		*	The memory actually allocated for them.
+		*/
+		DeviceSize allocatedSize{};
+
+		DeviceSize getSavedSize()const noexcept
+		{
+			return requiredSize - allocatedSize;
+		}
+	};
+
+	/**
+	*\brief
+	*	A resource released by a pass through an event, and acquired by a later pass.
+	*/
+	struct SplitBarrier
+	{
+		/**
+		*\brief
+		*	The index of the pass writing the resource, which sets the event.
+		*/
+		uint32_t producer{};
+		/**
+		*\brief
+		*	The index of the pass reading the resource, before which the event is waited for.
+		*/
+		uint32_t consumer{};
+		/**
+		*\brief
+		*	The consumer attachment.
+		*/
+		Attachment const * attach{};
+	};
+	using SplitBarrierArray = std::vector< SplitBarrier >;
+
+	/**
+	*\brief
+	*	A queue a graph can be submitted to.
+	*/
+	struct GraphQueue
+	{
+		VkQueue queue{};
+		uint32_t familyIndex{};
+	};
+	/**
+	*\brief
+	*	The queues a graph is run on, one per QueueClass.
+	*\remarks
+	*	When the compute or transfer queue is null, the passes wanting it run on the graphics queue.
+	*/
+	struct GraphQueues
+	{
+		GraphQueue graphics;
+		GraphQueue compute;
+		GraphQueue transfer;
+	};
+
+	/**
+	*\brief
+	*	A resource used by a partition, which ownership is taken from another queue family.
+	*/
+	struct QueueTransfer
+	{
+		static constexpr uint32_t FrameStart = ~0u;
+		/**
+		*\brief
+		*	The index of the partition releasing the resource.
+		*	FrameStart if the resource is first used in the frame, its content is then discarded.
+		*/
+		uint32_t source{};
+		/**
+		*\brief
+		*	The attachment acquiring the resource.
+		*/
+		Attachment const * attach{};
+	};
+	/**
+	*\brief
+	*	Consecutive passes submitted to the same queue, in a single command buffer.
+	*/
+	struct QueuePartition
+	{
+		QueueClass queue{};
+		uint32_t firstPass{};
+		uint32_t passCount{};
+		/**
+		*\brief
+		*	The earlier partitions this one waits for, through semaphores.
+		*/
+		std::vector< uint32_t > waited;
+		/**
+		*\brief
+		*	The resources acquired at the start of the partition.
+		*/
+		std::vector< QueueTransfer > acquired;
+	};
+	using QueuePartitionArray = std::vector< QueuePartition >;
+	struct RunnablePassSignature;
+
 	class RunnableGraph
 	{
+		friend class FrameGraph;
+
 	public:
 		/**
 		*\param inputTransitions
@@ -57,12 +195,29 @@ namespace crg
 		CRG_API ~RunnableGraph()noexcept;
 
 		CRG_API void record();
+		/**
+		*\return
+		*	\p true if the next run needs to record the graph again.
+		*\remarks
+		*	The graph is recorded again when a pass is dirty, when the states the graph
+		*	starts from changed, or when the last recording didn't end with the states it started from.
+		*/
+		CRG_API bool isRecordDirty()const;
 
 		CRG_API SemaphoreWaitArray run( VkQueue queue );
 		CRG_API SemaphoreWaitArray run( SemaphoreWait toWait
 			, VkQueue queue );
 		CRG_API SemaphoreWaitArray run( SemaphoreWaitArray const & toWait
 			, VkQueue queue );
+		/**
+		*\brief
+		*	Runs the graph, submitting the passes to the queue of their QueueClass.
+		*\remarks
+		*	Each run of consecutive passes on the same queue is a separate submission,
+		*	synchronised with the others through semaphores and queue family ownership transfers.
+		*/
+		CRG_API SemaphoreWaitArray run( SemaphoreWaitArray const & toWait
+			, GraphQueues const & queues );
 
 		CRG_API VkBuffer createBuffer( BufferId const & buffer );
 		CRG_API VkBufferView createBufferView( BufferViewId const & view );
@@ -129,14 +284,92 @@ namespace crg
 			return m_resources;
 		}
 
-		Fence & getFence()noexcept
+		/**
+		*\brief
+		*	Waits for the last submission of the current frame in flight.
+		*\remarks
+		*	Goes through the timeline semaphore when the graph uses one, through the frame fence otherwise.
+		*/
+		CRG_API VkResult wait( uint64_t timeout );
+		/**
+		*\return
+		*	The fence of the current frame in flight.
+		*\remarks
+		*	It is not submitted when the graph uses a timeline semaphore.
+		*/
+		CRG_API Fence & getFence()noexcept;
+		CRG_API Fence const & getFence()const noexcept;
+
+		/**
+		*\return
+		*	The CPU samples of all the graph timers of the given scope.
+		*\remarks
+		*	Other timers, like the TimerScope::eUpdate ones, can be added through FramePassTimer::setScopeHistories.
+		*/
+		TimerHistory & getCpuHistory( TimerScope scope )noexcept
+		{
+			return m_cpuScopeHistories[size_t( scope )];
+		}
+		/**
+		*\return
+		*	The GPU samples of all the graph timers of the given scope.
+		*/
+		TimerHistory & getGpuHistory( TimerScope scope )noexcept
+		{
+			return m_gpuScopeHistories[size_t( scope )];
+		}
+		/**
+		*\return
+		*	The counters of the last run frame, including its recording.
+		*/
+		RecordCounters const & getCounters()const noexcept
+		{
+			return m_frameCounters;
+		}
+		/**
+		*\return
+		*	The counters of the next frame, increased since the last run.
+		*/
+		RecordCountersHandler & getCurrentCounters()noexcept
+		{
+			return m_counters;
+		}
+		/**
+		*\return
+		*	The number of runs, used to tag the timers results.
+		*/
+		uint64_t getFrameId()const noexcept
+		{
+			return m_frameId;
+		}
+		/**
+		*\return
+		*	The timeline semaphore signaled by the graph submissions, null if the graph uses binary semaphores.
+		*/
+		VkSemaphore getTimelineSemaphore()const noexcept
+		{
+			return m_timelineSemaphore.object;
+		}
+		/**
+		*\return
+		*	The value signaled by the last submission, on the timeline semaphore.
+		*/
+		uint64_t getTimelineValue()const noexcept
 		{
-			return m_fence;
+			return m_timelineValue;
 		}
 
-		Fence const & getFence()const noexcept
+		uint32_t getFramesInFlight()const noexcept
 		{
-			return m_fence;
+			return m_framesInFlight;
+		}
+		/**
+		*\return
+		*	The index of the frame in flight last recorded or submitted.
+		*/
+		uint32_t getFrameIndex()const noexcept
+		{
+			return m_frameIndex;
 		}
 
 		FramePassTimer const & getTimer()const noexcept
@@ -154,20 +387,203 @@ namespace crg
 			return m_context;
 		}
 
+		TransientImageArray const & getTransientImages()const noexcept
+		{
+			return m_transientImages;
+		}
+
+		TransientMemoryStats const & getTransientMemoryStats()const noexcept
+		{
+			return m_transientStats;
+		}
+		/**
+		*\return
+		*	The device memory allocated for this graph: its resources, and its transient images heaps.
+		*/
+		CRG_API MemoryReport getMemoryReport()const;
+
+		SplitBarrierArray const & getSplitBarriers()const noexcept
+		{
+			return m_splitBarriers;
+		}
+		/**
+		*\brief
+		*	The queue partitions, as computed by the last recording.
+		*/
+		QueuePartitionArray const & getPartitions()const noexcept
+		{
+			return m_partitions;
+		}
+
+	private:
+		// The recording types and states, defined in RunnableGraphInternals.hpp.
+		struct RecordChunk;
+		struct FrameData;
+		struct Internals;
+		using PassesMap = std::unordered_map< FramePass const *, std::pair< RunnablePassSignature, RunnablePassPtr > >;
+		/**
+		*\brief
+		*	The stages given when the split barriers events were set, 0 for the events not set yet.
+		*/
+		using SplitStages = std::vector< VkPipelineStageFlags >;
+		/**
+		*\brief
+		*	Replaces the nodes, keeping the runnable passes which FramePass is unchanged.
+		*/
+		void rebuild( GraphNodePtrArray nodes
+			, RootNode rootNode );
+		/**
+		*\brief
+		*	Creates the runnable passes for the current nodes, picking them from \p previous when possible.
+		*\return
+		*	The number of reused passes.
+		*/
+		size_t doCreatePasses( PassesMap & previous );
+		/**
+		*\brief
+		*	Creates the transient images, placing those with non overlapping lifetimes in the same memory.
+		*\remarks
+		*	If the placements changed since the last call, the previous transient images are destroyed,
+		*	and the passes using them are removed from \p previous.
+		*/
+		void doCreateTransientImages( PassesMap & previous );
+		void doDestroyTransientImages( PassesMap & previous );
+		/**
+		*\brief
+		*	Lists the split barriers, and creates the events they need.
+		*/
+		void doCreateSplitBarriers();
+		/**
+		*\brief
+		*	Lists the passes using each image, once the passes are created.
+		*/
+		void doListImageUses();
+		/**
+		*\brief
+		*	Computes the layouts each pass images have in the next enabled pass using them,
+		*	if the passes enabled state changed since the last call.
+		*/
+		void doUpdateNextImageLayouts();
+		/**
+		*\brief
+		*	Finds the pass waiting for each split barrier, as the consumer may be disabled.
+		*/
+		void doUpdateSplitAcquirers();
+		/**
+		*\brief
+		*	Waits for the events released for the given pass, transitioning the resources it consumes.
+		*\remarks
+		*	The events routed from a disabled consumer are only waited for, the pass barriers do the transitions.
+		*/
+		void doAcquireSplitBarriers( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t passIndex
+			, SplitStages const & released );
+		/**
+		*\brief
+		*	Sets the events of the resources released by the given pass.
+		*/
+		void doReleaseSplitBarriers( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t passIndex
+			, SplitStages & released );
+		/**
+		*\brief
+		*	Splits the passes between the available queues, if the passes or the queues changed.
+		*/
+		void doUpdatePartitions();
+		VkCommandPool doGetCommandPool( uint32_t familyIndex );
+		void doResetCommandPools();
+		VkCommandBuffer doGetCommandBuffer( uint32_t partition );
+		VkCommandBuffer doBeginPartition( uint32_t partition );
+		void doEndPartition( VkCommandBuffer commandBuffer );
+		/**
+		*\brief
+		*	Acquires the resources the given partition takes from other partitions.
+		*/
+		void doAcquireResources( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t partition );
+		/**
+		*\brief
+		*	Releases the resources later partitions take from the given partition.
+		*/
+		void doReleaseResources( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t partition );
+		GraphQueue const & doGetQueue( QueueClass queue )const noexcept;
+		/**
+		*\brief
+		*	Records the given pass, and the barriers the graph adds around it.
+		*/
+		uint32_t doRecordPass( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, uint32_t passIndex
+			, SplitStages & released );
+		/**
+		*\brief
+		*	Records all the passes on the calling thread, keeping the states at the start of each chunk.
+		*/
+		void doRecordSerial( RecordContext & context
+			, RecordContext::PassIndexArray & passIndices );
+		/**
+		*\brief
+		*	Records the chunks on the record threads.
+		*\return
+		*	\p false if the chunks can't be recorded in parallel, or if their recording doesn't match a serial one.
+		*/
+		bool doRecordChunks( RecordContext & context
+			, RecordContext::PassIndexArray & passIndices );
+		void doRecordChunk( RecordContext & context
+			, SplitStages & released
+			, RecordChunk const & chunk
+			, RecordContext::PassIndexArray & passIndices );
+		void doRecordChunkPasses( RecordContext & context
+			, VkCommandBuffer commandBuffer
+			, SplitStages & released
+			, RecordChunk const & chunk
+			, RecordContext::PassIndexArray & passIndices );
+		/**
+		*\brief
+		*	Splits the partitions in chunks, if the partitions or the record threads count changed.
+		*/
+		void doUpdateChunks();
+		void doDestroyChunk( RecordChunk & chunk );
+		void doCreateFrames();
+		void doDestroyFrames();
+		VkResult doWaitFrame( FrameData & frame
+			, uint64_t timeout );
+		void doWaitFrames();
+		void doSetTimersFrame();
+		void doAttachScopeHistories( FramePassTimer & timer )noexcept;
+
 	private:
 		FrameGraph & m_graph;
 		GraphContext & m_context;
 		ContextResourcesCache m_resources;
 		GraphNodePtrArray m_nodes;
 		RootNode m_rootNode;
+		uint32_t m_framesInFlight{};
 		ContextObjectT< VkQueryPool > m_timerQueries;
+		uint32_t m_timerQueryCount{};
 		uint32_t m_timerQueryOffset{};
 		ContextObjectT< VkCommandPool > m_commandPool;
 		std::vector< RunnablePassPtr > m_passes;
 		RecordContext::GraphIndexMap m_states;
-		VkCommandBuffer m_commandBuffer{};
-		VkSemaphore m_semaphore{};
-		Fence m_fence;
+		uint32_t m_frameIndex{};
+		uint64_t m_frameId{};
+		ContextObjectT< VkSemaphore > m_timelineSemaphore;
+		uint64_t m_timelineValue{};
+		std::array< TimerHistory, TimerScopeCount > m_cpuScopeHistories;
+		std::array< TimerHistory, TimerScopeCount > m_gpuScopeHistories;
+		RecordCountersHandler m_counters;
+		RecordCounters m_frameCounters;
 		FramePassTimer m_timer;
+		TransientImageArray m_transientImages;
+		TransientMemoryStats m_transientStats;
+		SplitBarrierArray m_splitBarriers;
+		GraphQueues m_queues;
+		QueuePartitionArray m_partitions;
+		std::unique_ptr< Internals > m_internals;
 	};
 }
@@ -127,9 +127,44 @@ namespace crg
 			std::vector< RecordContext::ImplicitAction > postPassActions{};
 			std::map< ImageViewId, RecordContext::ImplicitAction > implicitImageActions{};
 			std::map< BufferViewId, RecordContext::ImplicitAction > implicitBufferActions{};
+			/**
+			*\brief
+			*	\p true if the pass commands depend on values changing between two runs,
+			*	the graph is then recorded at each run.
+			*\remarks
+			*	When unset, the passes recording user callbacks are recorded at each run, since the graph can't track what they read.
+			*	The copy, blit and mipmaps passes, and ComputePass, RenderQuad and RenderMesh without callbacks called while recording,
+			*	are only recorded again when the graph changes.
+			*	Set it to \p false for a custom pass whose record callback only depends on the graph resources.
+			*/
+			std::optional< bool > recordEachRun{};
+			/**
+			*\brief
+			*	\p true if the pass begins a render pass, it is then recorded into a primary command buffer.
+			*\remarks
+			*	Custom passes beginning a render pass must set it, to be kept out of the parallel recording.
+			*/
+			bool renderPass{ false };
 		};
 	}
 
+	namespace ru
+	{
+		/**
+		*\param[in] ruConfig
+		*	The configuration of a pass whose commands only depend on the graph resources.
+		*\return
+		*	\p ruConfig, recorded only when the graph changes, unless told otherwise.
+		*/
+		inline Config getTrackedConfig( Config ruConfig )
+		{
+			if ( !ruConfig.recordEachRun )
+				ruConfig.recordEachRun = false;
+
+			return ruConfig;
+		}
+	}
+
 	template<>
 	struct DefaultValueGetterT< ru::Config >
 	{
@@ -265,10 +300,31 @@ namespace crg
 			return m_callbacks.isEnabled();
 		}
 
+		bool isComputePass()const
+		{
+			return m_callbacks.isComputePass();
+		}
+
+		bool isRenderPass()const
+		{
+			return m_ruConfig.renderPass;
+		}
+
 		uint32_t getIndex()const
 		{
 			return isEnabled() ? m_callbacks.getPassIndex() : InvalidIndex;
 		}
+		/**
+		*\return
+		*	\p true if the pass must be recorded again: its enabled status or its index changed,
+		*	its command buffer was reset, or it is recorded at each run.
+		*/
+		bool isDirty()const
+		{
+			return m_dirty
+				|| m_ruConfig.recordEachRun.value_or( true )
+				|| getIndex() != m_recordedIndex;
+		}
 
 		FramePass const & getPass()const
 		{
@@ -374,6 +430,8 @@ namespace crg
 		std::vector< RecordContext > m_passContexts;
 		LayerLayoutStatesHandler m_imageLayouts;
 		AccessStateMap m_bufferAccesses;
+		uint32_t m_recordedIndex{ InvalidIndex };
+		bool m_dirty{ true };
 	};
 
 	template<>
@@ -0,0 +1,110 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "FrameGraphPrerequisites.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace crg
+{
+	using Clock = std::chrono::high_resolution_clock;
+	using Nanoseconds = std::chrono::nanoseconds;
+
+	struct TimerStatistics
+	{
+		/**
+		*\brief
+		*	The number of samples the statistics are computed from.
+		*/
+		uint32_t count{};
+		Nanoseconds min{};
+		Nanoseconds max{};
+		Nanoseconds mean{};
+		Nanoseconds p50{};
+		Nanoseconds p95{};
+		Nanoseconds p99{};
+		/**
+		*\brief
+		*	The number of samples above the hitch threshold, since the last clear.
+		*/
+		uint64_t hitches{};
+	};
+	/**
+	*\brief
+	*	Keeps the last samples of a timer, in a ring buffer allocated at construction.
+	*\remarks
+	*	push is lock-free and can be called from several threads.
+	*	getStatistics uses an internal buffer, and must not be called concurrently with itself.
+	*/
+	class TimerHistory
+	{
+	public:
+		TimerHistory( TimerHistory const & rhs ) = delete;
+		TimerHistory( TimerHistory && rhs )noexcept = delete;
+		TimerHistory & operator=( TimerHistory const & rhs ) = delete;
+		TimerHistory & operator=( TimerHistory && rhs )noexcept = delete;
+		~TimerHistory()noexcept = default;
+		/**
+		*\param[in] capacity
+		*	The number of kept samples, 0 to disable the history.
+		*\param[in] hitchThreshold
+		*	The duration above which a sample is a hitch, 0 to disable the detection.
+		*/
+		CRG_API explicit TimerHistory( uint32_t capacity = 0u
+			, Nanoseconds hitchThreshold = Nanoseconds{} );
+		/**
+		*\brief
+		*	Adds a sample, replacing the oldest one when the history is full.
+		*\return
+		*	\p true if the sample is a hitch.
+		*/
+		CRG_API bool push( Nanoseconds sample )noexcept;
+		/**
+		*\brief
+		*	Computes the statistics of the kept samples.
+		*/
+		CRG_API TimerStatistics getStatistics()const noexcept;
+		/**
+		*\brief
+		*	Removes the samples and the hitches count.
+		*/
+		CRG_API void clear()noexcept;
+
+		void setHitchThreshold( Nanoseconds value )noexcept
+		{
+			m_hitchThreshold.store( value.count(), std::memory_order_relaxed );
+		}
+
+		Nanoseconds getHitchThreshold()const noexcept
+		{
+			return Nanoseconds{ m_hitchThreshold.load( std::memory_order_relaxed ) };
+		}
+
+		uint64_t getHitchCount()const noexcept
+		{
+			return m_hitches.load( std::memory_order_relaxed );
+		}
+
+		uint32_t getCapacity()const noexcept
+		{
+			return uint32_t( m_samples.size() );
+		}
+
+		bool isEnabled()const noexcept
+		{
+			return !m_samples.empty();
+		}
+
+	private:
+		std::vector< std::atomic< int64_t > > m_samples;
+		mutable std::vector< int64_t > m_sorted;
+		std::atomic< uint64_t > m_count{};
+		std::atomic< int64_t > m_hitchThreshold{};
+		std::atomic< uint64_t > m_hitches{};
+	};
+}
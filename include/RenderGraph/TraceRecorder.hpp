@@ -0,0 +1,144 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "TimerHistory.hpp"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#pragma warning( push )
+#pragma warning( disable: 4365 )
+#pragma warning( disable: 5262 )
+#include <ostream>
+#pragma warning( pop )
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Records CPU and GPU spans, and writes them as a Chrome trace (JSON), readable by Perfetto.
+	*\remarks
+	*	Set it in GraphContext::traceRecorder for the graphs and timers to feed it.
+	*	The CPU spans are on one track per thread, the GPU spans on a separate track.
+	*	The groups of the passes are written as slices enclosing the passes of a frame.
+	*/
+	class TraceRecorder
+	{
+	public:
+		CRG_API TraceRecorder();
+		/**
+		*\brief
+		*	Adds a CPU span, on the track of the calling thread.
+		*\param[in] path
+		*	The full name of the enclosing group, its components separated by '/'.
+		*/
+		CRG_API void addCpuEvent( std::string name
+			, std::string category
+			, std::string path
+			, uint64_t frameId
+			, Clock::time_point begin
+			, Clock::time_point end );
+		/**
+		*\brief
+		*	Adds a GPU span, from a timestamps pair.
+		*\param[in] period
+		*	The number of nanoseconds per timestamp tick.
+		*/
+		CRG_API void addGpuEvent( std::string name
+			, std::string category
+			, std::string path
+			, uint64_t frameId
+			, uint64_t begin
+			, uint64_t end
+			, float period );
+		/**
+		*\brief
+		*	Aligns the GPU track on the CPU clock, from a GPU timestamp taken at the given CPU time.
+		*\remarks
+		*	Without calibration, the GPU track starts at the trace origin.
+		*/
+		CRG_API void setCalibration( uint64_t gpuTimestamp
+			, float period
+			, Clock::time_point cpuTime );
+		/**
+		*\brief
+		*	Calibrates the GPU track through vkGetCalibratedTimestampsEXT.
+		*\return
+		*	\p false if the function is not available or failed.
+		*/
+		CRG_API bool calibrate( GraphContext const & context );
+		/**
+		*\brief
+		*	Writes the recorded spans as a Chrome trace.
+		*/
+		CRG_API void write( std::ostream & stream )const;
+		/**
+		*\brief
+		*	Removes the recorded spans.
+		*/
+		CRG_API void clear();
+
+		size_t getEventCount()const
+		{
+			std::lock_guard lock{ m_mutex };
+			return m_events.size();
+		}
+
+	private:
+		uint32_t doGetThreadIndex();
+
+	private:
+		struct Event
+		{
+			std::string name;
+			std::string category;
+			std::string path;
+			uint64_t frameId{};
+			uint32_t thread{};
+			bool gpu{};
+			// Nanoseconds, from the trace origin for the CPU, from the GPU timestamps origin for the GPU.
+			double begin{};
+			double end{};
+		};
+		struct Calibration
+		{
+			double gpu{};
+			double cpu{};
+		};
+
+		mutable std::mutex m_mutex;
+		Clock::time_point m_origin;
+		std::vector< Event > m_events;
+		std::vector< std::thread::id > m_threads;
+		std::optional< Calibration > m_calibration;
+	};
+	/**
+	*\brief
+	*	Adds a CPU span to the recorder, if any, from its construction to its destruction.
+	*/
+	class TraceScope
+	{
+	public:
+		TraceScope( TraceScope const & ) = delete;
+		TraceScope( TraceScope && )noexcept = delete;
+		TraceScope & operator=( TraceScope const & ) = delete;
+		TraceScope & operator=( TraceScope && )noexcept = delete;
+
+		CRG_API TraceScope( TraceRecorder * recorder
+			, std::string name
+			, std::string category );
+		CRG_API ~TraceScope()noexcept;
+
+	private:
+		TraceRecorder * m_recorder;
+		std::string m_name;
+		std::string m_category;
+		Clock::time_point m_begin;
+	};
+}
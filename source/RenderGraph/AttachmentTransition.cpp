@@ -5,25 +5,63 @@ See LICENSE file in root folder.
 #include "RenderGraph/AttachmentTransition.hpp"
 
 #include "RenderGraph/FramePass.hpp"
+#include "RenderGraph/Hash.hpp"
 #include "RenderGraph/LayerLayoutStatesHandler.hpp"
 
 #include <algorithm>
+#include <unordered_map>
 
 namespace crg
 {
 	namespace attTran
 	{
+		static size_t hashAttach( size_t hash
+			, Attachment const & attach )
+		{
+			hash = hashCombine( hash, attach.pass );
+			return hashCombine( hash, attach.flags );
+		}
+
+		static size_t hashTransition( ImageTransition const & transition )
+		{
+			// Only hash what match() compares strictly, aspect masks are only required to intersect,
+			// and array layers can be remapped for 3D images.
+			auto const & view = *transition.data.data;
+			size_t hash = std::hash< uint32_t >{}( view.image.id );
+			hash = hashCombine( hash, view.info.format );
+			hash = hashCombine( hash, view.info.subresourceRange.baseMipLevel );
+			hash = hashCombine( hash, view.info.subresourceRange.levelCount );
+			hash = hashAttach( hash, transition.outputAttach );
+			return hashAttach( hash, transition.inputAttach );
+		}
+
+		static size_t hashTransition( BufferTransition const & transition )
+		{
+			size_t hash = std::hash< uint32_t >{}( transition.data.id );
+			hash = hashAttach( hash, transition.outputAttach );
+			return hashAttach( hash, transition.inputAttach );
+		}
+
 		template< typename TransitionT >
 		std::vector< TransitionT > mergeIdenticalTransitionsT( std::vector< TransitionT > transitions )
 		{
 			std::vector< TransitionT > result;
+			std::unordered_map< size_t, std::vector< size_t > > buckets;
+			result.reserve( transitions.size() );
+			buckets.reserve( transitions.size() );
 
 			for ( auto & transition : transitions )
 			{
-				if ( auto it = std::find( result.begin(), result.end(), transition );
-					it == result.end() )
+				auto & bucket = buckets[hashTransition( transition )];
+
+				if ( bucket.end() == std::find_if( bucket.begin(), bucket.end()
+					, [&result, &transition]( size_t index )
+					{
+						return result[index] == transition;
+					} ) )
 				{
-					result.push_back( transition );
+					bucket.push_back( result.size() );
+					result.push_back( std::move( transition ) );
 				}
 			}
 
@@ -11,9 +11,18 @@ See LICENSE file in root folder.
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/ResourceHandler.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
+#include "RenderGraph/TraceRecorder.hpp"
 #include "GraphBuilder.hpp"
+#include "GraphCache.hpp"
 
 #include <algorithm>
+#include <sstream>
+#include <unordered_set>
+
+#pragma warning( push )
+#pragma warning( disable: 5262 )
+#include <fstream>
+#pragma warning( pop )
 
 namespace crg
 {
@@ -206,6 +215,13 @@ namespace crg
 		return result;
 	}
 
+	ImageId FrameGraph::createTransientImage( ImageData const & img )
+	{
+		auto result = createImage( img );
+		m_transientImages.insert( result );
+		return result;
+	}
+
 	ImageViewId FrameGraph::createView( ImageViewData const & view )
 	{
 		auto result = m_handler.createViewId( view );
@@ -348,25 +364,92 @@ namespace crg
 
 	RunnableGraphPtr FrameGraph::compile( GraphContext & context )
 	{
-		FramePassArray passes;
-		m_defaultGroup->listPasses( passes );
-
-		if ( passes.empty() )
+		auto passes = doListPasses();
+		RootNode root{ *this };
+		GraphNodePtrArray nodes;
+		size_t depthFirstCount{};
 		{
-			Logger::logWarning( "No FramePass registered." );
-			CRG_Exception( "No FramePass registered." );
+			TraceScope trace{ context.traceRecorder, m_name + " - Build graph", "compile" };
+			depthFirstCount = doBuildGraph( context, passes, root, nodes );
 		}
+		doReport( passes, nodes, depthFirstCount, false );
+		TraceScope trace{ context.traceRecorder, m_name + " - Create runnable graph", "compile" };
+		return std::make_unique< RunnableGraph >( *this
+			, std::move( nodes )
+			, std::move( root )
+			, context );
+	}
 
-		auto endPoints = builder::findEndPoints( passes );
+	RunnableGraphPtr FrameGraph::compile( GraphContext & context
+		, std::string const & cacheFilePath )
+	{
+		auto passes = doListPasses();
+		auto hash = cache::computeHash( passes, m_passCulling, m_outputs, m_passScheduling );
 		RootNode root{ *this };
 		GraphNodePtrArray nodes;
-		builder::buildGraph( endPoints, root, nodes, context.separateDepthStencilLayouts );
+		size_t depthFirstCount{};
+		bool loaded{};
+
+		if ( std::ifstream file{ cacheFilePath, std::ios::binary };
+			file && cache::loadGraph( file, hash, context.separateDepthStencilLayouts, depthFirstCount
+				, passes, m_imageViews, m_bufferViews
+				, root, nodes ) )
+		{
+			loaded = true;
+			Logger::logDebug( m_name + " - Graph loaded from cache" );
+		}
+		else
+		{
+			Logger::logDebug( m_name + " - Graph cache mismatch, building graph" );
+			root = RootNode{ *this };
+			nodes.clear();
+			depthFirstCount = 0u;
+			TraceScope trace{ context.traceRecorder, m_name + " - Build graph", "compile" };
+			depthFirstCount = doBuildGraph( context, passes, root, nodes );
+			std::ostringstream stream;
+
+			if ( cache::saveGraph( stream, hash, context.separateDepthStencilLayouts, depthFirstCount, passes, root, nodes ) )
+			{
+				std::ofstream output{ cacheFilePath, std::ios::binary | std::ios::trunc };
+				auto content = stream.str();
+				output.write( content.data(), std::streamsize( content.size() ) );
+			}
+			else
+			{
+				Logger::logWarning( m_name + " - Graph can't be written to cache" );
+			}
+		}
+
+		doReport( passes, nodes, depthFirstCount, loaded );
+		TraceScope trace{ context.traceRecorder, m_name + " - Create runnable graph", "compile" };
 		return std::make_unique< RunnableGraph >( *this
 			, std::move( nodes )
 			, std::move( root )
 			, context );
 	}
 
+	void FrameGraph::recompile( RunnableGraph & runnable )
+	{
+		if ( &runnable.m_graph != this )
+		{
+			Logger::logWarning( "RunnableGraph was not compiled from this FrameGraph." );
+			CRG_Exception( "RunnableGraph was not compiled from this FrameGraph." );
+		}
+
+		auto passes = doListPasses();
+		RootNode root{ *this };
+		GraphNodePtrArray nodes;
+		size_t depthFirstCount{};
+		{
+			TraceScope trace{ runnable.getContext().traceRecorder, m_name + " - Build graph", "compile" };
+			depthFirstCount = doBuildGraph( runnable.getContext(), passes, root, nodes );
+		}
+		doReport( passes, nodes, depthFirstCount, false );
+		TraceScope trace{ runnable.getContext().traceRecorder, m_name + " - Rebuild runnable graph", "compile" };
+		runnable.rebuild( std::move( nodes )
+			, std::move( root ) );
+	}
+
 	LayoutState FrameGraph::getFinalLayoutState( ImageId image
 		, ImageViewType viewType
 		, ImageSubresourceRange const & range )const
@@ -482,6 +565,75 @@ namespace crg
 		return m_outputs.images;
 	}
 
+	uint64_t FrameGraph::getStructuralHash()const
+	{
+		return cache::computeHash( doListPasses(), m_passCulling, m_outputs, m_passScheduling );
+	}
+
+	FramePassArray FrameGraph::doListPasses()const
+	{
+		FramePassArray result;
+		m_defaultGroup->listPasses( result );
+
+		if ( result.empty() )
+		{
+			Logger::logWarning( "No FramePass registered." );
+			CRG_Exception( "No FramePass registered." );
+		}
+
+		return result;
+	}
+
+	size_t FrameGraph::doBuildGraph( GraphContext const & context
+		, FramePassArray const & passes
+		, RootNode & root
+		, GraphNodePtrArray & nodes )const
+	{
+		auto endPoints = builder::findEndPoints( passes );
+
+		if ( m_passCulling )
+			builder::cullEndPoints( passes, endPoints, m_outputs );
+
+		return builder::buildGraph( endPoints, root, nodes, context.separateDepthStencilLayouts, m_passScheduling );
+	}
+
+	void FrameGraph::doReport( FramePassArray const & passes
+		, GraphNodePtrArray const & nodes
+		, size_t depthFirstTransitionCount
+		, bool loadedFromCache )
+	{
+		std::unordered_set< FramePass const * > compiled;
+
+		for ( auto & node : nodes )
+		{
+			if ( node->getKind() == GraphNode::Kind::FramePass )
+				compiled.insert( &nodeCast< FramePassNode >( *node ).getFramePass() );
+		}
+
+		m_compileReport.culledPasses.clear();
+
+		for ( auto pass : passes )
+		{
+			if ( m_passCulling
+				&& compiled.find( pass ) == compiled.end() )
+			{
+				Logger::logInfo( m_name + " - Culled pass [" + pass->getFullName() + "]" );
+				m_compileReport.culledPasses.push_back( pass );
+			}
+		}
+
+		m_compileReport.transitionCount = builder::countTransitions( nodes );
+		m_compileReport.depthFirstTransitionCount = depthFirstTransitionCount;
+		m_compileReport.loadedFromCache = loadedFromCache;
+
+		if ( m_passScheduling == PassScheduling::eMinimiseTransitions
+			&& depthFirstTransitionCount )
+		{
+			Logger::logInfo( m_name + " - Scheduled passes need " + std::to_string( m_compileReport.transitionCount )
+				+ " transitions, instead of " + std::to_string( depthFirstTransitionCount ) );
+		}
+	}
+
 	void FrameGraph::registerFinalState( RecordContext const & context )
 	{
 		m_finalState = context;
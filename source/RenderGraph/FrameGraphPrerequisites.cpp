@@ -3,6 +3,7 @@
 #include "RenderGraph/BufferViewData.hpp"
 #include "RenderGraph/ImageData.hpp"
 #include "RenderGraph/ImageViewData.hpp"
+#include "RenderGraph/LayerLayoutStates.hpp"
 
 #include <cassert>
 
@@ -728,65 +729,14 @@ namespace crg
 		, ImageSubresourceRange const & range
 		, LayoutState const & newLayout )
 	{
-		for ( uint32_t layerIdx = 0u; layerIdx < range.layerCount; ++layerIdx )
-		{
-			auto & layers = ranges.try_emplace( range.baseArrayLayer + layerIdx ).first->second;
-
-			for ( uint32_t levelIdx = 0u; levelIdx < range.levelCount; ++levelIdx )
-			{
-				layers.insert_or_assign( range.baseMipLevel + levelIdx, newLayout );
-			}
-		}
-
+		ranges.setLayoutState( range, newLayout );
 		return newLayout;
 	}
 
-	static void gatherSubresourceRangeLayoutMips( ImageSubresourceRange const & range
-		, MipLayoutStates const & layers
-		, std::map< ImageLayout, LayoutState > & states )
-	{
-		for ( uint32_t levelIdx = 0u; levelIdx < range.levelCount; ++levelIdx )
-		{
-			if ( auto it = layers.find( range.baseMipLevel + levelIdx );
-				it != layers.end() )
-			{
-				auto state = it->second;
-				auto [rit, res] = states.emplace( state.layout, state );
-
-				if ( !res )
-				{
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wnull-dereference"
-					rit->second.state.access |= state.state.access;
-#pragma GCC diagnostic pop
-				}
-			}
-		}
-	}
-
 	LayoutState getSubresourceRangeLayout( LayerLayoutStates const & ranges
 		, ImageSubresourceRange const & range )
 	{
-		std::map< ImageLayout, LayoutState > states;
-
-		for ( uint32_t layerIdx = 0u; layerIdx < range.layerCount; ++layerIdx )
-		{
-			if ( auto layerIt = ranges.find( range.baseArrayLayer + layerIdx );
-				layerIt != ranges.end() )
-			{
-				auto & layers = layerIt->second;
-				gatherSubresourceRangeLayoutMips( range, layers, states );
-			}
-		}
-
-		if ( states.empty() )
-		{
-			return { ImageLayout::eUndefined
-				, getAccessMask( ImageLayout::eUndefined )
-				, getStageMask( ImageLayout::eUndefined ) };
-		}
-
-		return states.begin()->second;
+		return ranges.getLayoutState( range );
 	}
 
 	ImageSubresourceRange getVirtualRange( ImageId const & image
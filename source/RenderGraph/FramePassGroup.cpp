@@ -8,6 +8,7 @@ See LICENSE file in root folder.
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/FrameGraph.hpp"
 
+#include <algorithm>
 #include <numeric>
 #include <array>
 
@@ -22,25 +23,65 @@ namespace crg
 			return group;
 		}
 
-		static uint32_t countPasses( FramePassGroup const * group )
+		static uint32_t countGroups( FramePassGroup const * group )
 		{
 			return std::accumulate( group->getGroups().begin()
 				, group->getGroups().end()
-				, uint32_t( group->getPasses().size() )
+				, uint32_t( group->getGroups().size() )
 				, []( uint32_t val, FramePassGroupPtr const & lookup )
 				{
-					return val + countPasses( lookup.get() );
+					return val + countGroups( lookup.get() );
 				} );
 		}
 
-		static uint32_t countGroups( FramePassGroup const * group )
+		static bool isParent( FramePass const & pass
+			, FramePass const & consumer
+			, Attachment const * attach )
 		{
-			return std::accumulate( group->getGroups().begin()
-				, group->getGroups().end()
-				, uint32_t( group->getGroups().size() )
-				, []( uint32_t val, FramePassGroupPtr const & lookup )
+			auto parent = consumer.getParentAttachment( *attach );
+			return parent && parent->pass == &pass;
+		}
+
+		template< typename AttachT >
+		static bool isParent( FramePass const & pass
+			, FramePass const & consumer
+			, std::map< uint32_t, AttachT > const & attaches )
+		{
+			return std::any_of( attaches.begin()
+				, attaches.end()
+				, [&pass, &consumer]( auto const & lookup )
 				{
-					return val + countGroups( lookup.get() );
+					if constexpr ( std::is_same_v< AttachT, FramePass::SampledAttachment > )
+						return isParent( pass, consumer, lookup.second.attach );
+					else
+						return isParent( pass, consumer, lookup.second );
+				} );
+		}
+		/**
+		*\return
+		*	\p true if an attachment of another pass of the graph was created from one of \p pass attachments.
+		*/
+		static bool isConsumed( FramePass const & pass
+			, FramePassGroup const & group )
+		{
+			FramePassArray passes;
+			getOutermost( &group )->listPasses( passes );
+			return std::any_of( passes.begin()
+				, passes.end()
+				, [&pass]( FramePass const * consumer )
+				{
+					return consumer != &pass
+						&& ( isParent( pass, *consumer, consumer->getUniforms() )
+							|| isParent( pass, *consumer, consumer->getSampled() )
+							|| isParent( pass, *consumer, consumer->getInputs() )
+							|| isParent( pass, *consumer, consumer->getInouts() )
+							|| isParent( pass, *consumer, consumer->getOutputs() )
+							|| std::any_of( consumer->getTargets().begin()
+								, consumer->getTargets().end()
+								, [&pass, consumer]( Attachment const * attach )
+								{
+									return isParent( pass, *consumer, attach );
+								} ) );
 				} );
 		}
 	}
@@ -75,10 +116,14 @@ namespace crg
 			CRG_Exception( "Duplicate FramePass name detected." );
 		}
 
-		auto count = group::countPasses( group::getOutermost( this ) );
+		// Pass IDs are never reused, even after a pass removal,
+		// so that a RunnableGraph can tell a new pass from a removed one.
+		auto outermost = this;
+		while ( outermost->m_parent )
+			outermost = outermost->m_parent;
 		m_passes.emplace_back( new FramePass{ *this
 			, m_graph
-			, count + 1u
+			, ++outermost->m_lastPassId
 			, passName
 			, std::move( runnableCreator ) } );
 		return *m_passes.back();
@@ -103,6 +148,30 @@ namespace crg
 		return **it;
 	}
 
+	void FramePassGroup::removePass( std::string const & passName )
+	{
+		auto it = std::find_if( m_passes.begin()
+			, m_passes.end()
+			, [&passName]( FramePassPtr const & lookup )
+			{
+				return lookup->getName() == passName;
+			} );
+
+		if ( it == m_passes.end() )
+		{
+			Logger::logWarning( "Unknown FramePass name." );
+			CRG_Exception( "Unknown FramePass name." );
+		}
+
+		if ( group::isConsumed( **it, *this ) )
+		{
+			Logger::logWarning( "Can't remove a FramePass whose attachments are used by other passes." );
+			CRG_Exception( "Can't remove a FramePass whose attachments are used by other passes." );
+		}
+
+		m_passes.erase( it );
+	}
+
 	bool FramePassGroup::hasPass( std::string const & passName )const
 	{
 		return m_passes.end() != std::find_if( m_passes.begin()
@@ -157,6 +226,11 @@ namespace crg
 		return m_graph.createImage( img );
 	}
 
+	ImageId FramePassGroup::createTransientImage( ImageData const & img )const
+	{
+		return m_graph.createTransientImage( img );
+	}
+
 	ImageViewId FramePassGroup::createView( ImageViewData const & view )const
 	{
 		return m_graph.createView( view );
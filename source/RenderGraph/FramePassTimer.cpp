@@ -1,6 +1,7 @@
 #include "RenderGraph/FramePassTimer.hpp"
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/Log.hpp"
+#include "RenderGraph/TraceRecorder.hpp"
 
 #include <cassert>
 
@@ -8,6 +9,30 @@ namespace crg
 {
 	using namespace std::literals::chrono_literals;
 
+	namespace fpstmr
+	{
+		static Nanoseconds getDuration( uint64_t begin
+			, uint64_t end
+			, float period )
+		{
+			// The timestamp period is given in nanoseconds per tick.
+			return Nanoseconds{ uint64_t( double( end - begin ) * double( period ) ) };
+		}
+
+		static std::string getCategory( TimerScope scope )
+		{
+			switch ( scope )
+			{
+			case TimerScope::eGraph:
+				return "graph";
+			case TimerScope::ePass:
+				return "pass";
+			default:
+				return "update";
+			}
+		}
+	}
+
 	//*********************************************************************************************
 
 	FramePassTimerBlock::FramePassTimerBlock( FramePassTimer & timer )
@@ -35,15 +60,16 @@ namespace crg
 		, std::string const & name
 		, TimerScope scope
 		, VkQueryPool timerQueries
-		, uint32_t & baseQueryOffset )
+		, uint32_t & baseQueryOffset
+		, uint32_t frameCount )
 		: m_context{ context }
 		, m_scope{ scope }
 		, m_name{ name }
 		, m_colour{ context.getNextRainbowColour() }
-		, m_timerQueries{ timerQueries }
-		, m_queries{ { { baseQueryOffset, false, false }, { baseQueryOffset + 2u, false, false } } }
+		, m_cpuHistory{ context.timerHistorySize, context.timerHitchThreshold }
+		, m_gpuHistory{ context.timerHistorySize, context.timerHitchThreshold }
 	{
-		baseQueryOffset += 4u;
+		setQueryPool( timerQueries, baseQueryOffset, frameCount );
 	}
 
 	FramePassTimer::FramePassTimer( GraphContext & context
@@ -53,9 +79,11 @@ namespace crg
 		, m_scope{ scope }
 		, m_name{ name }
 		, m_colour{ context.getNextRainbowColour() }
-		, m_timerQueries{ createQueryPool( context, name, 4u ) }
+		, m_cpuHistory{ context.timerHistorySize, context.timerHitchThreshold }
+		, m_gpuHistory{ context.timerHistorySize, context.timerHitchThreshold }
+		, m_timerQueries{ createQueryPool( context, name, 2u ) }
 		, m_ownPool{ true }
-		, m_queries{ { { 0u, false, false }, { 2u, false, false } } }
+		, m_queries{ Query{ 0u, false, false, 0u } }
 	{
 	}
 
@@ -87,20 +115,47 @@ namespace crg
 
 	void FramePassTimer::notifyPassRender( [[maybe_unused]] uint32_t passIndex )noexcept
 	{
-		auto & query = m_queries.front();
+		auto & query = m_queries[m_frameIndex];
+		doRetireQuery( query );
 		query.started = true;
+		query.frameId = m_frameId;
+		query.submitted = ++m_submission;
+	}
+
+	void FramePassTimer::notifyPassReplay()noexcept
+	{
+		auto & query = m_queries[m_frameIndex];
+		query.written = true;
 	}
 
 	void FramePassTimer::stop()noexcept
 	{
 		auto current = Clock::now();
 		m_cpuTime += ( current - m_cpuSaveTime );
+
+		if ( auto recorder = m_context.traceRecorder )
+		{
+			try
+			{
+				recorder->addCpuEvent( m_name
+					, fpstmr::getCategory( m_scope )
+					, m_tracePath
+					, m_frameId
+					, m_cpuSaveTime
+					, current );
+			}
+			catch ( ... )
+			{
+				// Nothing to do here
+			}
+		}
 	}
 
 	void FramePassTimer::reset()noexcept
 	{
 		m_cpuTime = 0ns;
 		m_gpuTime = 0ns;
+		m_sampledCpuTime = 0ns;
 	}
 
 	void FramePassTimer::beginPass( VkCommandBuffer commandBuffer
@@ -113,8 +168,7 @@ namespace crg
 			, { "[" + std::to_string( passId ) + "] " + groupName
 			, m_colour } );
 #pragma GCC diagnostic pop
-		std::swap( m_queries.front(), m_queries.back() );
-		auto const & query = m_queries.front();
+		auto const & query = m_queries[m_frameIndex];
 		m_context.vkCmdResetQueryPool( commandBuffer
 			, m_timerQueries
 			, query.offset
@@ -127,7 +181,7 @@ namespace crg
 
 	void FramePassTimer::endPass( VkCommandBuffer commandBuffer )noexcept
 	{
-		auto & query = m_queries.front();
+		auto & query = m_queries[m_frameIndex];
 		m_context.vkCmdWriteTimestamp( commandBuffer
 			, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
 			, m_timerQueries
@@ -138,12 +192,72 @@ namespace crg
 
 	void FramePassTimer::retrieveGpuTime()noexcept
 	{
-		static float const period = m_context.properties.limits.timestampPeriod;
-
 		auto before = Clock::now();
+		auto retrieved = m_context.nonBlockingTimers
+			? doRetrieveAvailableGpuTime()
+			: doRetrieveGpuTime();
+
+		// One sample per retrieval, the CPU one being the time spent since the previous retrieval.
+		auto cpuTime = m_cpuTime - m_sampledCpuTime;
+		m_sampledCpuTime = m_cpuTime;
+		m_cpuHistory.push( cpuTime );
+
+		if ( m_cpuScopeHistory )
+			m_cpuScopeHistory->push( cpuTime );
+
+		if ( retrieved )
+		{
+			m_gpuHistory.push( m_gpuTime );
+
+			if ( m_gpuScopeHistory )
+				m_gpuScopeHistory->push( m_gpuTime );
+		}
+
+		auto after = Clock::now();
+		m_cpuTime += ( after - before );
+	}
+
+	void FramePassTimer::setQueryPool( VkQueryPool timerQueries
+		, uint32_t & baseQueryOffset
+		, uint32_t frameCount )noexcept
+	{
+		assert( !m_ownPool );
+		m_timerQueries = timerQueries;
+		m_queries.clear();
+		m_frameIndex = 0u;
+
+		for ( uint32_t index = 0u; index < frameCount; ++index )
+		{
+			m_queries.push_back( { baseQueryOffset, false, false, 0u } );
+			baseQueryOffset += 2u;
+		}
+	}
+
+	void FramePassTimer::setFrameIndex( uint32_t frameIndex
+		, uint64_t frameId )noexcept
+	{
+		m_frameIndex = frameIndex % uint32_t( m_queries.size() );
+		m_frameId = frameId;
+	}
+
+	void FramePassTimer::setScopeHistories( TimerHistory * cpuHistory
+		, TimerHistory * gpuHistory )noexcept
+	{
+		m_cpuScopeHistory = cpuHistory;
+		m_gpuScopeHistory = gpuHistory;
+	}
+
+	void FramePassTimer::setTracePath( std::string path )
+	{
+		m_tracePath = std::move( path );
+	}
+
+	bool FramePassTimer::doRetrieveGpuTime()noexcept
+	{
+		bool result{};
 		m_gpuTime = 0ns;
 
-		if ( auto & query = m_queries.front(); query.started && query.written )
+		if ( auto & query = m_queries[m_frameIndex]; query.started && query.written )
 		{
 			std::array< uint64_t, 2u > values{ 0u, 0u };
 			m_context.vkGetQueryPoolResults( m_context.device
@@ -154,16 +268,134 @@ namespace crg
 				, values.data()
 				, sizeof( uint64_t )
 				, VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_64_BIT );
+			m_gpuTime += fpstmr::getDuration( values[0], values[1], m_context.timestampPeriod );
+			m_gpuTimeFrameId = query.frameId;
+			doTraceGpuTime( values[0], values[1], query.frameId );
+			result = true;
+
+			query.started = false;
+			query.written = false;
+		}
+
+		return result;
+	}
+
+	bool FramePassTimer::doRetrieveAvailableGpuTime()noexcept
+	{
+		// Each frame in flight has its own queries, the results of the frames still executed are read later.
+		bool found{};
+		auto report = [this, &found]( uint64_t begin
+			, uint64_t end
+			, uint64_t frameId )
+		{
+			doTraceGpuTime( begin, end, frameId );
+
+			if ( !found || frameId > m_gpuTimeFrameId )
+			{
+				m_gpuTime = fpstmr::getDuration( begin, end, m_context.timestampPeriod );
+				m_gpuTimeFrameId = frameId;
+				found = true;
+			}
+		};
+
+		for ( auto & query : m_queries )
+		{
+			if ( query.retired )
+			{
+				report( query.retiredValues[0], query.retiredValues[1], query.retiredFrameId );
+				query.retired = false;
+			}
+
+			// Without host reset, the available results may still be the previous submission's ones, they are read when the queries are reused.
+			if ( !query.started || !query.written || !query.hostReset )
+				continue;
 
-			auto gpuTime = Nanoseconds{ uint64_t( float( values[1] - values[0] ) / period ) };
-			m_gpuTime += gpuTime;
+			// Timestamp and availability, for each query.
+			std::array< uint64_t, 4u > values{ 0u, 0u, 0u, 0u };
+			auto res = m_context.vkGetQueryPoolResults( m_context.device
+				, m_timerQueries
+				, query.offset
+				, 2u
+				, sizeof( uint64_t ) * values.size()
+				, values.data()
+				, sizeof( uint64_t ) * 2u
+				, VK_QUERY_RESULT_WITH_AVAILABILITY_BIT | VK_QUERY_RESULT_64_BIT );
 
+			if ( ( res != VK_SUCCESS && res != VK_NOT_READY )
+				|| values[1] == 0u
+				|| values[3] == 0u )
+				continue;
+
+			report( values[0], values[2], query.frameId );
 			query.started = false;
 			query.written = false;
 		}
 
-		auto after = Clock::now();
-		m_cpuTime += ( after - before );
+		return found;
+	}
+
+	void FramePassTimer::doRetireQuery( Query & query )noexcept
+	{
+		// The graph waited for the submission previously using the queries, their unread results are final.
+		// The queries never submitted were never reset on the device, they can't be read.
+		if ( query.submitted != 0u && query.started && query.written )
+		{
+			std::array< uint64_t, 4u > values{ 0u, 0u, 0u, 0u };
+			auto res = m_context.vkGetQueryPoolResults( m_context.device
+				, m_timerQueries
+				, query.offset
+				, 2u
+				, sizeof( uint64_t ) * values.size()
+				, values.data()
+				, sizeof( uint64_t ) * 2u
+				, VK_QUERY_RESULT_WITH_AVAILABILITY_BIT | VK_QUERY_RESULT_64_BIT );
+
+			if ( ( res == VK_SUCCESS || res == VK_NOT_READY )
+				&& values[1] != 0u
+				&& values[3] != 0u )
+			{
+				query.retired = true;
+				query.retiredValues = { values[0], values[2] };
+				query.retiredFrameId = query.frameId;
+			}
+		}
+
+		query.started = false;
+		query.hostReset = false;
+
+#if VK_VERSION_1_2
+		if ( m_context.hasHostQueryReset() )
+		{
+			m_context.vkResetQueryPool( m_context.device
+				, m_timerQueries
+				, query.offset
+				, 2u );
+			query.hostReset = true;
+		}
+#endif
+	}
+
+	void FramePassTimer::doTraceGpuTime( uint64_t begin
+		, uint64_t end
+		, uint64_t frameId )noexcept
+	{
+		if ( auto recorder = m_context.traceRecorder )
+		{
+			try
+			{
+				recorder->addGpuEvent( m_name
+					, fpstmr::getCategory( m_scope )
+					, m_tracePath
+					, frameId
+					, begin
+					, end
+					, m_context.timestampPeriod );
+			}
+			catch ( ... )
+			{
+				// Nothing to do here
+			}
+		}
 	}
 
 	//*********************************************************************************************
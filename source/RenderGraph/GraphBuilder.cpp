@@ -6,9 +6,17 @@ See LICENSE file in root folder.
 
 #include "RenderGraph/FramePass.hpp"
 #include "RenderGraph/GraphNode.hpp"
+#include "RenderGraph/Hash.hpp"
+#include "RenderGraph/LayerLayoutStatesHandler.hpp"
 #include "RenderGraph/Log.hpp"
 
 #include <algorithm>
+#include <cassert>
+#include <deque>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace crg::builder
 {
@@ -52,14 +60,6 @@ namespace crg::builder
 				listBuffersRec( *source.attach, pass, result );
 		}
 
-		static BufferViewIdArray listBuffers( Attachment const & attach
-			, FramePass const * pass )
-		{
-			BufferViewIdArray result;
-			listBuffersRec( attach, pass, result );
-			return result;
-		}
-
 		static void listImagesRec( Attachment const & attach
 			, FramePass const * pass
 			, ImageViewIdArray & result )
@@ -72,75 +72,152 @@ namespace crg::builder
 				listImagesRec( *source.attach, pass, result );
 		}
 
-		static ImageViewIdArray listImages( Attachment const & attach
-			, FramePass const * pass )
+		/**
+		*\brief
+		*	Indexes the attaches used as parent by the passes' own attaches,
+		*	so that a lookup doesn't need to traverse all the passes.
+		*/
+		class ParentAttachIndex
 		{
-			ImageViewIdArray result;
-			listImagesRec( attach, pass, result );
-			return result;
-		}
-
-		static bool isBufferAttachParent( Attachment const & parent, Attachment const & attach )
-		{
-			auto parentBuffers = listBuffers( parent, attach.pass );
-			auto attachBuffers = listBuffers( attach, nullptr );
-			return std::any_of( attachBuffers.begin(), attachBuffers.end()
-				, [&parentBuffers]( BufferViewId const & lookup )
+		public:
+			explicit ParentAttachIndex( FramePassArray const & passes )
+			{
+				for ( auto pass : passes )
 				{
-					return parentBuffers.end() != std::find( parentBuffers.begin(), parentBuffers.end(), lookup );
-				} );
-		}
+					for ( auto const & [_, own] : *pass )
+					{
+						if ( own.parent )
+							addParent( *own.parent, pass );
+					}
+				}
+			}
 
-		static bool isImageAttachParent( Attachment const & parent, Attachment const & attach )
-		{
-			auto parentBuffers = listImages( parent, attach.pass );
-			auto attachBuffers = listImages( attach, nullptr );
-			return std::any_of( attachBuffers.begin(), attachBuffers.end()
-				, [&parentBuffers]( ImageViewId const & lookup )
+			bool isParentForOtherPass( Attachment const & attach )const
+			{
+				if ( hasOtherUser( m_parents, &attach, attach.pass ) )
+					return true;
+
+				if ( attach.isBuffer() )
 				{
-					return parentBuffers.end() != std::find( parentBuffers.begin(), parentBuffers.end(), lookup );
-				} );
-		}
+					BufferViewIdArray views;
+					listBuffersRec( attach, nullptr, views );
+					return std::any_of( views.begin(), views.end()
+						, [this, &attach]( BufferViewId const & view )
+						{
+							return isViewParentForOtherPass( true, view.id, attach.pass );
+						} );
+				}
 
-		static bool isAttachParent( Attachment const * parent, Attachment const * attach )
-		{
-			if ( bool result = ( parent == attach );
-				result || !parent )
-				return result;
+				ImageViewIdArray views;
+				listImagesRec( attach, nullptr, views );
+				return std::any_of( views.begin(), views.end()
+					, [this, &attach]( ImageViewId const & view )
+					{
+						return isViewParentForOtherPass( false, view.id, attach.pass );
+					} );
+			}
 
-			if ( attach->isBuffer() != parent->isBuffer() )
-				return false;
+		private:
+			using PassSet = std::unordered_set< FramePass const * >;
 
-			if ( attach->isBuffer() )
-				return isBufferAttachParent( *parent, *attach );
+			struct ViewKey
+			{
+				bool isBuffer;
+				uint32_t view;
+				FramePass const * pass;
 
-			return isImageAttachParent( *parent, *attach );
-		}
+				friend bool operator==( ViewKey const & lhs, ViewKey const & rhs ) = default;
+			};
 
-		static bool isParentAttachForPass( Attachment const * attach, FramePass const * pass )
-		{
-			return pass->end() != std::find_if( pass->begin(), pass->end()
-				, [&attach]( auto const & lookup )
+			struct ViewKeyHasher
+			{
+				size_t operator()( ViewKey const & key )const noexcept
 				{
-					return isAttachParent( lookup.second.parent, attach );
-				} );
-		}
+					auto hash = std::hash< FramePass const * >{}( key.pass );
+					hash = hashCombine( hash, key.view );
+					return hashCombine( hash, key.isBuffer );
+				}
+			};
+
+			template< typename KeyT, typename MapT >
+			static bool hasOtherUser( MapT const & map
+				, KeyT const & key
+				, FramePass const * pass )
+			{
+				auto it = map.find( key );
+				return it != map.end()
+					&& std::any_of( it->second.begin(), it->second.end()
+						, [pass]( FramePass const * user )
+						{
+							return user != pass;
+						} );
+			}
+
+			void addParent( Attachment const & parent
+				, FramePass const * user )
+			{
+				m_parents[&parent].insert( user );
+				addParentViews( parent, parent.isBuffer(), user );
+			}
+
+			void addParentViews( Attachment const & parent
+				, bool isBuffer
+				, FramePass const * user )
+			{
+				if ( parent.source.empty() )
+				{
+					if ( isBuffer )
+					{
+						for ( auto & view : parent.bufferAttach.buffers )
+							addView( true, view.id, parent.pass, user );
+					}
+					else
+					{
+						for ( auto & view : parent.imageAttach.views )
+							addView( false, view.id, parent.pass, user );
+					}
+				}
+
+				for ( auto const & source : parent.source )
+					addParentViews( *source.attach, isBuffer, user );
+			}
+
+			void addView( bool isBuffer
+				, uint32_t view
+				, FramePass const * pass
+				, FramePass const * user )
+			{
+				m_views[ViewKey{ isBuffer, view, pass }].insert( user );
+				m_anyPassViews[ViewKey{ isBuffer, view, nullptr }].insert( user );
+			}
+
+			bool isViewParentForOtherPass( bool isBuffer
+				, uint32_t view
+				, FramePass const * pass )const
+			{
+				// A pass-less attach matches the parent views whatever their pass.
+				if ( !pass )
+					return hasOtherUser( m_anyPassViews, ViewKey{ isBuffer, view, nullptr }, pass );
+
+				return hasOtherUser( m_views, ViewKey{ isBuffer, view, pass }, pass );
+			}
+
+		private:
+			std::unordered_map< Attachment const *, PassSet > m_parents;
+			std::unordered_map< ViewKey, PassSet, ViewKeyHasher > m_views;
+			std::unordered_map< ViewKey, PassSet, ViewKeyHasher > m_anyPassViews;
+		};
 
 		static void listNonParentAttachs( FramePassArray const & passes
 			, AttachmentArray const & allAttachs
 			, AttachmentArray & result )
 		{
+			ParentAttachIndex index{ passes };
+
 			for ( auto attach : allAttachs )
 			{
-				if ( std::none_of( passes.begin(), passes.end()
-					, [&attach]( FramePass const * pass )
-					{
-						return attach->pass != pass
-							&& isParentAttachForPass( attach, pass );
-					} ) )
-				{
+				if ( !index.isParentForOtherPass( *attach ) )
 					addAttach( *attach, result );
-				}
 			}
 		}
 
@@ -181,6 +258,44 @@ namespace crg::builder
 				}
 		}
 
+		static bool isGraphOutput( ImageViewId view
+			, LayerLayoutStatesHandler const & outputs )
+		{
+			if ( view.data->source.empty() )
+				return outputs.getLayoutState( view ).layout != ImageLayout::eUndefined;
+
+			return std::any_of( view.data->source.begin()
+				, view.data->source.end()
+				, [&outputs]( ImageViewId const & source )
+				{
+					return isGraphOutput( source, outputs );
+				} );
+		}
+
+		static bool isGraphOutput( Attachment const & attach
+			, LayerLayoutStatesHandler const & outputs )
+		{
+			if ( !attach.isOutput() )
+				return false;
+
+			for ( uint32_t index = 0u; index < attach.getViewCount(); ++index )
+			{
+				if ( isGraphOutput( attach.view( index ), outputs ) )
+					return true;
+			}
+
+			return false;
+		}
+
+		static void addConsumed( Attachment const & parent
+			, std::unordered_set< Attachment const * > & result )
+		{
+			result.insert( &parent );
+
+			for ( auto & source : parent.source )
+				addConsumed( *source.attach, result );
+		}
+
 		static AttachmentArray listPassOutputs( FramePass const & pass )
 		{
 			AttachmentArray result;
@@ -195,28 +310,58 @@ namespace crg::builder
 		}
 
 		static bool areAllPassAttachsListed( FramePass const & pass
-			, AttachmentArray const & result )
+			, std::unordered_map< Attachment const *, uint32_t > const & listed )
 		{
 			auto passOutputs = listPassOutputs( pass );
 			return std::all_of( passOutputs.begin(), passOutputs.end()
-				, [&result]( Attachment const * lookup )
+				, [&listed]( Attachment const * lookup )
 				{
-
-					return result.end() != std::find( result.begin(), result.end(), lookup );
+					auto it = listed.find( lookup );
+					return it != listed.end() && it->second > 0u;
 				} );
 		}
 
 		static void removeMismatchs( AttachmentArray & result )
 		{
-			auto it = result.begin();
+			struct PassCheck
+			{
+				bool valid;
+				uint32_t removedCount;
+			};
+			// Count the listed attaches, to be able to look them up while removing some of them.
+			std::unordered_map< Attachment const *, uint32_t > listed;
+			listed.reserve( result.size() );
+			for ( auto attach : result )
+				++listed[attach];
+
+			// A pass check stays valid as long as no attach has been removed since it was computed.
+			std::unordered_map< FramePass const *, PassCheck > checks;
+			uint32_t removedCount{};
+			std::vector< bool > removed( result.size(), false );
+
+			for ( size_t index = 0u; index < result.size(); ++index )
+			{
+				auto attach = result[index];
+				auto [it, inserted] = checks.try_emplace( attach->pass, PassCheck{ false, removedCount } );
+
+				if ( inserted || ( it->second.valid && it->second.removedCount != removedCount ) )
+					it->second = PassCheck{ areAllPassAttachsListed( *attach->pass, listed ), removedCount };
+
+				if ( !it->second.valid )
+				{
+					removed[index] = true;
+					--listed[attach];
+					++removedCount;
+				}
+			}
 
-			while ( it != result.end() )
+			size_t kept{};
+			for ( size_t index = 0u; index < result.size(); ++index )
 			{
-				if ( !areAllPassAttachsListed( *( *it )->pass, result ) )
-					it = result.erase( it );
-				else
-					++it;
+				if ( !removed[index] )
+					result[kept++] = result[index];
 			}
+			result.resize( kept );
 		}
 	}
 
@@ -325,45 +470,46 @@ namespace crg::builder
 			return areOverlapping( *lhs.buffer().data, *rhs.buffer().data );
 		}
 
-		void traverseAttachmentPasses( GraphNode & parent
-			, Attachment const * currentAttach
-			, Attachment const * parentAttach
-			, AttachmentTransitions & transitions
-			, GraphNodePtrArray & nodes );
+		using AttachPair = std::pair< Attachment const *, Attachment const * >;
+		using AttachPairArray = std::vector< AttachPair >;
 
-		static void traversePassAttach( FramePassNode & node, std::map< uint32_t, Attachment const * > const & attachments
-			, AttachmentTransitions & transitions
-			, GraphNodePtrArray & nodes )
+		static void listPassAttachs( FramePassNode const & node, std::map< uint32_t, Attachment const * > const & attachments
+			, AttachPairArray & result )
 		{
 			for ( auto [binding, attach] : attachments )
-				traverseAttachmentPasses( node
-					, node.getFramePass().getParentAttachment( *attach ), attach
-					, transitions, nodes );
+				result.emplace_back( node.getFramePass().getParentAttachment( *attach ), attach );
 		}
 
-		static void traversePassAttach( FramePassNode & node, std::map< uint32_t, FramePass::SampledAttachment > const & attachments
-			, AttachmentTransitions & transitions
-			, GraphNodePtrArray & nodes )
+		static void listPassAttachs( FramePassNode const & node, std::map< uint32_t, FramePass::SampledAttachment > const & attachments
+			, AttachPairArray & result )
 		{
 			for ( auto const & [binding, attach] : attachments )
-				traverseAttachmentPasses( node
-					, node.getFramePass().getParentAttachment( *attach.attach ), attach.attach
-					, transitions, nodes );
+				result.emplace_back( node.getFramePass().getParentAttachment( *attach.attach ), attach.attach );
 		}
 
-		static void traversePassAttach( FramePassNode & node, AttachmentArray const & targets, Attachment::Flag flag
-			, AttachmentTransitions & transitions
-			, GraphNodePtrArray & nodes )
+		static void listPassAttachs( FramePassNode const & node, AttachmentArray const & targets, Attachment::Flag flag
+			, AttachPairArray & result )
 		{
 			for ( auto attach : targets )
 			{
 				if ( attach->hasFlag( flag ) )
-					traverseAttachmentPasses( node
-						, node.getFramePass().getParentAttachment( *attach ), attach
-						, transitions, nodes );
+					result.emplace_back( node.getFramePass().getParentAttachment( *attach ), attach );
 			}
 		}
 
+		static AttachPairArray listPassAttachs( FramePassNode const & node )
+		{
+			auto & pass = node.getFramePass();
+			AttachPairArray result;
+			listPassAttachs( node, pass.getTargets(), Attachment::Flag::InOut, result );
+			listPassAttachs( node, pass.getInouts(), result );
+			listPassAttachs( node, pass.getUniforms(), result );
+			listPassAttachs( node, pass.getSampled(), result );
+			listPassAttachs( node, pass.getInputs(), result );
+			listPassAttachs( node, pass.getTargets(), Attachment::Flag::Input, result );
+			return result;
+		}
+
 		static void insertTransition( bool isImage
 			, Attachment const * output
 			, Attachment const * input
@@ -389,41 +535,10 @@ namespace crg::builder
 			}
 		}
 
-		void traverseAttachmentPasses( GraphNode & parent
-			, Attachment const * outputAttach
+		static void insertTransitions( Attachment const * outputAttach
 			, Attachment const * inputAttach
-			, AttachmentTransitions & parentTransitions
-			, GraphNodePtrArray & nodes )
+			, AttachmentTransitions & transitions )
 		{
-			if ( outputAttach )
-			{
-				for ( auto pass : listAttachmentPasses( *outputAttach ) )
-				{
-					auto it = std::find_if( nodes.begin(), nodes.end()
-						, [&pass]( GraphNodePtr const & lookup )
-						{
-							return lookup->getName() == pass->getGroupName();
-						} );
-					if ( nodes.end() == it )
-					{
-						auto & node = static_cast< FramePassNode & >( *nodes.emplace_back( std::make_unique< FramePassNode >( *pass ) ) );
-						AttachmentTransitions transitions;
-						traversePassAttach( node, pass->getTargets(), Attachment::Flag::InOut, transitions, nodes );
-						traversePassAttach( node, pass->getInouts(), transitions, nodes );
-						traversePassAttach( node, pass->getUniforms(), transitions, nodes );
-						traversePassAttach( node, pass->getSampled(), transitions, nodes );
-						traversePassAttach( node, pass->getInputs(), transitions, nodes );
-						traversePassAttach( node, pass->getTargets(), Attachment::Flag::Input, transitions, nodes );
-						node.setTransitions( mergeIdenticalTransitions( std::move( transitions ) ) );
-						parent.attachNode( node );
-					}
-					else
-					{
-						parent.attachNode( **it );
-					}
-				}
-			}
-
 			if ( outputAttach && inputAttach )
 			{
 				auto outputs = splitAttach( *outputAttach );
@@ -433,7 +548,7 @@ namespace crg::builder
 					for ( auto input : inputs )
 					{
 						if ( areOverlapping( *output, *input ) )
-							insertTransition( output->isImage(), output, input, parentTransitions );
+							insertTransition( output->isImage(), output, input, transitions );
 					}
 				}
 			}
@@ -442,14 +557,129 @@ namespace crg::builder
 				// Attach to external
 				auto outputs = splitAttach( *outputAttach );
 				for ( auto output : outputs )
-					insertTransition( output->isImage(), output, nullptr, parentTransitions );
+					insertTransition( output->isImage(), output, nullptr, transitions );
 			}
 			else if ( inputAttach )
 			{
 				// External resource
 				auto inputs = splitAttach( *inputAttach );
 				for ( auto input : inputs )
-					insertTransition( input->isImage(), nullptr, input, parentTransitions );
+					insertTransition( input->isImage(), nullptr, input, transitions );
+			}
+		}
+		/**
+		*\brief
+		*	The nodes created during the traversal, indexed by name.
+		*/
+		struct GraphNodes
+		{
+			explicit GraphNodes( GraphNodePtrArray & nodes )
+				: nodes{ nodes }
+			{
+				for ( auto & node : nodes )
+					byName.try_emplace( node->getName(), node.get() );
+			}
+
+			GraphNode * find( std::string const & name )const
+			{
+				auto it = byName.find( name );
+				return it == byName.end()
+					? nullptr
+					: it->second;
+			}
+
+			FramePassNode & create( FramePass const & pass )
+			{
+				auto & node = static_cast< FramePassNode & >( *nodes.emplace_back( std::make_unique< FramePassNode >( pass ) ) );
+				byName.try_emplace( node.getName(), &node );
+				return node;
+			}
+
+			GraphNodePtrArray & nodes;
+			std::unordered_map< std::string_view, GraphNode * > byName;
+		};
+		/**
+		*\brief
+		*	One step of the attachment passes traversal.
+		*/
+		struct TraversalFrame
+		{
+			TraversalFrame( GraphNode & parent
+				, Attachment const * outputAttach
+				, Attachment const * inputAttach
+				, AttachmentTransitions & parentTransitions )
+				: parent{ &parent }
+				, outputAttach{ outputAttach }
+				, inputAttach{ inputAttach }
+				, parentTransitions{ &parentTransitions }
+				, passes{ outputAttach ? listAttachmentPasses( *outputAttach ) : FramePassArray{} }
+			{
+			}
+
+			GraphNode * parent;
+			Attachment const * outputAttach;
+			Attachment const * inputAttach;
+			AttachmentTransitions * parentTransitions;
+			FramePassArray passes;
+			size_t passIndex{};
+			// The node being built for passes[passIndex], and its attachs left to traverse.
+			FramePassNode * node{};
+			AttachmentTransitions transitions{};
+			AttachPairArray attachs{};
+			size_t attachIndex{};
+		};
+
+		static void traverseAttachmentPasses( GraphNode & root
+			, Attachment const * outputAttach
+			, Attachment const * inputAttach
+			, AttachmentTransitions & rootTransitions
+			, GraphNodes & nodes )
+		{
+			// Iterative depth first traversal, the deque keeps the frames' transitions addresses stable.
+			std::deque< TraversalFrame > stack;
+			stack.emplace_back( root, outputAttach, inputAttach, rootTransitions );
+
+			while ( !stack.empty() )
+			{
+				auto & frame = stack.back();
+
+				if ( frame.node )
+				{
+					if ( frame.attachIndex < frame.attachs.size() )
+					{
+						auto [output, input] = frame.attachs[frame.attachIndex++];
+						stack.emplace_back( *frame.node, output, input, frame.transitions );
+					}
+					else
+					{
+						frame.node->setTransitions( mergeIdenticalTransitions( std::move( frame.transitions ) ) );
+						frame.parent->attachNode( *frame.node );
+						frame.node = nullptr;
+						++frame.passIndex;
+					}
+				}
+				else if ( frame.passIndex < frame.passes.size() )
+				{
+					auto pass = frame.passes[frame.passIndex];
+
+					if ( auto node = nodes.find( pass->getGroupName() ) )
+					{
+						frame.parent->attachNode( *node );
+						++frame.passIndex;
+					}
+					else
+					{
+						frame.node = &nodes.create( *pass );
+						frame.transitions = {};
+						frame.attachs = listPassAttachs( *frame.node );
+						frame.attachIndex = 0u;
+					}
+				}
+				else
+				{
+					insertTransitions( frame.outputAttach, frame.inputAttach, *frame.parentTransitions );
+					stack.pop_back();
+				}
 			}
 		}
 
@@ -460,47 +690,62 @@ namespace crg::builder
 				, &child );
 		}
 
-		static void removeShortcuts( GraphNode & node )
+		static bool isShortcut( GraphAdjacentNodeArray const & predecessors
+			, size_t index )
 		{
-			GraphAdjacentNodeArray & predecessors = node.getPredecessors();
-			auto it = predecessors.begin();
+			auto curr = predecessors[index];
 
-			while ( it != predecessors.end() )
+			for ( size_t other = 0u; other < predecessors.size(); ++other )
 			{
-				auto curr = *it;
-				bool found = false;
-				auto oit = predecessors.begin();
-				while ( oit != predecessors.end() && !found )
-				{
-					if ( oit != it )
-						found = hasInPredecessors( **oit, *curr );
-					++oit;
-				}
-
-				removeShortcuts( *curr );
-				if ( found )
-					it = predecessors.erase( it );
-				else
-					++it;
+				if ( other != index
+					&& hasInPredecessors( *predecessors[other], *curr ) )
+					return true;
 			}
+
+			return false;
 		}
 
-		static void sortNodes( GraphNode & node
-			, GraphNodePtrArray & sourceGraph
-			, GraphNodePtrArray & targetGraph )
+		static void removeShortcuts( GraphNode & root )
 		{
-			for ( auto & pred : node.getPredecessors() )
-				sortNodes( *pred, sourceGraph, targetGraph );
+			// Predecessors lists only shrink, so processing a node a second time can't remove anything:
+			// each node is processed once, depth first.
+			struct Frame
+			{
+				GraphNode * node;
+				size_t index;
+				bool shortcut;
+				bool pending;
+			};
+			std::unordered_set< GraphNode const * > visited{ &root };
+			std::vector< Frame > stack{ Frame{ &root, 0u, false, false } };
+
+			while ( !stack.empty() )
+			{
+				auto & frame = stack.back();
+				auto & predecessors = frame.node->getPredecessors();
 
-			auto it = std::find_if( sourceGraph.begin(), sourceGraph.end()
-				, [&node]( GraphNodePtr const & lookup )
+				if ( frame.pending )
 				{
-					return &node == lookup.get();
-				} );
-			if ( sourceGraph.end() != it )
-			{
-				targetGraph.emplace_back( std::move( *it ) );
-				sourceGraph.erase( it );
+					frame.pending = false;
+
+					if ( frame.shortcut )
+						predecessors.erase( std::next( predecessors.begin(), std::ptrdiff_t( frame.index ) ) );
+					else
+						++frame.index;
+				}
+				else if ( frame.index < predecessors.size() )
+				{
+					auto curr = predecessors[frame.index];
+					frame.shortcut = isShortcut( predecessors, frame.index );
+					frame.pending = true;
+
+					if ( visited.insert( curr ).second )
+						stack.push_back( Frame{ curr, 0u, false, false } );
+				}
+				else
+				{
+					stack.pop_back();
+				}
 			}
 		}
 
@@ -509,8 +754,41 @@ namespace crg::builder
 		{
 			auto sourceGraph = std::move( graph );
 			graph.clear();
-			for ( auto & pred : root.getPredecessors() )
-				sortNodes( *pred, sourceGraph, graph );
+			std::unordered_map< GraphNode const *, size_t > sourceIndices;
+			sourceIndices.reserve( sourceGraph.size() );
+			for ( size_t index = 0u; index < sourceGraph.size(); ++index )
+				sourceIndices.try_emplace( sourceGraph[index].get(), index );
+
+			// Iterative post order traversal of the predecessors.
+			struct Frame
+			{
+				GraphNode * node;
+				size_t index;
+			};
+			std::unordered_set< GraphNode const * > visited{ &root };
+			std::vector< Frame > stack{ Frame{ &root, 0u } };
+
+			while ( !stack.empty() )
+			{
+				auto & frame = stack.back();
+				auto & predecessors = frame.node->getPredecessors();
+
+				if ( frame.index < predecessors.size() )
+				{
+					auto pred = predecessors[frame.index++];
+
+					if ( visited.insert( pred ).second )
+						stack.push_back( Frame{ pred, 0u } );
+				}
+				else
+				{
+					if ( auto it = sourceIndices.find( frame.node );
+						it != sourceIndices.end() )
+						graph.emplace_back( std::move( sourceGraph[it->second] ) );
+
+					stack.pop_back();
+				}
+			}
 		}
 
 		static void updateState( Attachment const & inputAttach
@@ -603,6 +881,265 @@ namespace crg::builder
 			}
 			AttachmentTransitions transitions;
 		}
+
+		template< typename TransitionT >
+		static size_t countNeededTransitions( std::vector< TransitionT > const & transitions
+			, AttachmentStates & states
+			, bool apply )
+		{
+			size_t result{};
+
+			for ( auto & transition : transitions )
+			{
+				if ( !isInNeededState( transition.inputAttach, states ) )
+				{
+					++result;
+
+					if ( apply )
+					{
+						if ( transition.inputAttach.isImage() )
+							updateState( transition.inputAttach, states.imageStates, states.separateDepthStencilLayouts );
+						else
+							updateState( transition.inputAttach, states.bufferStates );
+					}
+				}
+			}
+
+			return result;
+		}
+
+		static size_t countNeededTransitions( GraphNode const & node
+			, AttachmentStates & states
+			, bool apply )
+		{
+			return countNeededTransitions( node.getImageTransitions(), states, apply )
+				+ countNeededTransitions( node.getBufferTransitions(), states, apply );
+		}
+
+		static size_t countTransitions( GraphNodePtrArray const & graph
+			, AttachmentStates states )
+		{
+			size_t result{};
+
+			for ( auto & node : graph )
+			{
+				if ( node->getKind() == GraphNode::Kind::FramePass )
+					result += countNeededTransitions( *node, states, true );
+			}
+
+			return result;
+		}
+		/**
+		*\brief
+		*	Counts the transitions of \p node which would break the current state of a view, needed by another ready node.
+		*/
+		static size_t countBrokenStates( GraphNode const & node
+			, std::vector< GraphNode * > const & ready
+			, AttachmentStates const & states )
+		{
+			size_t result{};
+
+			for ( auto & transition : node.getImageTransitions() )
+			{
+				if ( isInNeededState( transition.inputAttach, states ) )
+					continue;
+
+				auto id = transition.inputAttach.view().id;
+				result += size_t( std::any_of( ready.begin(), ready.end()
+					, [&node, &states, id]( GraphNode const * other )
+					{
+						return other != &node
+							&& std::any_of( other->getImageTransitions().begin()
+								, other->getImageTransitions().end()
+								, [&states, id]( ImageTransition const & lookup )
+								{
+									return lookup.inputAttach.view().id == id
+										&& isInNeededState( lookup.inputAttach, states );
+								} );
+					} ) );
+			}
+
+			return result;
+		}
+
+		template< typename FuncT >
+		static void forEachResource( Attachment const & attach, FuncT const & func )
+		{
+			for ( uint32_t index = 0u; index < attach.getViewCount(); ++index )
+			{
+				auto view = attach.view( index );
+				func( true, view.data->image.id, attach.isOutput() );
+
+				for ( auto & source : view.data->source )
+					func( true, source.data->image.id, attach.isOutput() );
+			}
+
+			for ( uint32_t index = 0u; index < attach.getBufferCount(); ++index )
+			{
+				auto buffer = attach.buffer( index );
+				func( false, buffer.data->buffer.id, attach.isOutput() );
+
+				for ( auto & source : buffer.data->source )
+					func( false, source.data->buffer.id, attach.isOutput() );
+			}
+		}
+
+		template< typename FuncT >
+		static void forEachResource( FramePass const & pass, FuncT const & func )
+		{
+			for ( auto & [_, attach] : pass.getUniforms() )
+				forEachResource( *attach, func );
+			for ( auto & [_, attach] : pass.getSampled() )
+				forEachResource( *attach.attach, func );
+			for ( auto & [_, attach] : pass.getInputs() )
+				forEachResource( *attach, func );
+			for ( auto & [_, attach] : pass.getInouts() )
+				forEachResource( *attach, func );
+			for ( auto & [_, attach] : pass.getOutputs() )
+				forEachResource( *attach, func );
+			for ( auto attach : pass.getTargets() )
+				forEachResource( *attach, func );
+		}
+		/**
+		*\brief
+		*	Lists, for each node, the nodes which must run before it.
+		*\remarks
+		*	Besides the predecessors, the nodes accessing the same image or buffer keep their order
+		*	as soon as one of them writes to it, the order of reads and writes being given by the depth first order.
+		*/
+		static std::vector< std::vector< size_t > > listDependencies( GraphNodePtrArray const & graph )
+		{
+			struct ResourceAccesses
+			{
+				std::optional< size_t > lastWriter;
+				std::vector< size_t > readers;
+			};
+			std::unordered_map< GraphNode const *, size_t > indices;
+			indices.reserve( graph.size() );
+			for ( size_t index = 0u; index < graph.size(); ++index )
+				indices.try_emplace( graph[index].get(), index );
+
+			std::vector< std::vector< size_t > > result( graph.size() );
+			std::map< std::pair< bool, uint32_t >, ResourceAccesses > accesses;
+
+			for ( size_t index = 0u; index < graph.size(); ++index )
+			{
+				auto & node = *graph[index];
+				auto & dependencies = result[index];
+
+				for ( auto pred : node.getPredecessors() )
+				{
+					if ( auto it = indices.find( pred ); it != indices.end() )
+						dependencies.push_back( it->second );
+				}
+
+				if ( node.getKind() != GraphNode::Kind::FramePass )
+					continue;
+
+				forEachResource( nodeCast< FramePassNode >( node ).getFramePass()
+					, [&accesses, &dependencies, index]( bool isImage, uint32_t id, bool isOutput )
+					{
+						auto & resource = accesses[{ isImage, id }];
+
+						if ( resource.lastWriter && *resource.lastWriter != index )
+							dependencies.push_back( *resource.lastWriter );
+
+						if ( isOutput )
+						{
+							for ( auto reader : resource.readers )
+							{
+								if ( reader != index )
+									dependencies.push_back( reader );
+							}
+
+							resource.readers.clear();
+							resource.lastWriter = index;
+						}
+						else if ( resource.lastWriter != index )
+						{
+							resource.readers.push_back( index );
+						}
+					} );
+			}
+
+			for ( auto & dependencies : result )
+			{
+				std::sort( dependencies.begin(), dependencies.end() );
+				dependencies.erase( std::unique( dependencies.begin(), dependencies.end() ), dependencies.end() );
+			}
+
+			return result;
+		}
+		/**
+		*\brief
+		*	Reorders the depth first sorted nodes, picking at each step the ready node needing the fewest transitions.
+		*\remarks
+		*	Ties are broken by delaying the nodes which would change the state of a view still needed as is by other ready nodes,
+		*	then by keeping the depth first order.
+		*/
+		static void scheduleNodes( GraphNodePtrArray & graph
+			, AttachmentStates states )
+		{
+			auto dependencies = listDependencies( graph );
+			std::vector< std::vector< size_t > > successors( graph.size() );
+			std::vector< size_t > remaining( graph.size() );
+
+			for ( size_t index = 0u; index < graph.size(); ++index )
+			{
+				remaining[index] = dependencies[index].size();
+
+				for ( auto dependency : dependencies[index] )
+					successors[dependency].push_back( index );
+			}
+
+			std::vector< size_t > ready;
+			for ( size_t index = 0u; index < graph.size(); ++index )
+				if ( remaining[index] == 0u )
+					ready.push_back( index );
+
+			std::vector< GraphNode * > readyNodes;
+			GraphNodePtrArray result;
+			result.reserve( graph.size() );
+
+			while ( !ready.empty() )
+			{
+				readyNodes.clear();
+				for ( auto index : ready )
+					readyNodes.push_back( graph[index].get() );
+
+				auto best = ready.begin();
+				auto bestCost = std::make_pair( ~size_t{}, ~size_t{} );
+
+				for ( auto it = ready.begin(); it != ready.end(); ++it )
+				{
+					auto & node = *graph[*it];
+					auto cost = std::make_pair( countNeededTransitions( node, states, false )
+						, countBrokenStates( node, readyNodes, states ) );
+
+					if ( cost < bestCost
+						|| ( cost == bestCost && *it < *best ) )
+					{
+						best = it;
+						bestCost = cost;
+					}
+				}
+
+				auto index = *best;
+				ready.erase( best );
+				countNeededTransitions( *graph[index], states, true );
+
+				for ( auto successor : successors[index] )
+				{
+					if ( --remaining[successor] == 0u )
+						ready.push_back( successor );
+				}
+
+				result.emplace_back( std::move( graph[index] ) );
+			}
+
+			assert( result.size() == graph.size() );
+			graph = std::move( result );
+		}
 	}
 
 	//*********************************************************************************************
@@ -626,17 +1163,91 @@ namespace crg::builder
 		return result;
 	}
 
+	void cullEndPoints( FramePassArray const & passes
+		, AttachmentArray & endPoints
+		, LayerLayoutStatesHandler const & outputs )
+	{
+		// A pass is kept with all its end points, as soon as one of them is alive.
+		FramePassSet alive;
+
+		for ( auto pass : passes )
+		{
+			auto passOutputs = endpoints::listPassOutputs( *pass );
+
+			if ( pass->isKeptAlive()
+				|| std::any_of( passOutputs.begin()
+					, passOutputs.end()
+					, [&outputs]( Attachment const * attach )
+					{
+						return endpoints::isGraphOutput( *attach, outputs );
+					} ) )
+				alive.insert( pass );
+		}
+
+		endPoints.erase( std::remove_if( endPoints.begin()
+				, endPoints.end()
+				, [&alive]( Attachment const * attach )
+				{
+					return alive.find( attach->pass ) == alive.end();
+				} )
+			, endPoints.end() );
+
+		// The compiled passes are the alive ones, and the ones they read from, as the graph traversal goes.
+		FramePassSet compiled;
+		std::vector< FramePass const * > stack{ alive.begin(), alive.end() };
+		std::unordered_set< Attachment const * > consumed;
+
+		while ( !stack.empty() )
+		{
+			auto pass = stack.back();
+			stack.pop_back();
+
+			if ( !compiled.insert( pass ).second )
+				continue;
+
+			for ( auto const & [_, own] : *pass )
+			{
+				if ( !own.parent )
+					continue;
+
+				endpoints::addConsumed( *own.parent, consumed );
+
+				for ( auto producer : graph::listAttachmentPasses( *own.parent ) )
+					stack.push_back( producer );
+			}
+		}
+
+		// The outputs of a compiled pass which are only read by culled passes become end points,
+		// so they still get their final transitions.
+		std::unordered_set< Attachment const * > listed{ endPoints.begin(), endPoints.end() };
+
+		for ( auto pass : passes )
+		{
+			if ( compiled.find( pass ) == compiled.end() )
+				continue;
+
+			for ( auto attach : endpoints::listPassOutputs( *pass ) )
+			{
+				if ( consumed.find( attach ) == consumed.end()
+					&& listed.insert( attach ).second )
+					endPoints.push_back( attach );
+			}
+		}
+	}
+
 	//*********************************************************************************************
 
-	void buildGraph( AttachmentArray const & endPoints
+	size_t buildGraph( AttachmentArray const & endPoints
 		, RootNode & root
 		, GraphNodePtrArray & graph
-		, bool separateDepthStencilLayouts )
+		, bool separateDepthStencilLayouts
+		, PassScheduling scheduling )
 	{
 		// First generate the graph with all transitions and links.
 		AttachmentTransitions transitions;
+		graph::GraphNodes nodes{ graph };
 		for ( auto endPoint : endPoints )
-			graph::traverseAttachmentPasses( root, endPoint, nullptr, transitions, graph );
+			graph::traverseAttachmentPasses( root, endPoint, nullptr, transitions, nodes );
 
 		// Then remove the shortcuts (if pass C depends on A and B, if B depends on A, then remove link between A and C)
 		graph::removeShortcuts( root );
@@ -644,9 +1255,29 @@ namespace crg::builder
 		// Now sort the graph nodes regarding their position in the final graph.
 		graph::sortNodes( root, graph );
 
-		// Eventually parse the sorted nodes to generate a curated transitions list per node.
+		// Count the transitions needed by the depth first order, and look for a better order if required.
 		graph::AttachmentStates states{ separateDepthStencilLayouts };
+		auto result = graph::countTransitions( graph, states );
+
+		if ( scheduling == PassScheduling::eMinimiseTransitions )
+			graph::scheduleNodes( graph, states );
+
+		// Eventually parse the sorted nodes to generate a curated transitions list per node.
 		graph::buildTransitions( graph, states );
+		return result;
+	}
+
+	size_t countTransitions( GraphNodePtrArray const & graph )
+	{
+		size_t result{};
+
+		for ( auto & node : graph )
+		{
+			if ( node->getKind() == GraphNode::Kind::FramePass )
+				result += node->getImageTransitions().size() + node->getBufferTransitions().size();
+		}
+
+		return result;
 	}
 
 	//*********************************************************************************************
@@ -7,8 +7,28 @@ See LICENSE file in root folder.
 namespace crg::builder
 {
 	AttachmentArray findEndPoints( FramePassArray const & passes );
-	void buildGraph( AttachmentArray const & endPoints
+	/**
+	*\brief
+	*	Removes the end points of the passes which are not kept alive, and which don't write to a graph output.
+	*\remarks
+	*	The passes only reachable from the removed end points are then not part of the built graph.
+	*	The outputs of the remaining passes, which are only read by culled passes, are added to the end points.
+	*/
+	void cullEndPoints( FramePassArray const & passes
+		, AttachmentArray & endPoints
+		, LayerLayoutStatesHandler const & outputs );
+	/**
+	*\return
+	*	The number of transitions needed by the depth first order of the nodes.
+	*/
+	size_t buildGraph( AttachmentArray const & endPoints
 		, RootNode & root
 		, GraphNodePtrArray & graph
-		, bool separateDepthStencilLayouts );
+		, bool separateDepthStencilLayouts
+		, PassScheduling scheduling );
+	/**
+	*\return
+	*	The number of transitions in the given built graph.
+	*/
+	size_t countTransitions( GraphNodePtrArray const & graph );
 }
@@ -0,0 +1,600 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "GraphCache.hpp"
+
+#include "RenderGraph/Attachment.hpp"
+#include "RenderGraph/AttachmentTransition.hpp"
+#include "RenderGraph/BufferData.hpp"
+#include "RenderGraph/BufferViewData.hpp"
+#include "RenderGraph/FramePass.hpp"
+#include "RenderGraph/FramePassGroup.hpp"
+#include "RenderGraph/GraphNode.hpp"
+#include "RenderGraph/ImageData.hpp"
+#include "RenderGraph/ImageViewData.hpp"
+#include "RenderGraph/LayerLayoutStatesHandler.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+#include <unordered_map>
+
+namespace crg::cache
+{
+	namespace grcache
+	{
+		static constexpr uint32_t Magic = 0x43475243u;
+		static constexpr uint32_t Version = 3u;
+		static constexpr uint32_t InvalidIndex = ~0u;
+
+		enum class AttachKind : uint32_t
+		{
+			eRegistered,
+			eDefault,
+		};
+
+		/**
+		*\brief
+		*	FNV-1a hasher, used instead of std::hash so that the value doesn't depend on the standard library implementation.
+		*/
+		class Hasher
+		{
+		public:
+			void add( void const * data, size_t size )noexcept
+			{
+				auto bytes = static_cast< uint8_t const * >( data );
+
+				for ( size_t index = 0u; index < size; ++index )
+				{
+					m_value ^= bytes[index];
+					m_value *= 0x100000001b3ULL;
+				}
+			}
+
+			template< typename ValueT >
+			void add( ValueT value )noexcept
+			{
+				static_assert( std::is_arithmetic_v< ValueT > || std::is_enum_v< ValueT > );
+				add( &value, sizeof( ValueT ) );
+			}
+
+			void add( std::string const & value )noexcept
+			{
+				add( uint64_t( value.size() ) );
+				add( value.data(), value.size() );
+			}
+
+			uint64_t getValue()const noexcept
+			{
+				return m_value;
+			}
+
+		private:
+			uint64_t m_value{ 0xcbf29ce484222325ULL };
+		};
+
+		template< typename FuncT >
+		static void forEachAttach( FramePass const & pass, FuncT func )
+		{
+			for ( auto & [binding, attach] : pass.getUniforms() )
+				func( 0u, binding, *attach );
+			for ( auto & [binding, attach] : pass.getSampled() )
+				func( 1u, binding, *attach.attach );
+			for ( auto & [binding, attach] : pass.getInputs() )
+				func( 2u, binding, *attach );
+			for ( auto & [binding, attach] : pass.getInouts() )
+				func( 3u, binding, *attach );
+			for ( auto & [binding, attach] : pass.getOutputs() )
+				func( 4u, binding, *attach );
+			uint32_t index{};
+			for ( auto attach : pass.getTargets() )
+				func( 5u, index++, *attach );
+		}
+		/**
+		*\brief
+		*	Lists all attachments reachable from the passes, in a deterministic order.
+		*/
+		class AttachRegistry
+		{
+		public:
+			explicit AttachRegistry( FramePassArray const & passes )
+			{
+				for ( auto pass : passes )
+					m_passIndices.try_emplace( pass, uint32_t( m_passIndices.size() ) );
+
+				for ( auto pass : passes )
+				{
+					forEachAttach( *pass
+						, [this]( uint32_t, uint32_t, Attachment const & attach )
+						{
+							registerAttach( attach );
+						} );
+				}
+			}
+
+			uint32_t getIndex( Attachment const * attach )const
+			{
+				auto it = m_indices.find( attach );
+				return it == m_indices.end() ? InvalidIndex : it->second;
+			}
+
+			uint32_t getIndex( FramePass const * pass )const
+			{
+				auto it = m_passIndices.find( pass );
+				return it == m_passIndices.end() ? InvalidIndex : it->second;
+			}
+			/**
+			*\brief
+			*	Retrieves the index of the registered attachment the given one is a copy of.
+			*/
+			uint32_t findCopy( Attachment const & attach )const
+			{
+				if ( auto it = m_byName.find( attach.name ); it != m_byName.end() )
+				{
+					for ( auto index : it->second )
+					{
+						if ( *m_attaches[index] == attach )
+							return index;
+					}
+				}
+
+				return InvalidIndex;
+			}
+
+			std::vector< Attachment const * > const & getAttaches()const noexcept
+			{
+				return m_attaches;
+			}
+
+		private:
+			void registerAttach( Attachment const & attach )
+			{
+				if ( m_indices.try_emplace( &attach, uint32_t( m_attaches.size() ) ).second )
+				{
+					m_byName[attach.name].push_back( uint32_t( m_attaches.size() ) );
+					m_attaches.push_back( &attach );
+
+					for ( auto & source : attach.source )
+					{
+						if ( source.attach )
+							registerAttach( *source.attach );
+					}
+				}
+			}
+
+		private:
+			std::vector< Attachment const * > m_attaches;
+			std::unordered_map< Attachment const *, uint32_t > m_indices;
+			std::unordered_map< FramePass const *, uint32_t > m_passIndices;
+			std::unordered_map< std::string, std::vector< uint32_t > > m_byName;
+		};
+
+		static void hashView( Hasher & hasher, ImageViewId const & view )
+		{
+			auto & data = *view.data;
+			auto & image = *data.image.data;
+			hasher.add( view.id );
+			hasher.add( data.name );
+			hasher.add( data.image.id );
+			hasher.add( image.info.flags );
+			hasher.add( image.info.imageType );
+			hasher.add( image.info.format );
+			hasher.add( image.info.extent.width );
+			hasher.add( image.info.extent.height );
+			hasher.add( image.info.extent.depth );
+			hasher.add( image.info.mipLevels );
+			hasher.add( image.info.arrayLayers );
+			hasher.add( data.info.flags );
+			hasher.add( data.info.viewType );
+			hasher.add( data.info.format );
+			hasher.add( data.info.subresourceRange.aspectMask );
+			hasher.add( data.info.subresourceRange.baseMipLevel );
+			hasher.add( data.info.subresourceRange.levelCount );
+			hasher.add( data.info.subresourceRange.baseArrayLayer );
+			hasher.add( data.info.subresourceRange.layerCount );
+			hasher.add( uint32_t( data.source.size() ) );
+
+			for ( auto & source : data.source )
+				hashView( hasher, source );
+		}
+
+		static void hashView( Hasher & hasher, BufferViewId const & view )
+		{
+			auto & data = *view.data;
+			hasher.add( view.id );
+			hasher.add( data.name );
+			hasher.add( data.buffer.id );
+			hasher.add( data.buffer.data->info.size );
+			hasher.add( data.info.format );
+			hasher.add( data.info.subresourceRange.offset );
+			hasher.add( data.info.subresourceRange.size );
+			hasher.add( uint32_t( data.source.size() ) );
+
+			for ( auto & source : data.source )
+				hashView( hasher, source );
+		}
+
+		static void hashAttach( Hasher & hasher
+			, AttachRegistry const & registry
+			, Attachment const & attach )
+		{
+			hasher.add( attach.flags );
+			hasher.add( attach.name );
+			hasher.add( registry.getIndex( attach.pass ) );
+			hasher.add( attach.imageAttach.flags );
+			hasher.add( attach.imageAttach.wantedLayout );
+			hasher.add( uint32_t( attach.imageAttach.views.size() ) );
+
+			for ( auto & view : attach.imageAttach.views )
+				hashView( hasher, view );
+
+			hasher.add( attach.bufferAttach.flags );
+			hasher.add( attach.bufferAttach.wantedAccess.access );
+			hasher.add( attach.bufferAttach.wantedAccess.pipelineStage );
+			hasher.add( uint32_t( attach.bufferAttach.buffers.size() ) );
+
+			for ( auto & buffer : attach.bufferAttach.buffers )
+				hashView( hasher, buffer );
+
+			hasher.add( uint32_t( attach.source.size() ) );
+
+			for ( auto & source : attach.source )
+			{
+				hasher.add( registry.getIndex( source.attach.get() ) );
+				hasher.add( registry.getIndex( source.parent ) );
+				hasher.add( registry.getIndex( source.pass ) );
+			}
+		}
+
+		static void write( std::ostream & stream, uint32_t value )
+		{
+			stream.write( reinterpret_cast< char const * >( &value ), sizeof( value ) );
+		}
+
+		static void write( std::ostream & stream, uint64_t value )
+		{
+			stream.write( reinterpret_cast< char const * >( &value ), sizeof( value ) );
+		}
+
+		template< typename ValueT >
+		static bool read( std::istream & stream, ValueT & value )
+		{
+			stream.read( reinterpret_cast< char * >( &value ), sizeof( value ) );
+			return bool( stream );
+		}
+
+		template< typename ViewT >
+		static bool writeAttach( std::ostream & stream
+			, AttachRegistry const & registry
+			, Attachment const & attach
+			, ViewT const & view )
+		{
+			if ( auto index = registry.findCopy( attach );
+				index != InvalidIndex )
+			{
+				write( stream, uint32_t( AttachKind::eRegistered ) );
+				write( stream, index );
+				return true;
+			}
+
+			if ( attach == Attachment::createDefault( view )
+				&& attach.name.empty() )
+			{
+				write( stream, uint32_t( AttachKind::eDefault ) );
+				write( stream, view.id );
+				return true;
+			}
+
+			return false;
+		}
+
+		template< typename ViewT >
+		static bool writeTransitions( std::ostream & stream
+			, AttachRegistry const & registry
+			, DataTransitionArrayT< ViewT > const & transitions )
+		{
+			write( stream, uint32_t( transitions.size() ) );
+
+			for ( auto & transition : transitions )
+			{
+				write( stream, transition.data.id );
+
+				if ( !writeAttach( stream, registry, transition.outputAttach, transition.data )
+					|| !writeAttach( stream, registry, transition.inputAttach, transition.data ) )
+					return false;
+			}
+
+			return true;
+		}
+
+		static bool writeNode( std::ostream & stream
+			, AttachRegistry const & registry
+			, std::unordered_map< GraphNode const *, uint32_t > const & nodeIndices
+			, GraphNode const & node )
+		{
+			write( stream, uint32_t( node.getPredecessors().size() ) );
+
+			for ( auto predecessor : node.getPredecessors() )
+			{
+				auto it = nodeIndices.find( predecessor );
+
+				if ( it == nodeIndices.end() )
+					return false;
+
+				write( stream, it->second );
+			}
+
+			return writeTransitions( stream, registry, node.getImageTransitions() )
+				&& writeTransitions( stream, registry, node.getBufferTransitions() );
+		}
+
+		template< typename ViewT >
+		static bool readView( std::istream & stream
+			, std::set< ViewT > const & views
+			, ViewT & view )
+		{
+			uint32_t id{};
+
+			if ( !read( stream, id ) )
+				return false;
+
+			auto it = views.find( ViewT{ id } );
+
+			if ( it == views.end() )
+				return false;
+
+			view = *it;
+			return true;
+		}
+
+		template< typename ViewT >
+		static bool readAttach( std::istream & stream
+			, AttachRegistry const & registry
+			, std::set< ViewT > const & views
+			, std::optional< Attachment > & attach )
+		{
+			uint32_t kind{};
+
+			if ( !read( stream, kind ) )
+				return false;
+
+			if ( kind == uint32_t( AttachKind::eRegistered ) )
+			{
+				uint32_t index{};
+
+				if ( !read( stream, index )
+					|| index >= registry.getAttaches().size() )
+					return false;
+
+				attach.emplace( *registry.getAttaches()[index] );
+				return true;
+			}
+
+			if ( kind == uint32_t( AttachKind::eDefault ) )
+			{
+				ViewT view;
+
+				if ( !readView( stream, views, view ) )
+					return false;
+
+				attach.emplace( Attachment::createDefault( view ) );
+				return true;
+			}
+
+			return false;
+		}
+
+		template< typename ViewT >
+		static bool readTransitions( std::istream & stream
+			, AttachRegistry const & registry
+			, std::set< ViewT > const & views
+			, DataTransitionArrayT< ViewT > & transitions )
+		{
+			uint32_t count{};
+
+			if ( !read( stream, count ) )
+				return false;
+
+			for ( uint32_t index = 0u; index < count; ++index )
+			{
+				ViewT data;
+				std::optional< Attachment > outputAttach;
+				std::optional< Attachment > inputAttach;
+
+				if ( !readView( stream, views, data )
+					|| !readAttach( stream, registry, views, outputAttach )
+					|| !readAttach( stream, registry, views, inputAttach ) )
+					return false;
+
+				transitions.emplace_back( data, std::move( *outputAttach ), std::move( *inputAttach ) );
+			}
+
+			return true;
+		}
+
+		static bool readNode( std::istream & stream
+			, AttachRegistry const & registry
+			, std::set< ImageViewId > const & imageViews
+			, std::set< BufferViewId > const & bufferViews
+			, GraphNodePtrArray const & nodes
+			, GraphNode & node )
+		{
+			uint32_t count{};
+
+			if ( !read( stream, count ) )
+				return false;
+
+			for ( uint32_t index = 0u; index < count; ++index )
+			{
+				uint32_t predecessor{};
+
+				if ( !read( stream, predecessor )
+					|| predecessor >= nodes.size()
+					|| nodes[predecessor].get() == &node )
+					return false;
+
+				node.attachNode( *nodes[predecessor] );
+			}
+
+			AttachmentTransitions transitions;
+
+			if ( !readTransitions( stream, registry, imageViews, transitions.imageTransitions )
+				|| !readTransitions( stream, registry, bufferViews, transitions.bufferTransitions ) )
+				return false;
+
+			node.setTransitions( std::move( transitions ) );
+			return true;
+		}
+	}
+
+	uint64_t computeHash( FramePassArray const & passes
+		, bool passCulling
+		, LayerLayoutStatesHandler const & outputs
+		, PassScheduling scheduling )
+	{
+		grcache::AttachRegistry registry{ passes };
+		grcache::Hasher hasher;
+		hasher.add( grcache::Version );
+		hasher.add( uint32_t( passes.size() ) );
+
+		for ( auto pass : passes )
+		{
+			hasher.add( pass->getGroup().getFullName() );
+			hasher.add( pass->getName() );
+			hasher.add( uint32_t( pass->isKeptAlive() ) );
+			grcache::forEachAttach( *pass
+				, [&hasher, &registry]( uint32_t kind, uint32_t binding, Attachment const & attach )
+				{
+					hasher.add( kind );
+					hasher.add( binding );
+					hasher.add( registry.getIndex( &attach ) );
+				} );
+		}
+
+		for ( auto attach : registry.getAttaches() )
+			grcache::hashAttach( hasher, registry, *attach );
+
+		hasher.add( scheduling );
+		// The graph outputs decide which passes are culled.
+		hasher.add( uint32_t( passCulling ) );
+
+		if ( passCulling )
+		{
+			for ( auto & [image, layers] : outputs.images )
+			{
+				hasher.add( image );
+				auto prevLayer = ~0u;
+				layers.forEach( [&hasher, &prevLayer]( uint32_t layer, uint32_t mip, LayoutState const & )
+					{
+						if ( layer != prevLayer )
+							hasher.add( layer );
+
+						prevLayer = layer;
+						hasher.add( mip );
+					} );
+			}
+		}
+
+		return hasher.getValue();
+	}
+
+	bool saveGraph( std::ostream & stream
+		, uint64_t hash
+		, bool separateDepthStencilLayouts
+		, size_t depthFirstTransitionCount
+		, FramePassArray const & passes
+		, RootNode const & root
+		, GraphNodePtrArray const & nodes )
+	{
+		grcache::AttachRegistry registry{ passes };
+		std::unordered_map< GraphNode const *, uint32_t > nodeIndices;
+		grcache::write( stream, grcache::Magic );
+		grcache::write( stream, grcache::Version );
+		grcache::write( stream, hash );
+		grcache::write( stream, uint32_t( separateDepthStencilLayouts ) );
+		grcache::write( stream, uint64_t( depthFirstTransitionCount ) );
+		grcache::write( stream, uint32_t( nodes.size() ) );
+
+		for ( auto & node : nodes )
+		{
+			auto pass = getFramePass( *node );
+			auto passIndex = registry.getIndex( pass );
+
+			if ( passIndex == grcache::InvalidIndex )
+				return false;
+
+			nodeIndices.try_emplace( node.get(), uint32_t( nodeIndices.size() ) );
+			grcache::write( stream, passIndex );
+		}
+
+		if ( !grcache::writeNode( stream, registry, nodeIndices, root ) )
+			return false;
+
+		return std::all_of( nodes.begin()
+			, nodes.end()
+			, [&stream, &registry, &nodeIndices]( GraphNodePtr const & node )
+			{
+				return grcache::writeNode( stream, registry, nodeIndices, *node );
+			} )
+			&& bool( stream );
+	}
+
+	bool loadGraph( std::istream & stream
+		, uint64_t hash
+		, bool separateDepthStencilLayouts
+		, size_t & depthFirstTransitionCount
+		, FramePassArray const & passes
+		, std::set< ImageViewId > const & imageViews
+		, std::set< BufferViewId > const & bufferViews
+		, RootNode & root
+		, GraphNodePtrArray & nodes )
+	{
+		uint32_t magic{};
+		uint32_t version{};
+		uint64_t readHash{};
+		uint32_t separate{};
+		uint64_t depthFirstCount{};
+
+		if ( !grcache::read( stream, magic ) || magic != grcache::Magic
+			|| !grcache::read( stream, version ) || version != grcache::Version
+			|| !grcache::read( stream, readHash ) || readHash != hash
+			|| !grcache::read( stream, separate ) || separate != uint32_t( separateDepthStencilLayouts )
+			|| !grcache::read( stream, depthFirstCount ) )
+			return false;
+
+		depthFirstTransitionCount = size_t( depthFirstCount );
+
+		grcache::AttachRegistry registry{ passes };
+		std::vector< bool > usedPasses( passes.size(), false );
+		uint32_t count{};
+
+		if ( !grcache::read( stream, count ) )
+			return false;
+
+		for ( uint32_t index = 0u; index < count; ++index )
+		{
+			uint32_t passIndex{};
+
+			if ( !grcache::read( stream, passIndex )
+				|| passIndex >= passes.size()
+				|| usedPasses[passIndex] )
+				return false;
+
+			usedPasses[passIndex] = true;
+			nodes.push_back( std::make_unique< FramePassNode >( *passes[passIndex] ) );
+		}
+
+		if ( !grcache::readNode( stream, registry, imageViews, bufferViews, nodes, root ) )
+			return false;
+
+		return std::all_of( nodes.begin()
+			, nodes.end()
+			, [&stream, &registry, &imageViews, &bufferViews, &nodes]( GraphNodePtr const & node )
+			{
+				return grcache::readNode( stream, registry, imageViews, bufferViews, nodes, *node );
+			} );
+	}
+}
@@ -0,0 +1,56 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+#include <iosfwd>
+
+namespace crg::cache
+{
+	/**
+	*\brief
+	*	Computes a hash of the graph structure, stable between launches.
+	*\remarks
+	*	It covers the passes, their groups, their attachments, and the views subresources.
+	*	When the passes are culled, it also covers the graph outputs subresources.
+	*	The scheduling mode is covered too, since it changes the nodes order.
+	*/
+	uint64_t computeHash( FramePassArray const & passes
+		, bool passCulling
+		, LayerLayoutStatesHandler const & outputs
+		, PassScheduling scheduling );
+	/**
+	*\brief
+	*	Writes the nodes order, their predecessors and their transitions.
+	*\param[in] depthFirstTransitionCount
+	*	The number of transitions the depth first order of the passes needs, given back by loadGraph.
+	*\return
+	*	\p false if a transition couldn't be expressed from the passes attachments.
+	*/
+	bool saveGraph( std::ostream & stream
+		, uint64_t hash
+		, bool separateDepthStencilLayouts
+		, size_t depthFirstTransitionCount
+		, FramePassArray const & passes
+		, RootNode const & root
+		, GraphNodePtrArray const & nodes );
+	/**
+	*\brief
+	*	Reads a graph written by saveGraph.
+	*\return
+	*	\p false if the stream doesn't match the given hash, or is invalid.
+	*	In that case, \p root and \p nodes are left in an unspecified state.
+	*/
+	bool loadGraph( std::istream & stream
+		, uint64_t hash
+		, bool separateDepthStencilLayouts
+		, size_t & depthFirstTransitionCount
+		, FramePassArray const & passes
+		, std::set< ImageViewId > const & imageViews
+		, std::set< BufferViewId > const & bufferViews
+		, RootNode & root
+		, GraphNodePtrArray & nodes );
+}
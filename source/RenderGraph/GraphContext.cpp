@@ -9,6 +9,8 @@ See LICENSE file in root folder.
 #include <cassert>
 #include <cmath>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #pragma warning( push )
 #pragma warning( disable: 5262 )
@@ -20,6 +22,59 @@ namespace crg
 {
 	using lock_type = std::unique_lock< std::mutex >;
 
+	//************************************************************************************************
+
+#if VK_VERSION_1_3
+	namespace grctx
+	{
+		static VkMemoryBarrier2 convert( StagedMemoryBarrier const & value )
+		{
+			return { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2
+				, value.barrier.pNext
+				, value.srcStageMask, value.barrier.srcAccessMask
+				, value.dstStageMask, value.barrier.dstAccessMask };
+		}
+
+		static VkBufferMemoryBarrier2 convert( StagedBufferBarrier const & value )
+		{
+			return { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2
+				, value.barrier.pNext
+				, value.srcStageMask, value.barrier.srcAccessMask
+				, value.dstStageMask, value.barrier.dstAccessMask
+				, value.barrier.srcQueueFamilyIndex, value.barrier.dstQueueFamilyIndex
+				, value.barrier.buffer
+				, value.barrier.offset
+				, value.barrier.size };
+		}
+
+		static VkImageMemoryBarrier2 convert( StagedImageBarrier const & value )
+		{
+			return { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2
+				, value.barrier.pNext
+				, value.srcStageMask, value.barrier.srcAccessMask
+				, value.dstStageMask, value.barrier.dstAccessMask
+				, value.barrier.oldLayout, value.barrier.newLayout
+				, value.barrier.srcQueueFamilyIndex, value.barrier.dstQueueFamilyIndex
+				, value.barrier.image
+				, value.barrier.subresourceRange };
+		}
+
+		template< typename DstT, typename SrcT >
+		static std::vector< DstT > convert( std::span< SrcT const > values )
+		{
+			std::vector< DstT > result;
+			result.reserve( values.size() );
+
+			for ( auto & value : values )
+				result.push_back( convert( value ) );
+
+			return result;
+		}
+	}
+#endif
+
+	//************************************************************************************************
+
 	GraphContext::GraphContext( VkDevice device
 		, VkPipelineCache cache
 		, VkAllocationCallbacks const * allocator
@@ -33,6 +88,7 @@ namespace crg
 		, memoryProperties{ std::move( memoryProperties ) }
 		, properties{ std::move( properties ) }
 		, separateDepthStencilLayouts{ separateDepthStencilLayouts }
+		, timestampPeriod{ this->properties.limits.timestampPeriod }
 	{
 #pragma warning( push )
 #pragma warning( disable: 4191 )
@@ -91,6 +147,7 @@ namespace crg
 		DECL_vkFunction( DestroyQueryPool );
 		DECL_vkFunction( GetQueryPoolResults );
 		DECL_vkFunction( ResetCommandBuffer );
+		DECL_vkFunction( ResetCommandPool );
 		DECL_vkFunction( CreateEvent );
 		DECL_vkFunction( DestroyEvent );
 		DECL_vkFunction( ResetEvent );
@@ -101,6 +158,18 @@ namespace crg
 		DECL_vkFunction( GetFenceStatus );
 		DECL_vkFunction( WaitForFences );
 		DECL_vkFunction( ResetFences );
+#if VK_VERSION_1_2
+		DECL_vkFunction( WaitSemaphores );
+		DECL_vkFunction( GetSemaphoreCounterValue );
+		DECL_vkFunction( ResetQueryPool );
+
+		if ( !vkWaitSemaphores && vkGetDeviceProcAddr && device )
+			vkWaitSemaphores = reinterpret_cast< PFN_vkWaitSemaphores >( vkGetDeviceProcAddr( device, "vkWaitSemaphoresKHR" ) );
+		if ( !vkGetSemaphoreCounterValue && vkGetDeviceProcAddr && device )
+			vkGetSemaphoreCounterValue = reinterpret_cast< PFN_vkGetSemaphoreCounterValue >( vkGetDeviceProcAddr( device, "vkGetSemaphoreCounterValueKHR" ) );
+		if ( !vkResetQueryPool && vkGetDeviceProcAddr && device )
+			vkResetQueryPool = reinterpret_cast< PFN_vkResetQueryPool >( vkGetDeviceProcAddr( device, "vkResetQueryPoolEXT" ) );
+#endif
 
 		DECL_vkFunction( CmdBindPipeline );
 		DECL_vkFunction( CmdBindDescriptorSets );
@@ -130,6 +199,15 @@ namespace crg
 		DECL_vkFunction( CmdSetEvent );
 		DECL_vkFunction( CmdWaitEvents );
 		DECL_vkFunction( CmdFillBuffer );
+#if VK_VERSION_1_3
+		DECL_vkFunction( CmdPipelineBarrier2 );
+
+		if ( !vkCmdPipelineBarrier2 && vkGetDeviceProcAddr && device )
+			vkCmdPipelineBarrier2 = reinterpret_cast< PFN_vkCmdPipelineBarrier2 >( vkGetDeviceProcAddr( device, "vkCmdPipelineBarrier2KHR" ) );
+#endif
+#if VK_EXT_calibrated_timestamps
+		DECL_vkFunction( GetCalibratedTimestampsEXT );
+#endif
 
 #if VK_EXT_debug_utils
 		DECL_vkFunction( SetDebugUtilsObjectNameEXT );
@@ -198,6 +276,119 @@ namespace crg
 
 #endif
 
+	bool GraphContext::hasSynchronization2()const noexcept
+	{
+#if VK_VERSION_1_3
+		return synchronization2
+			&& vkCmdPipelineBarrier2 != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	bool GraphContext::hasTimelineSemaphores()const noexcept
+	{
+#if VK_VERSION_1_2
+		return timelineSemaphores
+			&& vkWaitSemaphores != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	bool GraphContext::hasHostQueryReset()const noexcept
+	{
+#if VK_VERSION_1_2
+		return hostQueryReset
+			&& vkResetQueryPool != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	void GraphContext::vkCmdPipelineBarriers( VkCommandBuffer commandBuffer
+		, VkDependencyFlags dependencyFlags
+		, std::span< StagedMemoryBarrier const > memoryBarriers
+		, std::span< StagedBufferBarrier const > bufferBarriers
+		, std::span< StagedImageBarrier const > imageBarriers )const
+	{
+		if ( memoryBarriers.empty() && bufferBarriers.empty() && imageBarriers.empty() )
+			return;
+
+#if VK_VERSION_1_3
+		if ( hasSynchronization2() )
+		{
+			auto memory = grctx::convert< VkMemoryBarrier2 >( memoryBarriers );
+			auto buffers = grctx::convert< VkBufferMemoryBarrier2 >( bufferBarriers );
+			auto images = grctx::convert< VkImageMemoryBarrier2 >( imageBarriers );
+			VkDependencyInfo dependencyInfo{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO
+				, nullptr
+				, dependencyFlags
+				, uint32_t( memory.size() ), memory.data()
+				, uint32_t( buffers.size() ), buffers.data()
+				, uint32_t( images.size() ), images.data() };
+			vkCmdPipelineBarrier2( commandBuffer, &dependencyInfo );
+			return;
+		}
+#endif
+
+		if ( memoryBarriers.size() + bufferBarriers.size() + imageBarriers.size() == 1u )
+		{
+			// Single barrier, no need to gather them.
+			auto stages = memoryBarriers.empty()
+				? ( bufferBarriers.empty()
+					? std::pair{ imageBarriers.front().srcStageMask, imageBarriers.front().dstStageMask }
+					: std::pair{ bufferBarriers.front().srcStageMask, bufferBarriers.front().dstStageMask } )
+				: std::pair{ memoryBarriers.front().srcStageMask, memoryBarriers.front().dstStageMask };
+			vkCmdPipelineBarrier( commandBuffer
+				, stages.first
+				, stages.second
+				, dependencyFlags
+				, uint32_t( memoryBarriers.size() ), memoryBarriers.empty() ? nullptr : &memoryBarriers.front().barrier
+				, uint32_t( bufferBarriers.size() ), bufferBarriers.empty() ? nullptr : &bufferBarriers.front().barrier
+				, uint32_t( imageBarriers.size() ), imageBarriers.empty() ? nullptr : &imageBarriers.front().barrier );
+			return;
+		}
+
+		VkPipelineStageFlags srcStageMask{};
+		VkPipelineStageFlags dstStageMask{};
+		std::vector< VkMemoryBarrier > memory;
+		std::vector< VkBufferMemoryBarrier > buffers;
+		std::vector< VkImageMemoryBarrier > images;
+		memory.reserve( memoryBarriers.size() );
+		buffers.reserve( bufferBarriers.size() );
+		images.reserve( imageBarriers.size() );
+
+		for ( auto & staged : memoryBarriers )
+		{
+			srcStageMask |= staged.srcStageMask;
+			dstStageMask |= staged.dstStageMask;
+			memory.push_back( staged.barrier );
+		}
+
+		for ( auto & staged : bufferBarriers )
+		{
+			srcStageMask |= staged.srcStageMask;
+			dstStageMask |= staged.dstStageMask;
+			buffers.push_back( staged.barrier );
+		}
+
+		for ( auto & staged : imageBarriers )
+		{
+			srcStageMask |= staged.srcStageMask;
+			dstStageMask |= staged.dstStageMask;
+			images.push_back( staged.barrier );
+		}
+
+		vkCmdPipelineBarrier( commandBuffer
+			, srcStageMask
+			, dstStageMask
+			, dependencyFlags
+			, uint32_t( memory.size() ), memory.data()
+			, uint32_t( buffers.size() ), buffers.data()
+			, uint32_t( images.size() ), images.data() );
+	}
+
 	std::array< float, 4u > GraphContext::getNextRainbowColour()const
 	{
 		static float currentColourHue{ 0.0f };
@@ -0,0 +1,207 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "ImageAliasing.hpp"
+
+#include "RenderGraph/Attachment.hpp"
+#include "RenderGraph/FramePass.hpp"
+#include "RenderGraph/GraphNode.hpp"
+#include "RenderGraph/ImageViewData.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace crg::alias
+{
+	namespace imgals
+	{
+		struct ImageUsage
+		{
+			uint32_t firstPass{ ~0u };
+			uint32_t lastPass{};
+			bool readFirst{};
+		};
+
+		template< typename FuncT >
+		static void forEachView( ImageViewId view, FuncT const & func )
+		{
+			func( view.data->image );
+
+			for ( auto & source : view.data->source )
+				forEachView( source, func );
+		}
+
+		template< typename FuncT >
+		static void forEachImage( Attachment const & attach, FuncT const & func )
+		{
+			if ( !attach.isImage() )
+				return;
+
+			for ( uint32_t index = 0u; index < attach.getViewCount(); ++index )
+			{
+				forEachView( attach.view( index )
+					, [&attach, &func]( ImageId image )
+					{
+						func( image, attach.isInput() );
+					} );
+			}
+		}
+
+		template< typename FuncT >
+		static void forEachImage( FramePass const & pass, FuncT const & func )
+		{
+			for ( auto & [_, attach] : pass.getUniforms() )
+				forEachImage( *attach, func );
+			for ( auto & [_, attach] : pass.getSampled() )
+				forEachImage( *attach.attach, func );
+			for ( auto & [_, attach] : pass.getInputs() )
+				forEachImage( *attach, func );
+			for ( auto & [_, attach] : pass.getInouts() )
+				forEachImage( *attach, func );
+			for ( auto & [_, attach] : pass.getOutputs() )
+				forEachImage( *attach, func );
+			for ( auto attach : pass.getTargets() )
+				forEachImage( *attach, func );
+		}
+
+		static bool areOverlapping( uint32_t lhsBegin, uint32_t lhsEnd
+			, uint32_t rhsBegin, uint32_t rhsEnd )
+		{
+			return lhsBegin <= rhsEnd && rhsBegin <= lhsEnd;
+		}
+
+		static bool areOverlapping( DeviceSize lhsOffset, DeviceSize lhsSize
+			, DeviceSize rhsOffset, DeviceSize rhsSize )
+		{
+			return lhsOffset < rhsOffset + rhsSize && rhsOffset < lhsOffset + lhsSize;
+		}
+
+		static DeviceSize alignUp( DeviceSize value, DeviceSize alignment )
+		{
+			return alignment > 1u
+				? ( ( value + alignment - 1u ) / alignment ) * alignment
+				: value;
+		}
+	}
+
+	TransientImageArray computeLifetimes( std::set< ImageId > const & images
+		, GraphNodePtrArray const & nodes
+		, LayerLayoutStatesHandler const & inputs
+		, LayerLayoutStatesHandler const & outputs )
+	{
+		std::map< ImageId, imgals::ImageUsage > usages;
+		uint32_t passIndex{};
+
+		for ( auto & node : nodes )
+		{
+			if ( node->getKind() != GraphNode::Kind::FramePass )
+				continue;
+
+			imgals::forEachImage( nodeCast< FramePassNode >( *node ).getFramePass()
+				, [&images, &usages, passIndex]( ImageId image, bool isInput )
+				{
+					if ( images.find( image ) == images.end() )
+						return;
+
+					auto & usage = usages.try_emplace( image ).first->second;
+
+					if ( usage.firstPass == ~0u )
+						usage.firstPass = passIndex;
+
+					usage.readFirst = usage.readFirst
+						|| ( isInput && usage.firstPass == passIndex );
+					usage.lastPass = passIndex;
+				} );
+			++passIndex;
+		}
+
+		TransientImageArray result;
+
+		for ( auto & [image, usage] : usages )
+		{
+			if ( !usage.readFirst
+				&& inputs.images.find( image.id ) == inputs.images.end()
+				&& outputs.images.find( image.id ) == outputs.images.end() )
+				result.push_back( { image, usage.firstPass, usage.lastPass } );
+		}
+
+		return result;
+	}
+
+	std::map< uint32_t, DeviceSize > placeImages( TransientImageArray & images )
+	{
+		// Biggest images are placed first, to get a tighter packing.
+		std::vector< size_t > order( images.size() );
+		std::iota( order.begin(), order.end(), size_t{} );
+		std::stable_sort( order.begin(), order.end()
+			, [&images]( size_t lhs, size_t rhs )
+			{
+				return images[lhs].size > images[rhs].size;
+			} );
+		std::map< uint32_t, DeviceSize > result;
+		std::vector< TransientImage const * > placed;
+		std::vector< TransientImage const * > concurrent;
+
+		for ( auto index : order )
+		{
+			auto & image = images[index];
+			concurrent.clear();
+
+			for ( auto other : placed )
+			{
+				if ( other->memoryType == image.memoryType
+					&& imgals::areOverlapping( image.firstPass, image.lastPass, other->firstPass, other->lastPass ) )
+					concurrent.push_back( other );
+			}
+
+			std::sort( concurrent.begin(), concurrent.end()
+				, []( TransientImage const * lhs, TransientImage const * rhs )
+				{
+					return lhs->offset < rhs->offset;
+				} );
+			// Lowest offset that doesn't overlap the memory ranges of the images alive at the same time.
+			DeviceSize offset{};
+
+			for ( auto other : concurrent )
+			{
+				if ( other->offset >= offset + image.size )
+					break;
+
+				if ( imgals::areOverlapping( offset, image.size, other->offset, other->size ) )
+					offset = imgals::alignUp( other->offset + other->size, image.alignment );
+			}
+
+			image.offset = offset;
+			auto & blockSize = result.try_emplace( image.memoryType ).first->second;
+			blockSize = std::max( blockSize, offset + image.size );
+			placed.push_back( &image );
+		}
+
+		return result;
+	}
+
+	bool isAliased( TransientImage const & image
+		, TransientImageArray const & images )
+	{
+		return std::any_of( images.begin(), images.end()
+			, [&image]( TransientImage const & lookup )
+			{
+				return lookup.image != image.image
+					&& lookup.memoryType == image.memoryType
+					&& imgals::areOverlapping( image.offset, image.size, lookup.offset, lookup.size );
+			} );
+	}
+
+	bool usesImages( FramePass const & pass
+		, std::unordered_set< uint32_t > const & imageIds )
+	{
+		bool result{};
+		imgals::forEachImage( pass
+			, [&imageIds, &result]( ImageId image, bool )
+			{
+				result = result || imageIds.find( image.id ) != imageIds.end();
+			} );
+		return result;
+	}
+}
@@ -0,0 +1,43 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/RunnableGraph.hpp"
+
+namespace crg::alias
+{
+	/**
+	*\brief
+	*	Computes the first and last pass using each of the given transient images, in nodes order.
+	*\remarks
+	*	Images which are not used, are graph inputs or outputs,
+	*	or which content is read by their first pass, are not listed.
+	*/
+	TransientImageArray computeLifetimes( std::set< ImageId > const & images
+		, GraphNodePtrArray const & nodes
+		, LayerLayoutStatesHandler const & inputs
+		, LayerLayoutStatesHandler const & outputs );
+	/**
+	*\brief
+	*	Computes the offset of each image, in one memory block per memory type.
+	*\remarks
+	*	Images which lifetimes don't overlap may be given overlapping memory ranges.
+	*\return
+	*	The size of the memory block needed for each memory type.
+	*/
+	std::map< uint32_t, DeviceSize > placeImages( TransientImageArray & images );
+	/**
+	*\return
+	*	\p true if the given image shares a part of its memory with another image.
+	*/
+	bool isAliased( TransientImage const & image
+		, TransientImageArray const & images );
+	/**
+	*\return
+	*	\p true if one of the given pass attachments uses one of the given images.
+	*/
+	bool usesImages( FramePass const & pass
+		, std::unordered_set< uint32_t > const & imageIds );
+}
@@ -0,0 +1,44 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "JsonWriter.hpp"
+
+#include <iomanip>
+#include <ostream>
+
+namespace crg::json
+{
+	void writeString( std::ostream & stream
+		, std::string const & value )
+	{
+		stream << '"';
+
+		for ( auto c : value )
+		{
+			switch ( c )
+			{
+			case '"':
+				stream << "\\\"";
+				break;
+			case '\\':
+				stream << "\\\\";
+				break;
+			case '\n':
+				stream << "\\n";
+				break;
+			case '\t':
+				stream << "\\t";
+				break;
+			default:
+				if ( uint8_t( c ) < 0x20u )
+					stream << "\\u00" << std::hex << std::setw( 2 ) << std::setfill( '0' ) << uint32_t( uint8_t( c ) ) << std::dec;
+				else
+					stream << c;
+				break;
+			}
+		}
+
+		stream << '"';
+	}
+}
@@ -0,0 +1,19 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+#include <iosfwd>
+
+namespace crg::json
+{
+	/**
+	*\brief
+	*	Writes a JSON string, quoted and escaped.
+	*/
+	void writeString( std::ostream & stream
+		, std::string const & value );
+}
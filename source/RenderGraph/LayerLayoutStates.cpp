@@ -0,0 +1,305 @@
+/*
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/LayerLayoutStates.hpp"
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace crg
+{
+	void LayerLayoutStates::setLayoutState( ImageSubresourceRange const & range
+		, LayoutState const & state )
+	{
+		if ( range.layerCount == 0u || range.levelCount == 0u )
+			return;
+
+		auto layerEnd = range.baseArrayLayer + range.layerCount;
+		auto levelEnd = range.baseMipLevel + range.levelCount;
+
+		if ( range.baseArrayLayer == 0u && range.baseMipLevel == 0u
+			&& layerEnd >= m_layerCount && levelEnd >= m_levelCount )
+		{
+			// The whole image is set, the storage becomes uniform.
+			m_layerCount = layerEnd;
+			m_levelCount = levelEnd;
+			m_states.assign( 1u, state );
+			m_counts.assign( 1u, layerEnd * levelEnd );
+			m_indices.clear();
+			return;
+		}
+
+		if ( isUniform()
+			&& m_states.front() == state
+			&& layerEnd <= m_layerCount && levelEnd <= m_levelCount )
+			return;
+
+		doResize( std::max( layerEnd, m_layerCount )
+			, std::max( levelEnd, m_levelCount ) );
+		auto index = doGetPaletteIndex( state );
+
+		for ( auto layer = range.baseArrayLayer; layer < layerEnd; ++layer )
+		{
+			auto it = std::next( m_indices.begin(), ptrdiff_t( layer * m_levelCount + range.baseMipLevel ) );
+
+			for ( auto level = range.baseMipLevel; level < levelEnd; ++level, ++it )
+			{
+				if ( *it != 0u )
+					--m_counts[*it - 1u];
+
+				*it = uint16_t( index + 1u );
+			}
+		}
+
+		m_counts[index] += range.layerCount * range.levelCount;
+
+		if ( m_counts[index] == m_layerCount * m_levelCount )
+		{
+			m_states.assign( 1u, state );
+			m_counts.assign( 1u, m_layerCount * m_levelCount );
+			m_indices.clear();
+		}
+	}
+
+	LayoutState LayerLayoutStates::getLayoutState( ImageSubresourceRange const & range )const
+	{
+		auto layerEnd = std::min( range.baseArrayLayer + range.layerCount, m_layerCount );
+		auto levelEnd = std::min( range.baseMipLevel + range.levelCount, m_levelCount );
+
+		if ( range.baseArrayLayer >= layerEnd || range.baseMipLevel >= levelEnd )
+		{
+			return { ImageLayout::eUndefined
+				, getAccessMask( ImageLayout::eUndefined )
+				, getStageMask( ImageLayout::eUndefined ) };
+		}
+
+		if ( isUniform() )
+			return m_states.front();
+
+		// Each palette entry is looked at once, the walk stops when all the used ones were.
+		auto remaining = std::count_if( m_counts.begin(), m_counts.end()
+			, []( uint32_t count )
+			{
+				return count != 0u;
+			} );
+		std::vector< bool > seen( m_states.size() );
+		LayoutState const * result{};
+		LayoutState merged{};
+
+		for ( auto layer = range.baseArrayLayer; layer < layerEnd && remaining > 0; ++layer )
+		{
+			auto it = std::next( m_indices.begin(), ptrdiff_t( layer * m_levelCount + range.baseMipLevel ) );
+
+			for ( auto level = range.baseMipLevel; level < levelEnd && remaining > 0; ++level, ++it )
+			{
+				if ( *it == 0u || seen[*it - 1u] )
+					continue;
+
+				seen[*it - 1u] = true;
+				--remaining;
+				auto & state = m_states[*it - 1u];
+
+				if ( !result || state.layout < result->layout )
+				{
+					result = &state;
+					merged = state;
+				}
+				else if ( state.layout == result->layout )
+				{
+					merged.state.access |= state.state.access;
+				}
+			}
+		}
+
+		if ( !result )
+		{
+			return { ImageLayout::eUndefined
+				, getAccessMask( ImageLayout::eUndefined )
+				, getStageMask( ImageLayout::eUndefined ) };
+		}
+
+		return merged;
+	}
+
+	LayoutState const * LayerLayoutStates::find( uint32_t layer
+		, uint32_t level )const noexcept
+	{
+		if ( layer >= m_layerCount || level >= m_levelCount )
+			return nullptr;
+
+		if ( isUniform() )
+			return &m_states.front();
+
+		auto index = m_indices[layer * m_levelCount + level];
+		return index == 0u
+			? nullptr
+			: &m_states[index - 1u];
+	}
+
+	LayerLayoutStates::const_iterator LayerLayoutStates::find( uint32_t layer )const
+	{
+		return doFindLayer( layer ) == layer
+			? const_iterator{ *this, layer }
+			: end();
+	}
+
+	std::pair< LayerLayoutStates::const_iterator, bool > LayerLayoutStates::emplace( uint32_t layer
+		, MipLayoutStates const & levels )
+	{
+		if ( auto it = find( layer ); it != end() )
+			return { it, false };
+
+		if ( levels.empty() )
+			return { end(), false };
+
+		for ( auto & [level, state] : levels )
+		{
+			ImageSubresourceRange range{};
+			range.baseArrayLayer = layer;
+			range.layerCount = 1u;
+			range.baseMipLevel = level;
+			range.levelCount = 1u;
+			setLayoutState( range, state );
+		}
+
+		return { const_iterator{ *this, layer }, true };
+	}
+
+	size_t LayerLayoutStates::size()const noexcept
+	{
+		size_t result{};
+
+		for ( auto layer = doFindLayer( 0u ); layer < m_layerCount; layer = doFindLayer( layer + 1u ) )
+			++result;
+
+		return result;
+	}
+
+	MipLayoutStates LayerLayoutStates::getMipLayoutStates( uint32_t layer )const
+	{
+		MipLayoutStates result;
+
+		for ( uint32_t level = 0u; level < m_levelCount; ++level )
+		{
+			if ( auto state = find( layer, level ) )
+				result.emplace( level, *state );
+		}
+
+		return result;
+	}
+
+	LayerMipLayoutStates LayerLayoutStates::getLayerMipLayoutStates()const
+	{
+		LayerMipLayoutStates result;
+		forEach( [&result]( uint32_t layer, uint32_t level, LayoutState const & state )
+			{
+				result[layer].emplace( level, state );
+			} );
+		return result;
+	}
+
+	bool LayerLayoutStates::isSame( LayerLayoutStates const & rhs )const noexcept
+	{
+		if ( m_layerCount == rhs.m_layerCount
+			&& m_levelCount == rhs.m_levelCount
+			&& isUniform() && rhs.isUniform() )
+			return m_states.front() == rhs.m_states.front();
+
+		auto layerCount = std::max( m_layerCount, rhs.m_layerCount );
+		auto levelCount = std::max( m_levelCount, rhs.m_levelCount );
+
+		for ( uint32_t layer = 0u; layer < layerCount; ++layer )
+		{
+			for ( uint32_t level = 0u; level < levelCount; ++level )
+			{
+				auto lhsState = find( layer, level );
+				auto rhsState = rhs.find( layer, level );
+
+				if ( lhsState
+					? ( !rhsState || *lhsState != *rhsState )
+					: rhsState != nullptr )
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	uint32_t LayerLayoutStates::doFindLayer( uint32_t layer )const noexcept
+	{
+		if ( isUniform() )
+			return std::min( layer, m_layerCount );
+
+		for ( ; layer < m_layerCount; ++layer )
+		{
+			auto begin = std::next( m_indices.begin(), ptrdiff_t( layer * m_levelCount ) );
+
+			if ( std::any_of( begin
+				, std::next( begin, ptrdiff_t( m_levelCount ) )
+				, []( uint16_t index )
+				{
+					return index != 0u;
+				} ) )
+				return layer;
+		}
+
+		return m_layerCount;
+	}
+
+	uint16_t LayerLayoutStates::doGetPaletteIndex( LayoutState const & state )
+	{
+		auto it = std::find( m_states.begin(), m_states.end(), state );
+
+		if ( it == m_states.end() )
+		{
+			// Reuses the entry of a state no subresource has anymore.
+			auto countIt = std::find( m_counts.begin(), m_counts.end(), 0u );
+
+			if ( countIt != m_counts.end() )
+			{
+				it = std::next( m_states.begin(), std::distance( m_counts.begin(), countIt ) );
+				*it = state;
+			}
+			else
+			{
+				assert( m_states.size() < std::numeric_limits< uint16_t >::max() );
+				m_counts.push_back( 0u );
+				it = m_states.insert( m_states.end(), state );
+			}
+		}
+
+		return uint16_t( std::distance( m_states.begin(), it ) );
+	}
+
+	void LayerLayoutStates::doResize( uint32_t layerCount
+		, uint32_t levelCount )
+	{
+		if ( !isUniform()
+			&& layerCount == m_layerCount
+			&& levelCount == m_levelCount )
+			return;
+
+		std::vector< uint16_t > indices( size_t( layerCount ) * levelCount );
+
+		for ( uint32_t layer = 0u; layer < m_layerCount; ++layer )
+		{
+			auto dst = std::next( indices.begin(), ptrdiff_t( layer * levelCount ) );
+
+			if ( isUniform() )
+			{
+				std::fill_n( dst, m_levelCount, uint16_t( 1u ) );
+			}
+			else
+			{
+				auto src = std::next( m_indices.begin(), ptrdiff_t( layer * m_levelCount ) );
+				std::copy_n( src, m_levelCount, dst );
+			}
+		}
+
+		m_indices = std::move( indices );
+		m_layerCount = layerCount;
+		m_levelCount = levelCount;
+	}
+}
@@ -0,0 +1,405 @@
+/*
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/MemoryAllocator.hpp"
+#include "RenderGraph/GraphContext.hpp"
+#include "RenderGraph/Log.hpp"
+#include "RenderGraph/MemoryTracker.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <optional>
+#include <set>
+
+namespace crg
+{
+	using lock_type = std::unique_lock< std::mutex >;
+
+	//*********************************************************************************************
+
+	namespace memalc
+	{
+		static DeviceSize getOrder( DeviceSize size
+			, DeviceSize minSize )
+		{
+			return DeviceSize( std::countr_zero( std::bit_ceil( std::max( size, minSize ) ) )
+				- std::countr_zero( minSize ) );
+		}
+
+		static std::string getName( uint32_t memoryType
+			, MemoryResourceKind kind )
+		{
+			return "MemoryBlock_" + std::to_string( memoryType )
+				+ ( kind == MemoryResourceKind::eLinear ? "_Linear" : "_Optimal" );
+		}
+	}
+
+	//*********************************************************************************************
+
+	void * MemoryAllocator::map( GraphContext & context
+		, MemoryAllocation const & allocation )
+	{
+		void * result{};
+		auto res = context.vkMapMemory( context.device
+			, allocation.memory
+			, allocation.offset
+			, allocation.size
+			, 0u
+			, &result );
+		checkVkResult( res, "Memory mapping" );
+		return result;
+	}
+
+	void MemoryAllocator::unmap( GraphContext & context
+		, MemoryAllocation const & allocation )
+	{
+		context.vkUnmapMemory( context.device, allocation.memory );
+	}
+
+	//*********************************************************************************************
+
+	/**
+	*\brief
+	*	A device memory split following a buddy scheme.
+	*\remarks
+	*	A node of order k is minSize << k large, and its offset is a multiple of its size.
+	*/
+	class BlockMemoryAllocator::Block
+	{
+	public:
+		Block( VkDeviceMemory memory
+			, DeviceSize size
+			, DeviceSize minSize )
+			: m_memory{ memory }
+			, m_minSize{ minSize }
+			, m_free( memalc::getOrder( size, minSize ) + 1u )
+		{
+			m_free.back().insert( 0u );
+		}
+
+		std::optional< DeviceSize > allocate( DeviceSize size
+			, DeviceSize alignment )
+		{
+			auto order = memalc::getOrder( std::max( size, alignment ), m_minSize );
+
+			if ( order >= m_free.size() )
+				return std::nullopt;
+
+			auto available = order;
+
+			while ( available < m_free.size() && m_free[available].empty() )
+				++available;
+
+			if ( available == m_free.size() )
+				return std::nullopt;
+
+			auto offset = *m_free[available].begin();
+			m_free[available].erase( m_free[available].begin() );
+
+			// Splits the node down to the wanted order, freeing the upper halves.
+			while ( available > order )
+			{
+				--available;
+				m_free[available].insert( offset + getNodeSize( available ) );
+			}
+
+			m_allocated.try_emplace( offset, order );
+			return offset;
+		}
+		/**
+		*\return
+		*	The size of the freed node.
+		*/
+		DeviceSize free( DeviceSize offset )
+		{
+			auto it = m_allocated.find( offset );
+			assert( it != m_allocated.end() );
+			auto order = it->second;
+			auto result = getNodeSize( order );
+			m_allocated.erase( it );
+
+			// Merges the node with its free buddies.
+			while ( order + 1u < m_free.size() )
+			{
+				auto buddy = offset ^ getNodeSize( order );
+				auto buddyIt = m_free[order].find( buddy );
+
+				if ( buddyIt == m_free[order].end() )
+					break;
+
+				m_free[order].erase( buddyIt );
+				offset = std::min( offset, buddy );
+				++order;
+			}
+
+			m_free[order].insert( offset );
+			return result;
+		}
+
+		DeviceSize getNodeSize( DeviceSize order )const noexcept
+		{
+			return m_minSize << order;
+		}
+
+		bool empty()const noexcept
+		{
+			return m_allocated.empty();
+		}
+
+		VkDeviceMemory getMemory()const noexcept
+		{
+			return m_memory;
+		}
+		/**
+		*\return
+		*	The address of the block first byte, the memory being mapped on the first call.
+		*/
+		uint8_t * map( GraphContext & context )
+		{
+			if ( m_mapCount == 0u )
+			{
+				void * data{};
+				auto res = context.vkMapMemory( context.device
+					, m_memory
+					, 0u
+					, VK_WHOLE_SIZE
+					, 0u
+					, &data );
+				checkVkResult( res, "Memory block mapping" );
+				m_mapped = static_cast< uint8_t * >( data );
+			}
+
+			++m_mapCount;
+			return m_mapped;
+		}
+
+		void unmap( GraphContext & context )
+		{
+			assert( m_mapCount > 0u );
+
+			if ( --m_mapCount == 0u )
+			{
+				context.vkUnmapMemory( context.device, m_memory );
+				m_mapped = nullptr;
+			}
+		}
+
+	private:
+		VkDeviceMemory m_memory;
+		uint8_t * m_mapped{};
+		uint32_t m_mapCount{};
+		DeviceSize m_minSize;
+		/**
+		*\brief
+		*	The offsets of the free nodes, per order.
+		*/
+		std::vector< std::set< DeviceSize > > m_free;
+		/**
+		*\brief
+		*	The order of the allocated nodes, per offset.
+		*/
+		std::unordered_map< DeviceSize, DeviceSize > m_allocated;
+	};
+
+	//*********************************************************************************************
+
+	BlockMemoryAllocator::BlockMemoryAllocator( DeviceSize blockSize
+		, DeviceSize minAllocationSize )
+		: m_blockSize{ std::bit_ceil( blockSize ) }
+		, m_minAllocationSize{ std::min( m_blockSize, std::bit_ceil( std::max( minAllocationSize, DeviceSize( 1u ) ) ) ) }
+	{
+	}
+
+	BlockMemoryAllocator::~BlockMemoryAllocator()noexcept
+	{
+		if ( m_stats.deviceAllocations != 0u )
+		{
+			Logger::logError( "Leaked [VkDeviceMemory] " + std::to_string( m_stats.deviceAllocations )
+				+ " allocations (" + std::to_string( m_stats.blocks ) + " blocks)" );
+		}
+	}
+
+	MemoryAllocation BlockMemoryAllocator::allocate( GraphContext & context
+		, VkMemoryRequirements const & requirements
+		, uint32_t memoryType
+		, MemoryResourceKind kind
+		, std::string const & name )
+	{
+		if ( std::max( requirements.size, requirements.alignment ) > m_blockSize / 2u )
+			return doAllocateDedicated( context, requirements, memoryType, name );
+
+		lock_type lock( m_mutex );
+		PoolKey key{ context.device, memoryType, kind };
+		auto & pool = m_pools[key];
+		MemoryAllocation result{ {}, {}, {}, memoryType, false };
+		Block * block{};
+
+		for ( auto & lookup : pool )
+		{
+			if ( auto offset = lookup->allocate( requirements.size, requirements.alignment ) )
+			{
+				block = lookup.get();
+				result.offset = *offset;
+				break;
+			}
+		}
+
+		if ( !block )
+		{
+			if ( m_tracker )
+				m_tracker->checkBudget( context, memoryType, m_blockSize, name );
+
+			VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
+				, nullptr
+				, m_blockSize
+				, memoryType };
+			VkDeviceMemory memory{};
+			auto res = context.vkAllocateMemory( context.device
+				, &allocateInfo
+				, context.allocator
+				, &memory );
+			checkVkResult( res, "Memory block allocation" );
+
+			if ( m_tracker )
+				m_tracker->addDeviceMemory( context, memoryType, m_blockSize );
+
+			crgRegisterObjectName( context, memalc::getName( memoryType, kind ), memory );
+			block = pool.emplace_back( std::make_unique< Block >( memory, m_blockSize, m_minAllocationSize ) ).get();
+			m_blockPools.try_emplace( memory, key );
+			++m_stats.deviceAllocations;
+			++m_stats.blocks;
+			m_stats.blocksSize += m_blockSize;
+			result.offset = *block->allocate( requirements.size, requirements.alignment );
+		}
+
+		result.memory = block->getMemory();
+		result.size = block->getNodeSize( memalc::getOrder( std::max( requirements.size, requirements.alignment ), m_minAllocationSize ) );
+		++m_stats.subAllocations;
+		m_stats.subAllocatedSize += result.size;
+		return result;
+	}
+
+	void BlockMemoryAllocator::free( GraphContext & context
+		, MemoryAllocation const & allocation )
+	{
+		if ( !allocation.memory )
+			return;
+
+		lock_type lock( m_mutex );
+
+		if ( allocation.dedicated )
+		{
+			if ( context.vkFreeMemory )
+				context.vkFreeMemory( context.device, allocation.memory, context.allocator );
+
+			if ( m_tracker )
+				m_tracker->removeDeviceMemory( context, allocation.memoryType, allocation.size );
+
+			--m_stats.deviceAllocations;
+			--m_stats.dedicatedAllocations;
+			m_stats.dedicatedSize -= allocation.size;
+			return;
+		}
+
+		auto poolIt = m_blockPools.find( allocation.memory );
+		assert( poolIt != m_blockPools.end() );
+		auto & pool = m_pools[poolIt->second];
+		auto it = std::find_if( pool.begin()
+			, pool.end()
+			, [&allocation]( BlockPtr const & lookup )
+			{
+				return lookup->getMemory() == allocation.memory;
+			} );
+		assert( it != pool.end() );
+		--m_stats.subAllocations;
+		m_stats.subAllocatedSize -= ( *it )->free( allocation.offset );
+
+		if ( ( *it )->empty() )
+		{
+			if ( context.vkFreeMemory )
+				context.vkFreeMemory( context.device, allocation.memory, context.allocator );
+
+			if ( m_tracker )
+				m_tracker->removeDeviceMemory( context, allocation.memoryType, m_blockSize );
+
+			pool.erase( it );
+			m_blockPools.erase( poolIt );
+			--m_stats.deviceAllocations;
+			--m_stats.blocks;
+			m_stats.blocksSize -= m_blockSize;
+		}
+	}
+
+	MemoryAllocatorStats BlockMemoryAllocator::getStats()const
+	{
+		lock_type lock( m_mutex );
+		return m_stats;
+	}
+
+	void * BlockMemoryAllocator::map( GraphContext & context
+		, MemoryAllocation const & allocation )
+	{
+		if ( allocation.dedicated )
+			return MemoryAllocator::map( context, allocation );
+
+		lock_type lock( m_mutex );
+		return doFindBlock( allocation ).map( context ) + allocation.offset;
+	}
+
+	void BlockMemoryAllocator::unmap( GraphContext & context
+		, MemoryAllocation const & allocation )
+	{
+		if ( allocation.dedicated )
+			return MemoryAllocator::unmap( context, allocation );
+
+		lock_type lock( m_mutex );
+		doFindBlock( allocation ).unmap( context );
+	}
+
+	BlockMemoryAllocator::Block & BlockMemoryAllocator::doFindBlock( MemoryAllocation const & allocation )
+	{
+		auto poolIt = m_blockPools.find( allocation.memory );
+		assert( poolIt != m_blockPools.end() );
+		auto & pool = m_pools[poolIt->second];
+		auto it = std::find_if( pool.begin()
+			, pool.end()
+			, [&allocation]( BlockPtr const & lookup )
+			{
+				return lookup->getMemory() == allocation.memory;
+			} );
+		assert( it != pool.end() );
+		return **it;
+	}
+
+	MemoryAllocation BlockMemoryAllocator::doAllocateDedicated( GraphContext & context
+		, VkMemoryRequirements const & requirements
+		, uint32_t memoryType
+		, std::string const & name )
+	{
+		MemoryAllocation result{ {}, 0u, requirements.size, memoryType, true };
+
+		if ( m_tracker )
+			m_tracker->checkBudget( context, memoryType, requirements.size, name );
+
+		VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
+			, nullptr
+			, requirements.size
+			, memoryType };
+		auto res = context.vkAllocateMemory( context.device
+			, &allocateInfo
+			, context.allocator
+			, &result.memory );
+		checkVkResult( res, "Dedicated memory allocation" );
+		crgRegisterObjectName( context, name, result.memory );
+
+		if ( m_tracker )
+			m_tracker->addDeviceMemory( context, memoryType, result.size );
+
+		lock_type lock( m_mutex );
+		++m_stats.deviceAllocations;
+		++m_stats.dedicatedAllocations;
+		m_stats.dedicatedSize += result.size;
+		return result;
+	}
+}
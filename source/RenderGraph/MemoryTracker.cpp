@@ -0,0 +1,278 @@
+/*
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/MemoryTracker.hpp"
+#include "RenderGraph/GraphContext.hpp"
+#include "JsonWriter.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace crg
+{
+	namespace memtrk
+	{
+		static void writeUsage( std::ostream & stream
+			, MemoryUsage const & usage )
+		{
+			stream << "{\"live\":" << usage.live
+				<< ",\"peak\":" << usage.peak
+				<< ",\"allocations\":" << usage.allocations << "}";
+		}
+
+		static void writeUsages( std::ostream & stream
+			, std::vector< MemoryUsage > const & usages )
+		{
+			stream << "[";
+
+			for ( auto it = usages.begin(); it != usages.end(); ++it )
+			{
+				if ( it != usages.begin() )
+					stream << ",";
+
+				writeUsage( stream, *it );
+			}
+
+			stream << "]";
+		}
+
+		static MemoryUsage & getUsage( std::vector< MemoryUsage > & usages
+			, uint32_t index )
+		{
+			if ( index >= usages.size() )
+				usages.resize( index + 1u );
+
+			return usages[index];
+		}
+
+		static void sortBySize( std::vector< MemoryResourceUsage > & resources )
+		{
+			std::stable_sort( resources.begin()
+				, resources.end()
+				, []( MemoryResourceUsage const & lhs, MemoryResourceUsage const & rhs )
+				{
+					return lhs.size > rhs.size;
+				} );
+		}
+
+		static void add( MemoryUsage & usage
+			, DeviceSize size )
+		{
+			usage.live += size;
+			usage.peak = std::max( usage.peak, usage.live );
+			++usage.allocations;
+		}
+
+		static void remove( MemoryUsage & usage
+			, DeviceSize size )
+		{
+			usage.live -= size;
+			--usage.allocations;
+		}
+
+		static uint32_t getHeap( GraphContext const & context
+			, uint32_t memoryType )
+		{
+			return memoryType < context.memoryProperties.memoryTypeCount
+				? context.memoryProperties.memoryTypes[memoryType].heapIndex
+				: 0u;
+		}
+	}
+
+	//*********************************************************************************************
+
+	void MemoryReport::writeJson( std::ostream & stream )const
+	{
+		stream << "{\"total\":";
+		memtrk::writeUsage( stream, total );
+		stream << ",\n\"heaps\":";
+		memtrk::writeUsages( stream, heaps );
+		stream << ",\n\"types\":";
+		memtrk::writeUsages( stream, types );
+		stream << ",\n\"graphs\":{";
+
+		for ( auto it = graphs.begin(); it != graphs.end(); ++it )
+		{
+			if ( it != graphs.begin() )
+				stream << ",";
+
+			stream << "\n";
+			json::writeString( stream, it->first );
+			stream << ":";
+			memtrk::writeUsage( stream, it->second );
+		}
+
+		stream << "},\n\"resources\":[";
+
+		for ( auto it = resources.begin(); it != resources.end(); ++it )
+		{
+			if ( it != resources.begin() )
+				stream << ",";
+
+			stream << "\n{\"name\":";
+			json::writeString( stream, it->name );
+			stream << ",\"graph\":";
+			json::writeString( stream, it->graph );
+			stream << ",\"heap\":" << it->heap
+				<< ",\"type\":" << it->memoryType
+				<< ",\"size\":" << it->size << "}";
+		}
+
+		stream << "]}\n";
+	}
+
+	//*********************************************************************************************
+
+	void MemoryTracker::checkBudget( GraphContext & context
+		, uint32_t memoryType
+		, DeviceSize size
+		, std::string const & name )
+	{
+		std::unique_lock lock{ m_mutex };
+
+		if ( !m_budgetCallback
+			|| memoryType >= context.memoryProperties.memoryTypeCount )
+			return;
+
+		MemoryBudgetEvent event{ name
+			, context.memoryProperties.memoryTypes[memoryType].heapIndex
+			, memoryType
+			, size
+			, {}
+			, {} };
+#if VK_EXT_memory_budget
+		if ( context.physicalDevice && context.vkGetPhysicalDeviceMemoryProperties2 )
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT
+				, nullptr
+				, {}
+				, {} };
+			VkPhysicalDeviceMemoryProperties2 properties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2
+				, &budget
+				, {} };
+			context.vkGetPhysicalDeviceMemoryProperties2( context.physicalDevice, &properties );
+			event.usage = budget.heapUsage[event.heap];
+			event.budget = budget.heapBudget[event.heap];
+		}
+		else
+#endif
+		{
+			event.usage = event.heap < m_deviceMemory.size()
+				? m_deviceMemory[event.heap]
+				: 0u;
+			event.budget = context.memoryProperties.memoryHeaps[event.heap].size;
+		}
+
+		if ( event.usage + size <= event.budget )
+			return;
+
+		// The callback may query the tracker.
+		auto callback = m_budgetCallback;
+		lock.unlock();
+		callback( event );
+	}
+
+	void MemoryTracker::addDeviceMemory( GraphContext const & context
+		, uint32_t memoryType
+		, DeviceSize size )
+	{
+		std::lock_guard lock{ m_mutex };
+		auto heap = memtrk::getHeap( context, memoryType );
+
+		if ( heap >= m_deviceMemory.size() )
+			m_deviceMemory.resize( heap + 1u );
+
+		m_deviceMemory[heap] += size;
+	}
+
+	void MemoryTracker::removeDeviceMemory( GraphContext const & context
+		, uint32_t memoryType
+		, DeviceSize size )
+	{
+		std::lock_guard lock{ m_mutex };
+		auto heap = memtrk::getHeap( context, memoryType );
+		assert( heap < m_deviceMemory.size() && m_deviceMemory[heap] >= size );
+		m_deviceMemory[heap] -= size;
+	}
+
+	void MemoryTracker::addAllocation( Key key
+		, std::string name
+		, std::string graph
+		, GraphContext const & context
+		, uint32_t memoryType
+		, DeviceSize size )
+	{
+		std::lock_guard lock{ m_mutex };
+		auto heap = memtrk::getHeap( context, memoryType );
+		auto & graphUsages = m_graphs[graph];
+
+		for ( auto usages : { &m_usages, &graphUsages } )
+		{
+			memtrk::add( usages->total, size );
+			memtrk::add( memtrk::getUsage( usages->heaps, heap ), size );
+			memtrk::add( memtrk::getUsage( usages->types, memoryType ), size );
+		}
+
+		m_allocations.insert_or_assign( key, Allocation{ std::move( name ), std::move( graph ), heap, memoryType, size } );
+	}
+
+	void MemoryTracker::removeAllocation( Key key )
+	{
+		std::lock_guard lock{ m_mutex };
+		auto it = m_allocations.find( key );
+
+		if ( it == m_allocations.end() )
+			return;
+
+		auto & allocation = it->second;
+		auto & graphUsages = m_graphs[allocation.graph];
+
+		for ( auto usages : { &m_usages, &graphUsages } )
+		{
+			memtrk::remove( usages->total, allocation.size );
+			memtrk::remove( usages->heaps[allocation.heap], allocation.size );
+			memtrk::remove( usages->types[allocation.memoryType], allocation.size );
+		}
+
+		m_allocations.erase( it );
+	}
+
+	MemoryReport MemoryTracker::getReport()const
+	{
+		std::lock_guard lock{ m_mutex };
+		MemoryReport result{ m_usages.total, m_usages.heaps, m_usages.types, {}, {} };
+
+		for ( auto & [graph, usages] : m_graphs )
+			result.graphs.try_emplace( graph, usages.total );
+
+		for ( auto & [_, allocation] : m_allocations )
+			result.resources.push_back( { allocation.name, allocation.graph, allocation.heap, allocation.memoryType, allocation.size } );
+
+		memtrk::sortBySize( result.resources );
+		return result;
+	}
+
+	MemoryReport MemoryTracker::getReport( std::string const & graph )const
+	{
+		std::lock_guard lock{ m_mutex };
+		MemoryReport result{};
+		auto graphIt = m_graphs.find( graph );
+
+		if ( graphIt == m_graphs.end() )
+			return result;
+
+		result.total = graphIt->second.total;
+		result.heaps = graphIt->second.heaps;
+		result.types = graphIt->second.types;
+		result.graphs.try_emplace( graph, graphIt->second.total );
+
+		for ( auto & [_, allocation] : m_allocations )
+		{
+			if ( allocation.graph == graph )
+				result.resources.push_back( { allocation.name, allocation.graph, allocation.heap, allocation.memoryType, allocation.size } );
+		}
+
+		memtrk::sortBySize( result.resources );
+		return result;
+	}
+}
@@ -0,0 +1,192 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "QueuePartitions.hpp"
+#include "ImageAliasing.hpp"
+#include "ResourceUses.hpp"
+
+#include "RenderGraph/Attachment.hpp"
+#include "RenderGraph/FramePass.hpp"
+#include "RenderGraph/Log.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace crg::partition
+{
+	namespace qupart
+	{
+		struct ResourceUsers
+		{
+			uint32_t first{};
+			uint32_t last{};
+			bool readFirst{};
+		};
+
+		using UsersMap = std::map< uses::ResourceKey, ResourceUsers >;
+
+		static UsersMap listUsers( std::vector< RunnablePassPtr > const & passes )
+		{
+			UsersMap result;
+			uint32_t passIndex{};
+
+			for ( auto & pass : passes )
+			{
+				for ( auto & use : uses::listUses( pass->getPass() ) )
+				{
+					auto [it, inserted] = result.try_emplace( use.resource, ResourceUsers{ passIndex, passIndex, false } );
+					it->second.last = passIndex;
+
+					if ( it->second.first == passIndex )
+						it->second.readFirst = it->second.readFirst || use.attach->isInput();
+				}
+
+				++passIndex;
+			}
+
+			return result;
+		}
+
+		static bool isInOutputs( uses::ResourceKey const & resource
+			, LayerLayoutStatesHandler const & outputs )
+		{
+			return resource.first
+				&& outputs.images.find( resource.second ) != outputs.images.end();
+		}
+
+		static QueueClass getQueueClass( RunnablePass const & pass
+			, uint32_t passIndex
+			, std::array< bool, 3u > const & available
+			, std::unordered_set< uint32_t > const & aliasedImages
+			, LayerLayoutStatesHandler const & outputs
+			, UsersMap const & users )
+		{
+			auto & framePass = pass.getPass();
+			auto result = framePass.getQueueClass();
+
+			if ( result == QueueClass::eGraphics
+				|| !available[size_t( result )] )
+				return QueueClass::eGraphics;
+
+			if ( result == QueueClass::eCompute
+				&& !pass.isComputePass() )
+			{
+				Logger::logWarning( framePass.getFullName() + " - Not a compute pass, kept on the graphics queue" );
+				return QueueClass::eGraphics;
+			}
+
+			// The memory shared by aliased images is synchronised on the graphics queue only.
+			if ( alias::usesImages( framePass, aliasedImages ) )
+				return QueueClass::eGraphics;
+
+			// The resources content coming from, or going to, outside the frame is owned by the graphics queue.
+			for ( auto & use : uses::listUses( framePass ) )
+			{
+				auto & resUsers = users.at( use.resource );
+				bool crossesFrames = resUsers.readFirst || isInOutputs( use.resource, outputs );
+
+				if ( ( resUsers.first == passIndex && resUsers.readFirst )
+					|| ( resUsers.last == passIndex && crossesFrames ) )
+					return QueueClass::eGraphics;
+			}
+
+			return result;
+		}
+
+		template< typename ValueT >
+		static bool addUnique( std::vector< ValueT > & values
+			, ValueT const & value )
+		{
+			if ( std::find( values.begin(), values.end(), value ) != values.end() )
+				return false;
+
+			values.push_back( value );
+			return true;
+		}
+
+		static void joinLastPartition( QueuePartitionArray & partitions )
+		{
+			std::vector< bool > joined( partitions.size(), false );
+			auto & last = partitions.back();
+			joined.back() = true;
+
+			for ( auto index = uint32_t( partitions.size() ); index-- > 0u; )
+			{
+				if ( !joined[index] )
+				{
+					last.waited.push_back( index );
+					joined[index] = true;
+				}
+
+				for ( auto waited : partitions[index].waited )
+					joined[waited] = true;
+			}
+		}
+	}
+
+	QueuePartitionArray listPartitions( std::vector< RunnablePassPtr > const & passes
+		, std::array< bool, 3u > const & available
+		, std::unordered_set< uint32_t > const & aliasedImages
+		, LayerLayoutStatesHandler const & outputs )
+	{
+		// Without pass, a partition is still needed to signal the graph semaphore and fence.
+		if ( passes.empty() )
+			return { QueuePartition{ QueueClass::eGraphics, 0u, 0u, {}, {} } };
+
+		QueuePartitionArray result;
+		auto users = qupart::listUsers( passes );
+		uint32_t passIndex{};
+
+		for ( auto & pass : passes )
+		{
+			auto queue = qupart::getQueueClass( *pass, passIndex, available, aliasedImages, outputs, users );
+
+			if ( result.empty() || result.back().queue != queue )
+				result.push_back( { queue, passIndex, 0u, {}, {} } );
+
+			++result.back().passCount;
+			++passIndex;
+		}
+
+		if ( result.size() <= 1u )
+			return result;
+
+		std::map< uses::ResourceKey, uint32_t > lastPartitions;
+
+		for ( uint32_t index = 0u; index < result.size(); ++index )
+		{
+			auto & partition = result[index];
+			std::vector< uses::ResourceKey > transferred;
+
+			for ( auto passIt = std::next( passes.begin(), partition.firstPass );
+				passIt != std::next( passes.begin(), partition.firstPass + partition.passCount );
+				++passIt )
+			{
+				for ( auto & use : uses::listUses( ( *passIt )->getPass() ) )
+				{
+					auto [it, inserted] = lastPartitions.try_emplace( use.resource, index );
+
+					if ( inserted )
+					{
+						// First use in the frame, on another queue than the graphics one: the content is not needed.
+						if ( partition.queue != QueueClass::eGraphics
+							&& qupart::addUnique( transferred, use.resource ) )
+							partition.acquired.push_back( { QueueTransfer::FrameStart, use.attach } );
+					}
+					else if ( auto source = std::exchange( it->second, index );
+						source != index
+						&& result[source].queue != partition.queue
+						&& qupart::addUnique( transferred, use.resource ) )
+					{
+						qupart::addUnique( partition.waited, source );
+						partition.acquired.push_back( { source, use.attach } );
+					}
+				}
+			}
+		}
+
+		qupart::joinLastPartition( result );
+		return result;
+	}
+}
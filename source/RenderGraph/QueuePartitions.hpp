@@ -0,0 +1,29 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/RunnableGraph.hpp"
+
+#include <array>
+
+namespace crg::partition
+{
+	/**
+	*\brief
+	*	Splits the passes in runs of consecutive passes submitted to the same queue.
+	*\param available
+	*	Tells, for each QueueClass, if a queue is available for it.
+	*\remarks
+	*	A pass falls back to the graphics queue when its runnable can't run on the wanted queue,
+	*	when it uses an aliased transient image, or when it is the first or the last user
+	*	of a resource which content lives across frames.
+	*\remarks
+	*	The last partition waits, directly or not, for all the other ones.
+	*/
+	QueuePartitionArray listPartitions( std::vector< RunnablePassPtr > const & passes
+		, std::array< bool, 3u > const & available
+		, std::unordered_set< uint32_t > const & aliasedImages
+		, LayerLayoutStatesHandler const & outputs );
+}
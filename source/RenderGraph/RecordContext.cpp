@@ -4,14 +4,18 @@ See LICENSE file in root folder.
 #include "RenderGraph/RecordContext.hpp"
 
 #include "RenderGraph/Exception.hpp"
+#include "RenderGraph/ImageViewData.hpp"
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/ResourceHandler.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
 
+#include <algorithm>
+#include <cassert>
 #include <array>
 #include <string>
 #include <type_traits>
 #include <unordered_set>
+#include <utility>
 
 #pragma warning( push )
 #pragma warning( disable: 5262 )
@@ -24,6 +28,16 @@ namespace crg
 
 	namespace recctx
 	{
+		static bool hasSameImages( std::shared_ptr< LayerLayoutStatesHandler const > const & lhs
+			, std::shared_ptr< LayerLayoutStatesHandler const > const & rhs )
+		{
+			if ( lhs == rhs )
+				return true;
+
+			// No layouts is the same as empty layouts.
+			return ( lhs ? lhs->images : LayerLayoutStatesMap{} ) == ( rhs ? rhs->images : LayerLayoutStatesMap{} );
+		}
+
 		static ImageSubresourceRange adaptRange( GraphContext const & context
 			, ImageType type
 			, PixelFormat format
@@ -66,12 +80,8 @@ namespace crg
 
 	void RecordContext::addStates( RecordContext const & data )
 	{
-		m_images.addStates( data.m_images );
-
-		for ( auto & state : data.m_buffers )
-		{
-			m_buffers.insert( state );
-		}
+		m_images.addMissing( data.m_images );
+		m_buffers.addMissing( data.m_buffers );
 
 		if ( m_prevPipelineState.access < data.m_currPipelineState.access )
 		{
@@ -79,24 +89,67 @@ namespace crg
 		}
 	}
 
+	bool RecordContext::hasSameStates( RecordContext const & rhs )const
+	{
+		auto sameImage = []( ImplicitImageTransition const & lhs, ImplicitImageTransition const & rhs )
+		{
+			return lhs.pass == rhs.pass && lhs.view == rhs.view;
+		};
+		auto sameBuffer = []( ImplicitBufferTransition const & lhs, ImplicitBufferTransition const & rhs )
+		{
+			return lhs.pass == rhs.pass && lhs.view == rhs.view;
+		};
+		return m_images == rhs.m_images
+			&& m_buffers == rhs.m_buffers
+			&& recctx::hasSameImages( m_nextImages, rhs.m_nextImages )
+			&& m_state == rhs.m_state
+			&& m_prevPipelineState == rhs.m_prevPipelineState
+			&& m_currPipelineState == rhs.m_currPipelineState
+			&& m_nextPipelineState == rhs.m_nextPipelineState
+			&& std::equal( m_implicitImageTransitions.begin(), m_implicitImageTransitions.end()
+				, rhs.m_implicitImageTransitions.begin(), rhs.m_implicitImageTransitions.end()
+				, sameImage )
+			&& std::equal( m_implicitBufferTransitions.begin(), m_implicitBufferTransitions.end()
+				, rhs.m_implicitBufferTransitions.begin(), rhs.m_implicitBufferTransitions.end()
+				, sameBuffer );
+	}
+
 	void RecordContext::setNextPipelineState( PipelineState const & state
 		, LayerLayoutStatesMap const & imageLayouts )
 	{
 		m_prevPipelineState = m_currPipelineState;
 		m_currPipelineState = m_nextPipelineState;
 		m_nextPipelineState = state;
-		m_nextImages = LayerLayoutStatesHandler{ imageLayouts };
+		m_nextImages = std::make_shared< LayerLayoutStatesHandler const >( imageLayouts );
+	}
+
+	void RecordContext::setNextPipelineState( PipelineState const & state
+		, std::shared_ptr< LayerLayoutStatesHandler const > imageLayouts )
+	{
+		m_prevPipelineState = m_currPipelineState;
+		m_currPipelineState = m_nextPipelineState;
+		m_nextPipelineState = state;
+		m_nextImages = std::move( imageLayouts );
 	}
 
 	void RecordContext::setLayoutState( ImageViewId view
 		, LayoutState const & layoutState )
 	{
-		m_images.setLayoutState( view, layoutState );
+		assert( view.data->source.empty()
+			&& "Merged image views must be resolved before setting their layout state" );
+		setLayoutState( view.data->image
+			, view.data->info.viewType
+			, view.data->info.subresourceRange
+			, layoutState );
 	}
 
 	LayoutState RecordContext::getLayoutState( ImageViewId view )const
 	{
-		return m_images.getLayoutState( view );
+		assert( view.data->source.empty()
+			&& "Merged image views must be resolved before finding their layout state" );
+		return getLayoutState( view.data->image
+			, view.data->info.viewType
+			, view.data->info.subresourceRange );
 	}
 
 	void RecordContext::setLayoutState( ImageId image
@@ -104,9 +157,8 @@ namespace crg
 		, ImageSubresourceRange const & subresourceRange
 		, LayoutState const & layoutState )
 	{
-		m_images.setLayoutState( image
-			, viewType
-			, subresourceRange
+		addSubresourceRangeLayout( m_images.edit( image.id )
+			, getVirtualRange( image, viewType, subresourceRange )
 			, layoutState );
 	}
 
@@ -114,21 +166,31 @@ namespace crg
 		, ImageViewType viewType
 		, ImageSubresourceRange const & subresourceRange )const
 	{
-		return m_images.getLayoutState( image
-			, viewType
-			, subresourceRange );
+		if ( auto layouts = m_images.find( image.id ) )
+		{
+			return getSubresourceRangeLayout( *layouts
+				, getVirtualRange( image, viewType, subresourceRange ) );
+		}
+
+		return { ImageLayout::eUndefined, { AccessFlags::eNone, PipelineStageFlags::eBottomOfPipe } };
 	}
 
 	LayoutState RecordContext::getNextLayoutState( ImageViewId view )const
 	{
-		return m_nextImages.getLayoutState( view );
+		if ( !m_nextImages )
+			return { ImageLayout::eUndefined, { AccessFlags::eNone, PipelineStageFlags::eBottomOfPipe } };
+
+		return m_nextImages->getLayoutState( view );
 	}
 
 	LayoutState RecordContext::getNextLayoutState( ImageId image
 		, ImageViewType viewType
 		, ImageSubresourceRange const & subresourceRange )const
 	{
-		return m_nextImages.getLayoutState( image
+		if ( !m_nextImages )
+			return { ImageLayout::eUndefined, { AccessFlags::eNone, PipelineStageFlags::eBottomOfPipe } };
+
+		return m_nextImages->getLayoutState( image
 			, viewType
 			, subresourceRange );
 	}
@@ -176,7 +238,7 @@ namespace crg
 
 			if ( !pass->isEnabled() )
 			{
-				action( *this, commandBuffer, index );
+				doRunImplicitAction( action, commandBuffer, index );
 			}
 		}
 	}
@@ -200,7 +262,7 @@ namespace crg
 
 			if ( !pass->isEnabled() )
 			{
-				action( *this, commandBuffer, index );
+				doRunImplicitAction( action, commandBuffer, index );
 			}
 		}
 	}
@@ -220,15 +282,15 @@ namespace crg
 		, [[maybe_unused]] BufferSubresourceRange const & subresourceRange
 		, AccessState const & accessState )
 	{
-		m_buffers.insert_or_assign( buffer.id, accessState );
+		m_buffers.edit( buffer.id ) = accessState;
 	}
 
 	AccessState const & RecordContext::getAccessState( BufferId buffer
 		, [[maybe_unused]] BufferSubresourceRange const & subresourceRange )const
 	{
-		if ( auto bufferIt = m_buffers.find( buffer.id ); bufferIt != m_buffers.end() )
+		if ( auto state = m_buffers.find( buffer.id ) )
 		{
-			return bufferIt->second;
+			return *state;
 		}
 
 		static AccessState const dummy{ AccessFlags::eNone, PipelineStageFlags::eBottomOfPipe };
@@ -303,20 +365,21 @@ namespace crg
 				, VK_QUEUE_FAMILY_IGNORED
 				, resources.createImage( image )
 				, convert( range ) };
-			resources->vkCmdPipelineBarrier( commandBuffer
-				, getPipelineStageFlags( from.state.pipelineStage )
-				, getPipelineStageFlags( wantedState.state.pipelineStage )
-				, VK_DEPENDENCY_BY_REGION_BIT
-				, 0u
-				, nullptr
-				, 0u
-				, nullptr
-				, 1u
-				, &barrier );
+			doPipelineBarrier( commandBuffer
+				, { getPipelineStageFlags( from.state.pipelineStage )
+					, getPipelineStageFlags( wantedState.state.pipelineStage )
+					, barrier } );
 			setLayoutState( image
 				, viewType
 				, range
 				, wantedState );
+
+			if ( m_counters && from.layout != wantedState.layout )
+				m_counters->addLayoutTransition();
+		}
+		else if ( m_counters )
+		{
+			m_counters->addSkippedBarrier();
 		}
 	}
 
@@ -406,20 +469,18 @@ namespace crg
 				, resources.createBuffer( buffer )
 				, subresourceRange.offset
 				, subresourceRange.size };
-			resources->vkCmdPipelineBarrier( commandBuffer
-				, getPipelineStageFlags( from.pipelineStage )
-				, getPipelineStageFlags( wantedState.pipelineStage )
-				, VK_DEPENDENCY_BY_REGION_BIT
-				, 0u
-				, nullptr
-				, 1u
-				, &barrier
-				, 0u
-				, nullptr );
+			doPipelineBarrier( commandBuffer
+				, { getPipelineStageFlags( from.pipelineStage )
+					, getPipelineStageFlags( wantedState.pipelineStage )
+					, barrier } );
 			setAccessState( buffer
 				, subresourceRange
 				, wantedState );
 		}
+		else if ( m_counters )
+		{
+			m_counters->addSkippedBarrier();
+		}
 	}
 
 	void RecordContext::memoryBarrier( VkCommandBuffer commandBuffer
@@ -448,6 +509,203 @@ namespace crg
 			, force );
 	}
 
+	void RecordContext::beginBarrierBatch()
+	{
+		m_batchBarriers = true;
+	}
+
+	void RecordContext::flushBarriers( VkCommandBuffer commandBuffer )
+	{
+		if ( m_pendingImageBarriers.empty() && m_pendingBufferBarriers.empty() )
+			return;
+
+		getContext().vkCmdPipelineBarriers( commandBuffer
+			, VK_DEPENDENCY_BY_REGION_BIT
+			, {}
+			, m_pendingBufferBarriers
+			, m_pendingImageBarriers );
+
+		if ( m_counters )
+			m_counters->addBarrierCommand( uint32_t( m_pendingImageBarriers.size() )
+				, uint32_t( m_pendingBufferBarriers.size() ) );
+
+		m_pendingImageBarriers.clear();
+		m_pendingBufferBarriers.clear();
+	}
+
+	void RecordContext::endBarrierBatch( VkCommandBuffer commandBuffer )
+	{
+		flushBarriers( commandBuffer );
+		m_batchBarriers = false;
+	}
+
+	void RecordContext::waitEvents( VkCommandBuffer commandBuffer
+		, std::span< VkEvent const > events
+		, VkPipelineStageFlags srcStages
+		, VkPipelineStageFlags dstStages )
+	{
+		// Events were set with legacy stages, so the legacy wait command is used.
+		std::vector< VkBufferMemoryBarrier > bufferBarriers;
+		std::vector< VkImageMemoryBarrier > imageBarriers;
+		bufferBarriers.reserve( m_pendingBufferBarriers.size() );
+		imageBarriers.reserve( m_pendingImageBarriers.size() );
+
+		for ( auto & staged : m_pendingBufferBarriers )
+		{
+			dstStages |= staged.dstStageMask;
+			bufferBarriers.push_back( staged.barrier );
+		}
+
+		for ( auto & staged : m_pendingImageBarriers )
+		{
+			dstStages |= staged.dstStageMask;
+			imageBarriers.push_back( staged.barrier );
+		}
+
+		getResources()->vkCmdWaitEvents( commandBuffer
+			, uint32_t( events.size() ), events.data()
+			, srcStages
+			, dstStages
+			, 0u, nullptr
+			, uint32_t( bufferBarriers.size() ), bufferBarriers.data()
+			, uint32_t( imageBarriers.size() ), imageBarriers.data() );
+
+		if ( m_counters )
+			m_counters->addBarrierCommand( uint32_t( imageBarriers.size() )
+				, uint32_t( bufferBarriers.size() ) );
+
+		m_pendingImageBarriers.clear();
+		m_pendingBufferBarriers.clear();
+	}
+
+	void RecordContext::releaseOwnership( VkCommandBuffer commandBuffer
+		, ImageViewId const & view
+		, uint32_t srcFamily
+		, uint32_t dstFamily )
+	{
+		auto image = view.data->image;
+		auto range = recctx::adaptRange( getContext()
+			, image.data->info.imageType
+			, image.data->info.format
+			, getSubresourceRange( view ) );
+		auto from = getLayoutState( image, view.data->info.viewType, range );
+
+		if ( srcFamily == dstFamily
+			|| from.layout == ImageLayout::eUndefined )
+			return;
+
+		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER
+			, nullptr
+			, getAccessFlags( from.state.access )
+			, 0u
+			, convert( from.layout )
+			, convert( from.layout )
+			, srcFamily
+			, dstFamily
+			, getResources().createImage( image )
+			, convert( range ) };
+		doPipelineBarrier( commandBuffer
+			, { getPipelineStageFlags( from.state.pipelineStage )
+				, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+				, barrier } );
+	}
+
+	void RecordContext::releaseOwnership( VkCommandBuffer commandBuffer
+		, BufferViewId const & view
+		, uint32_t srcFamily
+		, uint32_t dstFamily )
+	{
+		if ( srcFamily == dstFamily )
+			return;
+
+		auto range = getSubresourceRange( view );
+		auto & from = getAccessState( view.data->buffer, range );
+		VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER
+			, nullptr
+			, getAccessFlags( from.access )
+			, 0u
+			, srcFamily
+			, dstFamily
+			, getResources().createBuffer( view.data->buffer )
+			, range.offset
+			, range.size };
+		doPipelineBarrier( commandBuffer
+			, { checkFlag( from.pipelineStage, PipelineStageFlags::eBottomOfPipe )
+					? VkPipelineStageFlags( VK_PIPELINE_STAGE_ALL_COMMANDS_BIT )
+					: getPipelineStageFlags( from.pipelineStage )
+				, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+				, barrier } );
+	}
+
+	void RecordContext::acquireOwnership( VkCommandBuffer commandBuffer
+		, ImageViewId const & view
+		, uint32_t srcFamily
+		, uint32_t dstFamily )
+	{
+		auto image = view.data->image;
+		auto range = recctx::adaptRange( getContext()
+			, image.data->info.imageType
+			, image.data->info.format
+			, getSubresourceRange( view ) );
+		auto from = getLayoutState( image, view.data->info.viewType, range );
+
+		if ( from.layout == ImageLayout::eUndefined )
+			return;
+
+		if ( srcFamily != dstFamily )
+		{
+			VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER
+				, nullptr
+				, 0u
+				, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+				, convert( from.layout )
+				, convert( from.layout )
+				, srcFamily
+				, dstFamily
+				, getResources().createImage( image )
+				, convert( range ) };
+			doPipelineBarrier( commandBuffer
+				, { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+					, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+					, barrier } );
+		}
+
+		// The next barrier must chain with the acquire one, whatever its stages.
+		setLayoutState( image
+			, view.data->info.viewType
+			, range
+			, { from.layout, { AccessFlags::eNone, PipelineStageFlags::eAllCommands } } );
+	}
+
+	void RecordContext::acquireOwnership( VkCommandBuffer commandBuffer
+		, BufferViewId const & view
+		, uint32_t srcFamily
+		, uint32_t dstFamily )
+	{
+		auto range = getSubresourceRange( view );
+
+		if ( srcFamily != dstFamily )
+		{
+			VkBufferMemoryBarrier barrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER
+				, nullptr
+				, 0u
+				, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+				, srcFamily
+				, dstFamily
+				, getResources().createBuffer( view.data->buffer )
+				, range.offset
+				, range.size };
+			doPipelineBarrier( commandBuffer
+				, { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+					, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+					, barrier } );
+		}
+
+		setAccessState( view.data->buffer
+			, range
+			, { AccessFlags::eNone, PipelineStageFlags::eAllCommands } );
+	}
+
 	GraphContext & RecordContext::getContext()const
 	{
 		return getResources().getContext();
@@ -689,5 +947,71 @@ namespace crg
 			};
 	}
 
+	void RecordContext::doRunImplicitAction( ImplicitAction const & action
+		, VkCommandBuffer commandBuffer
+		, uint32_t index )
+	{
+		// The action records its own commands, so its barriers can't be deferred.
+		flushBarriers( commandBuffer );
+		auto batchBarriers = std::exchange( m_batchBarriers, false );
+		action( *this, commandBuffer, index );
+		m_batchBarriers = batchBarriers;
+	}
+
+	void RecordContext::doPipelineBarrier( VkCommandBuffer commandBuffer
+		, StagedImageBarrier const & barrier )
+	{
+		if ( !m_batchBarriers )
+		{
+			getContext().vkCmdPipelineBarriers( commandBuffer
+				, VK_DEPENDENCY_BY_REGION_BIT
+				, {}
+				, {}
+				, { &barrier, 1u } );
+
+			if ( m_counters )
+				m_counters->addBarrierCommand( 1u, 0u );
+
+			return;
+		}
+
+		// Two transitions of the same image must not end up in the same command.
+		if ( std::any_of( m_pendingImageBarriers.begin(), m_pendingImageBarriers.end()
+			, [&barrier]( StagedImageBarrier const & lookup )
+			{
+				return lookup.barrier.image == barrier.barrier.image;
+			} ) )
+			flushBarriers( commandBuffer );
+
+		m_pendingImageBarriers.push_back( barrier );
+	}
+
+	void RecordContext::doPipelineBarrier( VkCommandBuffer commandBuffer
+		, StagedBufferBarrier const & barrier )
+	{
+		if ( !m_batchBarriers )
+		{
+			getContext().vkCmdPipelineBarriers( commandBuffer
+				, VK_DEPENDENCY_BY_REGION_BIT
+				, {}
+				, { &barrier, 1u }
+				, {} );
+
+			if ( m_counters )
+				m_counters->addBarrierCommand( 0u, 1u );
+
+			return;
+		}
+
+		if ( std::any_of( m_pendingBufferBarriers.begin(), m_pendingBufferBarriers.end()
+			, [&barrier]( StagedBufferBarrier const & lookup )
+			{
+				return lookup.barrier.buffer == barrier.barrier.buffer;
+			} ) )
+			flushBarriers( commandBuffer );
+
+		m_pendingBufferBarriers.push_back( barrier );
+	}
+
 	//************************************************************************************************
 }
@@ -0,0 +1,84 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "RecordWorkers.hpp"
+
+#include <utility>
+
+namespace crg
+{
+	RecordWorkers::RecordWorkers( uint32_t count )
+	{
+		m_threads.reserve( count );
+
+		for ( uint32_t index = 0u; index < count; ++index )
+			m_threads.emplace_back( [this](){ doWork(); } );
+	}
+
+	RecordWorkers::~RecordWorkers()noexcept
+	{
+		{
+			std::unique_lock< std::mutex > lock{ m_mutex };
+			m_stop = true;
+		}
+		m_wakeUp.notify_all();
+
+		for ( auto & thread : m_threads )
+			thread.join();
+	}
+
+	void RecordWorkers::run( std::vector< Task > const & tasks )
+	{
+		std::unique_lock< std::mutex > lock{ m_mutex };
+		m_tasks = &tasks;
+		m_next = 0u;
+		m_pending = tasks.size();
+		m_error = nullptr;
+		m_wakeUp.notify_all();
+		doRunTasks( lock );
+		m_done.wait( lock, [this](){ return m_pending == 0u; } );
+		m_tasks = nullptr;
+
+		if ( auto error = std::exchange( m_error, nullptr ) )
+			std::rethrow_exception( error );
+	}
+
+	void RecordWorkers::doWork()
+	{
+		std::unique_lock< std::mutex > lock{ m_mutex };
+
+		while ( !m_stop )
+		{
+			m_wakeUp.wait( lock, [this](){ return m_stop || ( m_tasks && m_next < m_tasks->size() ); } );
+			doRunTasks( lock );
+		}
+	}
+
+	void RecordWorkers::doRunTasks( std::unique_lock< std::mutex > & lock )
+	{
+		while ( m_tasks && m_next < m_tasks->size() )
+		{
+			auto & task = ( *m_tasks )[m_next++];
+			lock.unlock();
+			std::exception_ptr error;
+
+			try
+			{
+				task();
+			}
+			catch ( ... )
+			{
+				error = std::current_exception();
+			}
+
+			lock.lock();
+
+			if ( error && !m_error )
+				m_error = error;
+
+			if ( --m_pending == 0u )
+				m_done.notify_all();
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	Threads recording chunks of passes, kept alive between two recordings.
+	*/
+	class RecordWorkers
+	{
+	public:
+		using Task = std::function< void() >;
+
+		RecordWorkers( RecordWorkers const & ) = delete;
+		RecordWorkers & operator=( RecordWorkers const & ) = delete;
+		RecordWorkers( RecordWorkers && )noexcept = delete;
+		RecordWorkers & operator=( RecordWorkers && )noexcept = delete;
+
+		explicit RecordWorkers( uint32_t count );
+		~RecordWorkers()noexcept;
+		/**
+		*\brief
+		*	Runs the given tasks, the calling thread taking its share, and waits for all of them.
+		*\remarks
+		*	The first exception thrown by a task is rethrown, once all tasks are done.
+		*/
+		void run( std::vector< Task > const & tasks );
+
+		uint32_t getCount()const noexcept
+		{
+			return uint32_t( m_threads.size() );
+		}
+
+	private:
+		void doWork();
+		void doRunTasks( std::unique_lock< std::mutex > & lock );
+
+	private:
+		std::vector< std::thread > m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wakeUp;
+		std::condition_variable m_done;
+		std::vector< Task > const * m_tasks{};
+		size_t m_next{};
+		size_t m_pending{};
+		std::exception_ptr m_error;
+		bool m_stop{};
+	};
+}
@@ -64,6 +64,20 @@ namespace crg
 			return result;
 		}
 
+		static VkImage createImage( GraphContext & context
+			, ImageId imageId
+			, VkImage & image )
+		{
+			auto createInfo = convert( *imageId.data );
+			auto res = context.vkCreateImage( context.device
+				, &createInfo
+				, context.allocator
+				, &image );
+			checkVkResult( res, "Image creation" );
+			crgRegisterObjectName( context, imageId.data->name, image );
+			return image;
+		}
+
 		static size_t makeHash( SamplerDesc const & samplerDesc )
 		{
 			auto result = std::hash< FilterMode >{}( samplerDesc.magFilter );
@@ -78,6 +92,46 @@ namespace crg
 			return result;
 		}
 
+		static size_t makeHash( BufferViewData const & view )
+		{
+			auto result = std::hash< uint32_t >{}( view.buffer.id );
+			result = hashCombine( result, view.info.format );
+			result = hashCombine( result, view.info.subresourceRange.offset );
+			result = hashCombine( result, view.info.subresourceRange.size );
+			return result;
+		}
+
+		static size_t makeHash( ImageViewData const & view )
+		{
+			auto result = std::hash< uint32_t >{}( view.image.id );
+			result = hashCombine( result, view.info.flags );
+			result = hashCombine( result, view.info.viewType );
+			result = hashCombine( result, view.info.format );
+			result = hashCombine( result, view.info.subresourceRange.aspectMask );
+			result = hashCombine( result, view.info.subresourceRange.baseMipLevel );
+			result = hashCombine( result, view.info.subresourceRange.levelCount );
+			result = hashCombine( result, view.info.subresourceRange.baseArrayLayer );
+			result = hashCombine( result, view.info.subresourceRange.layerCount );
+			return result;
+		}
+
+		template< typename DataT >
+		static Id< DataT > findView( std::unordered_multimap< size_t, Id< DataT > > const & views
+			, size_t hash
+			, DataT const & view )
+		{
+			auto [begin, end] = views.equal_range( hash );
+			auto it = std::find_if( begin
+				, end
+				, [&view]( std::pair< size_t const, Id< DataT > > const & lookup )
+				{
+					return *lookup.second.data == view;
+				} );
+			return it == end
+				? Id< DataT >{}
+				: it->second;
+		}
+
 		static size_t makeHash( bool texCoords
 			, Texcoord const & config )
 		{
@@ -90,35 +144,41 @@ namespace crg
 
 	//*********************************************************************************************
 
+	ResourceHandler::ResourceHandler()
+		: m_allocator{ std::make_unique< BlockMemoryAllocator >() }
+	{
+		m_allocator->setMemoryTracker( &m_memoryTracker );
+	}
+
 	ResourceHandler::~ResourceHandler()noexcept
 	{
-		for ( auto const & [data, _] : m_bufferViews )
-		{
-			std::stringstream stream;
-			stream << "Leaked [VkBufferView](" << data.data->name << ")";
-			Logger::logError( stream.str() );
-		}
+		m_bufferViews.forEach( []( auto const & data, auto const & )
+			{
+				std::stringstream stream;
+				stream << "Leaked [VkBufferView](" << data.data->name << ")";
+				Logger::logError( stream.str() );
+			} );
 
-		for ( auto const & [data, _] : m_buffers )
-		{
-			std::stringstream stream;
-			stream << "Leaked [VkBuffer](" << data.data->name << ")";
-			Logger::logError( stream.str() );
-		}
+		m_buffers.forEach( []( auto const & data, auto const & )
+			{
+				std::stringstream stream;
+				stream << "Leaked [VkBuffer](" << data.data->name << ")";
+				Logger::logError( stream.str() );
+			} );
 
-		for ( auto const & [data, _] : m_imageViews )
-		{
-			std::stringstream stream;
-			stream << "Leaked [VkImageView](" << data.data->name << ")";
-			Logger::logError( stream.str() );
-		}
+		m_imageViews.forEach( []( auto const & data, auto const & )
+			{
+				std::stringstream stream;
+				stream << "Leaked [VkImageView](" << data.data->name << ")";
+				Logger::logError( stream.str() );
+			} );
 
-		for ( auto const & [data, _] : m_images )
-		{
-			std::stringstream stream;
-			stream << "Leaked [VkImage](" << data.data->name << ")";
-			Logger::logError( stream.str() );
-		}
+		m_images.forEach( []( auto const & data, auto const & )
+			{
+				std::stringstream stream;
+				stream << "Leaked [VkImage](" << data.data->name << ")";
+				Logger::logError( stream.str() );
+			} );
 
 		for ( auto const & [_, data] : m_samplers )
 		{
@@ -128,6 +188,15 @@ namespace crg
 		}
 	}
 
+	void ResourceHandler::setMemoryAllocator( MemoryAllocatorPtr allocator )
+	{
+		lock_type bufferLock( m_buffersMutex );
+		lock_type imageLock( m_imagesMutex );
+		assert( m_buffers.empty() && m_images.empty() );
+		m_allocator = std::move( allocator );
+		m_allocator->setMemoryTracker( &m_memoryTracker );
+	}
+
 	BufferId ResourceHandler::createBufferId( BufferData const & img )
 	{
 		lock_type lock( m_buffersMutex );
@@ -140,37 +209,30 @@ namespace crg
 	BufferViewId ResourceHandler::createViewId( BufferViewData const & view )
 	{
 		lock_type lock( m_bufferViewsMutex );
-		auto it = std::find_if( m_bufferViewIds.begin()
-			, m_bufferViewIds.end()
-			, [&view]( BufferViewIdDataOwnerCont::value_type const & lookup )
-			{
-				return *lookup.second == view;
-			} );
-		BufferViewId result{};
+		auto hash = reshdl::makeHash( view );
+		auto result = reshdl::findView( m_bufferViewHashes, hash, view );
 
-		if ( it == m_bufferViewIds.end() )
+		if ( result.id == 0u )
 		{
 			auto data = std::make_unique< BufferViewData >( view );
 			result = BufferViewId{ uint32_t( m_bufferViewIds.size() + 1u ), data.get() };
 			m_bufferViewIds.try_emplace( result, std::move( data ) );
-		}
-		else
-		{
-			result = it->first;
+			m_bufferViewHashes.emplace( hash, result );
 		}
 
 		return result;
 	}
 
 	ResourceHandler::CreatedT< VkBuffer > ResourceHandler::createBuffer( GraphContext & context
-		, BufferId bufferId )
+		, BufferId bufferId
+		, std::string const & graph )
 	{
 		ResourceHandler::CreatedT< VkBuffer > result{};
 
 		if ( context.vkCreateBuffer )
 		{
 			lock_type lock( m_buffersMutex );
-			auto [it, ins] = m_buffers.try_emplace( bufferId, std::pair< VkBuffer, VkDeviceMemory >{} );
+			auto [value, ins] = m_buffers.tryEmplace( bufferId );
 
 			if ( ins && context.device )
 			{
@@ -179,8 +241,8 @@ namespace crg
 				auto res = context.vkCreateBuffer( context.device
 					, &createInfo
 					, context.allocator
-					, &it->second.first );
-				result.resource = it->second.first;
+					, &value->first );
+				result.resource = value->first;
 				checkVkResult( res, "Buffer creation" );
 				crgRegisterObjectName( context, bufferId.data->name, result.resource );
 
@@ -191,30 +253,31 @@ namespace crg
 					, &requirements );
 				uint32_t deduced = context.deduceMemoryType( requirements.memoryTypeBits
 					, getMemoryPropertyFlags( bufferId.data->info.memory ) );
-				VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
-					, nullptr
-					, requirements.size
-					, deduced };
-				res = context.vkAllocateMemory( context.device
-					, &allocateInfo
-					, context.allocator
-					, &it->second.second );
-				result.memory = it->second.second;
-				checkVkResult( res, "Buffer memory allocation" );
-				crgRegisterObjectName( context, bufferId.data->name, result.memory );
+				value->second = m_allocator->allocate( context
+					, requirements
+					, deduced
+					, MemoryResourceKind::eLinear
+					, bufferId.data->name );
+				m_memoryTracker.addAllocation( { bufferId.data, 0u }
+					, bufferId.data->name
+					, graph
+					, context
+					, deduced
+					, value->second.size );
+				result.memory = value->second;
 
 				// Bind buffer and memory
 				res = context.vkBindBufferMemory( context.device
 					, result.resource
-					, result.memory
-					, 0u );
+					, result.memory.memory
+					, result.memory.offset );
 				checkVkResult( res, "Buffer memory binding" );
 				result.created = true;
 			}
 			else
 			{
-				result.resource = it->second.first;
-				result.memory = it->second.second;
+				result.resource = value->first;
+				result.memory = value->second;
 			}
 		}
 
@@ -222,31 +285,32 @@ namespace crg
 	}
 
 	ResourceHandler::CreatedViewT< VkBufferView > ResourceHandler::createBufferView( GraphContext & context
-		, BufferViewId view )
+		, BufferViewId view
+		, std::string const & graph )
 	{
 		ResourceHandler::CreatedViewT< VkBufferView > result{};
 
 		if ( context.vkCreateBufferView )
 		{
 			lock_type lock( m_bufferViewsMutex );
-			auto [it, ins] = m_bufferViews.try_emplace( view, VkBufferView{} );
+			auto [value, ins] = m_bufferViews.tryEmplace( view );
 
 			if ( ins )
 			{
-				auto buffer = createBuffer( context, view.data->buffer ).resource;
+				auto buffer = createBuffer( context, view.data->buffer, graph ).resource;
 				auto createInfo = reshdl::convert( *view.data, buffer );
 				auto res = context.vkCreateBufferView( context.device
 					, &createInfo
 					, context.allocator
-					, &it->second );
+					, value );
 				checkVkResult( res, "BufferView creation" );
-				crgRegisterObjectName( context, view.data->name, it->second );
-				result.view = it->second;
+				crgRegisterObjectName( context, view.data->name, *value );
+				result.view = *value;
 				result.created = true;
 			}
 			else
 			{
-				result.view = it->second;
+				result.view = *value;
 			}
 		}
 
@@ -265,49 +329,35 @@ namespace crg
 	ImageViewId ResourceHandler::createViewId( ImageViewData const & view )
 	{
 		lock_type lock( m_imageViewsMutex );
-		auto it = std::find_if( m_imageViewIds.begin()
-			, m_imageViewIds.end()
-			, [&view]( ImageViewIdDataOwnerCont::value_type const & lookup )
-			{
-				return *lookup.second == view;
-			} );
-		ImageViewId result{};
+		auto hash = reshdl::makeHash( view );
+		auto result = reshdl::findView( m_imageViewHashes, hash, view );
 
-		if ( it == m_imageViewIds.end() )
+		if ( result.id == 0u )
 		{
 			auto data = std::make_unique< ImageViewData >( view );
 			result = ImageViewId{ uint32_t( m_imageViewIds.size() + 1u ), data.get() };
 			m_imageViewIds.try_emplace( result, std::move( data ) );
-		}
-		else
-		{
-			result = it->first;
+			m_imageViewHashes.emplace( hash, result );
 		}
 
 		return result;
 	}
 
 	ResourceHandler::CreatedT< VkImage > ResourceHandler::createImage( GraphContext & context
-		, ImageId imageId )
+		, ImageId imageId
+		, std::string const & graph )
 	{
 		ResourceHandler::CreatedT< VkImage > result{};
 
 		if ( context.vkCreateImage )
 		{
 			lock_type lock( m_imagesMutex );
-			auto [it, ins] = m_images.try_emplace( imageId, std::pair< VkImage, VkDeviceMemory >{} );
+			auto [value, ins] = m_images.tryEmplace( imageId );
 
 			if ( ins && context.device )
 			{
 				// Create image
-				auto createInfo = reshdl::convert( *imageId.data );
-				auto res = context.vkCreateImage( context.device
-					, &createInfo
-					, context.allocator
-					, &it->second.first );
-				result.resource = it->second.first;
-				checkVkResult( res, "Image creation" );
-				crgRegisterObjectName( context, imageId.data->name, result.resource );
+				result.resource = reshdl::createImage( context, imageId, value->first );
 
 				// Create Image memory
 				VkMemoryRequirements requirements{};
@@ -316,30 +366,58 @@ namespace crg
 					, &requirements );
 				uint32_t deduced = context.deduceMemoryType( requirements.memoryTypeBits
 					, getMemoryPropertyFlags( imageId.data->info.memory ) );
-				VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
-					, nullptr
-					, requirements.size
-					, deduced };
-				res = context.vkAllocateMemory( context.device
-					, &allocateInfo
-					, context.allocator
-					, &it->second.second );
-				result.memory = it->second.second;
-				checkVkResult( res, "Image memory allocation" );
-				crgRegisterObjectName( context, imageId.data->name, result.memory );
+				value->second = m_allocator->allocate( context
+					, requirements
+					, deduced
+					, ( imageId.data->info.tiling == ImageTiling::eOptimal
+						? MemoryResourceKind::eOptimal
+						: MemoryResourceKind::eLinear )
+					, imageId.data->name );
+				m_memoryTracker.addAllocation( { imageId.data, 0u }
+					, imageId.data->name
+					, graph
+					, context
+					, deduced
+					, value->second.size );
+				result.memory = value->second;
 
 				// Bind image and memory
-				res = context.vkBindImageMemory( context.device
+				auto res = context.vkBindImageMemory( context.device
 					, result.resource
-					, result.memory
-					, 0u );
+					, result.memory.memory
+					, result.memory.offset );
 				checkVkResult( res, "Image memory binding" );
 				result.created = true;
 			}
 			else
 			{
-				result.resource = it->second.first;
-				result.memory = it->second.second;
+				result.resource = value->first;
+				result.memory = value->second;
+			}
+		}
+
+		return result;
+	}
+
+	ResourceHandler::CreatedT< VkImage > ResourceHandler::createUnboundImage( GraphContext & context
+		, ImageId imageId )
+	{
+		ResourceHandler::CreatedT< VkImage > result{};
+
+		if ( context.vkCreateImage )
+		{
+			lock_type lock( m_imagesMutex );
+			auto [value, ins] = m_images.tryEmplace( imageId );
+
+			if ( ins && context.device )
+			{
+				result.resource = reshdl::createImage( context, imageId, value->first );
+				result.created = true;
+			}
+			else
+			{
+				result.resource = value->first;
+				result.memory = value->second;
 			}
 		}
 
@@ -347,31 +425,32 @@ namespace crg
 	}
 
 	ResourceHandler::CreatedViewT< VkImageView > ResourceHandler::createImageView( GraphContext & context
-		, ImageViewId view )
+		, ImageViewId view
+		, std::string const & graph )
 	{
 		ResourceHandler::CreatedViewT< VkImageView > result{};
 
 		if ( context.vkCreateImageView )
 		{
 			lock_type lock( m_bufferViewsMutex );
-			auto [it, ins] = m_imageViews.try_emplace( view, VkImageView{} );
+			auto [value, ins] = m_imageViews.tryEmplace( view );
 
 			if ( ins )
 			{
-				auto image = createImage( context, view.data->image ).resource;
+				auto image = createImage( context, view.data->image, graph ).resource;
 				auto createInfo = reshdl::convert( *view.data, image );
 				auto res = context.vkCreateImageView( context.device
 					, &createInfo
 					, context.allocator
-					, &it->second );
+					, value );
 				checkVkResult( res, "ImageView creation" );
-				crgRegisterObjectName( context, view.data->name, it->second );
-				result.view = it->second;
+				crgRegisterObjectName( context, view.data->name, *value );
+				result.view = *value;
 				result.created = true;
 			}
 			else
 			{
-				result.view = it->second;
+				result.view = *value;
 			}
 		}
 
@@ -441,14 +520,8 @@ namespace crg
 			if ( context.device )
 			{
 				auto created = createBuffer( context, vertexBuffer->buffer.data->buffer );
-				reshdl::Quad::Vertex * buffer{};
-				auto res = context.vkMapMemory( context.device
-					, created.memory
-					, 0u
-					, VK_WHOLE_SIZE
-					, 0u
-					, reinterpret_cast< void ** >( &buffer ) );
-				checkVkResult( res, "Buffer memory mapping" );
+				// The memory block may be shared with other host visible resources, it is mapped by the allocator.
+				auto buffer = static_cast< reshdl::Quad::Vertex * >( m_allocator->map( context, created.memory ) );
 
 				if ( buffer )
 				{
@@ -470,11 +543,11 @@ namespace crg
 
 					VkMappedMemoryRange memoryRange{ VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE
 						, nullptr
-						, created.memory
-						, 0u
-						, VK_WHOLE_SIZE };
+						, created.memory.memory
+						, created.memory.offset
+						, created.memory.size };
 					context.vkFlushMappedMemoryRanges( context.device, 1u, &memoryRange );
-					context.vkUnmapMemory( context.device, created.memory );
+					m_allocator->unmap( context, created.memory );
 				}
 
 				vertexBuffer->vertexAttribs.push_back( { 0u, 0u, VK_FORMAT_R32G32_SFLOAT, offsetof( reshdl::Quad::Vertex, position ) } );
@@ -504,21 +577,18 @@ namespace crg
 		, BufferId bufferId )
 	{
 		lock_type lock( m_buffersMutex );
-		auto it = m_buffers.find( bufferId );
+		auto value = m_buffers.find( bufferId );
 
-		if ( it != m_buffers.end() )
+		if ( value )
 		{
-			if ( context.vkDestroyBuffer && it->second.first )
+			if ( context.vkDestroyBuffer && value->first )
 			{
-				context.vkDestroyBuffer( context.device, it->second.first, context.allocator );
+				context.vkDestroyBuffer( context.device, value->first, context.allocator );
 			}
 
-			if ( context.vkFreeMemory && it->second.second )
-			{
-				context.vkFreeMemory( context.device, it->second.second, context.allocator );
-			}
-
-			m_buffers.erase( it );
+			m_memoryTracker.removeAllocation( { bufferId.data, 0u } );
+			m_allocator->free( context, value->second );
+			m_buffers.erase( bufferId );
 		}
 	}
 
@@ -526,16 +596,16 @@ namespace crg
 		, BufferViewId viewId )
 	{
 		lock_type lock( m_bufferViewsMutex );
-		auto it = m_bufferViews.find( viewId );
+		auto value = m_bufferViews.find( viewId );
 
-		if ( it != m_bufferViews.end() )
+		if ( value )
 		{
-			if ( context.vkDestroyBufferView && it->second )
+			if ( context.vkDestroyBufferView && *value )
 			{
-				context.vkDestroyBufferView( context.device, it->second, context.allocator );
+				context.vkDestroyBufferView( context.device, *value, context.allocator );
 			}
 
-			m_bufferViews.erase( it );
+			m_bufferViews.erase( viewId );
 		}
 	}
 
@@ -543,21 +613,18 @@ namespace crg
 		, ImageId imageId )
 	{
 		lock_type lock( m_imagesMutex );
-		auto it = m_images.find( imageId );
+		auto value = m_images.find( imageId );
 
-		if ( it != m_images.end() )
+		if ( value )
 		{
-			if ( context.vkDestroyImage && it->second.first )
-			{
-				context.vkDestroyImage( context.device, it->second.first, context.allocator );
-			}
-
-			if ( context.vkFreeMemory && it->second.second )
+			if ( context.vkDestroyImage && value->first )
 			{
-				context.vkFreeMemory( context.device, it->second.second, context.allocator );
+				context.vkDestroyImage( context.device, value->first, context.allocator );
 			}
 
-			m_images.erase( it );
+			m_memoryTracker.removeAllocation( { imageId.data, 0u } );
+			m_allocator->free( context, value->second );
+			m_images.erase( imageId );
 		}
 	}
 
@@ -565,16 +632,16 @@ namespace crg
 		, ImageViewId viewId )
 	{
 		lock_type lock( m_bufferViewsMutex );
-		auto it = m_imageViews.find( viewId );
+		auto value = m_imageViews.find( viewId );
 
-		if ( it != m_imageViews.end() )
+		if ( value )
 		{
-			if ( context.vkDestroyImageView && it->second )
+			if ( context.vkDestroyImageView && *value )
 			{
-				context.vkDestroyImageView( context.device, it->second, context.allocator );
+				context.vkDestroyImageView( context.device, *value, context.allocator );
 			}
 
-			m_imageViews.erase( it );
+			m_imageViews.erase( viewId );
 		}
 	}
 
@@ -620,33 +687,35 @@ namespace crg
 	//*********************************************************************************************
 
 	ContextResourcesCache::ContextResourcesCache( ResourceHandler & handler
-		, GraphContext & context )
+		, GraphContext & context
+		, std::string graph )
 		: m_handler{ handler }
 		, m_context{ context }
+		, m_graph{ std::move( graph ) }
 	{
 	}
 
 	ContextResourcesCache::~ContextResourcesCache()noexcept
 	{
-		for ( auto const & [bufferView, _] : m_bufferViews )
-		{
-			m_handler.destroyBufferView( m_context, bufferView );
-		}
+		m_bufferViews.forEach( [this]( auto const & bufferView, auto const & )
+			{
+				m_handler.destroyBufferView( m_context, bufferView );
+			} );
 
-		for ( auto const & [buffer, _] : m_buffers )
-		{
-			m_handler.destroyBuffer( m_context, buffer );
-		}
+		m_buffers.forEach( [this]( auto const & buffer, auto const & )
+			{
+				m_handler.destroyBuffer( m_context, buffer );
+			} );
 
-		for ( auto const & [imageView, _] : m_imageViews )
-		{
-			m_handler.destroyImageView( m_context, imageView );
-		}
+		m_imageViews.forEach( [this]( auto const & imageView, auto const & )
+			{
+				m_handler.destroyImageView( m_context, imageView );
+			} );
 
-		for ( auto const & [image, _] : m_images )
-		{
-			m_handler.destroyImage( m_context, image );
-		}
+		m_images.forEach( [this]( auto const & image, auto const & )
+			{
+				m_handler.destroyImage( m_context, image );
+			} );
 
 		for ( auto const & [_, sampler] : m_samplers )
 		{
@@ -661,13 +730,14 @@ namespace crg
 
 	VkBuffer ContextResourcesCache::createBuffer( BufferId const & buffer )
 	{
-		VkDeviceMemory memory{};
+		MemoryAllocation memory{};
 		return createBuffer( buffer, memory );
 	}
 
-	VkBuffer ContextResourcesCache::createBuffer( BufferId const & buffer, VkDeviceMemory & memory )
+	VkBuffer ContextResourcesCache::createBuffer( BufferId const & buffer, MemoryAllocation & memory )
 	{
-		auto [created, result, mem] = m_handler.createBuffer( m_context, buffer );
+		lock_type lock( m_mutex );
+		auto [created, result, mem] = m_handler.createBuffer( m_context, buffer, m_graph );
 
 		if ( created )
 		{
@@ -680,7 +750,8 @@ namespace crg
 
 	VkBufferView ContextResourcesCache::createBufferView( BufferViewId const & view )
 	{
-		auto [created, result] = m_handler.createBufferView( m_context, view );
+		lock_type lock( m_mutex );
+		auto [created, result] = m_handler.createBufferView( m_context, view, m_graph );
 
 		if ( created )
 		{
@@ -692,8 +763,8 @@ namespace crg
 
 	bool ContextResourcesCache::destroyBuffer( BufferId const & bufferId )
 	{
-		auto it = m_buffers.find( bufferId );
-		auto result = it != m_buffers.end();
+		lock_type lock( m_mutex );
+		auto result = m_buffers.find( bufferId ) != nullptr;
 
 		if ( result )
 		{
@@ -705,8 +776,8 @@ namespace crg
 
 	bool ContextResourcesCache::destroyBufferView( BufferViewId const & viewId )
 	{
-		auto it = m_bufferViews.find( viewId );
-		auto result = it != m_bufferViews.end();
+		lock_type lock( m_mutex );
+		auto result = m_bufferViews.find( viewId ) != nullptr;
 
 		if ( result )
 		{
@@ -718,13 +789,14 @@ namespace crg
 
 	VkImage ContextResourcesCache::createImage( ImageId const & image )
 	{
-		VkDeviceMemory memory{};
+		MemoryAllocation memory{};
 		return createImage( image, memory );
 	}
 
-	VkImage ContextResourcesCache::createImage( ImageId const & image, VkDeviceMemory & memory )
+	VkImage ContextResourcesCache::createImage( ImageId const & image, MemoryAllocation & memory )
 	{
-		auto [created, result, mem] = m_handler.createImage( m_context, image );
+		lock_type lock( m_mutex );
+		auto [created, result, mem] = m_handler.createImage( m_context, image, m_graph );
 
 		if ( created )
 		{
@@ -735,9 +807,24 @@ namespace crg
 		return result;
 	}
 
+	VkImage ContextResourcesCache::createUnboundImage( ImageId const & image )
+	{
+		lock_type lock( m_mutex );
+		auto [created, result, mem] = m_handler.createUnboundImage( m_context, image );
+
+		if ( !created )
+		{
+			return VkImage{};
+		}
+
+		m_images[image] = result;
+		return result;
+	}
+
 	VkImageView ContextResourcesCache::createImageView( ImageViewId const & view )
 	{
-		auto [created, result] = m_handler.createImageView( m_context, view );
+		lock_type lock( m_mutex );
+		auto [created, result] = m_handler.createImageView( m_context, view, m_graph );
 
 		if ( created )
 		{
@@ -749,8 +836,8 @@ namespace crg
 
 	bool ContextResourcesCache::destroyImage( ImageId const & imageId )
 	{
-		auto it = m_images.find( imageId );
-		auto result = it != m_images.end();
+		lock_type lock( m_mutex );
+		auto result = m_images.find( imageId ) != nullptr;
 
 		if ( result )
 		{
@@ -762,8 +849,8 @@ namespace crg
 
 	bool ContextResourcesCache::destroyImageView( ImageViewId const & viewId )
 	{
-		auto it = m_imageViews.find( viewId );
-		auto result = it != m_imageViews.end();
+		lock_type lock( m_mutex );
+		auto result = m_imageViews.find( viewId ) != nullptr;
 
 		if ( result )
 		{
@@ -775,6 +862,7 @@ namespace crg
 
 	VkSampler ContextResourcesCache::createSampler( SamplerDesc const & samplerDesc )
 	{
+		lock_type lock( m_mutex );
 		auto hash = reshdl::makeHash( samplerDesc );
 		auto [it, res] = m_samplers.try_emplace( hash, VkSampler{} );
 
@@ -791,6 +879,7 @@ namespace crg
 	VertexBuffer const & ContextResourcesCache::createQuadTriVertexBuffer( bool texCoords
 		, Texcoord const & config )
 	{
+		lock_type lock( m_mutex );
 		auto hash = reshdl::makeHash( texCoords, config );
 		auto [it, res] = m_vertexBuffers.emplace( hash, nullptr );
 
@@ -814,7 +903,7 @@ namespace crg
 
 	VkBuffer ResourcesCache::createBuffer( GraphContext & context
 		, BufferId const & bufferId
-		, VkDeviceMemory & memory )
+		, MemoryAllocation & memory )
 	{
 		auto & cache = getContextCache( context );
 		return cache.createBuffer( bufferId, memory );
@@ -872,7 +961,7 @@ namespace crg
 
 	VkImage ResourcesCache::createImage( GraphContext & context
 		, ImageId const & imageId
-		, VkDeviceMemory & memory )
+		, MemoryAllocation & memory )
 	{
 		auto & cache = getContextCache( context );
 		return cache.createImage( imageId, memory );
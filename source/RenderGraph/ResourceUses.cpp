@@ -0,0 +1,57 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "ResourceUses.hpp"
+
+#include "RenderGraph/Attachment.hpp"
+#include "RenderGraph/BufferViewData.hpp"
+#include "RenderGraph/FramePass.hpp"
+#include "RenderGraph/ImageViewData.hpp"
+
+namespace crg::uses
+{
+	namespace resuse
+	{
+		static void listUses( Attachment const & attach
+			, std::vector< ResourceUse > & uses )
+		{
+			if ( attach.isImage() )
+			{
+				for ( uint32_t index = 0u; index < attach.getViewCount(); ++index )
+				{
+					auto view = attach.view( index );
+					uses.push_back( { { true, view.data->image.id }, &attach } );
+
+					for ( auto & source : view.data->source )
+						uses.push_back( { { true, source.data->image.id }, &attach } );
+				}
+			}
+			else
+			{
+				for ( uint32_t index = 0u; index < attach.getBufferCount(); ++index )
+					uses.push_back( { { false, attach.buffer( index ).data->buffer.id }, &attach } );
+			}
+		}
+	}
+
+	std::vector< ResourceUse > listUses( FramePass const & pass )
+	{
+		std::vector< ResourceUse > result;
+
+		for ( auto & [_, attach] : pass.getUniforms() )
+			resuse::listUses( *attach, result );
+		for ( auto & [_, attach] : pass.getSampled() )
+			resuse::listUses( *attach.attach, result );
+		for ( auto & [_, attach] : pass.getInputs() )
+			resuse::listUses( *attach, result );
+		for ( auto & [_, attach] : pass.getInouts() )
+			resuse::listUses( *attach, result );
+		for ( auto & [_, attach] : pass.getOutputs() )
+			resuse::listUses( *attach, result );
+		for ( auto attach : pass.getTargets() )
+			resuse::listUses( *attach, result );
+
+		return result;
+	}
+}
@@ -0,0 +1,32 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/FrameGraphPrerequisites.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace crg::uses
+{
+	/**
+	*\brief
+	*	Identifies an image (first member is \p true) or a buffer (first member is \p false).
+	*/
+	using ResourceKey = std::pair< bool, uint32_t >;
+
+	struct ResourceUse
+	{
+		ResourceKey resource;
+		Attachment const * attach;
+	};
+	/**
+	*\brief
+	*	Lists the images and buffers used by the attachments of the given pass.
+	*\remarks
+	*	An image is listed once per view using it, with the images the view is built from.
+	*/
+	std::vector< ResourceUse > listUses( FramePass const & pass );
+}
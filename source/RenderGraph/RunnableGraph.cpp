@@ -1,15 +1,23 @@
 /*
 See LICENSE file in root folder.
 */
-#include "RenderGraph/RunnableGraph.hpp"
+#include "RunnableGraphInternals.hpp"
 #include "RenderGraph/GraphVisitor.hpp"
+#include "RenderGraph/ImageData.hpp"
+#include "RenderGraph/Hash.hpp"
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/ResourceHandler.hpp"
+#include "ImageAliasing.hpp"
+#include "QueuePartitions.hpp"
+#include "RecordWorkers.hpp"
+#include "SplitBarriers.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 
 #pragma warning( push )
@@ -26,7 +34,9 @@ namespace crg
 	namespace rungrf
 	{
 		static VkCommandPool createCommandPool( GraphContext & context
-			, std::string const & name )
+			, std::string const & name
+			, uint32_t familyIndex = 0u
+			, VkCommandPoolCreateFlags flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT )
 		{
 			VkCommandPool result{};
 
@@ -34,8 +44,8 @@ namespace crg
 			{
 				VkCommandPoolCreateInfo createInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO
 					, nullptr
-					, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
-					, 0 };
+					, flags
+					, familyIndex };
 				auto res = context.vkCreateCommandPool( context.device
 					, &createInfo
 					, context.allocator
@@ -47,72 +57,142 @@ namespace crg
 			return result;
 		}
 
-		static void mergeMipRanges( LayerLayoutStates const & nextLayout
-			, uint32_t currentLayout
-			, MipLayoutStates const & curStates
-			, LayerLayoutStates & result )
+		static VkSemaphore createSemaphore( GraphContext & context
+			, std::string const & name )
 		{
-			if ( auto nextLayerIt = nextLayout.find( currentLayout );
-				nextLayerIt != nextLayout.end() )
-			{
-				auto resLayerIt = result.try_emplace( currentLayout ).first;
+			VkSemaphore result{};
 
-				for ( auto & [curLevel, _] : curStates )
-				{
-					if ( auto nextLevelIt = nextLayerIt->second.find( curLevel );
-						nextLevelIt != nextLayerIt->second.end() )
-						resLayerIt->second.emplace( *nextLevelIt );
-				}
+			if ( context.vkCreateSemaphore )
+			{
+				VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+					, nullptr
+					, 0u };
+				auto res = context.vkCreateSemaphore( context.device
+					, &createInfo
+					, context.allocator
+					, &result );
+				checkVkResult( res, name + " - Semaphore creation" );
+				crgRegisterObject( context, name, result );
 			}
+
+			return result;
 		}
 
-		static LayerLayoutStates mergeRanges( LayerLayoutStatesMap const & nextLayouts
-			, LayerLayoutStatesMap::value_type const & currentLayout )
+		static VkSemaphore createTimelineSemaphore( GraphContext & context
+			, std::string const & name )
 		{
-			LayerLayoutStates result;
+			VkSemaphore result{};
 
-			if ( auto nextIt = nextLayouts.find( currentLayout.first );
-				nextIt != nextLayouts.end() )
+#if VK_VERSION_1_2
+			if ( context.vkCreateSemaphore && context.hasTimelineSemaphores() )
 			{
-				auto & nxtLayout = nextIt->second;
-
-				for ( auto & [curLayout, curStates] : currentLayout.second )
-					mergeMipRanges( nxtLayout, curLayout, curStates, result );
+				VkSemaphoreTypeCreateInfo typeInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO
+					, nullptr
+					, VK_SEMAPHORE_TYPE_TIMELINE
+					, 0u };
+				VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+					, &typeInfo
+					, 0u };
+				auto res = context.vkCreateSemaphore( context.device
+					, &createInfo
+					, context.allocator
+					, &result );
+				checkVkResult( res, name + " - Timeline semaphore creation" );
+				crgRegisterObject( context, name, result );
 			}
+#endif
 
 			return result;
 		}
 
-		static LayerLayoutStatesMap gatherNextImageLayouts( LayerLayoutStatesMap currentLayouts
-			, std::vector< RunnablePassPtr >::iterator nextPassIt
-			, std::vector< RunnablePassPtr >::iterator endIt )
+		static void submit( GraphContext & context
+			, VkQueue queue
+			, std::vector< VkSemaphore > const & waitSemaphores
+			, std::vector< VkPipelineStageFlags > const & dstStageMasks
+			, std::vector< uint64_t > const & waitValues
+			, std::vector< VkCommandBuffer > const & commandBuffers
+			, std::vector< VkSemaphore > const & signalSemaphores
+			, std::vector< uint64_t > const & signalValues
+			, VkFence fence )
+		{
+			VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO
+				, nullptr
+				, uint32_t( waitSemaphores.size() )
+				, waitSemaphores.data()
+				, dstStageMasks.data()
+				, uint32_t( commandBuffers.size() )
+				, commandBuffers.data()
+				, uint32_t( signalSemaphores.size() )
+				, signalSemaphores.data() };
+#if VK_VERSION_1_2
+			// The values are only given when a timeline semaphore is involved, the binary semaphores ignore them.
+			auto isTimeline = []( uint64_t value ){ return value != 0u; };
+			VkTimelineSemaphoreSubmitInfo timelineInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO
+				, nullptr
+				, uint32_t( waitValues.size() )
+				, waitValues.data()
+				, uint32_t( signalValues.size() )
+				, signalValues.data() };
+
+			if ( std::any_of( waitValues.begin(), waitValues.end(), isTimeline )
+				|| std::any_of( signalValues.begin(), signalValues.end(), isTimeline ) )
+				submitInfo.pNext = &timelineInfo;
+#endif
+			context.vkQueueSubmit( queue
+				, 1u
+				, &submitInfo
+				, fence );
+		}
+
+		static bool areEqual( GraphQueue const & lhs, GraphQueue const & rhs )
+		{
+			return lhs.queue == rhs.queue
+				&& lhs.familyIndex == rhs.familyIndex;
+		}
+
+		static bool areEqual( GraphQueues const & lhs, GraphQueues const & rhs )
 		{
-			LayerLayoutStatesMap result;
+			return areEqual( lhs.graphics, rhs.graphics )
+				&& areEqual( lhs.compute, rhs.compute )
+				&& areEqual( lhs.transfer, rhs.transfer );
+		}
 
-			while ( !currentLayouts.empty()
-				&& endIt != nextPassIt )
+		static void forEachView( Attachment const & attach
+			, RecordContext & context
+			, RunnableGraph const & graph
+			, std::function< void( ImageViewId ) > const & imageFunc
+			, std::function< void( BufferViewId ) > const & bufferFunc )
+		{
+			if ( attach.isImage() )
 			{
-				if ( auto const & nextPass = **nextPassIt;
-					nextPass.isEnabled() )
+				for ( uint32_t index = 0u; index < attach.getViewCount(); ++index )
 				{
-					auto & nextLayouts = nextPass.getImageLayouts();
-					LayerLayoutStates layoutStates;
-					auto currIt = std::find_if( currentLayouts.begin()
-						, currentLayouts.end()
-						, [&nextLayouts, &layoutStates]( LayerLayoutStatesMap::value_type const & lookup )
-						{
-							layoutStates = mergeRanges( nextLayouts, lookup );
-							return !layoutStates.empty();
-						} );
-
-					if ( currIt != currentLayouts.end() )
-					{
-						result.try_emplace( currIt->first, layoutStates );
-						currentLayouts.erase( currIt );
-					}
+					// Fetches the state from the previous frame, if needed.
+					graph.getCurrentLayoutState( context, attach.view( index ) );
+					imageFunc( attach.view( index ) );
 				}
-				
-				++nextPassIt;
+			}
+			else
+			{
+				for ( uint32_t index = 0u; index < attach.getBufferCount(); ++index )
+					bufferFunc( attach.buffer( index ) );
+			}
+		}
+
+		static LayerLayoutStates mergeRanges( LayerLayoutStatesMap const & nextLayouts
+			, LayerLayoutStatesMap::value_type const & currentLayout )
+		{
+			LayerLayoutStates result;
+
+			if ( auto nextIt = nextLayouts.find( currentLayout.first );
+				nextIt != nextLayouts.end() )
+			{
+				auto & nxtLayout = nextIt->second;
+				currentLayout.second.forEach( [&nxtLayout, &result]( uint32_t layer, uint32_t level, LayoutState const & )
+					{
+						if ( auto state = nxtLayout.find( layer, level ) )
+							result.setLayoutState( { ImageAspectFlags{}, level, 1u, layer, 1u }, *state );
+					} );
 			}
 
 			return result;
@@ -133,6 +213,69 @@ namespace crg
 				: currentState;
 		}
 
+		template< typename AttachT >
+		static void addAttaches( RunnablePassSignature & signature
+			, std::map< uint32_t, AttachT > const & attaches )
+		{
+			for ( auto & [binding, attach] : attaches )
+			{
+				if constexpr ( std::is_same_v< AttachT, FramePass::SampledAttachment > )
+					signature.attaches.emplace_back( binding, attach.attach );
+				else
+					signature.attaches.emplace_back( binding, attach );
+			}
+		}
+
+		/**
+		*\brief
+		*	Lists what a RunnablePass depends on, in its FramePass.
+		*\remarks
+		*	Pass IDs are never reused and attachments can't be modified,
+		*	so comparing attachments addresses is enough.
+		*/
+		static RunnablePassSignature makeSignature( FramePass const & pass )
+		{
+			RunnablePassSignature result{ {}, pass.getId(), {} };
+			addAttaches( result, pass.getUniforms() );
+			addAttaches( result, pass.getSampled() );
+			addAttaches( result, pass.getInputs() );
+			addAttaches( result, pass.getInouts() );
+			addAttaches( result, pass.getOutputs() );
+			uint32_t index{};
+
+			for ( auto attach : pass.getTargets() )
+				result.attaches.emplace_back( index++, attach );
+
+			result.hash = std::hash< uint32_t >{}( result.id );
+
+			for ( auto & [binding, attach] : result.attaches )
+			{
+				result.hash = hashCombine( result.hash, binding );
+				result.hash = hashCombine( result.hash, attach );
+			}
+
+			return result;
+		}
+
+		static void aliasingBarrier( GraphContext & context
+			, RecordCountersHandler & counters
+			, VkCommandBuffer commandBuffer )
+		{
+			// The images previously bound to the memory must be done with it before the next one uses it.
+			StagedMemoryBarrier barrier{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+				, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+				, { VK_STRUCTURE_TYPE_MEMORY_BARRIER
+					, nullptr
+					, VK_ACCESS_MEMORY_WRITE_BIT
+					, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT } };
+			context.vkCmdPipelineBarriers( commandBuffer
+				, 0u
+				, { &barrier, 1u }
+				, {}
+				, {} );
+			counters.addBarrierCommand( 0u, 0u );
+		}
+
 		static VkDescriptorType getDescriptorType( BufferAttachment const & attach )
 		{
 			if ( attach.isUniformView() )
@@ -202,6 +345,20 @@ namespace crg
 
 			return result;
 		}
+
+		static void freeTransientMemory( GraphContext & context
+			, MemoryTracker & tracker
+			, RunnableGraph const * graph
+			, std::vector< VkDeviceMemory > const & memories )
+		{
+			for ( uint32_t index = 0u; index < memories.size(); ++index )
+			{
+				tracker.removeAllocation( { graph, index } );
+				context.vkFreeMemory( context.device
+					, memories[index]
+					, context.allocator );
+			}
+		}
 	}
 
 	//************************************************************************************************
@@ -239,17 +396,19 @@ namespace crg
 		, GraphContext & context )
 		: m_graph{ graph }
 		, m_context{ context }
-		, m_resources{ m_graph.getHandler(), m_context }
+		, m_resources{ m_graph.getHandler(), m_context, m_graph.getName() }
 		, m_nodes{ std::move( nodes ) }
 		, m_rootNode{ std::move( rootNode ) }
+		, m_framesInFlight{ m_graph.getFramesInFlight() }
 		, m_timerQueries{ m_context
-			, createQueryPool( m_context, m_graph.getName() + "TimerQueries", uint32_t( ( m_nodes.size() + 1u ) * 2u * 2u ) )
+			, createQueryPool( m_context, m_graph.getName() + "TimerQueries", uint32_t( ( m_nodes.size() + 1u ) * 2u * m_framesInFlight ) )
 			, []( GraphContext & ctx, VkQueryPool & object )noexcept
 			{
 				crgUnregisterObject( ctx, object );
 				ctx.vkDestroyQueryPool( ctx.device, object, ctx.allocator );
 				object = {};
 			} }
+		, m_timerQueryCount{ uint32_t( ( m_nodes.size() + 1u ) * 2u * m_framesInFlight ) }
 		, m_commandPool{ m_context
 			, rungrf::createCommandPool( m_context, m_graph.getName() )
 			, []( GraphContext & ctx, VkCommandPool & object )noexcept
@@ -258,48 +417,97 @@ namespace crg
 				ctx.vkDestroyCommandPool( ctx.device, object, ctx.allocator );
 				object = {};
 			} }
-		, m_fence{ m_context
-			, graph.getName() + "/Graph"
-			, { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, VK_FENCE_CREATE_SIGNALED_BIT } }
-		, m_timer{ context, graph.getName() + "/Graph", TimerScope::eGraph, getTimerQueryPool(), getTimerQueryOffset() }
+		, m_timelineSemaphore{ m_context
+			, rungrf::createTimelineSemaphore( m_context, m_graph.getName() + "/Timeline" )
+			, []( GraphContext & ctx, VkSemaphore & object )noexcept
+			{
+				crgUnregisterObject( ctx, object );
+				ctx.vkDestroySemaphore( ctx.device, object, ctx.allocator );
+				object = {};
+			} }
+		, m_cpuScopeHistories{ TimerHistory{ context.timerHistorySize, context.timerHitchThreshold }
+			, TimerHistory{ context.timerHistorySize, context.timerHitchThreshold }
+			, TimerHistory{ context.timerHistorySize, context.timerHitchThreshold } }
+		, m_gpuScopeHistories{ TimerHistory{ context.timerHistorySize, context.timerHitchThreshold }
+			, TimerHistory{ context.timerHistorySize, context.timerHitchThreshold }
+			, TimerHistory{ context.timerHistorySize, context.timerHitchThreshold } }
+		, m_timer{ context, graph.getName() + "/Graph", TimerScope::eGraph, getTimerQueryPool(), getTimerQueryOffset(), m_framesInFlight }
+		, m_internals{ std::make_unique< Internals >() }
+	{
+		doAttachScopeHistories( m_timer );
+		doCreateFrames();
+		PassesMap previous;
+		doCreatePasses( previous );
+	}
+
+	RunnableGraph::~RunnableGraph()noexcept
+	{
+		for ( auto & chunk : m_internals->chunks )
+			doDestroyChunk( chunk );
+
+		doDestroyFrames();
+
+		// The transient images are destroyed with the resources, freeing their memory first is allowed.
+		rungrf::freeTransientMemory( m_context
+			, m_graph.getHandler().getMemoryTracker()
+			, this
+			, m_internals->transientMemory );
+	}
+
+	void RunnableGraph::rebuild( GraphNodePtrArray nodes
+		, RootNode rootNode )
 	{
-		auto name = m_graph.getName() + "/Graph";
+		// The removed passes, and the kept passes' timers, may still be in use.
+		doWaitFrames();
+		PassesMap previous;
 
-		if ( m_context.vkCreateSemaphore )
+		for ( size_t index = 0u; index < m_passes.size(); ++index )
 		{
-			VkSemaphoreCreateInfo createInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
-				, nullptr
-				, 0u };
-			auto res = context.vkCreateSemaphore( m_context.device
-				, &createInfo
-				, m_context.allocator
-				, &m_semaphore );
-			checkVkResult( res, name + " - Semaphore creation" );
-			crgRegisterObject( m_context, name, m_semaphore );
+			auto & pass = m_passes[index];
+			previous.try_emplace( &pass->getPass(), std::move( m_internals->passSignatures[index] ), std::move( pass ) );
 		}
 
-		if ( m_context.vkAllocateCommandBuffers )
+		m_passes.clear();
+		m_internals->passSignatures.clear();
+		m_states.clear();
+		m_rootNode = std::move( rootNode );
+		m_nodes = std::move( nodes );
+
+		if ( m_framesInFlight != m_graph.getFramesInFlight() )
 		{
-			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO
-				, nullptr
-				, getCommandPool()
-				, VK_COMMAND_BUFFER_LEVEL_PRIMARY
-				, 1u };
-			auto res = m_context.vkAllocateCommandBuffers( m_context.device
-				, &allocateInfo
-				, &m_commandBuffer );
-			checkVkResult( res, name + " - CommandBuffer allocation" );
-			crgRegisterObject( m_context, name, m_commandBuffer );
+			for ( auto & chunk : m_internals->chunks )
+				doDestroyChunk( chunk );
+
+			m_internals->chunks.clear();
+			m_internals->chunksDirty = true;
+			doDestroyFrames();
+			m_framesInFlight = m_graph.getFramesInFlight();
+			m_frameIndex = 0u;
+			doCreateFrames();
+		}
 
-			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-				, nullptr
-				, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-				, nullptr };
-			m_context.vkBeginCommandBuffer( m_commandBuffer, &beginInfo );
-			m_context.vkEndCommandBuffer( m_commandBuffer );
+		// Reserve queries for all the timers, in a new pool if the current one is too small.
+		auto queryCount = uint32_t( ( m_nodes.size() + 1u ) * 2u * m_framesInFlight );
+
+		if ( queryCount > m_timerQueryCount )
+		{
+			if ( m_timerQueries.object )
+				m_timerQueries.destroy( m_context, m_timerQueries.object );
+
+			m_timerQueries.object = createQueryPool( m_context, m_graph.getName() + "TimerQueries", queryCount );
+			m_timerQueryCount = queryCount;
 		}
 
+		m_timerQueryOffset = 0u;
+		m_timer.setQueryPool( getTimerQueryPool(), m_timerQueryOffset, m_framesInFlight );
+		auto reused = doCreatePasses( previous );
+		Logger::logDebug( m_graph.getName() + " - Reused " + std::to_string( reused ) + "/" + std::to_string( m_passes.size() ) + " runnable passes" );
+	}
+
+	size_t RunnableGraph::doCreatePasses( PassesMap & previous )
+	{
 		Logger::logDebug( m_graph.getName() + " - Initialising resources" );
+		doCreateTransientImages( previous );
 
 		for ( auto & img : m_graph.m_images )
 		{
@@ -312,207 +520,1384 @@ namespace crg
 		}
 
 		Logger::logDebug( m_graph.getName() + " - Creating runnable passes" );
+		size_t reused{};
+		std::vector< RunnablePass * > created;
 
 		for ( auto const & node : m_nodes )
 		{
 			if ( node->getKind() == GraphNode::Kind::FramePass )
 			{
-				auto const & renderPassNode = nodeCast< FramePassNode >( *node );
-				m_passes.push_back( renderPassNode.getFramePass().createRunnable( m_context
-					, *this ) );
+				auto const & framePass = nodeCast< FramePassNode >( *node ).getFramePass();
+				auto signature = rungrf::makeSignature( framePass );
+
+				if ( auto it = previous.find( &framePass );
+					it != previous.end() && it->second.first == signature )
+				{
+					m_passes.push_back( std::move( it->second.second ) );
+					m_passes.back()->getTimer().setQueryPool( getTimerQueryPool(), m_timerQueryOffset, m_framesInFlight );
+					previous.erase( it );
+					++reused;
+				}
+				else
+				{
+					m_passes.push_back( framePass.createRunnable( m_context
+						, *this ) );
+					created.push_back( m_passes.back().get() );
+				}
+
+				doAttachScopeHistories( m_passes.back()->getTimer() );
+				m_internals->passSignatures.push_back( std::move( signature ) );
 			}
 		}
 
+		// Passes that are not part of the graph anymore are destroyed before the new ones are initialised.
+		previous.clear();
 		Logger::logDebug( m_graph.getName() + " - Initialising passes" );
 
-		for ( auto const & pass : m_passes )
+		for ( auto pass : created )
 		{
 			if ( pass->isEnabled() )
 			{
 				pass->initialise( pass->getIndex() );
 			}
 		}
+
+		doCreateSplitBarriers();
+		doListImageUses();
+		m_internals->partitionsDirty = true;
+		m_internals->recordDirty = true;
+		return reused;
 	}
 
-	RunnableGraph::~RunnableGraph()noexcept
+	void RunnableGraph::doListImageUses()
 	{
-		if ( m_context.vkDestroySemaphore && m_semaphore )
-		{
-			crgUnregisterObject( m_context, m_semaphore );
-			m_context.vkDestroySemaphore( m_context.device
-				, m_semaphore
-				, m_context.allocator );
-		}
+		m_internals->imageUses.clear();
 
-		if ( m_context.vkFreeCommandBuffers && m_commandBuffer )
+		for ( uint32_t index = 0u; index < m_passes.size(); ++index )
 		{
-			crgUnregisterObject( m_context, m_commandBuffer );
-			m_context.vkFreeCommandBuffers( m_context.device
-				, getCommandPool()
-				, 1u
-				, &m_commandBuffer );
+			for ( auto & [image, _] : m_passes[index]->getImageLayouts() )
+				m_internals->imageUses[image].push_back( index );
 		}
+
+		m_internals->firstImageLayouts = m_passes.empty()
+			? nullptr
+			: std::make_shared< LayerLayoutStatesHandler const >( m_passes.front()->getImageLayouts() );
+		m_internals->nextImageLayouts.assign( m_passes.size(), nullptr );
+		m_internals->nextLayoutsEnabled.clear();
 	}
 
-	void RunnableGraph::record()
+	void RunnableGraph::doUpdateNextImageLayouts()
 	{
-		auto block( m_timer.start() );
-		m_states.clear();
-		RecordContext recordContext{ m_resources };
+		std::vector< bool > enabled;
+		enabled.reserve( m_passes.size() );
 
-		for ( auto & dependency : m_graph.getDependencies() )
-		{
-			recordContext.addStates( dependency->getFinalStates() );
-			m_states.try_emplace( dependency
-				, dependency->getFinalStates().getIndexState() );
-		}
+		for ( auto & pass : m_passes )
+			enabled.push_back( pass->isEnabled() );
 
-		auto itGraph = m_states.try_emplace( &m_graph ).first;
-		itGraph->second.resize( m_passes.size() );
+		if ( enabled == m_internals->nextLayoutsEnabled )
+			return;
 
-		if ( !m_passes.empty() )
+		for ( uint32_t index = 0u; index + 1u < m_passes.size(); ++index )
 		{
-			auto it = itGraph->second.begin();
-			auto currPass = m_passes.begin();
-			recordContext.setNextPipelineState( ( *currPass )->getPipelineState()
-				, ( *currPass )->getImageLayouts() );
-			auto nextPass = std::next( currPass );
-			m_fence.wait( 0xFFFFFFFFFFFFFFFFULL );
-			m_context.vkResetCommandBuffer( m_commandBuffer, 0u );
-			VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-				, nullptr
-				, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-				, nullptr };
-			m_context.vkBeginCommandBuffer( m_commandBuffer, &beginInfo );
-			m_timer.beginPass( m_commandBuffer, getName(), 0u );
+			LayerLayoutStatesMap nextLayouts;
 
-			while ( currPass != m_passes.end() )
+			for ( auto & current : m_passes[index]->getImageLayouts() )
 			{
-				auto const & pass = *currPass;
-				++currPass;
+				auto & uses = m_internals->imageUses[current.first];
 
-				if ( nextPass != m_passes.end() )
+				// The first later enabled pass using some of the subresources gives their next layouts.
+				for ( auto it = std::upper_bound( uses.begin(), uses.end(), index ); it != uses.end(); ++it )
 				{
-					recordContext.setNextPipelineState( rungrf::getNextState( pass->getPipelineState(), nextPass, m_passes.end() )
-						, rungrf::gatherNextImageLayouts( pass->getImageLayouts(), nextPass, m_passes.end() ) );
-					++nextPass;
-				}
-				else
-				{
-					recordContext.setNextPipelineState( pass->getPipelineState()
-						, m_graph.getOutputLayoutStates() );
-				}
+					if ( !enabled[*it] )
+						continue;
 
-				*it = pass->recordCurrentInto( recordContext, m_commandBuffer );
-				++it;
+					if ( auto layoutStates = rungrf::mergeRanges( m_passes[*it]->getImageLayouts(), current );
+						!layoutStates.empty() )
+					{
+						nextLayouts.try_emplace( current.first, std::move( layoutStates ) );
+						break;
+					}
+				}
 			}
 
-			m_timer.endPass( m_commandBuffer );
-			m_context.vkEndCommandBuffer( m_commandBuffer );
+			m_internals->nextImageLayouts[index] = std::make_shared< LayerLayoutStatesHandler const >( nextLayouts );
 		}
 
-		m_graph.registerFinalState( recordContext );
+		m_internals->nextLayoutsEnabled = std::move( enabled );
 	}
 
-	SemaphoreWaitArray RunnableGraph::run( VkQueue queue )
+	void RunnableGraph::doCreateSplitBarriers()
 	{
-		return run( SemaphoreWaitArray{}
-			, queue );
-	}
+		m_splitBarriers.clear();
 
-	SemaphoreWaitArray RunnableGraph::run( SemaphoreWait toWait
-		, VkQueue queue )
-	{
-		return run( ( toWait.semaphore
-				? SemaphoreWaitArray{ 1u, toWait }
-				: SemaphoreWaitArray{} )
-			, queue );
-	}
+		if ( !m_graph.hasSplitBarriers() || !m_context.vkCreateEvent )
+			return;
 
-	SemaphoreWaitArray RunnableGraph::run( SemaphoreWaitArray const & toWait
-		, VkQueue queue )
-	{
-		record();
-		std::vector< VkSemaphore > semaphores;
-		std::vector< VkPipelineStageFlags > dstStageMasks;
-		convert( toWait, semaphores, dstStageMasks );
-		m_timer.notifyPassRender();
+		m_splitBarriers = split::listSplitBarriers( m_passes );
+		// The events are kept between rebuilds, a graph pool only grows.
+		// Each frame in flight has its own events, they are set and waited from its command buffers.
+		VkEventCreateInfo createInfo{ VK_STRUCTURE_TYPE_EVENT_CREATE_INFO
+			, nullptr
+			, 0u };
 
-		for ( auto const & pass : m_passes )
+		for ( uint32_t index = 0u; index < m_framesInFlight; ++index )
 		{
-			pass->notifyPassRender();
+			auto & events = m_internals->frames[index].splitEvents;
+
+			while ( events.size() < m_splitBarriers.size() )
+			{
+				auto name = m_graph.getName() + "/Frame" + std::to_string( index ) + "/SplitBarrier" + std::to_string( events.size() );
+				VkEvent event{};
+				auto res = m_context.vkCreateEvent( m_context.device
+					, &createInfo
+					, m_context.allocator
+					, &event );
+				checkVkResult( res, name + " - Event creation" );
+				crgRegisterObject( m_context, name, event );
+				events.push_back( event );
+			}
 		}
 
-		VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO
-			, nullptr
-			, uint32_t( semaphores.size() )
-			, semaphores.data()
-			, dstStageMasks.data()
-			, 1u
-			, &m_commandBuffer
-			, 1u
-			, &m_semaphore };
-		m_fence.reset();
-		m_context.delQueue.clear( m_context );
-		m_context.vkQueueSubmit( queue
-			, 1u
-			, &submitInfo
-			, m_fence.getInternal() );
-		return { SemaphoreWait{ m_semaphore
-			, m_graph.getFinalStates().getCurrPipelineState().pipelineStage } };
+		Logger::logDebug( m_graph.getName() + " - " + std::to_string( m_splitBarriers.size() ) + " split barriers" );
 	}
 
-	VkBuffer RunnableGraph::createBuffer( BufferId const & buffer )
+	void RunnableGraph::doUpdateSplitAcquirers()
 	{
-		return m_resources.createBuffer( buffer );
-	}
+		m_internals->splitAcquirers.clear();
+		m_internals->splitAcquirers.reserve( m_splitBarriers.size() );
 
-	VkBufferView RunnableGraph::createBufferView( BufferViewId const & view )
-	{
-		return m_resources.createBufferView( view );
+		for ( auto const & split : m_splitBarriers )
+		{
+			// The event can't be waited for from another queue.
+			auto partition = std::find_if( m_partitions.begin(), m_partitions.end()
+				, [&split]( QueuePartition const & lookup )
+				{
+					return split.producer < lookup.firstPass + lookup.passCount;
+				} );
+			auto endPass = partition == m_partitions.end()
+				? uint32_t( m_passes.size() )
+				: partition->firstPass + partition->passCount;
+			m_internals->splitAcquirers.push_back( split::findAcquirer( m_passes, split, endPass ) );
+		}
 	}
 
-	VkImage RunnableGraph::createImage( ImageId const & image )
+	void RunnableGraph::doAcquireSplitBarriers( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t passIndex
+		, SplitStages const & released )
 	{
-		return m_resources.createImage( image );
-	}
+		std::vector< VkEvent > events;
+		VkPipelineStageFlags srcStages{};
+		VkPipelineStageFlags dstStages{};
+		context.beginBarrierBatch();
 
-	VkImageView RunnableGraph::createImageView( ImageViewId const & view )
-	{
-		return m_resources.createImageView( view );
-	}
+		for ( size_t index = 0u; index < m_splitBarriers.size(); ++index )
+		{
+			auto const & split = m_splitBarriers[index];
 
-	VkSampler RunnableGraph::createSampler( SamplerDesc const & samplerDesc )
-	{
-		return m_resources.createSampler( samplerDesc );
+			if ( m_internals->splitAcquirers[index] != passIndex || !released[index] )
+				continue;
+
+			auto const & attach = *split.attach;
+
+			if ( split.consumer != passIndex )
+			{
+				// The consumer is disabled, its layout is not wanted.
+				dstStages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			}
+			else if ( attach.isImage() )
+			{
+				auto wanted = makeLayoutState( attach.getImageLayout( m_context.separateDepthStencilLayouts ) );
+				context.memoryBarrier( commandBuffer, attach.view(), wanted );
+				dstStages |= getPipelineStageFlags( wanted.state.pipelineStage );
+			}
+			else
+			{
+				AccessState wanted{ attach.getAccessMask()
+					, attach.getPipelineStageFlags( m_passes[passIndex]->isComputePass() ) };
+				context.memoryBarrier( commandBuffer, attach.buffer(), wanted );
+				dstStages |= getPipelineStageFlags( wanted.pipelineStage );
+			}
+
+			srcStages |= released[index];
+			events.push_back( m_internals->frames[m_frameIndex].splitEvents[index] );
+		}
+
+		if ( !events.empty() )
+		{
+			context.waitEvents( commandBuffer, events, srcStages, dstStages );
+
+			for ( auto event : events )
+				m_context.vkCmdResetEvent( commandBuffer, event, dstStages );
+		}
+
+		context.endBarrierBatch( commandBuffer );
 	}
 
-	VertexBuffer const & RunnableGraph::createQuadTriVertexBuffer( bool texCoords
-		, Texcoord const & config )
+	void RunnableGraph::doReleaseSplitBarriers( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t passIndex
+		, SplitStages & released )
 	{
-		return m_resources.createQuadTriVertexBuffer( texCoords
-			, config );
+		for ( size_t index = 0u; index < m_splitBarriers.size(); ++index )
+		{
+			auto const & split = m_splitBarriers[index];
+
+			if ( split.producer != passIndex
+				|| m_internals->splitAcquirers[index] == RunnablePass::InvalidIndex )
+				continue;
+
+			auto const & attach = *split.attach;
+			auto stage = attach.isImage()
+				? getPipelineStageFlags( context.getLayoutState( attach.view() ).state.pipelineStage )
+				: getPipelineStageFlags( context.getAccessState( attach.buffer() ).pipelineStage );
+
+			if ( !stage )
+				stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			m_context.vkCmdSetEvent( commandBuffer, m_internals->frames[m_frameIndex].splitEvents[index], stage );
+			released[index] = stage;
+		}
 	}
 
-	LayoutState RunnableGraph::getCurrentLayoutState( RecordContext & context
-		, ImageId image
-		, ImageViewType viewType
-		, ImageSubresourceRange range )const
+	void RunnableGraph::doCreateTransientImages( PassesMap & previous )
 	{
-		auto result = context.getLayoutState( image, viewType, range );
-
-		if ( result.layout == ImageLayout::eUndefined )
+		auto lifetimes = alias::computeLifetimes( m_graph.m_transientImages
+			, m_nodes
+			, m_graph.m_inputs
+			, m_graph.m_outputs );
+
+		if ( std::equal( lifetimes.begin(), lifetimes.end()
+			, m_transientImages.begin(), m_transientImages.end()
+			, []( TransientImage const & lhs, TransientImage const & rhs )
+			{
+				return lhs.image == rhs.image
+					&& lhs.firstPass == rhs.firstPass
+					&& lhs.lastPass == rhs.lastPass;
+			} ) )
 		{
-			// Lookup in graph's external inputs.
-			result = m_graph.getInputLayoutState( image, viewType, range );
+			return;
+		}
 
-			if ( result.layout != ImageLayout::eUndefined )
+		doDestroyTransientImages( previous );
+
+		for ( auto & transient : lifetimes )
+		{
+			// An image which already exists (created for another context) keeps its own memory, its size is left to 0.
+			if ( auto image = m_resources.createUnboundImage( transient.image ) )
 			{
-				context.setLayoutState( image, viewType, range, result );
+				VkMemoryRequirements requirements{};
+				m_context.vkGetImageMemoryRequirements( m_context.device
+					, image
+					, &requirements );
+				transient.memoryType = m_context.deduceMemoryType( requirements.memoryTypeBits
+					, getMemoryPropertyFlags( transient.image.data->info.memory ) );
+				transient.size = requirements.size;
+				transient.alignment = std::max( requirements.alignment
+					, m_context.properties.limits.bufferImageGranularity );
+				m_transientStats.requiredSize += transient.size;
 			}
 		}
 
-		if ( result.layout == ImageLayout::eUndefined )
+		m_transientImages = std::move( lifetimes );
+		std::map< uint32_t, VkDeviceMemory > memories;
+
+		for ( auto & [memoryType, size] : alias::placeImages( m_transientImages ) )
+		{
+			if ( size == 0u )
+				continue;
+
+			auto name = m_graph.getName() + "/TransientImages";
+			auto & tracker = m_graph.getHandler().getMemoryTracker();
+			tracker.checkBudget( m_context, memoryType, size, name );
+			VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO
+				, nullptr
+				, size
+				, memoryType };
+			VkDeviceMemory memory{};
+			auto res = m_context.vkAllocateMemory( m_context.device
+				, &allocateInfo
+				, m_context.allocator
+				, &memory );
+			checkVkResult( res, m_graph.getName() + " - Transient images memory allocation" );
+			crgRegisterObjectName( m_context, name, memory );
+			tracker.addAllocation( { this, uint32_t( m_internals->transientMemory.size() ) }
+				, name
+				, m_graph.getName()
+				, m_context
+				, memoryType
+				, size );
+			m_internals->transientMemory.push_back( memory );
+			memories.try_emplace( memoryType, memory );
+			m_transientStats.allocatedSize += size;
+		}
+
+		m_internals->aliasingBarriers.assign( size_t( std::count_if( m_nodes.begin(), m_nodes.end()
+				, []( GraphNodePtr const & node )
+				{
+					return node->getKind() == GraphNode::Kind::FramePass;
+				} ) )
+			, false );
+
+		for ( auto & transient : m_transientImages )
+		{
+			if ( transient.size == 0u )
+				continue;
+
+			auto res = m_context.vkBindImageMemory( m_context.device
+				, m_resources.createImage( transient.image )
+				, memories[transient.memoryType]
+				, transient.offset );
+			checkVkResult( res, transient.image.data->name + " - Transient image memory binding" );
+			m_internals->aliasedImages.insert( transient.image.id );
+
+			if ( alias::isAliased( transient, m_transientImages ) )
+				m_internals->aliasingBarriers[transient.firstPass] = true;
+		}
+
+		Logger::logInfo( m_graph.getName() + " - Transient images use " + std::to_string( m_transientStats.allocatedSize )
+			+ " bytes instead of " + std::to_string( m_transientStats.requiredSize )
+			+ " (saved " + std::to_string( m_transientStats.getSavedSize() ) + ")" );
+	}
+
+	void RunnableGraph::doDestroyTransientImages( PassesMap & previous )
+	{
+		if ( m_transientImages.empty() )
+			return;
+
+		// The passes using the transient images hold views on them.
+		for ( auto it = previous.begin(); it != previous.end(); )
+		{
+			if ( alias::usesImages( *it->first, m_internals->aliasedImages ) )
+				it = previous.erase( it );
+			else
+				++it;
+		}
+
+		for ( auto & view : m_graph.m_imageViews )
+		{
+			if ( m_internals->aliasedImages.find( view.data->image.id ) != m_internals->aliasedImages.end() )
+				m_resources.destroyImageView( view );
+		}
+
+		for ( auto & transient : m_transientImages )
+		{
+			if ( transient.size != 0u )
+				m_resources.destroyImage( transient.image );
+		}
+
+		rungrf::freeTransientMemory( m_context
+			, m_graph.getHandler().getMemoryTracker()
+			, this
+			, m_internals->transientMemory );
+
+		m_transientImages.clear();
+		m_internals->transientMemory.clear();
+		m_internals->aliasedImages.clear();
+		m_internals->aliasingBarriers.clear();
+		m_transientStats = {};
+	}
+
+	MemoryReport RunnableGraph::getMemoryReport()const
+	{
+		return m_graph.getHandler().getMemoryTracker().getReport( m_graph.getName() );
+	}
+
+	void RunnableGraph::record()
+	{
+		auto block( m_timer.start() );
+
+		// The other frames command buffers were recorded from outdated passes or states.
+		if ( isRecordDirty() )
+		{
+			for ( auto & frame : m_internals->frames )
+				frame.recorded = false;
+		}
+
+		m_states.clear();
+		RecordContext recordContext{ m_resources };
+		recordContext.setCounters( &m_counters );
+
+		for ( auto & dependency : m_graph.getDependencies() )
+		{
+			recordContext.addStates( dependency->getFinalStates() );
+			m_states.try_emplace( dependency
+				, dependency->getFinalStates().getIndexState() );
+		}
+
+		auto itGraph = m_states.try_emplace( &m_graph ).first;
+		itGraph->second.resize( m_passes.size() );
+
+		auto & frame = m_internals->frames[m_frameIndex];
+		doWaitFrame( frame, 0xFFFFFFFFFFFFFFFFULL );
+
+		doResetCommandPools();
+		doSetTimersFrame();
+		doUpdatePartitions();
+		doUpdateChunks();
+		doUpdateNextImageLayouts();
+		doUpdateSplitAcquirers();
+
+		if ( !doRecordChunks( recordContext, itGraph->second ) )
+			doRecordSerial( recordContext, itGraph->second );
+
+		// Until the recording ends with the states it started from, the next one may differ.
+		m_internals->recordDirty = !m_graph.getFinalStates().hasSameStates( recordContext );
+		// The final states may outlive this graph.
+		recordContext.setCounters( nullptr );
+		m_graph.registerFinalState( recordContext );
+		m_internals->dependencyStates.clear();
+
+		for ( auto & dependency : m_graph.getDependencies() )
+			m_internals->dependencyStates.push_back( dependency->getFinalStates() );
+
+		frame.recorded = true;
+	}
+
+	Fence & RunnableGraph::getFence()noexcept
+	{
+		return m_internals->frames[m_frameIndex].fence;
+	}
+
+	Fence const & RunnableGraph::getFence()const noexcept
+	{
+		return m_internals->frames[m_frameIndex].fence;
+	}
+
+	VkResult RunnableGraph::wait( uint64_t timeout )
+	{
+		return doWaitFrame( m_internals->frames[m_frameIndex], timeout );
+	}
+
+	bool RunnableGraph::isRecordDirty()const
+	{
+		if ( m_internals->recordDirty
+			|| m_internals->partitionsDirty
+			|| m_internals->chunksDirty
+			|| m_internals->chunksThreadCount != m_graph.getRecordThreadCount() )
+			return true;
+
+		auto & dependencies = m_graph.getDependencies();
+
+		if ( dependencies.size() != m_internals->dependencyStates.size()
+			|| !std::equal( dependencies.begin(), dependencies.end(), m_internals->dependencyStates.begin()
+				, []( FrameGraph const * dependency, RecordContext const & states )
+				{
+					return states.hasSameStates( dependency->getFinalStates() );
+				} ) )
+			return true;
+
+		return std::any_of( m_passes.begin(), m_passes.end()
+			, []( RunnablePassPtr const & pass )
+			{
+				return pass->isDirty();
+			} );
+	}
+
+	SemaphoreWaitArray RunnableGraph::run( VkQueue queue )
+	{
+		return run( SemaphoreWaitArray{}
+			, queue );
+	}
+
+	SemaphoreWaitArray RunnableGraph::run( SemaphoreWait toWait
+		, VkQueue queue )
+	{
+		return run( ( toWait.semaphore
+				? SemaphoreWaitArray{ 1u, toWait }
+				: SemaphoreWaitArray{} )
+			, queue );
+	}
+
+	SemaphoreWaitArray RunnableGraph::run( SemaphoreWaitArray const & toWait
+		, VkQueue queue )
+	{
+		return run( toWait
+			, GraphQueues{ { queue, 0u }, {}, {} } );
+	}
+
+	SemaphoreWaitArray RunnableGraph::run( SemaphoreWaitArray const & toWait
+		, GraphQueues const & queues )
+	{
+		if ( !rungrf::areEqual( queues, m_queues ) )
+		{
+			m_queues = queues;
+			m_internals->partitionsDirty = true;
+		}
+
+		// Only waits for the GPU when the frame, recorded frames in flight ago, is still executed.
+		m_frameIndex = ( m_frameIndex + 1u ) % m_framesInFlight;
+		++m_frameId;
+		auto & frame = m_internals->frames[m_frameIndex];
+
+		if ( !frame.recorded || isRecordDirty() )
+		{
+			record();
+		}
+		else
+		{
+			// The command buffers are submitted again, as they were recorded.
+			doWaitFrame( frame, 0xFFFFFFFFFFFFFFFFULL );
+			doSetTimersFrame();
+			m_timer.notifyPassReplay();
+
+			for ( auto const & pass : m_passes )
+			{
+				if ( pass->isEnabled() )
+					pass->getTimer().notifyPassReplay();
+			}
+		}
+
+		m_timer.notifyPassRender();
+
+		for ( auto const & pass : m_passes )
+		{
+			pass->notifyPassRender();
+		}
+
+		// The objects to delete may still be used by the other frames in flight.
+		if ( !m_context.delQueue.empty() )
+		{
+			doWaitFrames();
+			m_context.delQueue.clear( m_context );
+		}
+
+		auto timeline = m_timelineSemaphore.object;
+
+		if ( !timeline )
+			frame.fence.reset();
+
+		// One semaphore per partitions dependency, plus one per queue first partition, if there is something to wait for on several queues.
+		std::vector< std::vector< VkSemaphore > > signaled( m_partitions.size() );
+		std::vector< std::vector< VkSemaphore > > waited( m_partitions.size() );
+		std::vector< VkQueue > usedQueues;
+		std::vector< uint32_t > firstPartitions;
+		size_t semaphoreIndex{};
+		auto getSemaphore = [this, &frame, &semaphoreIndex]()
+		{
+			if ( semaphoreIndex == frame.queueSemaphores.size() )
+				frame.queueSemaphores.push_back( rungrf::createSemaphore( m_context
+					, m_graph.getName() + "/Frame" + std::to_string( m_frameIndex ) + "/Queue" + std::to_string( semaphoreIndex ) ) );
+
+			return frame.queueSemaphores[semaphoreIndex++];
+		};
+		std::vector< VkSemaphore > entrySemaphores;
+
+		for ( uint32_t index = 0u; index < m_partitions.size(); ++index )
+		{
+			auto & partition = m_partitions[index];
+			auto queue = doGetQueue( partition.queue ).queue;
+
+			if ( std::find( usedQueues.begin(), usedQueues.end(), queue ) == usedQueues.end() )
+			{
+				usedQueues.push_back( queue );
+				firstPartitions.push_back( index );
+			}
+
+			for ( auto source : partition.waited )
+			{
+				signaled[source].push_back( getSemaphore() );
+				waited[index].push_back( signaled[source].back() );
+			}
+		}
+
+		// A semaphore wait only covers its own batch, so the first partition of each queue, the first one included, waits for its entry semaphore.
+		if ( usedQueues.size() > 1u && !toWait.empty() )
+		{
+			for ( auto index : firstPartitions )
+			{
+				entrySemaphores.push_back( getSemaphore() );
+				waited[index].push_back( entrySemaphores.back() );
+			}
+		}
+
+		// Only the last submission signals the graph semaphore, the queues are synchronised through binary semaphores,
+		// since independent partitions may end in any order, while a timeline value can't decrease.
+		std::vector< uint64_t > lastValues( signaled.back().size() );
+		SemaphoreWait result{ frame.semaphore
+			, m_graph.getFinalStates().getCurrPipelineState().pipelineStage };
+
+		if ( timeline )
+		{
+			frame.timelineValue = ++m_timelineValue;
+			result.semaphore = timeline;
+			result.value = frame.timelineValue;
+			lastValues.push_back( frame.timelineValue );
+		}
+
+		signaled.back().push_back( result.semaphore );
+		std::vector< VkSemaphore > semaphores;
+		std::vector< VkPipelineStageFlags > dstStageMasks;
+		std::vector< uint64_t > values;
+		convert( toWait, semaphores, dstStageMasks, values );
+
+		if ( !entrySemaphores.empty() )
+		{
+			// The external semaphores can only be waited once, this submission forwards them to all the queues.
+			rungrf::submit( m_context
+				, usedQueues.front()
+				, semaphores
+				, dstStageMasks
+				, values
+				, {}
+				, entrySemaphores
+				, {}
+				, VkFence{} );
+			semaphores.clear();
+			dstStageMasks.clear();
+			values.clear();
+		}
+
+		for ( uint32_t index = 0u; index < m_partitions.size(); ++index )
+		{
+			auto & partition = m_partitions[index];
+			auto & toWaitInternal = waited[index];
+			bool isLast = index + 1u == m_partitions.size();
+			semaphores.insert( semaphores.end(), toWaitInternal.begin(), toWaitInternal.end() );
+			dstStageMasks.resize( semaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT );
+			values.resize( semaphores.size() );
+			rungrf::submit( m_context
+				, doGetQueue( partition.queue ).queue
+				, semaphores
+				, dstStageMasks
+				, values
+				, { doGetCommandBuffer( index ) }
+				, signaled[index]
+				, ( isLast ? lastValues : std::vector< uint64_t >{} )
+				, ( isLast && !timeline
+					? frame.fence.getInternal()
+					: VkFence{} ) );
+			semaphores.clear();
+			dstStageMasks.clear();
+			values.clear();
+		}
+
+		m_frameCounters = m_counters.reset();
+		return { result };
+	}
+
+	void RunnableGraph::doUpdatePartitions()
+	{
+		if ( !m_internals->partitionsDirty )
+			return;
+
+		m_internals->partitionsDirty = false;
+		m_internals->chunksDirty = true;
+		auto previousCount = m_partitions.size();
+		m_partitions = partition::listPartitions( m_passes
+			, { true, m_queues.compute.queue != nullptr, m_queues.transfer.queue != nullptr }
+			, m_internals->aliasedImages
+			, m_graph.m_outputs );
+
+		if ( m_partitions.size() <= 1u && previousCount <= 1u )
+			return;
+
+		// Events can't synchronise two queues, so the split barriers stay in a partition.
+		doCreateSplitBarriers();
+		auto getPartition = [this]( uint32_t passIndex )
+		{
+			return std::find_if( m_partitions.begin(), m_partitions.end()
+				, [passIndex]( QueuePartition const & lookup )
+				{
+					return passIndex < lookup.firstPass + lookup.passCount;
+				} );
+		};
+		auto removed = std::erase_if( m_splitBarriers
+			, [&getPartition]( SplitBarrier const & split )
+			{
+				return getPartition( split.producer ) != getPartition( split.consumer );
+			} );
+		Logger::logDebug( m_graph.getName() + " - " + std::to_string( m_partitions.size() ) + " queue partitions, "
+			+ std::to_string( removed ) + " split barriers removed" );
+	}
+
+	VkCommandPool RunnableGraph::doGetCommandPool( uint32_t familyIndex )
+	{
+		auto & frame = m_internals->frames[m_frameIndex];
+		auto it = std::find_if( frame.commandPools.begin(), frame.commandPools.end()
+			, [familyIndex]( std::pair< uint32_t, VkCommandPool > const & lookup )
+			{
+				return lookup.first == familyIndex;
+			} );
+
+		if ( it == frame.commandPools.end() )
+		{
+			// The command buffers are reset with their pool, when the frame is recorded.
+			frame.commandPools.emplace_back( familyIndex
+				, rungrf::createCommandPool( m_context
+					, m_graph.getName() + "/Frame" + std::to_string( m_frameIndex ) + "/Queue" + std::to_string( familyIndex )
+					, familyIndex
+					, 0u ) );
+			it = std::prev( frame.commandPools.end() );
+		}
+
+		return it->second;
+	}
+
+	void RunnableGraph::doResetCommandPools()
+	{
+		for ( auto & [familyIndex, pool] : m_internals->frames[m_frameIndex].commandPools )
+			m_context.vkResetCommandPool( m_context.device, pool, 0u );
+	}
+
+	VkCommandBuffer RunnableGraph::doGetCommandBuffer( uint32_t partition )
+	{
+		auto & frame = m_internals->frames[m_frameIndex];
+		auto familyIndex = doGetQueue( m_partitions[partition].queue ).familyIndex;
+
+		if ( frame.commandBuffers.size() <= partition )
+			frame.commandBuffers.resize( partition + 1u, { 0u, VkCommandBuffer{} } );
+
+		auto & [cbFamily, commandBuffer] = frame.commandBuffers[partition];
+
+		if ( commandBuffer && cbFamily == familyIndex )
+			return commandBuffer;
+
+		if ( commandBuffer )
+		{
+			crgUnregisterObject( m_context, commandBuffer );
+			m_context.vkFreeCommandBuffers( m_context.device
+				, doGetCommandPool( cbFamily )
+				, 1u
+				, &commandBuffer );
+			commandBuffer = {};
+		}
+
+		if ( m_context.vkAllocateCommandBuffers )
+		{
+			auto name = m_graph.getName() + "/Frame" + std::to_string( m_frameIndex ) + "/Partition" + std::to_string( partition );
+			VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO
+				, nullptr
+				, doGetCommandPool( familyIndex )
+				, VK_COMMAND_BUFFER_LEVEL_PRIMARY
+				, 1u };
+			auto res = m_context.vkAllocateCommandBuffers( m_context.device
+				, &allocateInfo
+				, &commandBuffer );
+			checkVkResult( res, name + " - CommandBuffer allocation" );
+			crgRegisterObject( m_context, name, commandBuffer );
+			cbFamily = familyIndex;
+		}
+
+		return commandBuffer;
+	}
+
+	VkCommandBuffer RunnableGraph::doBeginPartition( uint32_t partition )
+	{
+		auto commandBuffer = doGetCommandBuffer( partition );
+		// Not one time submit, the command buffer is submitted again while the graph isn't dirty.
+		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+			, nullptr
+			, 0u
+			, nullptr };
+		m_context.vkBeginCommandBuffer( commandBuffer, &beginInfo );
+		return commandBuffer;
+	}
+
+	void RunnableGraph::doEndPartition( VkCommandBuffer commandBuffer )
+	{
+		m_context.vkEndCommandBuffer( commandBuffer );
+	}
+
+	void RunnableGraph::doAcquireResources( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t partition )
+	{
+		auto & current = m_partitions[partition];
+
+		if ( current.acquired.empty() )
+			return;
+
+		auto dstFamily = doGetQueue( current.queue ).familyIndex;
+		context.beginBarrierBatch();
+
+		for ( auto & transfer : current.acquired )
+		{
+			auto srcFamily = transfer.source == QueueTransfer::FrameStart
+				? dstFamily
+				: doGetQueue( m_partitions[transfer.source].queue ).familyIndex;
+			rungrf::forEachView( *transfer.attach, context, *this
+				, [&]( ImageViewId view )
+				{
+					context.acquireOwnership( commandBuffer, view, srcFamily, dstFamily );
+				}
+				, [&]( BufferViewId view )
+				{
+					context.acquireOwnership( commandBuffer, view, srcFamily, dstFamily );
+				} );
+		}
+
+		context.endBarrierBatch( commandBuffer );
+	}
+
+	void RunnableGraph::doReleaseResources( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t partition )
+	{
+		auto srcFamily = doGetQueue( m_partitions[partition].queue ).familyIndex;
+		context.beginBarrierBatch();
+
+		for ( auto & later : m_partitions )
+		{
+			auto dstFamily = doGetQueue( later.queue ).familyIndex;
+
+			for ( auto & transfer : later.acquired )
+			{
+				if ( transfer.source != partition )
+					continue;
+
+				rungrf::forEachView( *transfer.attach, context, *this
+					, [&]( ImageViewId view )
+					{
+						context.releaseOwnership( commandBuffer, view, srcFamily, dstFamily );
+					}
+					, [&]( BufferViewId view )
+					{
+						context.releaseOwnership( commandBuffer, view, srcFamily, dstFamily );
+					} );
+			}
+		}
+
+		context.endBarrierBatch( commandBuffer );
+	}
+
+	GraphQueue const & RunnableGraph::doGetQueue( QueueClass queue )const noexcept
+	{
+		if ( queue == QueueClass::eCompute && m_queues.compute.queue )
+			return m_queues.compute;
+
+		if ( queue == QueueClass::eTransfer && m_queues.transfer.queue )
+			return m_queues.transfer;
+
+		return m_queues.graphics;
+	}
+
+	uint32_t RunnableGraph::doRecordPass( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, uint32_t passIndex
+		, SplitStages & released )
+	{
+		auto const & pass = m_passes[passIndex];
+
+		if ( auto nextPass = std::next( m_passes.begin(), passIndex + 1u );
+			nextPass != m_passes.end() )
+		{
+			context.setNextPipelineState( rungrf::getNextState( pass->getPipelineState(), nextPass, m_passes.end() )
+				, m_internals->nextImageLayouts[passIndex] );
+		}
+		else
+		{
+			context.setNextPipelineState( pass->getPipelineState()
+				, m_graph.getOutputLayoutStates() );
+		}
+
+		if ( passIndex < m_internals->aliasingBarriers.size() && m_internals->aliasingBarriers[passIndex] )
+		{
+			rungrf::aliasingBarrier( m_context, m_counters, commandBuffer );
+		}
+
+		// A disabled pass doesn't acquire anything, its events are waited for by the next pass using the resources.
+		if ( !m_splitBarriers.empty() && pass->isEnabled() )
+			doAcquireSplitBarriers( context, commandBuffer, passIndex, released );
+
+		auto result = pass->recordCurrentInto( context, commandBuffer );
+
+		if ( !m_splitBarriers.empty() && result != RunnablePass::InvalidIndex )
+			doReleaseSplitBarriers( context, commandBuffer, passIndex, released );
+
+		return result;
+	}
+
+	void RunnableGraph::doRecordSerial( RecordContext & context
+		, RecordContext::PassIndexArray & passIndices )
+	{
+		uint32_t partition{};
+		auto commandBuffer = doBeginPartition( partition );
+		doAcquireResources( context, commandBuffer, partition );
+
+		if ( !m_passes.empty() )
+		{
+			context.setNextPipelineState( m_passes.front()->getPipelineState()
+				, m_internals->firstImageLayouts );
+			SplitStages released( m_splitBarriers.size(), VkPipelineStageFlags{} );
+			auto chunk = m_internals->chunks.begin();
+			m_timer.beginPass( commandBuffer, getName(), 0u );
+
+			for ( uint32_t index = 0u; index < m_passes.size(); ++index )
+			{
+				auto & current = m_partitions[partition];
+				auto partitionEnd = index == current.firstPass + current.passCount;
+
+				if ( partitionEnd )
+				{
+					doReleaseResources( context, commandBuffer, partition );
+					doEndPartition( commandBuffer );
+				}
+
+				// The chunks start from these states, when recorded in parallel.
+				if ( chunk != m_internals->chunks.end() && chunk->firstPass == index )
+				{
+					chunk->seed = std::make_unique< RecordContext >( context );
+					chunk->released = released;
+					++chunk;
+				}
+
+				if ( partitionEnd )
+				{
+					commandBuffer = doBeginPartition( ++partition );
+					doAcquireResources( context, commandBuffer, partition );
+				}
+
+				passIndices[index] = doRecordPass( context, commandBuffer, index, released );
+			}
+
+			m_timer.endPass( commandBuffer );
+		}
+
+		doReleaseResources( context, commandBuffer, partition );
+		doEndPartition( commandBuffer );
+	}
+
+	bool RunnableGraph::doRecordChunks( RecordContext & context
+		, RecordContext::PassIndexArray & passIndices )
+	{
+		if ( std::count_if( m_internals->chunks.begin(), m_internals->chunks.end()
+				, []( RecordChunk const & lookup )
+				{
+					return !lookup.inlined;
+				} ) < 2
+			|| !m_internals->recordWorkers
+			|| std::any_of( std::next( m_internals->chunks.begin() ), m_internals->chunks.end()
+				, []( RecordChunk const & lookup )
+				{
+					return lookup.seed == nullptr;
+				} ) )
+			return false;
+
+		// The first chunk starts from the current states, the others from the last serial recording ones.
+		std::vector< RecordContext > contexts;
+		std::vector< SplitStages > released;
+		contexts.reserve( m_internals->chunks.size() );
+		released.reserve( m_internals->chunks.size() );
+		contexts.push_back( context );
+		released.emplace_back( m_splitBarriers.size(), VkPipelineStageFlags{} );
+
+		for ( auto chunk = std::next( m_internals->chunks.begin() ); chunk != m_internals->chunks.end(); ++chunk )
+		{
+			contexts.push_back( *chunk->seed );
+			released.push_back( chunk->released );
+		}
+
+		// The discarded recordings must not be counted.
+		auto counters = m_counters.get();
+		std::vector< RecordWorkers::Task > tasks;
+		tasks.reserve( m_internals->chunks.size() );
+
+		for ( size_t index = 0u; index < m_internals->chunks.size(); ++index )
+		{
+			if ( !m_internals->chunks[index].inlined )
+			{
+				tasks.emplace_back( [this, index, &contexts, &released, &passIndices]()
+					{
+						doRecordChunk( contexts[index], released[index], m_internals->chunks[index], passIndices );
+					} );
+			}
+		}
+
+		m_internals->recordWorkers->run( tasks );
+
+		// A chunk is valid if the previous one ended with the states it started from.
+		auto isSeedValid = [this, &contexts, &released]( size_t index )
+		{
+			if ( contexts[index - 1u].hasSameStates( *m_internals->chunks[index].seed )
+				&& released[index - 1u] == m_internals->chunks[index].released )
+				return true;
+
+			Logger::logDebug( m_graph.getName() + " - Chunk " + std::to_string( index ) + " states changed, recording serially" );
+			return false;
+		};
+
+		// The inlined chunks end states are only known once recorded, the other ones are checked before any primary command buffer is begun.
+		for ( size_t index = 1u; index < m_internals->chunks.size(); ++index )
+		{
+			if ( !m_internals->chunks[index - 1u].inlined
+				&& !isSeedValid( index ) )
+			{
+				m_counters.restoreCommands( counters );
+				return false;
+			}
+		}
+
+		// The render passes are recorded into the primary command buffers, between the other chunks executions.
+		auto chunk = m_internals->chunks.begin();
+		std::vector< VkCommandBuffer > commandBuffers;
+		auto executeChunks = [this, &commandBuffers]( VkCommandBuffer commandBuffer )
+		{
+			if ( !commandBuffers.empty() )
+				m_context.vkCmdExecuteCommands( commandBuffer
+					, uint32_t( commandBuffers.size() )
+					, commandBuffers.data() );
+
+			commandBuffers.clear();
+		};
+
+		for ( uint32_t partition = 0u; partition < m_partitions.size(); ++partition )
+		{
+			auto commandBuffer = doBeginPartition( partition );
+
+			if ( partition == 0u )
+				m_timer.beginPass( commandBuffer, getName(), 0u );
+
+			for ( ; chunk != m_internals->chunks.end() && chunk->partition == partition; ++chunk )
+			{
+				if ( chunk->inlined )
+				{
+					auto index = size_t( std::distance( m_internals->chunks.begin(), chunk ) );
+					executeChunks( commandBuffer );
+					doRecordChunkPasses( contexts[index], commandBuffer, released[index], *chunk, passIndices );
+
+					// The primary command buffers are recorded again by the serial recording, they are reset first.
+					if ( index + 1u < m_internals->chunks.size()
+						&& !isSeedValid( index + 1u ) )
+					{
+						doResetCommandPools();
+						m_counters.restoreCommands( counters );
+						return false;
+					}
+				}
+				else
+				{
+					commandBuffers.push_back( chunk->commandBuffers[m_frameIndex] );
+				}
+			}
+
+			executeChunks( commandBuffer );
+
+			if ( partition + 1u == m_partitions.size() )
+				m_timer.endPass( commandBuffer );
+
+			doEndPartition( commandBuffer );
+		}
+
+		context = std::move( contexts.back() );
+		return true;
+	}
+
+	void RunnableGraph::doRecordChunk( RecordContext & context
+		, SplitStages & released
+		, RecordChunk const & chunk
+		, RecordContext::PassIndexArray & passIndices )
+	{
+		auto commandBuffer = chunk.commandBuffers[m_frameIndex];
+		m_context.vkResetCommandPool( m_context.device, chunk.commandPools[m_frameIndex], 0u );
+		VkCommandBufferInheritanceInfo inheritanceInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO
+			, nullptr
+			, VkRenderPass{}
+			, 0u
+			, VkFramebuffer{}
+			, VK_FALSE
+			, 0u
+			, 0u };
+		VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+			, nullptr
+			, 0u
+			, &inheritanceInfo };
+		m_context.vkBeginCommandBuffer( commandBuffer, &beginInfo );
+		doRecordChunkPasses( context, commandBuffer, released, chunk, passIndices );
+		m_context.vkEndCommandBuffer( commandBuffer );
+	}
+
+	void RunnableGraph::doRecordChunkPasses( RecordContext & context
+		, VkCommandBuffer commandBuffer
+		, SplitStages & released
+		, RecordChunk const & chunk
+		, RecordContext::PassIndexArray & passIndices )
+	{
+		auto & partition = m_partitions[chunk.partition];
+
+		if ( chunk.firstPass == partition.firstPass )
+			doAcquireResources( context, commandBuffer, chunk.partition );
+
+		if ( chunk.firstPass == 0u )
+			context.setNextPipelineState( m_passes.front()->getPipelineState()
+				, m_internals->firstImageLayouts );
+
+		for ( uint32_t index = chunk.firstPass; index < chunk.firstPass + chunk.passCount; ++index )
+			passIndices[index] = doRecordPass( context, commandBuffer, index, released );
+
+		if ( chunk.firstPass + chunk.passCount == partition.firstPass + partition.passCount )
+			doReleaseResources( context, commandBuffer, chunk.partition );
+	}
+
+	void RunnableGraph::doUpdateChunks()
+	{
+		auto threadCount = m_graph.getRecordThreadCount();
+
+		if ( !m_internals->chunksDirty && threadCount == m_internals->chunksThreadCount )
+			return;
+
+		m_internals->chunksDirty = false;
+		m_internals->chunksThreadCount = threadCount;
+
+		// The other frames in flight may still execute the chunks command buffers.
+		if ( !m_internals->chunks.empty() )
+			doWaitFrames();
+
+		for ( auto & chunk : m_internals->chunks )
+			doDestroyChunk( chunk );
+
+		m_internals->chunks.clear();
+
+		if ( threadCount < 2u || m_passes.size() < 2u )
+		{
+			m_internals->recordWorkers.reset();
+			return;
+		}
+
+		if ( !m_internals->recordWorkers || m_internals->recordWorkers->getCount() + 1u != threadCount )
+			m_internals->recordWorkers = std::make_unique< RecordWorkers >( threadCount - 1u );
+
+		// Each chunk has its own pool, a command pool can't be used from several threads.
+		auto chunkSize = uint32_t( ( m_passes.size() + threadCount - 1u ) / threadCount );
+
+		for ( uint32_t partition = 0u; partition < m_partitions.size(); ++partition )
+		{
+			auto & current = m_partitions[partition];
+			auto familyIndex = doGetQueue( current.queue ).familyIndex;
+			auto partitionEnd = current.firstPass + current.passCount;
+
+			auto firstPass = current.firstPass;
+
+			while ( firstPass < partitionEnd )
+			{
+				// Consecutive render passes are grouped in one chunk, recorded into the primary command buffer.
+				auto inlined = m_passes[firstPass]->isRenderPass();
+				uint32_t passCount = 1u;
+
+				while ( firstPass + passCount < partitionEnd
+					&& m_passes[firstPass + passCount]->isRenderPass() == inlined
+					&& ( inlined || passCount < chunkSize ) )
+					++passCount;
+
+				auto & chunk = m_internals->chunks.emplace_back();
+				chunk.partition = partition;
+				chunk.firstPass = firstPass;
+				chunk.passCount = passCount;
+				chunk.familyIndex = familyIndex;
+				chunk.inlined = inlined;
+				firstPass += passCount;
+
+				for ( uint32_t frame = 0u; frame < m_framesInFlight && !inlined; ++frame )
+				{
+					auto name = m_graph.getName() + "/Frame" + std::to_string( frame ) + "/Chunk" + std::to_string( m_internals->chunks.size() - 1u );
+					auto & commandPool = chunk.commandPools.emplace_back( rungrf::createCommandPool( m_context, name, familyIndex, 0u ) );
+					auto & commandBuffer = chunk.commandBuffers.emplace_back();
+
+					if ( m_context.vkAllocateCommandBuffers )
+					{
+						VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO
+							, nullptr
+							, commandPool
+							, VK_COMMAND_BUFFER_LEVEL_SECONDARY
+							, 1u };
+						auto res = m_context.vkAllocateCommandBuffers( m_context.device
+							, &allocateInfo
+							, &commandBuffer );
+						checkVkResult( res, name + " - CommandBuffer allocation" );
+						crgRegisterObject( m_context, name, commandBuffer );
+					}
+				}
+			}
+		}
+
+		Logger::logDebug( m_graph.getName() + " - " + std::to_string( m_internals->chunks.size() ) + " record chunks" );
+	}
+
+	void RunnableGraph::doDestroyChunk( RecordChunk & chunk )
+	{
+		for ( size_t frame = 0u; frame < chunk.commandPools.size(); ++frame )
+		{
+			if ( auto & commandBuffer = chunk.commandBuffers[frame] )
+			{
+				crgUnregisterObject( m_context, commandBuffer );
+				m_context.vkFreeCommandBuffers( m_context.device
+					, chunk.commandPools[frame]
+					, 1u
+					, &commandBuffer );
+			}
+
+			if ( auto & commandPool = chunk.commandPools[frame] )
+			{
+				crgUnregisterObject( m_context, commandPool );
+				m_context.vkDestroyCommandPool( m_context.device
+					, commandPool
+					, m_context.allocator );
+			}
+		}
+
+		chunk.commandBuffers.clear();
+		chunk.commandPools.clear();
+	}
+
+	void RunnableGraph::doCreateFrames()
+	{
+		for ( uint32_t index = 0u; index < m_framesInFlight; ++index )
+		{
+			auto name = m_graph.getName() + "/Frame" + std::to_string( index );
+			auto & frame = m_internals->frames.emplace_back( FrameData{ Fence{ m_context
+				, name
+				, { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, VK_FENCE_CREATE_SIGNALED_BIT } } } );
+
+			// With a timeline semaphore, the graph submissions don't signal a per frame semaphore.
+			if ( !m_timelineSemaphore.object )
+				frame.semaphore = rungrf::createSemaphore( m_context, name );
+		}
+	}
+
+	void RunnableGraph::doDestroyFrames()
+	{
+		for ( auto & frame : m_internals->frames )
+		{
+			if ( m_context.vkDestroySemaphore && frame.semaphore )
+			{
+				crgUnregisterObject( m_context, frame.semaphore );
+				m_context.vkDestroySemaphore( m_context.device
+					, frame.semaphore
+					, m_context.allocator );
+			}
+
+			for ( auto semaphore : frame.queueSemaphores )
+			{
+				crgUnregisterObject( m_context, semaphore );
+				m_context.vkDestroySemaphore( m_context.device
+					, semaphore
+					, m_context.allocator );
+			}
+
+			for ( auto event : frame.splitEvents )
+			{
+				crgUnregisterObject( m_context, event );
+				m_context.vkDestroyEvent( m_context.device
+					, event
+					, m_context.allocator );
+			}
+
+			// The command buffers are freed with their pool.
+			for ( auto & [familyIndex, commandBuffer] : frame.commandBuffers )
+			{
+				if ( commandBuffer )
+					crgUnregisterObject( m_context, commandBuffer );
+			}
+
+			for ( auto & [familyIndex, pool] : frame.commandPools )
+			{
+				crgUnregisterObject( m_context, pool );
+				m_context.vkDestroyCommandPool( m_context.device
+					, pool
+					, m_context.allocator );
+			}
+		}
+
+		m_internals->frames.clear();
+	}
+
+	VkResult RunnableGraph::doWaitFrame( FrameData & frame
+		, uint64_t timeout )
+	{
+#if VK_VERSION_1_2
+		if ( m_timelineSemaphore.object )
+		{
+			if ( frame.timelineValue == 0u )
+				return VK_SUCCESS;
+
+			VkSemaphoreWaitInfo waitInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO
+				, nullptr
+				, 0u
+				, 1u
+				, &m_timelineSemaphore.object
+				, &frame.timelineValue };
+			return m_context.vkWaitSemaphores( m_context.device
+				, &waitInfo
+				, timeout );
+		}
+#endif
+		return frame.fence.wait( timeout );
+	}
+
+	void RunnableGraph::doWaitFrames()
+	{
+		for ( auto & frame : m_internals->frames )
+			doWaitFrame( frame, 0xFFFFFFFFFFFFFFFFULL );
+	}
+
+	void RunnableGraph::doAttachScopeHistories( FramePassTimer & timer )noexcept
+	{
+		auto scope = size_t( timer.getScope() );
+		timer.setScopeHistories( &m_cpuScopeHistories[scope]
+			, &m_gpuScopeHistories[scope] );
+	}
+
+	void RunnableGraph::doSetTimersFrame()
+	{
+		m_timer.setFrameIndex( m_frameIndex, m_frameId );
+
+		for ( auto const & pass : m_passes )
+			pass->getTimer().setFrameIndex( m_frameIndex, m_frameId );
+	}
+
+	VkBuffer RunnableGraph::createBuffer( BufferId const & buffer )
+	{
+		return m_resources.createBuffer( buffer );
+	}
+
+	VkBufferView RunnableGraph::createBufferView( BufferViewId const & view )
+	{
+		return m_resources.createBufferView( view );
+	}
+
+	VkImage RunnableGraph::createImage( ImageId const & image )
+	{
+		return m_resources.createImage( image );
+	}
+
+	VkImageView RunnableGraph::createImageView( ImageViewId const & view )
+	{
+		return m_resources.createImageView( view );
+	}
+
+	VkSampler RunnableGraph::createSampler( SamplerDesc const & samplerDesc )
+	{
+		return m_resources.createSampler( samplerDesc );
+	}
+
+	VertexBuffer const & RunnableGraph::createQuadTriVertexBuffer( bool texCoords
+		, Texcoord const & config )
+	{
+		return m_resources.createQuadTriVertexBuffer( texCoords
+			, config );
+	}
+
+	LayoutState RunnableGraph::getCurrentLayoutState( RecordContext & context
+		, ImageId image
+		, ImageViewType viewType
+		, ImageSubresourceRange range )const
+	{
+		auto result = context.getLayoutState( image, viewType, range );
+
+		if ( result.layout == ImageLayout::eUndefined )
+		{
+			// Lookup in graph's external inputs.
+			result = m_graph.getInputLayoutState( image, viewType, range );
+
+			if ( result.layout != ImageLayout::eUndefined )
+			{
+				context.setLayoutState( image, viewType, range, result );
+			}
+		}
+
+		// The content of the transient images sharing their memory is lost between two frames.
+		if ( result.layout == ImageLayout::eUndefined
+			&& m_internals->aliasedImages.find( image.id ) == m_internals->aliasedImages.end() )
 		{
 			// Lookup in graph's previous final state.
 			result = m_graph.getFinalLayoutState( image, viewType, range );
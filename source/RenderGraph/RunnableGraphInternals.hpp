@@ -0,0 +1,118 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/RunnableGraph.hpp"
+#include "RecordWorkers.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace crg
+{
+	/**
+	*\brief
+	*	What a RunnablePass depends on, in its FramePass.
+	*\remarks
+	*	The hash is compared first, the pass ID and attachments then rule out collisions.
+	*/
+	struct RunnablePassSignature
+	{
+		size_t hash{};
+		uint32_t id{};
+		std::vector< std::pair< uint32_t, Attachment const * > > attaches;
+
+	private:
+		friend bool operator==( RunnablePassSignature const & lhs, RunnablePassSignature const & rhs ) = default;
+	};
+	/**
+	*\brief
+	*	Consecutive passes of a partition, recorded into their own secondary command buffer.
+	*/
+	struct RunnableGraph::RecordChunk
+	{
+		uint32_t partition{};
+		uint32_t firstPass{};
+		uint32_t passCount{};
+		uint32_t familyIndex{};
+		/**
+		*\brief
+		*	\p true for a render pass, recorded into the partition's primary command buffer
+		*	since a render pass can't be begun in a secondary one.
+		*/
+		bool inlined{};
+		/**
+		*\brief
+		*	One pool and secondary command buffer per frame in flight.
+		*/
+		std::vector< VkCommandPool > commandPools;
+		std::vector< VkCommandBuffer > commandBuffers;
+		/**
+		*\brief
+		*	The states of the last serial recording, before the first pass of the chunk.
+		*/
+		std::unique_ptr< RecordContext > seed;
+		SplitStages released;
+	};
+	/**
+	*\brief
+	*	The objects used by one frame in flight.
+	*/
+	struct RunnableGraph::FrameData
+	{
+		Fence fence;
+		VkSemaphore semaphore{};
+		/**
+		*\brief
+		*	One pool per queue family, reset when the frame is recorded.
+		*/
+		std::vector< std::pair< uint32_t, VkCommandPool > > commandPools;
+		/**
+		*\brief
+		*	One command buffer per queue partition.
+		*/
+		std::vector< std::pair< uint32_t, VkCommandBuffer > > commandBuffers;
+		std::vector< VkSemaphore > queueSemaphores;
+		std::vector< VkEvent > splitEvents;
+		/**
+		*\brief
+		*	The timeline value signaled by the frame last submission.
+		*/
+		uint64_t timelineValue{};
+		/**
+		*\brief
+		*	\p false if the frame command buffers don't match the last recording.
+		*/
+		bool recorded{};
+	};
+	/**
+	*\brief
+	*	The recording states of a RunnableGraph, kept between two runs.
+	*/
+	struct RunnableGraph::Internals
+	{
+		std::vector< RunnablePassSignature > passSignatures;
+		std::vector< FrameData > frames;
+		std::vector< VkDeviceMemory > transientMemory;
+		std::unordered_set< uint32_t > aliasedImages;
+		std::vector< bool > aliasingBarriers;
+		/**
+		*\brief
+		*	The pass waiting for each split barrier.
+		*/
+		std::vector< uint32_t > splitAcquirers;
+		bool partitionsDirty{ true };
+		bool recordDirty{ true };
+		std::vector< RecordContext > dependencyStates;
+		std::unordered_map< uint32_t, std::vector< uint32_t > > imageUses;
+		std::shared_ptr< LayerLayoutStatesHandler const > firstImageLayouts;
+		std::vector< std::shared_ptr< LayerLayoutStatesHandler const > > nextImageLayouts;
+		std::vector< bool > nextLayoutsEnabled;
+		std::vector< RecordChunk > chunks;
+		bool chunksDirty{ true };
+		uint32_t chunksThreadCount{};
+		std::unique_ptr< RecordWorkers > recordWorkers;
+	};
+}
@@ -4,6 +4,7 @@ See LICENSE file in root folder.
 */
 #include "RenderGraph/RunnablePass.hpp"
 
+#include "RenderGraph/FramePassGroup.hpp"
 #include "RenderGraph/GraphContext.hpp"
 #include "RenderGraph/Log.hpp"
 #include "RenderGraph/RunnableGraph.hpp"
@@ -124,6 +125,7 @@ namespace crg
 						, view
 						, currentLayout.layout
 						, makeLayoutState( ImageLayout::eTransferDst ) );
+					recordContext.flushBarriers( commandBuffer );
 					auto subresourceRange = convert( getSubresourceRange( view ) );
 
 					if ( isColourFormat( getFormat( view ) ) )
@@ -183,6 +185,7 @@ namespace crg
 						, range
 						, currentState
 						, { AccessFlags::eTransferWrite, PipelineStageFlags::eTransfer } );
+					recordContext.flushBarriers( commandBuffer );
 					recordContext->vkCmdFillBuffer( commandBuffer
 						, graph.createBuffer( buffer )
 						, range.offset == 0u ? 0u : details::getAlignedSize( range.offset, 4u )
@@ -263,6 +266,36 @@ namespace crg
 		}
 	}
 
+	void convert( SemaphoreWaitArray const & toWait
+		, std::vector< VkSemaphore > & semaphores
+		, std::vector< VkPipelineStageFlags > & dstStageMasks
+		, std::vector< uint64_t > & values )
+	{
+		values.resize( semaphores.size() );
+
+		for ( auto & wait : toWait )
+		{
+			if ( !wait.semaphore )
+				continue;
+
+			auto it = std::find( semaphores.begin()
+				, semaphores.end()
+				, wait.semaphore );
+
+			if ( it == semaphores.end() )
+			{
+				semaphores.push_back( wait.semaphore );
+				dstStageMasks.push_back( getPipelineStageFlags( wait.dstStageMask ) );
+				values.push_back( wait.value );
+			}
+			else
+			{
+				auto & value = values[size_t( std::distance( semaphores.begin(), it ) )];
+				value = std::max( value, wait.value );
+			}
+		}
+	}
+
 	//*********************************************************************************************
 
 	RunnablePass::Callbacks::Callbacks( InitialiseCallback initialise
@@ -458,8 +491,10 @@ namespace crg
 		, m_callbacks{ std::move( callbacks ) }
 		, m_ruConfig{ std::move( ruConfig ) }
 		, m_pipelineState{ m_callbacks.getPipelineState() }
-		, m_timer{ context, pass.getGroupName(), TimerScope::ePass, graph.getTimerQueryPool(), graph.getTimerQueryOffset() }
+		, m_timer{ context, pass.getGroupName(), TimerScope::ePass, graph.getTimerQueryPool(), graph.getTimerQueryOffset(), graph.getFramesInFlight() }
 	{
+		m_timer.setTracePath( pass.getGroup().getFullName() );
+
 		for ( uint32_t i = 0u; i < m_ruConfig.maxPassCount; ++i )
 		{
 			m_passes.emplace_back( m_graph, m_context, m_pass.getGroupName() );
@@ -492,13 +527,16 @@ namespace crg
 		recordInto( commandBuffer
 			, index
 			, context );
-		return isEnabled() ? index : InvalidIndex;
+		m_recordedIndex = isEnabled() ? index : InvalidIndex;
+		m_dirty = false;
+		return m_recordedIndex;
 	}
 
 	uint32_t RunnablePass::reRecordCurrent()
 	{
 		assert( m_ruConfig.resettable );
 		auto index = m_callbacks.getPassIndex();
+		m_dirty = true;
 
 		if ( index < m_passContexts.size() )
 		{
@@ -506,6 +544,7 @@ namespace crg
 			recordOne( m_passes[index].commandBuffer
 				, index
 				, context );
+			m_graph.getCurrentCounters().addReRecord();
 		}
 
 		return isEnabled() ? index : InvalidIndex;
@@ -553,8 +592,10 @@ namespace crg
 			auto block( m_timer.start() );
 			m_timer.beginPass( commandBuffer, m_pass.getGroupName(), m_pass.getId() );
 
+			context.beginBarrierBatch();
 			details::prepareResources( commandBuffer, index, context
 				, m_graph, m_pass, m_callbacks, m_context );
+			context.endBarrierBatch( commandBuffer );
 
 			for ( auto const & action : m_ruConfig.prePassActions )
 			{
@@ -585,6 +626,7 @@ namespace crg
 	bool RunnablePass::resetCommandBuffer( uint32_t passIndex )
 	{
 		bool result{};
+		m_dirty = true;
 
 		if ( m_context.device )
 		{
@@ -27,7 +27,7 @@ namespace crg
 				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
-			, std::move( ruConfig ) }
+			, ru::getTrackedConfig( std::move( ruConfig ) ) }
 		, m_copyOffset{ copyOffset }
 		, m_copyRange{ copyRange }
 	{
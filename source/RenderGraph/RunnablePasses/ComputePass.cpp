@@ -16,6 +16,20 @@ namespace crg
 		{
 			return v ? *v : true;
 		}
+
+		static ru::Config getRuConfig( ru::Config ruConfig
+			, cp::Config const & cpConfig )
+		{
+			// These callbacks are called when recording, the other inputs are tracked by the graph.
+			if ( !ruConfig.recordEachRun )
+				ruConfig.recordEachRun = cpConfig.m_recordInto
+					|| cpConfig.m_end
+					|| cpConfig.m_getGroupCountX
+					|| cpConfig.m_getGroupCountY
+					|| cpConfig.m_getGroupCountZ;
+
+			return ruConfig;
+		}
 	}
 
 	ComputePass::ComputePass( FramePass const & pass
@@ -32,7 +46,7 @@ namespace crg
 				, GetPassIndexCallback( [this](){ return doGetPassIndex(); } )
 				, IsEnabledCallback( [this](){ return doIsEnabled(); } )
 				, IsComputePassCallback( [](){ return true; } ) }
-			, ruConfig }
+			, cppss::getRuConfig( ruConfig, cpConfig ) }
 		, m_cpConfig{ cpConfig.m_initialise ? std::move( *cpConfig.m_initialise ) : getDefaultV< RunnablePass::InitialiseCallback >()
 			, cpConfig.m_enabled.has_value() ? std::move( *cpConfig.m_enabled ) : getDefaultV< bool const * >()
 			, cpConfig.m_isEnabled
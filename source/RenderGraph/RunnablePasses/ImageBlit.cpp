@@ -28,7 +28,7 @@ namespace crg
 				, [this]( RecordContext const & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
-			, std::move( ruConfig ) }
+			, ru::getTrackedConfig( std::move( ruConfig ) ) }
 		, m_srcOffset{ convert( blitSrc.offset ) }
 		, m_srcSize{ convert( blitSrc.extent ) }
 		, m_dstOffset{ convert( blitDst.offset ) }
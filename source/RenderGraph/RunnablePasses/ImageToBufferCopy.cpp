@@ -27,7 +27,7 @@ namespace crg
 				, [this]( RecordContext const & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
 				, std::move( passIndex )
 				, std::move( isEnabled ) }
-			, std::move( ruConfig ) }
+			, ru::getTrackedConfig( std::move( ruConfig ) ) }
 		, m_copyOffset{ convert( copyOffset ) }
 		, m_copySize{ convert( copySize ) }
 	{
@@ -211,6 +211,7 @@ namespace crg
 				, &pipeline );
 			crg::checkVkResult( res, name + " - Pipeline creation" );
 			crgRegisterObject( m_context, name, pipeline );
+			m_graph.getCurrentCounters().addPipeline();
 		}
 	}
 
@@ -237,6 +238,7 @@ namespace crg
 				, &pipeline );
 			checkVkResult( res, name + " - Pipeline creation" );
 			crgRegisterObject( m_context, name, pipeline );
+			m_graph.getCurrentCounters().addPipeline();
 		}
 	}
 
@@ -355,6 +357,7 @@ namespace crg
 			, descriptorWrites.data()
 			, 0u
 			, nullptr );
+		m_graph.getCurrentCounters().addDescriptorSetUpdate();
 	}
 
 	void PipelineHolder::doFillDescriptorBindings()
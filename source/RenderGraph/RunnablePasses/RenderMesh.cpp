@@ -6,6 +6,26 @@ See LICENSE file in root folder.
 
 namespace crg
 {
+	namespace rdmesh
+	{
+		static ru::Config getRuConfig( ru::Config ruConfig
+			, rm::Config const & rmConfig )
+		{
+			ruConfig.resettable = true;
+			ruConfig.renderPass = true;
+			// These callbacks are called when recording, the other inputs are tracked by the graph.
+			if ( !ruConfig.recordEachRun )
+				ruConfig.recordEachRun = rmConfig.m_recordInto
+					|| rmConfig.m_end
+					|| rmConfig.m_getPrimitiveCount
+					|| rmConfig.m_getVertexCount
+					|| rmConfig.m_getIndexType
+					|| rmConfig.m_getCullMode;
+
+			return ruConfig;
+		}
+	}
+
 	RenderMesh::RenderMesh( FramePass const & pass
 		, GraphContext & context
 		, RunnableGraph & graph
@@ -19,12 +39,7 @@ namespace crg
 				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
 				, GetPassIndexCallback( [this](){ return m_renderMesh.getPassIndex(); } )
 				, IsEnabledCallback( [this](){ return m_renderMesh.isEnabled(); } ) }
-			, { ruConfig.maxPassCount
-				, true /*resettable*/
-				, ruConfig.prePassActions
-				, ruConfig.postPassActions
-				, ruConfig.implicitImageActions
-				, ruConfig.implicitBufferActions } }
+			, rdmesh::getRuConfig( ruConfig, rmConfig ) }
 		, m_renderMesh{ pass
 			, context
 			, graph
@@ -84,6 +84,15 @@ namespace crg
 
 	//*********************************************************************************************
 
+	namespace rdpass
+	{
+		static ru::Config getRuConfig( ru::Config ruConfig )
+		{
+			ruConfig.renderPass = true;
+			return ruConfig;
+		}
+	}
+
 	RenderPass::RenderPass( FramePass const & pass
 		, GraphContext & context
 		, RunnableGraph & graph
@@ -98,7 +107,7 @@ namespace crg
 				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
 				, std::move( callbacks.getPassIndex )
 				, std::move( callbacks.isEnabled ) }
-			, ruConfig }
+			, rdpass::getRuConfig( ruConfig ) }
 		, m_rpCallbacks{ std::move( callbacks ) }
 		, m_holder{ pass
 			, context
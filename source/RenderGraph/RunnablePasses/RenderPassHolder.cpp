@@ -315,6 +315,7 @@ namespace crg
 			, &data.renderPass );
 		checkVkResult( res, m_pass.getGroupName() + " - RenderPass creation" );
 		crgRegisterObject( m_context, m_pass.getGroupName() + std::to_string( m_count++ ), data.renderPass );
+		m_graph.getCurrentCounters().addRenderPass();
 	}
 
 	VkPipelineColorBlendStateCreateInfo RenderPassHolder::createBlendState()
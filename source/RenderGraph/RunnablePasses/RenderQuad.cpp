@@ -6,6 +6,22 @@ See LICENSE file in root folder.
 
 namespace crg
 {
+	namespace rdquad
+	{
+		static ru::Config getRuConfig( ru::Config ruConfig
+			, rq::Config const & rqConfig )
+		{
+			ruConfig.resettable = true;
+			ruConfig.renderPass = true;
+			// These callbacks are called when recording, the other inputs are tracked by the graph.
+			if ( !ruConfig.recordEachRun )
+				ruConfig.recordEachRun = rqConfig.m_recordInto
+					|| rqConfig.m_end;
+
+			return ruConfig;
+		}
+	}
+
 	RenderQuad::RenderQuad( FramePass const & pass
 		, GraphContext & context
 		, RunnableGraph & graph
@@ -19,12 +35,7 @@ namespace crg
 				, [this]( RecordContext & recContext, VkCommandBuffer cb, uint32_t i ){ doRecordInto( recContext, cb, i ); }
 				, GetPassIndexCallback( [this](){ return m_renderQuad.getPassIndex(); } )
 				, IsEnabledCallback( [this](){ return m_renderQuad.isEnabled(); } ) }
-			, { ruConfig.maxPassCount
-				, true /*resettable*/
-				, ruConfig.prePassActions
-				, ruConfig.postPassActions
-				, ruConfig.implicitImageActions
-				, ruConfig.implicitBufferActions } }
+			, rdquad::getRuConfig( ruConfig, rqConfig ) }
 		, m_renderQuad{ pass
 			, context
 			, graph
@@ -0,0 +1,123 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "SplitBarriers.hpp"
+#include "ResourceUses.hpp"
+
+#include "RenderGraph/Attachment.hpp"
+#include "RenderGraph/FramePass.hpp"
+#include "RenderGraph/BufferViewData.hpp"
+#include "RenderGraph/ImageViewData.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace crg::split
+{
+	namespace splbar
+	{
+		struct ResourceState
+		{
+			uint32_t writer{};
+			bool touched{};
+		};
+
+		static bool isTransitioned( Attachment const & attach )
+		{
+			if ( attach.isNoTransition()
+				|| !attach.isInput()
+				|| attach.isOutput() )
+				return false;
+
+			if ( attach.isImage() )
+				return attach.getViewCount() == 1u
+					&& attach.view().data->source.empty()
+					&& !attach.isClearableImage()
+					&& ( attach.isSampledImageView() || attach.isStorageImageView() || attach.isTransferImageView() || attach.isTransitionImageView() );
+
+			return attach.getBufferCount() == 1u
+				&& !attach.isClearableBuffer()
+				&& ( attach.isStorageBuffer() || attach.isTransferBuffer() || attach.isTransitionBuffer() );
+		}
+
+		static uses::ResourceKey getResource( Attachment const & attach )
+		{
+			return attach.isImage()
+				? uses::ResourceKey{ true, attach.view().data->image.id }
+				: uses::ResourceKey{ false, attach.buffer().data->buffer.id };
+		}
+	}
+
+	SplitBarrierArray listSplitBarriers( std::vector< RunnablePassPtr > const & passes )
+	{
+		SplitBarrierArray result;
+		std::map< uses::ResourceKey, splbar::ResourceState > states;
+		uint32_t passIndex{};
+
+		for ( auto & pass : passes )
+		{
+			auto passUses = uses::listUses( pass->getPass() );
+
+			for ( auto & use : passUses )
+			{
+				auto it = states.find( use.resource );
+
+				if ( it == states.end()
+					|| it->second.touched
+					|| it->second.writer + 1u >= passIndex
+					|| !splbar::isTransitioned( *use.attach ) )
+					continue;
+
+				// The reader must use the resource through this attachment only.
+				if ( 1u == std::count_if( passUses.begin(), passUses.end()
+					, [&use]( uses::ResourceUse const & lookup )
+					{
+						return lookup.resource == use.resource;
+					} ) )
+					result.push_back( { it->second.writer, passIndex, use.attach } );
+			}
+
+			for ( auto & use : passUses )
+			{
+				if ( use.attach->isOutput() )
+					states.insert_or_assign( use.resource, splbar::ResourceState{ passIndex, false } );
+				else if ( auto it = states.find( use.resource ); it != states.end() && it->second.writer != passIndex )
+					it->second.touched = true;
+			}
+
+			++passIndex;
+		}
+
+		return result;
+	}
+
+	uint32_t findAcquirer( std::vector< RunnablePassPtr > const & passes
+		, SplitBarrier const & split
+		, uint32_t endPass )
+	{
+		if ( passes[split.consumer]->isEnabled() )
+			return split.consumer;
+
+		auto resource = splbar::getResource( *split.attach );
+
+		for ( auto passIndex = split.consumer + 1u; passIndex < endPass; ++passIndex )
+		{
+			auto & pass = *passes[passIndex];
+
+			if ( !pass.isEnabled() )
+				continue;
+
+			auto passUses = uses::listUses( pass.getPass() );
+
+			if ( std::any_of( passUses.begin(), passUses.end()
+				, [&resource]( uses::ResourceUse const & lookup )
+				{
+					return lookup.resource == resource;
+				} ) )
+				return passIndex;
+		}
+
+		return RunnablePass::InvalidIndex;
+	}
+}
@@ -0,0 +1,30 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#pragma once
+
+#include "RenderGraph/RunnableGraph.hpp"
+
+namespace crg::split
+{
+	/**
+	*\brief
+	*	Lists the resources written by a pass and next read by a later, non adjacent, pass.
+	*\remarks
+	*	Only the resources untouched by the passes in between are listed,
+	*	when the reader uses them through a single view attachment needing a transition.
+	*/
+	SplitBarrierArray listSplitBarriers( std::vector< RunnablePassPtr > const & passes );
+	/**
+	*\brief
+	*	Finds the pass waiting for the event of the given split barrier.
+	*\remarks
+	*	It is the consumer when it is enabled, else the next enabled pass using the resource, before \p endPass.
+	*\return
+	*	RunnablePass::InvalidIndex if no enabled pass uses the resource, the event is then not set.
+	*/
+	uint32_t findAcquirer( std::vector< RunnablePassPtr > const & passes
+		, SplitBarrier const & split
+		, uint32_t endPass );
+}
@@ -0,0 +1,81 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/TimerHistory.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace crg
+{
+	namespace tmrhst
+	{
+		static Nanoseconds getPercentile( std::vector< int64_t > const & sorted
+			, uint32_t count
+			, uint32_t percent )
+		{
+			// Nearest rank.
+			auto rank = std::max( 1u, ( count * percent + 99u ) / 100u );
+			return Nanoseconds{ sorted[rank - 1u] };
+		}
+	}
+
+	TimerHistory::TimerHistory( uint32_t capacity
+		, Nanoseconds hitchThreshold )
+		: m_samples( capacity )
+		, m_sorted( capacity )
+		, m_hitchThreshold{ hitchThreshold.count() }
+	{
+	}
+
+	bool TimerHistory::push( Nanoseconds sample )noexcept
+	{
+		auto threshold = m_hitchThreshold.load( std::memory_order_relaxed );
+		auto result = threshold > 0 && sample.count() > threshold;
+
+		if ( result )
+			m_hitches.fetch_add( 1u, std::memory_order_relaxed );
+
+		if ( !m_samples.empty() )
+		{
+			auto index = m_count.fetch_add( 1u, std::memory_order_relaxed );
+			m_samples[index % m_samples.size()].store( sample.count(), std::memory_order_release );
+		}
+
+		return result;
+	}
+
+	TimerStatistics TimerHistory::getStatistics()const noexcept
+	{
+		TimerStatistics result;
+		result.hitches = m_hitches.load( std::memory_order_relaxed );
+		result.count = uint32_t( std::min( m_count.load( std::memory_order_acquire ), uint64_t( m_samples.size() ) ) );
+
+		if ( result.count == 0u )
+			return result;
+
+		auto end = std::next( m_sorted.begin(), ptrdiff_t( result.count ) );
+		std::transform( m_samples.begin()
+			, std::next( m_samples.begin(), ptrdiff_t( result.count ) )
+			, m_sorted.begin()
+			, []( std::atomic< int64_t > const & sample )
+			{
+				return sample.load( std::memory_order_acquire );
+			} );
+		std::sort( m_sorted.begin(), end );
+		result.min = Nanoseconds{ m_sorted.front() };
+		result.max = Nanoseconds{ *std::prev( end ) };
+		result.mean = Nanoseconds{ std::accumulate( m_sorted.begin(), end, int64_t{} ) / int64_t( result.count ) };
+		result.p50 = tmrhst::getPercentile( m_sorted, result.count, 50u );
+		result.p95 = tmrhst::getPercentile( m_sorted, result.count, 95u );
+		result.p99 = tmrhst::getPercentile( m_sorted, result.count, 99u );
+		return result;
+	}
+
+	void TimerHistory::clear()noexcept
+	{
+		m_count.store( 0u, std::memory_order_relaxed );
+		m_hitches.store( 0u, std::memory_order_relaxed );
+	}
+}
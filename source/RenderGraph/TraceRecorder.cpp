@@ -0,0 +1,288 @@
+/*
+This file belongs to FrameGraph.
+See LICENSE file in root folder.
+*/
+#include "RenderGraph/TraceRecorder.hpp"
+#include "RenderGraph/GraphContext.hpp"
+#include "JsonWriter.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace crg
+{
+	namespace trcrec
+	{
+		static constexpr uint32_t CpuProcess = 1u;
+		static constexpr uint32_t GpuProcess = 2u;
+
+		static void writeMetadata( std::ostream & stream
+			, std::string const & name
+			, uint32_t process
+			, std::optional< uint32_t > thread
+			, std::string const & value )
+		{
+			stream << ",\n{\"name\":";
+			json::writeString( stream, name );
+			stream << ",\"ph\":\"M\",\"pid\":" << process;
+
+			if ( thread )
+				stream << ",\"tid\":" << *thread;
+
+			stream << ",\"args\":{\"name\":";
+			json::writeString( stream, value );
+			stream << "}}";
+		}
+
+		static void writeSpan( std::ostream & stream
+			, std::string const & name
+			, std::string const & category
+			, uint32_t process
+			, uint32_t thread
+			, uint64_t frameId
+			, double begin
+			, double end )
+		{
+			// Chrome traces are in microseconds.
+			stream << ",\n{\"name\":";
+			json::writeString( stream, name );
+			stream << ",\"cat\":";
+			json::writeString( stream, category );
+			stream << ",\"ph\":\"X\",\"pid\":" << process
+				<< ",\"tid\":" << thread
+				<< ",\"ts\":" << ( begin / 1000.0 )
+				<< ",\"dur\":" << ( std::max( 0.0, end - begin ) / 1000.0 )
+				<< ",\"args\":{\"frame\":" << frameId << "}}";
+		}
+
+		static double getNanoseconds( Clock::time_point origin
+			, Clock::time_point value )
+		{
+			return double( std::chrono::duration_cast< Nanoseconds >( value - origin ).count() );
+		}
+	}
+
+	//*********************************************************************************************
+
+	TraceRecorder::TraceRecorder()
+		: m_origin{ Clock::now() }
+	{
+	}
+
+	void TraceRecorder::addCpuEvent( std::string name
+		, std::string category
+		, std::string path
+		, uint64_t frameId
+		, Clock::time_point begin
+		, Clock::time_point end )
+	{
+		std::lock_guard lock{ m_mutex };
+		m_events.push_back( { std::move( name )
+			, std::move( category )
+			, std::move( path )
+			, frameId
+			, doGetThreadIndex()
+			, false
+			, trcrec::getNanoseconds( m_origin, begin )
+			, trcrec::getNanoseconds( m_origin, end ) } );
+	}
+
+	void TraceRecorder::addGpuEvent( std::string name
+		, std::string category
+		, std::string path
+		, uint64_t frameId
+		, uint64_t begin
+		, uint64_t end
+		, float period )
+	{
+		std::lock_guard lock{ m_mutex };
+		m_events.push_back( { std::move( name )
+			, std::move( category )
+			, std::move( path )
+			, frameId
+			, 0u
+			, true
+			, double( begin ) * double( period )
+			, double( end ) * double( period ) } );
+	}
+
+	void TraceRecorder::setCalibration( uint64_t gpuTimestamp
+		, float period
+		, Clock::time_point cpuTime )
+	{
+		std::lock_guard lock{ m_mutex };
+		m_calibration = Calibration{ double( gpuTimestamp ) * double( period )
+			, trcrec::getNanoseconds( m_origin, cpuTime ) };
+	}
+
+	bool TraceRecorder::calibrate( [[maybe_unused]] GraphContext const & context )
+	{
+#if VK_EXT_calibrated_timestamps
+		if ( !context.vkGetCalibratedTimestampsEXT )
+			return false;
+
+		// Only the device time domain is queried, the CPU time is taken around the call.
+		VkCalibratedTimestampInfoEXT info{ VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT
+			, nullptr
+			, VK_TIME_DOMAIN_DEVICE_EXT };
+		uint64_t timestamp{};
+		uint64_t deviation{};
+		auto before = Clock::now();
+		auto res = context.vkGetCalibratedTimestampsEXT( context.device
+			, 1u
+			, &info
+			, &timestamp
+			, &deviation );
+		auto after = Clock::now();
+
+		if ( res != VK_SUCCESS )
+			return false;
+
+		setCalibration( timestamp
+			, context.timestampPeriod
+			, before + ( after - before ) / 2 );
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void TraceRecorder::write( std::ostream & stream )const
+	{
+		std::lock_guard lock{ m_mutex };
+		auto gpuOffset = 0.0;
+
+		if ( m_calibration )
+		{
+			gpuOffset = m_calibration->cpu - m_calibration->gpu;
+		}
+		else
+		{
+			auto gpuOrigin = std::numeric_limits< double >::max();
+
+			for ( auto const & event : m_events )
+			{
+				if ( event.gpu )
+					gpuOrigin = std::min( gpuOrigin, event.begin );
+			}
+
+			gpuOffset = -gpuOrigin;
+		}
+
+		auto flags = stream.flags();
+		auto fill = stream.fill();
+		stream << std::fixed << std::setprecision( 3 );
+		stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+		stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << trcrec::CpuProcess << ",\"args\":{\"name\":\"CPU\"}}";
+		trcrec::writeMetadata( stream, "process_name", trcrec::GpuProcess, std::nullopt, "GPU" );
+		trcrec::writeMetadata( stream, "thread_name", trcrec::GpuProcess, 0u, "Queues" );
+
+		for ( uint32_t index = 0u; index < m_threads.size(); ++index )
+			trcrec::writeMetadata( stream, "thread_name", trcrec::CpuProcess, index, "Thread " + std::to_string( index ) );
+
+		// The groups enclose their passes, for each frame and track.
+		using GroupKey = std::tuple< bool, uint32_t, uint64_t, std::string >;
+		std::map< GroupKey, std::pair< double, double > > groups;
+
+		for ( auto const & event : m_events )
+		{
+			auto offset = event.gpu ? gpuOffset : 0.0;
+			auto begin = event.begin + offset;
+			auto end = event.end + offset;
+			trcrec::writeSpan( stream
+				, event.name
+				, event.category
+				, ( event.gpu ? trcrec::GpuProcess : trcrec::CpuProcess )
+				, event.thread
+				, event.frameId
+				, begin
+				, end );
+
+			for ( size_t pos = 0u; pos != std::string::npos && !event.path.empty(); )
+			{
+				pos = event.path.find( '/', pos + 1u );
+				auto [it, inserted] = groups.try_emplace( GroupKey{ event.gpu, event.thread, event.frameId, event.path.substr( 0u, pos ) }
+					, begin, end );
+
+				if ( !inserted )
+				{
+					it->second.first = std::min( it->second.first, begin );
+					it->second.second = std::max( it->second.second, end );
+				}
+			}
+		}
+
+		for ( auto const & [key, range] : groups )
+		{
+			auto const & [gpu, thread, frameId, path] = key;
+			auto pos = path.rfind( '/' );
+			trcrec::writeSpan( stream
+				, ( pos == std::string::npos ? path : path.substr( pos + 1u ) )
+				, "group"
+				, ( gpu ? trcrec::GpuProcess : trcrec::CpuProcess )
+				, thread
+				, frameId
+				, range.first
+				, range.second );
+		}
+
+		stream << "\n]}\n";
+		stream.flags( flags );
+		stream.fill( fill );
+	}
+
+	void TraceRecorder::clear()
+	{
+		std::lock_guard lock{ m_mutex };
+		m_events.clear();
+	}
+
+	uint32_t TraceRecorder::doGetThreadIndex()
+	{
+		auto id = std::this_thread::get_id();
+		auto it = std::find( m_threads.begin(), m_threads.end(), id );
+
+		if ( it == m_threads.end() )
+		{
+			m_threads.push_back( id );
+			it = std::prev( m_threads.end() );
+		}
+
+		return uint32_t( std::distance( m_threads.begin(), it ) );
+	}
+
+	//*********************************************************************************************
+
+	TraceScope::TraceScope( TraceRecorder * recorder
+		, std::string name
+		, std::string category )
+		: m_recorder{ recorder }
+		, m_name{ std::move( name ) }
+		, m_category{ std::move( category ) }
+		, m_begin{ Clock::now() }
+	{
+	}
+
+	TraceScope::~TraceScope()noexcept
+	{
+		try
+		{
+			if ( m_recorder )
+				m_recorder->addCpuEvent( std::move( m_name )
+					, std::move( m_category )
+					, std::string{}
+					, 0u
+					, m_begin
+					, Clock::now() );
+		}
+		catch ( ... )
+		{
+			// Nothing to do here
+		}
+	}
+
+	//*********************************************************************************************
+}
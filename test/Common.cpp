@@ -368,7 +368,8 @@ namespace test
 			, Properties
 			, false
 			, nullptr };
-		static std::atomic< uintptr_t > counter{};
+		// Starts at 1, for the device to be valid from the first call.
+		static std::atomic< uintptr_t > counter{ 1u };
 		context.device = VkDevice( counter.load() );
 		++counter;
 		context.vkCreateGraphicsPipelines = PFN_vkCreateGraphicsPipelines( []( VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo *, const VkAllocationCallbacks *, VkPipeline * pPipelines )
@@ -559,12 +560,21 @@ namespace test
 		context.vkQueueSubmit = PFN_vkQueueSubmit( []( VkQueue, uint32_t, const VkSubmitInfo *, VkFence ){ return VK_SUCCESS; } );
 		context.vkGetQueryPoolResults = PFN_vkGetQueryPoolResults( []( VkDevice, VkQueryPool, uint32_t, uint32_t, size_t, void *, VkDeviceSize, VkQueryResultFlags ){ return VK_SUCCESS; } );
 		context.vkResetCommandBuffer = PFN_vkResetCommandBuffer( []( VkCommandBuffer, VkCommandBufferResetFlags ){ return VK_SUCCESS; } );
+		context.vkResetCommandPool = PFN_vkResetCommandPool( []( VkDevice, VkCommandPool, VkCommandPoolResetFlags ){ return VK_SUCCESS; } );
 		context.vkResetEvent = PFN_vkResetEvent( []( VkDevice, VkEvent ){ return VK_SUCCESS; } );
 		context.vkSetEvent = PFN_vkSetEvent( []( VkDevice, VkEvent ){ return VK_SUCCESS; } );
 		context.vkGetEventStatus = PFN_vkGetEventStatus( []( VkDevice, VkEvent ){ return VK_SUCCESS; } );
 		context.vkGetFenceStatus = PFN_vkGetFenceStatus( []( VkDevice, VkFence ){ return VK_SUCCESS; } );
 		context.vkWaitForFences = PFN_vkWaitForFences( []( VkDevice, uint32_t, const VkFence *, VkBool32, uint64_t ){ return VK_SUCCESS; } );
 		context.vkResetFences = PFN_vkResetFences( []( VkDevice, uint32_t, const VkFence * ){ return VK_SUCCESS; } );
+#if VK_VERSION_1_2
+		context.vkWaitSemaphores = PFN_vkWaitSemaphores( []( VkDevice, const VkSemaphoreWaitInfo *, uint64_t ){ return VK_SUCCESS; } );
+		context.vkGetSemaphoreCounterValue = PFN_vkGetSemaphoreCounterValue( []( VkDevice, VkSemaphore, uint64_t * pValue )
+			{
+				*pValue = 0u;
+				return VK_SUCCESS;
+			} );
+#endif
 
 		context.vkCmdBindPipeline = PFN_vkCmdBindPipeline( []( VkCommandBuffer, VkPipelineBindPoint, VkPipeline ){} );
 		context.vkCmdBindDescriptorSets = PFN_vkCmdBindDescriptorSets( []( VkCommandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t, const VkDescriptorSet *, uint32_t, const uint32_t * ){} );
@@ -962,6 +972,54 @@ namespace test
 		// Nothing checked yet...
 	}
 
+	crg::RunnablePassCreator createDummyCreator( test::TestCounts & testCounts
+		, bool enabled
+		, crg::ru::Config config )
+	{
+		return [&testCounts, enabled, config]( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			if ( enabled )
+				return createDummy( testCounts
+					, framePass, context, runGraph, crg::PipelineStageFlags::eFragmentShader
+					, config );
+
+			return createDummy( testCounts
+				, framePass, context, runGraph, crg::PipelineStageFlags::eFragmentShader
+				, checkDummy, 0u, false, config );
+		};
+	}
+
+	crg::RunnablePassCreator createDummyCreator( test::TestCounts & testCounts
+		, uint32_t & created )
+	{
+		return [&testCounts, &created]( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			++created;
+			return createDummy( testCounts
+				, framePass, context, runGraph, crg::PipelineStageFlags::eFragmentShader );
+		};
+	}
+
+	crg::RunnablePassCreator createDummyCreator( test::TestCounts & testCounts
+		, crg::RunnablePass *& created
+		, crg::ru::Config config )
+	{
+		return [&testCounts, &created, config]( crg::FramePass const & framePass
+			, crg::GraphContext & context
+			, crg::RunnableGraph & runGraph )
+		{
+			auto result = createDummy( testCounts
+				, framePass, context, runGraph, crg::PipelineStageFlags::eFragmentShader
+				, config );
+			created = result.get();
+			return result;
+		};
+	}
+
 	template< typename EnumT >
 	static void condAppendEnumFlag( std::ostream & stream, std::string & sep, EnumT const & v, EnumT const & t, std::string_view s )
 	{
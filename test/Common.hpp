@@ -1,11 +1,13 @@
 #pragma once
 
 #include <RenderGraph/FrameGraphPrerequisites.hpp>
+#include <RenderGraph/FramePass.hpp>
 #include <RenderGraph/RunnablePass.hpp>
 
 #include "BaseTest.hpp"
 
 #include <sstream>
+#include <utility>
 
 namespace test
 {
@@ -120,6 +122,57 @@ namespace test
 		, crg::RunnableGraph const & graph
 		, crg::RecordContext const & context
 		, uint32_t index );
+	/**
+	*\return
+	*	A creator of dummy fragment shader passes, disabled ones if \p enabled is \p false.
+	*/
+	crg::RunnablePassCreator createDummyCreator( test::TestCounts & testCounts
+		, bool enabled = true
+		, crg::ru::Config config = {} );
+	/**
+	*\return
+	*	A creator of dummy fragment shader passes, counting the created ones in \p created.
+	*/
+	crg::RunnablePassCreator createDummyCreator( test::TestCounts & testCounts
+		, uint32_t & created );
+	/**
+	*\return
+	*	A creator of dummy fragment shader passes, \p created receiving the last created one.
+	*/
+	crg::RunnablePassCreator createDummyCreator( test::TestCounts & testCounts
+		, crg::RunnablePass *& created
+		, crg::ru::Config config = {} );
+	/**
+	*\brief
+	*	Replaces a value, of the test context usually, until the end of the scope.
+	*\remarks
+	*	The context is shared by the tests, a failed check must not leave it patched.
+	*/
+	template< typename ValueT >
+	class ScopedOverride
+	{
+	public:
+		ScopedOverride( ValueT & target
+			, ValueT value )
+			: m_target{ target }
+			, m_saved{ std::exchange( target, std::move( value ) ) }
+		{
+		}
+
+		ScopedOverride( ScopedOverride const & ) = delete;
+		ScopedOverride & operator=( ScopedOverride const & ) = delete;
+		ScopedOverride( ScopedOverride && ) = delete;
+		ScopedOverride & operator=( ScopedOverride && ) = delete;
+
+		~ScopedOverride()noexcept
+		{
+			m_target = std::move( m_saved );
+		}
+
+	private:
+		ValueT & m_target;
+		ValueT m_saved;
+	};
 }
 
 namespace crg
@@ -1,14 +1,20 @@
 #include "Common.hpp"
 
+#include <RenderGraph/CopyOnWriteMap.hpp>
 #include <RenderGraph/FrameGraph.hpp>
 #include <RenderGraph/FramePassTimer.hpp>
+#include <RenderGraph/IdSlotMap.hpp>
 #include <RenderGraph/ImageData.hpp>
+#include <RenderGraph/LayerLayoutStates.hpp>
+#include <RenderGraph/MemoryAllocator.hpp>
+#include <RenderGraph/MemoryTracker.hpp>
 #include <RenderGraph/Log.hpp>
 #include <RenderGraph/ResourceHandler.hpp>
 #include <RenderGraph/RunnableGraph.hpp>
 #include <RenderGraph/RunnablePass.hpp>
 #include <RenderGraph/RunnablePasses/GenerateMipmaps.hpp>
 #include <RenderGraph/RunnablePasses/RenderMeshConfig.hpp>
+#include <RenderGraph/TraceRecorder.hpp>
 
 #include <sstream>
 #include <thread>
@@ -347,6 +353,556 @@ TEST( Bases, FramePassTimer )
 	testEnd()
 }
 
+TEST( Bases, TimerHistory )
+{
+	testBegin( "testTimerHistory" )
+	{
+		crg::TimerHistory history{ 100u, crg::Nanoseconds{ 50u } };
+
+		for ( int64_t sample = 1; sample <= 100; ++sample )
+			history.push( crg::Nanoseconds{ sample } );
+
+		auto stats = history.getStatistics();
+		checkEqual( stats.count, 100u )
+		checkEqual( stats.min, crg::Nanoseconds{ 1u } )
+		checkEqual( stats.max, crg::Nanoseconds{ 100u } )
+		checkEqual( stats.mean, crg::Nanoseconds{ 50u } )
+		checkEqual( stats.p50, crg::Nanoseconds{ 50u } )
+		checkEqual( stats.p95, crg::Nanoseconds{ 95u } )
+		checkEqual( stats.p99, crg::Nanoseconds{ 99u } )
+		checkEqual( stats.hitches, 50u )
+
+		// The oldest sample is replaced.
+		check( history.push( crg::Nanoseconds{ 200u } ) )
+		stats = history.getStatistics();
+		checkEqual( stats.count, 100u )
+		checkEqual( stats.min, crg::Nanoseconds{ 2u } )
+		checkEqual( stats.max, crg::Nanoseconds{ 200u } )
+		checkEqual( stats.hitches, 51u )
+
+		history.clear();
+		stats = history.getStatistics();
+		checkEqual( stats.count, 0u )
+		checkEqual( stats.hitches, 0u )
+	}
+	{
+		// Without samples storage, the hitches are still counted.
+		crg::TimerHistory history{ 0u, crg::Nanoseconds{ 10u } };
+		check( !history.isEnabled() )
+		check( !history.push( crg::Nanoseconds{ 5u } ) )
+		check( history.push( crg::Nanoseconds{ 15u } ) )
+		checkEqual( history.getStatistics().count, 0u )
+		checkEqual( history.getHitchCount(), 1u )
+	}
+	{
+		auto & context = getContext();
+		test::ScopedOverride timerHistorySize{ context.timerHistorySize, 8u };
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		crg::RunnablePass * runPass{};
+		auto buffer = graph.createBuffer( test::createBuffer( "buffer" ) );
+		auto bufferv = graph.createView( test::createView( "bufferv", buffer ) );
+		auto & testPass = graph.createPass( "Mesh"
+			, [&testCounts, &runPass]( crg::FramePass const & framePass
+				, crg::GraphContext & ctx
+				, crg::RunnableGraph & runGraph )
+			{
+				auto res = createDummy( testCounts
+					, framePass, ctx, runGraph, crg::PipelineStageFlags::eFragmentShader );
+				runPass = res.get();
+				return res;
+			} );
+		testPass.addClearableOutputStorageBuffer( bufferv, 1u );
+		auto runnable = graph.compile( context );
+		crg::FramePassTimer update{ context, "update", crg::TimerScope::eUpdate };
+		update.setScopeHistories( &runnable->getCpuHistory( crg::TimerScope::eUpdate )
+			, &runnable->getGpuHistory( crg::TimerScope::eUpdate ) );
+
+		for ( uint32_t frame = 0u; frame < 3u; ++frame )
+		{
+			runnable->run( VkQueue{} );
+			runPass->getTimer().retrieveGpuTime();
+			update.retrieveGpuTime();
+		}
+
+		// Each timer keeps its samples, and forwards them to its scope breakdown.
+		checkEqual( runPass->getTimer().getCpuHistory().getStatistics().count, 3u )
+		checkEqual( runPass->getTimer().getGpuHistory().getStatistics().count, 3u )
+		checkEqual( update.getCpuHistory().getStatistics().count, 3u )
+		checkEqual( update.getGpuHistory().getStatistics().count, 0u )
+		checkEqual( runnable->getCpuHistory( crg::TimerScope::ePass ).getStatistics().count, 3u )
+		checkEqual( runnable->getGpuHistory( crg::TimerScope::ePass ).getStatistics().count, 3u )
+		checkEqual( runnable->getCpuHistory( crg::TimerScope::eUpdate ).getStatistics().count, 3u )
+		checkEqual( runnable->getCpuHistory( crg::TimerScope::eGraph ).getStatistics().count, 0u )
+	}
+	testEnd()
+}
+
+TEST( Bases, TraceRecorder )
+{
+	testBegin( "testTraceRecorder" )
+	{
+		crg::TraceRecorder recorder;
+		auto & context = getContext();
+		test::ScopedOverride traceRecorder{ context.traceRecorder, &recorder };
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		crg::RunnablePass * runPass{};
+		auto buffer = graph.createBuffer( test::createBuffer( "buffer" ) );
+		auto bufferv = graph.createView( test::createView( "bufferv", buffer ) );
+		auto & testPass = graph.createPassGroup( "Outer" ).createPassGroup( "Inner" ).createPass( "Mesh"
+			, [&testCounts, &runPass]( crg::FramePass const & framePass
+				, crg::GraphContext & ctx
+				, crg::RunnableGraph & runGraph )
+			{
+				auto res = createDummy( testCounts
+					, framePass, ctx, runGraph, crg::PipelineStageFlags::eFragmentShader );
+				runPass = res.get();
+				return res;
+			} );
+		testPass.addClearableOutputStorageBuffer( bufferv, 1u );
+		auto runnable = graph.compile( context );
+		runnable->run( VkQueue{} );
+		runPass->getTimer().retrieveGpuTime();
+
+		std::stringstream stream;
+		recorder.write( stream );
+		auto trace = stream.str();
+		// Compile phases, CPU record spans, GPU spans, and the groups enclosing the passes.
+		check( trace.find( "\"name\":\"testTraceRecorder - Build graph\",\"cat\":\"compile\"" ) != std::string::npos )
+		check( trace.find( "\"name\":\"Inner/Mesh\",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":1" ) != std::string::npos )
+		check( trace.find( "\"name\":\"Inner/Mesh\",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":2" ) != std::string::npos )
+		check( trace.find( "\"name\":\"Outer\",\"cat\":\"group\",\"ph\":\"X\",\"pid\":2" ) != std::string::npos )
+		check( trace.find( "\"name\":\"Inner\",\"cat\":\"group\",\"ph\":\"X\",\"pid\":1" ) != std::string::npos )
+		check( trace.find( "\"name\":\"testTraceRecorder\",\"cat\":\"group\"" ) != std::string::npos )
+		check( trace.find( "\"args\":{\"frame\":1}" ) != std::string::npos )
+		recorder.clear();
+		checkEqual( recorder.getEventCount(), 0u )
+	}
+	{
+		// Once calibrated, a GPU timestamp taken at a CPU time is written at that time.
+		crg::TraceRecorder recorder;
+		auto now = crg::Clock::now();
+		recorder.addCpuEvent( "cpu", "test", std::string{}, 0u, now, now + std::chrono::microseconds{ 2u } );
+		recorder.addGpuEvent( "gpu", "test", std::string{}, 0u, 500u, 1500u, 2.0f );
+		recorder.setCalibration( 500u, 2.0f, now );
+		auto getSpan = []( std::string const & trace, std::string const & name )
+		{
+			auto begin = trace.find( "\"name\":\"" + name + "\"" );
+			begin = trace.find( "\"ts\":", begin );
+			return trace.substr( begin, trace.find( ",\"args\"", begin ) - begin );
+		};
+		std::stringstream stream;
+		recorder.write( stream );
+		checkEqual( getSpan( stream.str(), "cpu" ), getSpan( stream.str(), "gpu" ) )
+	}
+	testEnd()
+}
+
+TEST( Bases, LayerLayoutStates )
+{
+	testBegin( "testLayerLayoutStates" )
+	auto makeRange = []( uint32_t baseLayer, uint32_t layerCount, uint32_t baseLevel, uint32_t levelCount )
+	{
+		return crg::ImageSubresourceRange{ crg::ImageAspectFlags::eColor, baseLevel, levelCount, baseLayer, layerCount };
+	};
+	auto sampled = crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly );
+	auto target = crg::makeLayoutState( crg::ImageLayout::eColorAttachment );
+	// A shadow atlas, set as a whole, then layer by layer.
+	crg::LayerLayoutStates atlas;
+	check( atlas.empty() )
+	checkEqual( atlas.getLayoutState( makeRange( 0u, 1u, 0u, 1u ) ).layout, crg::ImageLayout::eUndefined )
+	atlas.setLayoutState( makeRange( 0u, 2048u, 0u, 12u ), sampled );
+	check( atlas.isUniform() )
+	checkEqual( atlas.getLayerCount(), 2048u )
+	checkEqual( atlas.getLevelCount(), 12u )
+	check( atlas.getLayoutState( makeRange( 0u, 2048u, 0u, 12u ) ) == sampled )
+	atlas.setLayoutState( makeRange( 5u, 1u, 0u, 12u ), sampled );
+	check( atlas.isUniform() )
+	atlas.setLayoutState( makeRange( 5u, 1u, 0u, 12u ), target );
+	check( !atlas.isUniform() )
+	check( atlas.getLayoutState( makeRange( 5u, 1u, 3u, 1u ) ) == target )
+	check( atlas.getLayoutState( makeRange( 6u, 10u, 0u, 12u ) ) == sampled )
+	// The lowest layout wins when the range mixes them.
+	checkEqual( atlas.getLayoutState( makeRange( 0u, 2048u, 0u, 12u ) ).layout
+		, std::min( sampled.layout, target.layout ) )
+	// Back to a single state, the storage is uniform again.
+	atlas.setLayoutState( makeRange( 5u, 1u, 0u, 12u ), sampled );
+	check( atlas.isUniform() )
+	check( atlas.find( 2047u, 11u ) != nullptr )
+	check( atlas.find( 2048u, 0u ) == nullptr )
+
+	// Partially set images only have states for the set subresources.
+	crg::LayerLayoutStates partial;
+	partial.setLayoutState( makeRange( 2u, 2u, 1u, 1u ), target );
+	check( !partial.isUniform() )
+	check( partial.find( 0u, 0u ) == nullptr )
+	check( partial.find( 3u, 1u ) != nullptr )
+	checkEqual( partial.getLayoutState( makeRange( 0u, 2u, 0u, 2u ) ).layout, crg::ImageLayout::eUndefined )
+	check( partial.getLayoutState( makeRange( 0u, 4u, 0u, 2u ) ) == target )
+	std::vector< std::pair< uint32_t, uint32_t > > subresources;
+	partial.forEach( [&subresources]( uint32_t layer, uint32_t level, crg::LayoutState const & )
+		{
+			subresources.emplace_back( layer, level );
+		} );
+	check( ( subresources == std::vector< std::pair< uint32_t, uint32_t > >{ { 2u, 1u }, { 3u, 1u } } ) )
+	// The layer/mip maps are still available.
+	auto layers = partial.getLayerMipLayoutStates();
+	checkEqual( layers.size(), 2u )
+	checkEqual( layers[2u].size(), 1u )
+	check( layers[3u].begin()->first == 1u )
+	checkEqual( partial.getMipLayoutStates( 3u ).size(), 1u )
+	check( partial.getMipLayoutStates( 0u ).empty() )
+	// As is the map interface.
+	checkEqual( partial.size(), 2u )
+	std::vector< uint32_t > layerIndices;
+
+	for ( auto & [layer, levels] : partial )
+	{
+		layerIndices.push_back( layer );
+		check( levels.begin()->second == target )
+	}
+
+	check( ( layerIndices == std::vector< uint32_t >{ 2u, 3u } ) )
+	check( partial.find( 1u ) == partial.end() )
+	require( partial.find( 3u ) != partial.end() )
+	checkEqual( partial.find( 3u )->second.begin()->first, 1u )
+	check( !partial.emplace( 3u, { { 0u, sampled } } ).second )
+	check( partial.find( 3u, 0u ) == nullptr )
+	auto [emplaced, inserted] = partial.emplace( 0u, { { 0u, sampled }, { 1u, target } } );
+	check( inserted )
+	checkEqual( emplaced->first, 0u )
+	checkEqual( emplaced->second.size(), 2u )
+	check( *partial.find( 0u, 0u ) == sampled )
+	checkEqual( partial.size(), 3u )
+	check( std::next( partial.begin() ) == partial.find( 2u ) )
+
+	// Equality doesn't depend on the storage.
+	crg::LayerLayoutStates lhs;
+	crg::LayerLayoutStates rhs;
+	lhs.setLayoutState( makeRange( 0u, 4u, 0u, 2u ), sampled );
+	rhs.setLayoutState( makeRange( 0u, 2u, 0u, 2u ), sampled );
+	check( lhs != rhs )
+	rhs.setLayoutState( makeRange( 2u, 2u, 0u, 2u ), sampled );
+	check( rhs.isUniform() )
+	check( lhs == rhs )
+	rhs.setLayoutState( makeRange( 3u, 1u, 1u, 1u ), target );
+	check( lhs != rhs )
+	testEnd()
+}
+
+TEST( Bases, CopyOnWriteStates )
+{
+	testBegin( "testCopyOnWriteStates" )
+	{
+		crg::CopyOnWriteMapT< crg::AccessState > map;
+		map.edit( 1u ) = { crg::AccessFlags::eShaderRead, crg::PipelineStageFlags::eFragmentShader };
+		map.edit( 2u ) = { crg::AccessFlags::eShaderWrite, crg::PipelineStageFlags::eComputeShader };
+		auto snapshot = map;
+		check( snapshot == map )
+		check( snapshot.find( 1u ) == map.find( 1u ) )
+		// Only the written state is duplicated.
+		map.edit( 1u ) = { crg::AccessFlags::eTransferWrite, crg::PipelineStageFlags::eTransfer };
+		check( snapshot.find( 1u ) != map.find( 1u ) )
+		check( snapshot.find( 2u ) == map.find( 2u ) )
+		check( snapshot.find( 1u )->access == crg::AccessFlags::eShaderRead )
+		check( !( snapshot == map ) )
+		crg::CopyOnWriteMapT< crg::AccessState > other;
+		other.edit( 3u ) = {};
+		other.addMissing( snapshot );
+		checkEqual( other.size(), 3u )
+		check( other.find( 2u ) == snapshot.find( 2u ) )
+	}
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto image = graph.createImage( test::createImage( "image", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto view = graph.createView( test::createView( "view", image ) );
+		auto buffer = graph.createBuffer( test::createBuffer( "buffer" ) );
+		auto bufferv = graph.createView( test::createView( "bufferv", buffer ) );
+		crg::RecordContext context{ handler };
+		context.setLayoutState( view, crg::makeLayoutState( crg::ImageLayout::eColorAttachment ) );
+		context.setAccessState( bufferv, { crg::AccessFlags::eShaderWrite, crg::PipelineStageFlags::eComputeShader } );
+		auto snapshot = context;
+		check( snapshot.hasSameStates( context ) )
+		context.setLayoutState( view, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+		checkEqual( snapshot.getLayoutState( view ).layout, crg::ImageLayout::eColorAttachment )
+		checkEqual( context.getLayoutState( view ).layout, crg::ImageLayout::eShaderReadOnly )
+		check( !snapshot.hasSameStates( context ) )
+		context.setLayoutState( view, crg::makeLayoutState( crg::ImageLayout::eColorAttachment ) );
+		check( snapshot.hasSameStates( context ) )
+		context.setAccessState( bufferv, { crg::AccessFlags::eShaderRead, crg::PipelineStageFlags::eFragmentShader } );
+		check( snapshot.getAccessState( bufferv ).access == crg::AccessFlags::eShaderWrite )
+	}
+	testEnd()
+}
+
+TEST( Bases, IdSlotMap )
+{
+	testBegin( "testIdSlotMap" )
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	auto image1 = graph.createImage( test::createImage( "image1", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto image2 = graph.createImage( test::createImage( "image2", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto image3 = graph.createImage( test::createImage( "image3", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	crg::IdSlotMapT< crg::ImageData, uint32_t > map;
+	check( map.empty() )
+	check( map.tryEmplace( image3, 3u ).second )
+	check( map.tryEmplace( image1, 1u ).second )
+	check( !map.tryEmplace( image1, 4u ).second )
+	checkEqual( *map.find( image1 ), 1u )
+	check( map.find( image2 ) == nullptr )
+	checkEqual( map.size(), 2u )
+	// An id with the same index but another data is not found.
+	crg::ImageData other{ *image1.data };
+	crg::ImageId otherId{ image1.id, &other };
+	check( map.find( otherId ) == nullptr )
+	// Nor can it be added, it would replace the other id value.
+	checkThrow( map.tryEmplace( otherId, 4u ), crg::Exception )
+	checkThrow( map[otherId], crg::Exception )
+	checkEqual( *map.find( image1 ), 1u )
+	checkEqual( map.size(), 2u )
+	map[image2] = 2u;
+	std::vector< uint32_t > values;
+	map.forEach( [&values]( crg::ImageId const & id, uint32_t value )
+		{
+			values.push_back( id.id );
+			values.push_back( value );
+		} );
+	check( ( values == std::vector< uint32_t >{ image1.id, 1u, image2.id, 2u, image3.id, 3u } ) )
+	check( map.erase( image3 ) )
+	check( !map.erase( image3 ) )
+	check( map.find( image3 ) == nullptr )
+	checkEqual( map.size(), 2u )
+	check( map.tryEmplace( image3, 5u ).second )
+	checkEqual( *map.find( image3 ), 5u )
+	testEnd()
+}
+
+TEST( Bases, ViewIdsDeduplication )
+{
+	testBegin( "testViewIdsDeduplication" )
+	crg::ResourceHandler handler;
+	auto constexpr count = 100000u;
+	auto image = handler.createImageId( test::createImage( "image", crg::PixelFormat::eR32G32B32A32_SFLOAT, 1u, count ) );
+	auto buffer = handler.createBufferId( test::createBuffer( "buffer" ) );
+	std::vector< crg::ImageViewId > imageViews;
+	std::vector< crg::BufferViewId > bufferViews;
+
+	for ( uint32_t i = 0u; i < count; ++i )
+	{
+		imageViews.push_back( handler.createViewId( test::createView( "view" + std::to_string( i ), image, 0u, 1u, i, 1u ) ) );
+		bufferViews.push_back( handler.createViewId( test::createView( "view" + std::to_string( i ), buffer, i, 1u ) ) );
+	}
+
+	// The ids are distinct, and registering the same data again gives them back, whatever the name and sources.
+	bool allSame = true;
+
+	for ( uint32_t i = 0u; i < count; ++i )
+	{
+		auto imageData = test::createView( "other", image, 0u, 1u, i, 1u );
+		imageData.source.push_back( imageViews.front() );
+		auto bufferData = test::createView( "other", buffer, i, 1u );
+		allSame = allSame
+			&& imageViews[i].id == i + 1u
+			&& bufferViews[i].id == i + 1u
+			&& handler.createViewId( imageData ) == imageViews[i]
+			&& handler.createViewId( bufferData ) == bufferViews[i];
+	}
+
+	check( allSame )
+	check( handler.createViewId( test::createView( "view", image, crg::PixelFormat::eR16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) ).id == count + 1u )
+	check( handler.createViewId( test::createView( "view", buffer, 0u, 2u ) ).id == count + 1u )
+	testEnd()
+}
+
+TEST( Bases, MemoryAllocator )
+{
+	testBegin( "testMemoryAllocator" )
+	auto & context = getContext();
+	{
+		crg::BlockMemoryAllocator allocator{ 4096u, 256u };
+		auto a = allocator.allocate( context, { 1000u, 4u, 1u }, 0u, crg::MemoryResourceKind::eLinear, "a" );
+		auto b = allocator.allocate( context, { 200u, 512u, 1u }, 0u, crg::MemoryResourceKind::eLinear, "b" );
+		auto c = allocator.allocate( context, { 100u, 4u, 1u }, 0u, crg::MemoryResourceKind::eOptimal, "c" );
+		auto d = allocator.allocate( context, { 3000u, 4u, 1u }, 0u, crg::MemoryResourceKind::eLinear, "d" );
+		auto e = allocator.allocate( context, { 100u, 4u, 1u }, 1u, crg::MemoryResourceKind::eLinear, "e" );
+		check( !a.dedicated && !b.dedicated && !c.dedicated && !e.dedicated )
+		check( a.memory == b.memory )
+		checkEqual( a.offset, 0u )
+		checkEqual( a.size, 1024u )
+		checkEqual( b.offset, 1024u )
+		checkEqual( b.size, 512u )
+		// Linear and optimal resources don't share a block.
+		check( c.memory != a.memory )
+		// Too large for a block.
+		check( d.dedicated )
+		checkEqual( d.size, 3000u )
+		// Host visible resources are sub-allocated too, the block is mapped once for all of them.
+		{
+			static uint32_t maps{};
+			static uint32_t unmaps{};
+			static std::array< uint8_t, 4096u > mapped{};
+			test::ScopedOverride vkMapMemory{ context.vkMapMemory, PFN_vkMapMemory( []( VkDevice, VkDeviceMemory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void ** ppData )
+				{
+					++maps;
+					*ppData = mapped.data() + offset;
+					return VK_SUCCESS;
+				} ) };
+			test::ScopedOverride vkUnmapMemory{ context.vkUnmapMemory, PFN_vkUnmapMemory( []( VkDevice, VkDeviceMemory )
+				{
+					++unmaps;
+				} ) };
+			auto h = allocator.allocate( context, { 100u, 4u, 1u }, 1u, crg::MemoryResourceKind::eLinear, "h" );
+			check( h.memory == e.memory )
+			auto eData = static_cast< uint8_t * >( allocator.map( context, e ) );
+			auto hData = static_cast< uint8_t * >( allocator.map( context, h ) );
+			checkEqual( maps, 1u )
+			check( eData == mapped.data() + e.offset )
+			check( hData == mapped.data() + h.offset )
+			allocator.unmap( context, e );
+			checkEqual( unmaps, 0u )
+			allocator.unmap( context, h );
+			checkEqual( unmaps, 1u )
+			// Dedicated allocations are mapped on their own.
+			check( allocator.map( context, d ) == mapped.data() )
+			allocator.unmap( context, d );
+			checkEqual( maps, 2u )
+			checkEqual( unmaps, 2u )
+			allocator.free( context, h );
+		}
+		auto stats = allocator.getStats();
+		checkEqual( stats.deviceAllocations, 4u )
+		checkEqual( stats.blocks, 3u )
+		checkEqual( stats.dedicatedAllocations, 1u )
+		checkEqual( stats.subAllocations, 4u )
+		checkEqual( stats.blocksSize, 12288u )
+		checkEqual( stats.subAllocatedSize, 2048u )
+		checkEqual( stats.dedicatedSize, 3000u )
+		allocator.free( context, a );
+		auto f = allocator.allocate( context, { 2048u, 4u, 1u }, 0u, crg::MemoryResourceKind::eLinear, "f" );
+		check( f.memory == b.memory )
+		checkEqual( f.offset, 2048u )
+		// The freed node is reused.
+		auto g = allocator.allocate( context, { 1024u, 1024u, 1u }, 0u, crg::MemoryResourceKind::eLinear, "g" );
+		check( g.memory == b.memory )
+		checkEqual( g.offset, 0u )
+		allocator.free( context, b );
+		allocator.free( context, f );
+		allocator.free( context, g );
+		checkEqual( allocator.getStats().blocks, 2u )
+		allocator.free( context, c );
+		allocator.free( context, d );
+		allocator.free( context, e );
+		stats = allocator.getStats();
+		checkEqual( stats.deviceAllocations, 0u )
+		checkEqual( stats.subAllocatedSize, 0u )
+		checkEqual( stats.dedicatedSize, 0u )
+	}
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto buffer1 = graph.createBuffer( test::createBuffer( "buffer1" ) );
+		auto buffer2 = graph.createBuffer( test::createBuffer( "buffer2" ) );
+		auto image = graph.createImage( test::createImage( "image", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		{
+			crg::ResourcesCache cache{ handler };
+			crg::MemoryAllocation memory1{};
+			crg::MemoryAllocation memory2{};
+			cache.createBuffer( context, buffer1, memory1 );
+			cache.createBuffer( context, buffer2, memory2 );
+			cache.createImage( context, image );
+			// Both buffers share the block, at different offsets.
+			check( memory1.memory == memory2.memory )
+			check( memory1.offset != memory2.offset )
+			check( memory2.offset >= memory1.offset + memory1.size || memory1.offset >= memory2.offset + memory2.size )
+			auto stats = handler.getMemoryAllocator().getStats();
+			checkEqual( stats.blocks, 1u )
+			checkEqual( stats.subAllocations, 2u )
+			checkEqual( stats.dedicatedAllocations, 1u )
+		}
+		checkEqual( handler.getMemoryAllocator().getStats().deviceAllocations, 0u )
+	}
+	testEnd()
+}
+
+TEST( Bases, MemoryTracker )
+{
+	testBegin( "testMemoryTracker" )
+	auto & context = getContext();
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	auto buffer1 = graph.createBuffer( test::createBuffer( "buffer1" ) );
+	auto buffer2 = graph.createBuffer( test::createBuffer( "buffer2" ) );
+	auto image = graph.createImage( test::createImage( "image", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto & tracker = handler.getMemoryTracker();
+	std::vector< crg::MemoryBudgetEvent > events;
+	tracker.setBudgetCallback( [&events]( crg::MemoryBudgetEvent const & event )
+		{
+			events.push_back( event );
+		} );
+	{
+		crg::ContextResourcesCache cache{ handler, context, "graphA" };
+		cache.createBuffer( buffer1 );
+		cache.createImage( image );
+		handler.createBuffer( context, buffer2 );
+		auto report = tracker.getReport();
+		checkEqual( report.total.live, 64u * 1024u * 1024u + 2048u )
+		checkEqual( report.total.allocations, 3u )
+		checkEqual( report.heaps.size(), 1u )
+		checkEqual( report.types[0].allocations, 3u )
+		checkEqual( report.graphs.size(), 2u )
+		checkEqual( report.graphs["graphA"].live, 64u * 1024u * 1024u + 1024u )
+		checkEqual( report.graphs[""].live, 1024u )
+		checkEqual( report.resources.size(), 3u )
+		checkEqual( report.resources[0].name, "image" )
+		checkEqual( report.resources[0].graph, "graphA" )
+		report = tracker.getReport( "graphA" );
+		checkEqual( report.total.allocations, 2u )
+		checkEqual( report.resources.size(), 2u )
+		std::stringstream stream;
+		report.writeJson( stream );
+		check( stream.str().find( "\"name\":\"buffer1\"" ) != std::string::npos )
+		check( stream.str().find( "\"graphA\":{\"live\":" ) != std::string::npos )
+		// The heaps are large enough.
+		check( events.empty() )
+		handler.destroyBuffer( context, buffer2 );
+	}
+	auto report = tracker.getReport( "graphA" );
+	checkEqual( report.total.live, 0u )
+	checkEqual( report.total.peak, 64u * 1024u * 1024u + 1024u )
+	checkEqual( report.total.allocations, 0u )
+	check( report.resources.empty() )
+#if VK_EXT_memory_budget
+	{
+		test::ScopedOverride physicalDevice{ context.physicalDevice, reinterpret_cast< VkPhysicalDevice >( &context ) };
+		test::ScopedOverride getProperties{ context.vkGetPhysicalDeviceMemoryProperties2, PFN_vkGetPhysicalDeviceMemoryProperties2( []( VkPhysicalDevice, VkPhysicalDeviceMemoryProperties2 * properties )
+			{
+				auto budget = static_cast< VkPhysicalDeviceMemoryBudgetPropertiesEXT * >( properties->pNext );
+				budget->heapUsage[0] = 1024u;
+				budget->heapBudget[0] = 1536u;
+			} ) };
+		crg::ContextResourcesCache cache{ handler, context, "graphB" };
+		cache.createBuffer( buffer1 );
+		checkEqual( events.size(), 1u )
+		checkEqual( events[0].name, "buffer1" )
+		checkEqual( events[0].heap, 0u )
+		checkEqual( events[0].memoryType, 0u )
+		checkEqual( events[0].usage, 1024u )
+		checkEqual( events[0].budget, 1536u )
+		// The budget is checked against the allocated device memory, here a whole block.
+		checkEqual( events[0].size, crg::BlockMemoryAllocator::DefaultBlockSize )
+		// The next buffer lies in the same block, no device memory is allocated.
+		cache.createBuffer( buffer2 );
+		checkEqual( events.size(), 1u )
+		// The allocation still happens, the callback is only a notification.
+		checkEqual( tracker.getReport( "graphB" ).total.allocations, 2u )
+	}
+#endif
+	checkEqual( tracker.getReport().total.live, 0u )
+	testEnd()
+}
+
 TEST( Bases, ImplicitActions )
 {
 	testBegin( "testImplicitActions" )
@@ -5,8 +5,14 @@
 #include <RenderGraph/ResourceHandler.hpp>
 #include <RenderGraph/RunnableGraph.hpp>
 #include <RenderGraph/RunnablePass.hpp>
+#include <RenderGraph/RunnablePasses/ComputePass.hpp>
 #include <RenderGraph/RunnablePasses/GenerateMipmaps.hpp>
+#include <RenderGraph/RunnablePasses/RenderPass.hpp>
 
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
 #include <sstream>
 
 namespace
@@ -50,6 +56,28 @@ namespace
 		}
 	}
 
+	crg::AttachmentPtr buildMipChain( test::TestCounts & testCounts
+		, crg::FrameGraph & graph
+		, uint32_t mipLevels )
+	{
+		auto lp = graph.createImage( test::createImage( "lp", crg::PixelFormat::eR32G32B32_SFLOAT, mipLevels ) );
+		auto result = std::make_unique< crg::Attachment >( crg::Attachment::createDefault( graph.createView( test::createView( "m0v", lp, crg::PixelFormat::eR32G32B32_SFLOAT, 0u ) ) ) );
+		crg::Attachment const * previous = result.get();
+
+		for ( uint32_t level = 1u; level < mipLevels; ++level )
+		{
+			auto strLevel = std::to_string( level );
+			auto view = graph.createView( test::createView( "m" + strLevel + "v", lp, crg::PixelFormat::eR32G32B32_SFLOAT, level ) );
+			auto & pass = graph.createPass( "minifyPass" + strLevel
+				, test::createDummyCreator( testCounts ) );
+			pass.addInputSampled( *previous, 0 );
+			previous = pass.addOutputColourTarget( view );
+		}
+
+		// The first pass references the source attachment, the caller keeps it alive.
+		return result;
+	}
+
 	crg::FrameGraph buildNoPassGraph( test::TestCounts const & testCounts
 		, crg::ResourceHandler & handler )
 	{
@@ -2101,10 +2129,10 @@ TEST( RenderGraph, VarianceShadowMap )
 
 	crg::ResourcesCache cache{ handler };
 	auto & context = getContext();
-	VkDeviceMemory bufferMemory;
+	crg::MemoryAllocation bufferMemory;
 	cache.createBuffer( context, buffer, bufferMemory );
 	cache.createBufferView( context, bufferv );
-	VkDeviceMemory imageMemory;
+	crg::MemoryAllocation imageMemory;
 	cache.createImage( context, depth, imageMemory );
 	cache.createImageView( context, depthv );
 
@@ -2287,4 +2315,1484 @@ TEST( RenderGraph, DisabledPasses )
 	testEnd()
 }
 
+TEST( RenderGraph, LongPassChain )
+{
+	testBegin( "testLongPassChain" )
+	constexpr uint32_t passCount = 4096u;
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	crg::Attachment const * previous{};
+
+	for ( auto index = 0u; index < passCount; ++index )
+	{
+		auto strIndex = std::to_string( index );
+		auto rt = graph.createImage( test::createImage( "rt" + strIndex, crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto rtv = graph.createView( test::createView( "rtv" + strIndex, rt ) );
+		auto & pass = graph.createPass( "pass" + strIndex
+			, test::createDummyCreator( testCounts ) );
+
+		if ( previous )
+			pass.addInputSampled( *previous, 0u );
+
+		previous = pass.addOutputColourTarget( rtv );
+	}
+
+	auto runnable = graph.compile( getContext() );
+	auto node = runnable->getNodeGraph();
+	auto index = passCount;
+
+	while ( !node->getPredecessors().empty() )
+	{
+		require( node->getPredecessors().size() == 1u )
+		node = node->getPredecessors().front();
+		checkEqual( node->getName(), testCounts.testName + "/pass" + std::to_string( --index ) )
+	}
+
+	checkEqual( index, 0u )
+	testEnd()
+}
+
+TEST( RenderGraph, Recompile )
+{
+	testBegin( "testRecompile" )
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	uint32_t created{};
+	auto creator = test::createDummyCreator( testCounts, created );
+	auto rt1 = graph.createImage( test::createImage( "rt1", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv1 = graph.createView( test::createView( "rtv1", rt1 ) );
+	auto & pass1 = graph.createPass( "pass1", creator );
+	auto rt1Attach = pass1.addOutputColourTarget( rtv1 );
+
+	auto rt2 = graph.createImage( test::createImage( "rt2", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv2 = graph.createView( test::createView( "rtv2", rt2 ) );
+	auto & pass2 = graph.createPass( "pass2", creator );
+	pass2.addInputSampled( *rt1Attach, 0u );
+	auto rt2Attach = pass2.addOutputColourTarget( rtv2 );
+
+	auto runnable = graph.compile( getContext() );
+	checkEqual( created, 2u )
+	checkNoThrow( runnable->record() )
+
+	auto dbg = graph.createImage( test::createImage( "dbg", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto dbgv = graph.createView( test::createView( "dbgv", dbg ) );
+	auto & debugPass = graph.createPass( "debug", creator );
+	debugPass.addInputSampled( *rt2Attach, 0u );
+	debugPass.addOutputColourTarget( dbgv );
+
+	checkNoThrow( graph.recompile( *runnable ) )
+	checkEqual( created, 3u )
+	require( runnable->getNodeGraph()->getPredecessors().size() == 1u )
+	checkEqual( runnable->getNodeGraph()->getPredecessors().front()->getName(), testCounts.testName + "/debug" )
+	checkNoThrow( runnable->record() )
+
+	graph.getDefaultGroup().removePass( "debug" );
+	checkNoThrow( graph.recompile( *runnable ) )
+	checkEqual( created, 3u )
+	require( runnable->getNodeGraph()->getPredecessors().size() == 1u )
+	checkEqual( runnable->getNodeGraph()->getPredecessors().front()->getName(), testCounts.testName + "/pass2" )
+	checkNoThrow( runnable->record() )
+
+	auto rt3 = graph.createImage( test::createImage( "rt3", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv3 = graph.createView( test::createView( "rtv3", rt3 ) );
+	pass2.addOutputColourTarget( rtv3 );
+	checkNoThrow( graph.recompile( *runnable ) )
+	checkEqual( created, 4u )
+	checkNoThrow( runnable->record() )
+
+	checkThrow( graph.getDefaultGroup().removePass( "debug" ), crg::Exception )
+	// pass2 samples pass1 output.
+	checkThrow( graph.getDefaultGroup().removePass( "pass1" ), crg::Exception )
+	check( graph.getDefaultGroup().hasPass( "pass1" ) )
+	crg::FrameGraph other{ handler, testCounts.testName + "Other" };
+	checkThrow( other.recompile( *runnable ), crg::Exception )
+	testEnd()
+}
+
+TEST( RenderGraph, PassCulling )
+{
+	testBegin( "testPassCulling" )
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	uint32_t created{};
+	auto creator = test::createDummyCreator( testCounts, created );
+	auto rt = graph.createImage( test::createImage( "rt", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv = graph.createView( test::createView( "rtv", rt ) );
+	auto & pass = graph.createPass( "pass", creator );
+	auto rtAttach = pass.addOutputColourTarget( rtv );
+
+	auto out = graph.createImage( test::createImage( "out", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto outv = graph.createView( test::createView( "outv", out ) );
+	auto & finalPass = graph.createPass( "final", creator );
+	finalPass.addInputSampled( *rtAttach, 0u );
+	finalPass.addOutputColourTarget( outv );
+	graph.addOutput( outv, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+
+	// Nothing reads the debug pass output.
+	auto dbg = graph.createImage( test::createImage( "dbg", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto dbgv = graph.createView( test::createView( "dbgv", dbg ) );
+	auto & debug = graph.createPass( "debug", creator );
+	debug.addInputSampled( *rtAttach, 0u );
+	debug.addOutputColourTarget( dbgv );
+
+	// Without culling, all passes are compiled.
+	auto runnable = graph.compile( getContext() );
+	checkEqual( created, 3u )
+	check( graph.getCompileReport().culledPasses.empty() )
+
+	graph.setPassCulling( true );
+	auto culled = graph.compile( getContext() );
+	checkEqual( created, 5u )
+	require( graph.getCompileReport().culledPasses.size() == 1u )
+	checkEqual( graph.getCompileReport().culledPasses.front(), &debug )
+	require( culled->getNodeGraph()->getPredecessors().size() == 1u )
+	checkEqual( culled->getNodeGraph()->getPredecessors().front()->getName(), testCounts.testName + "/final" )
+	checkNoThrow( culled->record() )
+
+	// Kept alive passes are compiled, even if nothing reads their outputs.
+	debug.setKeptAlive();
+	checkNoThrow( graph.recompile( *culled ) )
+	checkEqual( created, 6u )
+	check( graph.getCompileReport().culledPasses.empty() )
+	checkNoThrow( culled->record() )
+
+	// A graph output only read by culled passes is still compiled.
+	auto kept = graph.createImage( test::createImage( "kept", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto keptv = graph.createView( test::createView( "keptv", kept ) );
+	auto & keptPass = graph.createPass( "keptPass", creator );
+	auto keptAttach = keptPass.addOutputColourTarget( keptv );
+	graph.addOutput( keptv, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+	auto unused = graph.createImage( test::createImage( "unused", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto unusedv = graph.createView( test::createView( "unusedv", unused ) );
+	auto & reader = graph.createPass( "reader", creator );
+	reader.addInputSampled( *keptAttach, 0u );
+	reader.addOutputColourTarget( unusedv );
+	checkNoThrow( graph.recompile( *culled ) )
+	checkEqual( created, 7u )
+	require( graph.getCompileReport().culledPasses.size() == 1u )
+	checkEqual( graph.getCompileReport().culledPasses.front(), &reader )
+	// The kept output is an end point of the graph.
+	auto & roots = culled->getNodeGraph()->getPredecessors();
+	check( std::any_of( roots.begin(), roots.end()
+		, [&testCounts]( crg::GraphNode const * node )
+		{
+			return node->getName() == testCounts.testName + "/keptPass";
+		} ) )
+	checkNoThrow( culled->record() )
+	testEnd()
+}
+
+TEST( RenderGraph, PassScheduling )
+{
+	testBegin( "testPassScheduling" )
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	auto creator = test::createDummyCreator( testCounts );
+	auto rt = graph.createImage( test::createImage( "rt", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv = graph.createView( test::createView( "rtv", rt ) );
+	auto & pass = graph.createPass( "pass", creator );
+	auto rtAttach = pass.addOutputColourTarget( rtv );
+
+	// Independent readers, alternating between sampled and storage reads.
+	for ( auto name : { "sampled1", "storage1", "sampled2", "storage2" } )
+	{
+		auto out = graph.createImage( test::createImage( std::string{ name } + "Out", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto outv = graph.createView( test::createView( std::string{ name } + "Outv", out ) );
+		auto & reader = graph.createPass( name, creator );
+
+		if ( std::string{ name }.find( "sampled" ) == 0u )
+			reader.addInputSampled( *rtAttach, 0u );
+		else
+			reader.addInputStorage( *rtAttach, 0u );
+
+		reader.addOutputColourTarget( outv );
+	}
+
+	auto depthFirst = graph.compile( getContext() );
+	auto depthFirstCount = graph.getCompileReport().depthFirstTransitionCount;
+	checkEqual( graph.getCompileReport().transitionCount, depthFirstCount )
+
+	graph.setPassScheduling( crg::PassScheduling::eMinimiseTransitions );
+	auto scheduled = graph.compile( getContext() );
+	checkEqual( graph.getCompileReport().depthFirstTransitionCount, depthFirstCount )
+	check( graph.getCompileReport().transitionCount < depthFirstCount )
+	checkNoThrow( scheduled->record() )
+	testEnd()
+}
+
+TEST( RenderGraph, BatchedBarriers )
+{
+	testBegin( "testBatchedBarriers" )
+	static uint32_t barrierCommands{};
+	static uint32_t maxImageBarriers{};
+	auto & context = getContext();
+	test::ScopedOverride vkCmdPipelineBarrier{ context.vkCmdPipelineBarrier, PFN_vkCmdPipelineBarrier( []( VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier *, uint32_t, const VkBufferMemoryBarrier *, uint32_t imageBarrierCount, const VkImageMemoryBarrier * )
+		{
+			++barrierCommands;
+			maxImageBarriers = std::max( maxImageBarriers, imageBarrierCount );
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto result = graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result ) );
+		auto & combine = graph.createPass( "combine", creator );
+		combine.addOutputColourTarget( resultv );
+
+		for ( uint32_t index = 0u; index < 8u; ++index )
+		{
+			auto name = "input" + std::to_string( index );
+			auto image = graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+			auto view = graph.createView( test::createView( name + "v", image ) );
+			auto & pass = graph.createPass( name + "Pass", creator );
+			combine.addInputSampled( *pass.addOutputColourTarget( view ), index );
+		}
+
+		auto runnable = graph.compile( context );
+		barrierCommands = 0u;
+		maxImageBarriers = 0u;
+		checkNoThrow( runnable->record() )
+		// The 8 sampled inputs of the combine pass are transitioned in one command.
+		check( barrierCommands > 0u )
+		checkEqual( maxImageBarriers, 8u )
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, Synchronization2Barriers )
+{
+	testBegin( "testSynchronization2Barriers" )
+	static uint32_t legacyCommands{};
+	static uint32_t sync2Commands{};
+	static uint32_t maxImageBarriers{};
+	auto & context = getContext();
+	test::ScopedOverride vkCmdPipelineBarrier{ context.vkCmdPipelineBarrier, PFN_vkCmdPipelineBarrier( []( VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier *, uint32_t, const VkBufferMemoryBarrier *, uint32_t, const VkImageMemoryBarrier * )
+		{
+			++legacyCommands;
+		} ) };
+	test::ScopedOverride synchronization2{ context.synchronization2, true };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto result = graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result ) );
+		auto & combine = graph.createPass( "combine", creator );
+		combine.addOutputColourTarget( resultv );
+
+		for ( uint32_t index = 0u; index < 4u; ++index )
+		{
+			auto name = "input" + std::to_string( index );
+			auto image = graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+			auto view = graph.createView( test::createView( name + "v", image ) );
+			auto & pass = graph.createPass( name + "Pass", creator );
+			combine.addInputSampled( *pass.addOutputColourTarget( view ), index );
+		}
+
+		auto runnable = graph.compile( context );
+		// The function is not available, the legacy barriers are used.
+		check( !context.hasSynchronization2() )
+		legacyCommands = 0u;
+		checkNoThrow( runnable->record() )
+		check( legacyCommands > 0u )
+
+#if VK_VERSION_1_3
+		test::ScopedOverride vkCmdPipelineBarrier2{ context.vkCmdPipelineBarrier2, PFN_vkCmdPipelineBarrier2( []( VkCommandBuffer, const VkDependencyInfo * dependencyInfo )
+			{
+				++sync2Commands;
+				maxImageBarriers = std::max( maxImageBarriers, dependencyInfo->imageMemoryBarrierCount );
+			} ) };
+		check( context.hasSynchronization2() )
+		legacyCommands = 0u;
+		checkNoThrow( runnable->record() )
+		checkEqual( legacyCommands, 0u )
+		check( sync2Commands > 0u )
+		checkEqual( maxImageBarriers, 4u )
+#endif
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, SplitBarriers )
+{
+	testBegin( "testSplitBarriers" )
+	static uint32_t setEvents{};
+	static uint32_t waitedEvents{};
+	static uint32_t waitedImageBarriers{};
+	auto & context = getContext();
+	test::ScopedOverride vkCmdSetEvent{ context.vkCmdSetEvent, PFN_vkCmdSetEvent( []( VkCommandBuffer, VkEvent, VkPipelineStageFlags )
+		{
+			++setEvents;
+		} ) };
+	test::ScopedOverride vkCmdWaitEvents{ context.vkCmdWaitEvents, PFN_vkCmdWaitEvents( []( VkCommandBuffer, uint32_t eventCount, const VkEvent *, VkPipelineStageFlags, VkPipelineStageFlags, uint32_t, const VkMemoryBarrier *, uint32_t, const VkBufferMemoryBarrier *, uint32_t imageBarrierCount, const VkImageMemoryBarrier * )
+		{
+			waitedEvents += eventCount;
+			waitedImageBarriers += imageBarrierCount;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto createView = [&graph]( std::string const & name )
+		{
+			return graph.createView( test::createView( name + "v"
+				, graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+		};
+		// pass0 writes a and x, a is only read by pass3, after two unrelated passes.
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto aAttach = pass0.addOutputColourTarget( createView( "a" ) );
+		auto xAttach = pass0.addOutputColourTarget( createView( "x" ) );
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addInputSampled( *xAttach, 0u );
+		auto bAttach = pass1.addOutputColourTarget( createView( "b" ) );
+		auto & pass2 = graph.createPass( "pass2", creator );
+		pass2.addInputSampled( *bAttach, 0u );
+		auto cAttach = pass2.addOutputColourTarget( createView( "c" ) );
+		auto & pass3 = graph.createPass( "pass3", creator );
+		pass3.addInputSampled( *aAttach, 0u );
+		pass3.addInputSampled( *cAttach, 1u );
+		pass3.addOutputColourTarget( createView( "d" ) );
+
+		auto disabled = graph.compile( context );
+		check( disabled->getSplitBarriers().empty() )
+
+		graph.setSplitBarriers( true );
+		auto runnable = graph.compile( context );
+		require( runnable->getSplitBarriers().size() == 1u )
+		auto & split = runnable->getSplitBarriers().front();
+		checkEqual( split.producer, 0u )
+		checkEqual( split.consumer, 3u )
+		check( split.attach->view() == aAttach->view() )
+
+		setEvents = 0u;
+		waitedEvents = 0u;
+		waitedImageBarriers = 0u;
+		checkNoThrow( runnable->record() )
+		checkEqual( setEvents, 1u )
+		checkEqual( waitedEvents, 1u )
+		// The transition of a to the sampled layout is done by the wait.
+		checkEqual( waitedImageBarriers, 1u )
+	}
+	{
+		// The consumer is disabled: the event is waited for by the next pass reading the resource, without transition.
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName + "Disabled" };
+		graph.setSplitBarriers( true );
+		auto creator = test::createDummyCreator( testCounts );
+		auto disabledCreator = test::createDummyCreator( testCounts, false );
+		auto createView = [&graph]( std::string const & name )
+		{
+			return graph.createView( test::createView( name + "v"
+				, graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+		};
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto aAttach = pass0.addOutputColourTarget( createView( "a" ) );
+		auto xAttach = pass0.addOutputColourTarget( createView( "x" ) );
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addInputSampled( *xAttach, 0u );
+		auto bAttach = pass1.addOutputColourTarget( createView( "b" ) );
+		auto & pass2 = graph.createPass( "pass2", creator );
+		pass2.addInputSampled( *bAttach, 0u );
+		auto cAttach = pass2.addOutputColourTarget( createView( "c" ) );
+		auto & pass3 = graph.createPass( "pass3", disabledCreator );
+		pass3.addInputSampled( *aAttach, 0u );
+		pass3.addInputSampled( *cAttach, 1u );
+		auto dAttach = pass3.addOutputColourTarget( createView( "d" ) );
+		auto & pass4 = graph.createPass( "pass4", creator );
+		pass4.addInputSampled( *aAttach, 0u );
+		pass4.addInputSampled( *dAttach, 1u );
+		pass4.addOutputColourTarget( createView( "e" ) );
+
+		auto runnable = graph.compile( context );
+		require( runnable->getSplitBarriers().size() == 1u )
+		checkEqual( runnable->getSplitBarriers().front().consumer, 3u )
+		setEvents = 0u;
+		waitedEvents = 0u;
+		waitedImageBarriers = 0u;
+		checkNoThrow( runnable->record() )
+		checkEqual( setEvents, 1u )
+		checkEqual( waitedEvents, 1u )
+		checkEqual( waitedImageBarriers, 0u )
+	}
+	{
+		// No enabled pass reads the resource: the event is not set.
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName + "Unused" };
+		graph.setSplitBarriers( true );
+		auto creator = test::createDummyCreator( testCounts );
+		auto disabledCreator = test::createDummyCreator( testCounts, false );
+		auto createView = [&graph]( std::string const & name )
+		{
+			return graph.createView( test::createView( name + "v"
+				, graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+		};
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto aAttach = pass0.addOutputColourTarget( createView( "a" ) );
+		auto xAttach = pass0.addOutputColourTarget( createView( "x" ) );
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addInputSampled( *xAttach, 0u );
+		auto bAttach = pass1.addOutputColourTarget( createView( "b" ) );
+		auto & pass2 = graph.createPass( "pass2", creator );
+		pass2.addInputSampled( *bAttach, 0u );
+		auto cAttach = pass2.addOutputColourTarget( createView( "c" ) );
+		auto & pass3 = graph.createPass( "pass3", disabledCreator );
+		pass3.addInputSampled( *aAttach, 0u );
+		pass3.addInputSampled( *cAttach, 1u );
+		pass3.addOutputColourTarget( createView( "d" ) );
+
+		auto runnable = graph.compile( context );
+		require( runnable->getSplitBarriers().size() == 1u )
+		setEvents = 0u;
+		waitedEvents = 0u;
+		checkNoThrow( runnable->record() )
+		checkEqual( setEvents, 0u )
+		checkEqual( waitedEvents, 0u )
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, QueuePartitions )
+{
+	testBegin( "testQueuePartitions" )
+	struct Submit
+	{
+		VkQueue queue;
+		std::vector< VkSemaphore > waited;
+		std::vector< VkSemaphore > signaled;
+		uint32_t commandBufferCount;
+	};
+	static uint32_t submits{};
+	static std::vector< Submit > submitted;
+	static uint32_t ownershipBarriers{};
+	auto & context = getContext();
+	test::ScopedOverride vkQueueSubmit{ context.vkQueueSubmit, PFN_vkQueueSubmit( []( VkQueue queue, uint32_t submitCount, const VkSubmitInfo * submitInfos, VkFence )
+		{
+			++submits;
+
+			for ( uint32_t index = 0u; index < submitCount; ++index )
+			{
+				auto & info = submitInfos[index];
+				submitted.push_back( { queue
+					, { info.pWaitSemaphores, info.pWaitSemaphores + info.waitSemaphoreCount }
+					, { info.pSignalSemaphores, info.pSignalSemaphores + info.signalSemaphoreCount }
+					, info.commandBufferCount } );
+			}
+
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkCmdPipelineBarrier{ context.vkCmdPipelineBarrier, PFN_vkCmdPipelineBarrier( []( VkCommandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier *, uint32_t, const VkBufferMemoryBarrier *, uint32_t imageBarrierCount, const VkImageMemoryBarrier * imageBarriers )
+		{
+			for ( uint32_t index = 0u; index < imageBarrierCount; ++index )
+			{
+				if ( imageBarriers[index].srcQueueFamilyIndex != imageBarriers[index].dstQueueFamilyIndex )
+					++ownershipBarriers;
+			}
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto createView = [&graph]( std::string const & name )
+		{
+			return graph.createView( test::createView( name + "v"
+				, graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+		};
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto depthAttach = pass0.addOutputColourTarget( createView( "depth" ) );
+		// pass1 computes ao from depth, on the compute queue.
+		auto & pass1 = graph.createPass( "pass1"
+			, []( crg::FramePass const & framePass
+				, crg::GraphContext & ctx
+				, crg::RunnableGraph & runGraph )
+			{
+				crg::cp::Config cfg;
+				cfg.baseConfig( crg::pp::Config{}
+					.programCreator( crg::ProgramCreator{ 1u
+						, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } ) );
+				return std::make_unique< crg::ComputePass >( framePass, ctx, runGraph
+					, crg::ru::Config{}, std::move( cfg ) );
+			} );
+		pass1.setQueueClass( crg::QueueClass::eCompute );
+		pass1.addInputSampled( *depthAttach, 0u );
+		auto aoAttach = pass1.addOutputStorageImage( createView( "ao" ), 1u );
+		// pass2 is not a compute pass, it stays on the graphics queue.
+		auto & pass2 = graph.createPass( "pass2", creator );
+		pass2.setQueueClass( crg::QueueClass::eCompute );
+		pass2.addInputSampled( *aoAttach, 0u );
+		pass2.addOutputColourTarget( createView( "out" ) );
+
+		auto runnable = graph.compile( context );
+		auto graphicsQueue = reinterpret_cast< VkQueue >( 1u );
+		auto computeQueue = reinterpret_cast< VkQueue >( 2u );
+
+		// Without compute queue, a single submission.
+		submits = 0u;
+		checkNoThrow( runnable->run( crg::SemaphoreWaitArray{}, graphicsQueue ) )
+		checkEqual( runnable->getPartitions().size(), 1u )
+		checkEqual( submits, 1u )
+
+		submits = 0u;
+		ownershipBarriers = 0u;
+		checkNoThrow( runnable->run( crg::SemaphoreWaitArray{}
+			, crg::GraphQueues{ { graphicsQueue, 0u }, { computeQueue, 1u }, {} } ) )
+		auto & partitions = runnable->getPartitions();
+		require( partitions.size() == 3u )
+		check( partitions[0].queue == crg::QueueClass::eGraphics )
+		check( partitions[1].queue == crg::QueueClass::eCompute )
+		check( partitions[2].queue == crg::QueueClass::eGraphics )
+		checkEqual( partitions[1].firstPass, 1u )
+		checkEqual( partitions[1].passCount, 1u )
+		check( partitions[1].waited == std::vector< uint32_t >{ 0u } )
+		check( partitions[2].waited == std::vector< uint32_t >{ 1u } )
+		checkEqual( submits, 3u )
+		// depth goes from the graphics queue to the compute one, then ao goes back: a release and an acquire for each.
+		checkEqual( ownershipBarriers, 4u )
+
+		// The external semaphore is forwarded to both queues through an additional submission.
+		submits = 0u;
+		submitted.clear();
+		auto external = reinterpret_cast< VkSemaphore >( 1u );
+		checkNoThrow( runnable->run( crg::SemaphoreWaitArray{ crg::SemaphoreWait{ external, crg::PipelineStageFlags::eColorAttachmentOutput } }
+			, crg::GraphQueues{ { graphicsQueue, 0u }, { computeQueue, 1u }, {} } ) )
+		checkEqual( submits, 4u )
+		require( submitted.size() == 4u )
+		auto & forward = submitted[0];
+		checkEqual( forward.commandBufferCount, 0u )
+		check( forward.waited == std::vector< VkSemaphore >{ external } )
+		checkEqual( forward.signaled.size(), 2u )
+		// The first partition waits for the external semaphore too, through its entry semaphore.
+		auto & first = submitted[1];
+		check( first.queue == graphicsQueue )
+		require( first.waited.size() == 1u )
+		check( first.waited.front() != external )
+		check( std::find( forward.signaled.begin(), forward.signaled.end(), first.waited.front() ) != forward.signaled.end() )
+		auto & compute = submitted[2];
+		check( compute.queue == computeQueue )
+		check( std::any_of( compute.waited.begin(), compute.waited.end()
+			, [&forward]( VkSemaphore semaphore )
+			{
+				return std::find( forward.signaled.begin(), forward.signaled.end(), semaphore ) != forward.signaled.end();
+			} ) )
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, ParallelRecording )
+{
+	testBegin( "testParallelRecording" )
+	struct Barrier
+	{
+		VkCommandBuffer commandBuffer;
+		VkImage image;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+	};
+	static std::mutex mutex;
+	static std::vector< Barrier > barriers;
+	static uint32_t executedCommandBuffers{};
+	auto & context = getContext();
+	test::ScopedOverride vkCmdPipelineBarrier{ context.vkCmdPipelineBarrier, PFN_vkCmdPipelineBarrier( []( VkCommandBuffer commandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier *, uint32_t, const VkBufferMemoryBarrier *, uint32_t imageBarrierCount, const VkImageMemoryBarrier * imageBarriers )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+
+			for ( uint32_t index = 0u; index < imageBarrierCount; ++index )
+				barriers.push_back( { commandBuffer, imageBarriers[index].image, imageBarriers[index].oldLayout, imageBarriers[index].newLayout } );
+		} ) };
+	test::ScopedOverride vkCmdExecuteCommands{ context.vkCmdExecuteCommands, PFN_vkCmdExecuteCommands( []( VkCommandBuffer, uint32_t commandBufferCount, const VkCommandBuffer * )
+		{
+			executedCommandBuffers += commandBufferCount;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		crg::Attachment const * previous{};
+
+		for ( uint32_t index = 0u; index < 8u; ++index )
+		{
+			auto name = "pass" + std::to_string( index );
+			auto image = graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+			auto & pass = graph.createPass( name, creator );
+
+			if ( previous )
+				pass.addInputSampled( *previous, 0u );
+
+			previous = pass.addOutputColourTarget( graph.createView( test::createView( name + "v", image ) ) );
+		}
+
+		graph.addOutput( previous->view()
+			, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+		auto runnable = graph.compile( context );
+		auto recordBarriers = [&runnable]()
+		{
+			barriers.clear();
+			executedCommandBuffers = 0u;
+			runnable->record();
+			// Sorted by command buffer, allocated in chunks order, keeping each one's barriers order.
+			std::stable_sort( barriers.begin(), barriers.end()
+				, []( Barrier const & lhs, Barrier const & rhs )
+				{
+					return lhs.commandBuffer < rhs.commandBuffer;
+				} );
+			return barriers;
+		};
+		auto areEqual = []( std::vector< Barrier > const & lhs, std::vector< Barrier > const & rhs )
+		{
+			return std::equal( lhs.begin(), lhs.end(), rhs.begin(), rhs.end()
+				, []( Barrier const & lhsBarrier, Barrier const & rhsBarrier )
+				{
+					return lhsBarrier.image == rhsBarrier.image
+						&& lhsBarrier.oldLayout == rhsBarrier.oldLayout
+						&& lhsBarrier.newLayout == rhsBarrier.newLayout;
+				} );
+		};
+
+		// Once the graph states are stable, the serial recording is the reference.
+		checkNoThrow( recordBarriers() )
+		auto serial = recordBarriers();
+		check( !serial.empty() )
+		checkEqual( executedCommandBuffers, 0u )
+
+		// The first recording captures the chunks states, the next ones are parallel.
+		graph.setRecordThreadCount( 4u );
+		auto seeding = recordBarriers();
+		checkEqual( executedCommandBuffers, 0u )
+		check( areEqual( seeding, serial ) )
+
+		for ( uint32_t frame = 0u; frame < 3u; ++frame )
+		{
+			auto parallel = recordBarriers();
+			checkEqual( executedCommandBuffers, 4u )
+			check( areEqual( parallel, serial ) )
+		}
+
+		// Back to serial recording.
+		graph.setRecordThreadCount( 0u );
+		auto back = recordBarriers();
+		checkEqual( executedCommandBuffers, 0u )
+		check( areEqual( back, serial ) )
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, ParallelRecordingRenderPass )
+{
+	testBegin( "testParallelRecordingRenderPass" )
+	static std::mutex mutex;
+	static std::vector< VkCommandBuffer > renderPassBuffers;
+	static std::vector< VkCommandBuffer > executedBuffers;
+	static uint32_t executeCalls{};
+	auto & context = getContext();
+	test::ScopedOverride vkCmdBeginRenderPass{ context.vkCmdBeginRenderPass, PFN_vkCmdBeginRenderPass( []( VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *, VkSubpassContents )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+			renderPassBuffers.push_back( commandBuffer );
+		} ) };
+	test::ScopedOverride vkCmdExecuteCommands{ context.vkCmdExecuteCommands, PFN_vkCmdExecuteCommands( []( VkCommandBuffer, uint32_t commandBufferCount, const VkCommandBuffer * commandBuffers )
+		{
+			++executeCalls;
+			executedBuffers.insert( executedBuffers.end(), commandBuffers, commandBuffers + commandBufferCount );
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto renderPassCreator = []( crg::FramePass const & framePass
+			, crg::GraphContext & ctx
+			, crg::RunnableGraph & runGraph )
+		{
+			return std::make_unique< crg::RenderPass >( framePass, ctx, runGraph
+				, crg::RenderPass::Callbacks{ crg::defaultV< crg::RunnablePass::InitialiseCallback >
+					, crg::defaultV< crg::RunnablePass::RecordCallback > } );
+		};
+		crg::Attachment const * previous{};
+
+		for ( uint32_t index = 0u; index < 8u; ++index )
+		{
+			auto name = "pass" + std::to_string( index );
+			auto image = graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+			auto & pass = ( index == 3u
+				? graph.createPass( name, renderPassCreator )
+				: graph.createPass( name, creator ) );
+
+			if ( previous )
+				pass.addInputSampled( *previous, 0u );
+
+			previous = pass.addOutputColourTarget( graph.createView( test::createView( name + "v", image ) ) );
+		}
+
+		graph.addOutput( previous->view()
+			, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+		auto runnable = graph.compile( context );
+		auto record = [&runnable]()
+		{
+			renderPassBuffers.clear();
+			executedBuffers.clear();
+			executeCalls = 0u;
+			runnable->record();
+		};
+
+		checkNoThrow( record() )
+		record();
+		checkEqual( renderPassBuffers.size(), 1u )
+		checkEqual( executeCalls, 0u )
+
+		// The first recording captures the chunks states, the next ones are parallel.
+		graph.setRecordThreadCount( 4u );
+		record();
+
+		for ( uint32_t frame = 0u; frame < 3u; ++frame )
+		{
+			record();
+			// The render pass splits the chunks executions, and is begun in the primary command buffer.
+			checkEqual( executeCalls, 2u )
+			checkEqual( executedBuffers.size(), 4u )
+			require( renderPassBuffers.size() == 1u )
+			check( std::find( executedBuffers.begin(), executedBuffers.end(), renderPassBuffers.front() ) == executedBuffers.end() )
+		}
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, ParallelRecordingStatesChange )
+{
+	testBegin( "testParallelRecordingStatesChange" )
+	static std::mutex mutex;
+	static uintptr_t handles{ 0x10000u };
+	static std::map< VkCommandPool, VkCommandPoolCreateFlags > poolFlags;
+	static std::map< VkCommandBuffer, VkCommandPool > bufferPools;
+	static std::set< VkCommandBuffer > recorded;
+	static uint32_t primaryBegins{};
+	static uint32_t invalidBegins{};
+	static uint32_t executeCalls{};
+	static bool renderPassEnabled{ true };
+	static bool renderPassWrites{ false };
+	auto & context = getContext();
+	test::ScopedOverride vkCreateCommandPool{ context.vkCreateCommandPool, PFN_vkCreateCommandPool( []( VkDevice, const VkCommandPoolCreateInfo * pCreateInfo, const VkAllocationCallbacks *, VkCommandPool * pCommandPool )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+			*pCommandPool = VkCommandPool( ++handles );
+			poolFlags[*pCommandPool] = pCreateInfo->flags;
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkAllocateCommandBuffers{ context.vkAllocateCommandBuffers, PFN_vkAllocateCommandBuffers( []( VkDevice, const VkCommandBufferAllocateInfo * pAllocateInfo, VkCommandBuffer * pCommandBuffers )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+
+			for ( uint32_t index = 0u; index < pAllocateInfo->commandBufferCount; ++index )
+			{
+				pCommandBuffers[index] = VkCommandBuffer( ++handles );
+				bufferPools[pCommandBuffers[index]] = pAllocateInfo->commandPool;
+			}
+
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkResetCommandPool{ context.vkResetCommandPool, PFN_vkResetCommandPool( []( VkDevice, VkCommandPool commandPool, VkCommandPoolResetFlags )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+			std::erase_if( recorded
+				, [commandPool]( VkCommandBuffer commandBuffer )
+				{
+					return bufferPools[commandBuffer] == commandPool;
+				} );
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkResetCommandBuffer{ context.vkResetCommandBuffer, PFN_vkResetCommandBuffer( []( VkCommandBuffer commandBuffer, VkCommandBufferResetFlags )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+			recorded.erase( commandBuffer );
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkBeginCommandBuffer{ context.vkBeginCommandBuffer, PFN_vkBeginCommandBuffer( []( VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo * pBeginInfo )
+		{
+			std::unique_lock< std::mutex > lock{ mutex };
+
+			// Without reset, a command buffer can only be begun again if its pool allows an implicit reset.
+			if ( !recorded.insert( commandBuffer ).second
+				&& !( poolFlags[bufferPools[commandBuffer]] & VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT ) )
+				++invalidBegins;
+
+			if ( !pBeginInfo->pInheritanceInfo )
+				++primaryBegins;
+
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkCmdExecuteCommands{ context.vkCmdExecuteCommands, PFN_vkCmdExecuteCommands( []( VkCommandBuffer, uint32_t, const VkCommandBuffer * )
+		{
+			++executeCalls;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		// Written by the render pass record callback only, the states of the next chunk don't depend on it.
+		auto extrav = graph.createView( test::createView( "extrav"
+			, graph.createImage( test::createImage( "extra", crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+		auto renderPassCreator = [extrav]( crg::FramePass const & framePass
+			, crg::GraphContext & ctx
+			, crg::RunnableGraph & runGraph )
+		{
+			return std::make_unique< crg::RenderPass >( framePass, ctx, runGraph
+				, crg::RenderPass::Callbacks{ crg::defaultV< crg::RunnablePass::InitialiseCallback >
+					, crg::RunnablePass::RecordCallback( [extrav]( crg::RecordContext & recordContext, VkCommandBuffer, uint32_t )
+						{
+							if ( renderPassWrites )
+								recordContext.setLayoutState( extrav, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+						} )
+					, crg::defaultV< crg::RenderPass::GetSubpassContentsCallback >
+					, crg::defaultV< crg::RunnablePass::GetPassIndexCallback >
+					, crg::RunnablePass::IsEnabledCallback( [](){ return renderPassEnabled; } ) } );
+		};
+		crg::Attachment const * previous{};
+
+		for ( uint32_t index = 0u; index < 8u; ++index )
+		{
+			auto name = "pass" + std::to_string( index );
+			auto image = graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+			auto & pass = ( index == 3u
+				? graph.createPass( name, renderPassCreator )
+				: graph.createPass( name, creator ) );
+
+			if ( previous )
+				pass.addInputSampled( *previous, 0u );
+
+			previous = pass.addOutputColourTarget( graph.createView( test::createView( name + "v", image ) ) );
+		}
+
+		graph.addOutput( previous->view()
+			, crg::makeLayoutState( crg::ImageLayout::eShaderReadOnly ) );
+		auto runnable = graph.compile( context );
+		auto record = [&runnable]()
+		{
+			primaryBegins = 0u;
+			executeCalls = 0u;
+			runnable->record();
+		};
+
+		checkNoThrow( record() )
+		record();
+		graph.setRecordThreadCount( 4u );
+		record();
+		record();
+		checkEqual( primaryBegins, 1u )
+		checkEqual( executeCalls, 2u )
+
+		// The render pass changes a state, the next chunk doesn't start from its seed.
+		renderPassWrites = true;
+		record();
+		// The primary command buffer was begun for the parallel recording, then reset and recorded serially.
+		checkEqual( primaryBegins, 2u )
+		checkEqual( executeCalls, 1u )
+
+		// The seeds were captured again by the serial recording.
+		record();
+		checkEqual( primaryBegins, 1u )
+		checkEqual( executeCalls, 2u )
+
+		// The previous pass transitions its output for the next enabled one, its chunk doesn't end with the render pass seed.
+		renderPassEnabled = false;
+		record();
+		// Detected before any primary command buffer is begun.
+		checkEqual( primaryBegins, 1u )
+		checkEqual( executeCalls, 0u )
+
+		record();
+		checkEqual( primaryBegins, 1u )
+		checkEqual( executeCalls, 2u )
+		checkEqual( invalidBegins, 0u )
+	}
+	renderPassEnabled = true;
+	renderPassWrites = false;
+	testEnd()
+}
+
+TEST( RenderGraph, RecordSkipping )
+{
+	testBegin( "testRecordSkipping" )
+	static uint32_t beginCommandBuffers{};
+	static uint32_t submits{};
+	auto & context = getContext();
+	test::ScopedOverride vkBeginCommandBuffer{ context.vkBeginCommandBuffer, PFN_vkBeginCommandBuffer( []( VkCommandBuffer, const VkCommandBufferBeginInfo * )
+		{
+			++beginCommandBuffers;
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkQueueSubmit{ context.vkQueueSubmit, PFN_vkQueueSubmit( []( VkQueue, uint32_t, const VkSubmitInfo *, VkFence )
+		{
+			++submits;
+			return VK_SUCCESS;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		crg::RunnablePass * runnablePass{};
+		// The dummy passes commands only depend on the graph resources.
+		crg::ru::Config ruConfig;
+		ruConfig.recordEachRun = false;
+		auto creator = test::createDummyCreator( testCounts, runnablePass, ruConfig );
+		auto inter = graph.createImage( test::createImage( "inter", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto interv = graph.createView( test::createView( "interv", inter ) );
+		auto result = graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result ) );
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto interAttach = pass0.addOutputColourTarget( interv );
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addInputSampled( *interAttach, 0u );
+		pass1.addOutputColourTarget( resultv );
+
+		auto runnable = graph.compile( context );
+		auto queue = reinterpret_cast< VkQueue >( 1u );
+		check( runnable->isRecordDirty() )
+
+		// The first runs record the graph, until its states are stable.
+		for ( uint32_t frame = 0u; frame < 3u; ++frame )
+			checkNoThrow( runnable->run( queue ) )
+
+		check( !runnable->isRecordDirty() )
+		beginCommandBuffers = 0u;
+		submits = 0u;
+		checkNoThrow( runnable->run( queue ) )
+		checkEqual( beginCommandBuffers, 0u )
+		checkEqual( submits, 1u )
+
+		// A reset pass makes the graph dirty, once.
+		require( runnablePass != nullptr )
+		runnablePass->resetCommandBuffer( 0u );
+		check( runnable->isRecordDirty() )
+		beginCommandBuffers = 0u;
+		checkNoThrow( runnable->run( queue ) )
+		check( beginCommandBuffers > 0u )
+		check( !runnable->isRecordDirty() )
+
+		// So does a change in the recording threads.
+		graph.setRecordThreadCount( 2u );
+		check( runnable->isRecordDirty() )
+		beginCommandBuffers = 0u;
+		checkNoThrow( runnable->run( queue ) )
+		check( beginCommandBuffers > 0u )
+		check( !runnable->isRecordDirty() )
+	}
+	{
+		// By default, a pass with a record callback is recorded at each run.
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName + "Default" };
+		auto & pass = graph.createPass( "pass", test::createDummyCreator( testCounts ) );
+		pass.addOutputColourTarget( graph.createView( test::createView( "resultv"
+			, graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) ) );
+
+		auto runnable = graph.compile( context );
+		auto queue = reinterpret_cast< VkQueue >( 1u );
+
+		for ( uint32_t frame = 0u; frame < 3u; ++frame )
+			checkNoThrow( runnable->run( queue ) )
+
+		check( runnable->isRecordDirty() )
+		beginCommandBuffers = 0u;
+		checkNoThrow( runnable->run( queue ) )
+		check( beginCommandBuffers > 0u )
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, FramesInFlight )
+{
+	testBegin( "testFramesInFlight" )
+	static std::vector< VkFence > waitedFences;
+	static std::vector< std::pair< VkFence, VkCommandBuffer > > submits;
+	auto & context = getContext();
+	test::ScopedOverride vkWaitForFences{ context.vkWaitForFences, PFN_vkWaitForFences( []( VkDevice, uint32_t fenceCount, const VkFence * fences, VkBool32, uint64_t )
+		{
+			waitedFences.insert( waitedFences.end(), fences, fences + fenceCount );
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkQueueSubmit{ context.vkQueueSubmit, PFN_vkQueueSubmit( []( VkQueue, uint32_t, const VkSubmitInfo * submitInfos, VkFence fence )
+		{
+			submits.emplace_back( fence, submitInfos->pCommandBuffers[0] );
+			return VK_SUCCESS;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto inter = graph.createImage( test::createImage( "inter", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto interv = graph.createView( test::createView( "interv", inter ) );
+		auto result = graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result ) );
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto interAttach = pass0.addOutputColourTarget( interv );
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addInputSampled( *interAttach, 0u );
+		pass1.addOutputColourTarget( resultv );
+		graph.setFramesInFlight( 3u );
+
+		auto runnable = graph.compile( context );
+		checkEqual( runnable->getFramesInFlight(), 3u )
+		auto queue = reinterpret_cast< VkQueue >( 1u );
+		submits.clear();
+
+		for ( uint32_t frame = 0u; frame < 9u; ++frame )
+		{
+			waitedFences.clear();
+			checkNoThrow( runnable->run( queue ) )
+			require( submits.size() == frame + 1u )
+			// Only the fence of the reused frame is waited.
+			auto submitted = submits.back().first;
+			check( std::all_of( waitedFences.begin(), waitedFences.end()
+				, [submitted]( VkFence lookup )
+				{
+					return lookup == submitted;
+				} ) )
+			checkEqual( runnable->getFence().getInternal(), submitted )
+		}
+
+		// Each frame has its own fence and command buffer, reused frames in flight later.
+		for ( size_t index = 0u; index < submits.size(); ++index )
+		{
+			for ( size_t other = 0u; other < index; ++other )
+			{
+				auto sameFrame = ( index - other ) % 3u == 0u;
+				check( ( submits[index].first == submits[other].first ) == sameFrame )
+				check( ( submits[index].second == submits[other].second ) == sameFrame )
+			}
+		}
+	}
+	testEnd()
+}
+
+#if VK_VERSION_1_2
+TEST( RenderGraph, TimelineSemaphores )
+{
+	testBegin( "testTimelineSemaphores" )
+	struct Submit
+	{
+		VkFence fence{};
+		std::vector< VkSemaphore > waitSemaphores;
+		std::vector< uint64_t > waitValues;
+		std::vector< VkSemaphore > signalSemaphores;
+		std::vector< uint64_t > signalValues;
+	};
+	static std::vector< uint64_t > waitedValues;
+	static uint32_t waitedFences;
+	static std::vector< Submit > submits;
+	auto & context = getContext();
+	test::ScopedOverride timelineSemaphores{ context.timelineSemaphores, true };
+	test::ScopedOverride vkWaitForFences{ context.vkWaitForFences, PFN_vkWaitForFences( []( VkDevice, uint32_t, const VkFence *, VkBool32, uint64_t )
+		{
+			++waitedFences;
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkWaitSemaphores{ context.vkWaitSemaphores, PFN_vkWaitSemaphores( []( VkDevice, const VkSemaphoreWaitInfo * waitInfo, uint64_t )
+		{
+			waitedValues.insert( waitedValues.end(), waitInfo->pValues, waitInfo->pValues + waitInfo->semaphoreCount );
+			return VK_SUCCESS;
+		} ) };
+	test::ScopedOverride vkQueueSubmit{ context.vkQueueSubmit, PFN_vkQueueSubmit( []( VkQueue, uint32_t, const VkSubmitInfo * submitInfos, VkFence fence )
+		{
+			auto & submit = submits.emplace_back();
+			submit.fence = fence;
+			submit.waitSemaphores.assign( submitInfos->pWaitSemaphores, submitInfos->pWaitSemaphores + submitInfos->waitSemaphoreCount );
+			submit.signalSemaphores.assign( submitInfos->pSignalSemaphores, submitInfos->pSignalSemaphores + submitInfos->signalSemaphoreCount );
+
+			if ( auto timelineInfo = static_cast< VkTimelineSemaphoreSubmitInfo const * >( submitInfos->pNext ) )
+			{
+				submit.waitValues.assign( timelineInfo->pWaitSemaphoreValues, timelineInfo->pWaitSemaphoreValues + timelineInfo->waitSemaphoreValueCount );
+				submit.signalValues.assign( timelineInfo->pSignalSemaphoreValues, timelineInfo->pSignalSemaphoreValues + timelineInfo->signalSemaphoreValueCount );
+			}
+
+			return VK_SUCCESS;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		auto creator = test::createDummyCreator( testCounts );
+		auto inter = graph.createImage( test::createImage( "inter", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto interv = graph.createView( test::createView( "interv", inter ) );
+		auto result = graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result ) );
+		auto & pass0 = graph.createPass( "pass0", creator );
+		auto interAttach = pass0.addOutputColourTarget( interv );
+		auto & pass1 = graph.createPass( "pass1", creator );
+		pass1.addInputSampled( *interAttach, 0u );
+		pass1.addOutputColourTarget( resultv );
+		graph.setFramesInFlight( 2u );
+
+		auto runnable = graph.compile( context );
+		auto timeline = runnable->getTimelineSemaphore();
+		require( timeline != VkSemaphore{} )
+		auto queue = reinterpret_cast< VkQueue >( 1u );
+		auto external = reinterpret_cast< VkSemaphore >( 0xFFFFu );
+		waitedFences = 0u;
+		submits.clear();
+
+		for ( uint64_t frame = 0u; frame < 6u; ++frame )
+		{
+			waitedValues.clear();
+			crg::SemaphoreWaitArray toWait{ { external, crg::PipelineStageFlags::eFragmentShader, 100u + frame } };
+			crg::SemaphoreWaitArray signaled;
+			checkNoThrow( signaled = runnable->run( toWait, queue ) )
+			require( signaled.size() == 1u )
+			// Each run signals the next timeline value, which the dependent submissions wait for.
+			checkEqual( signaled.front().semaphore, timeline )
+			checkEqual( signaled.front().value, frame + 1u )
+			checkEqual( runnable->getTimelineValue(), frame + 1u )
+			require( submits.size() == frame + 1u )
+			auto & submit = submits.back();
+			check( submit.fence == VkFence{} )
+			require( submit.signalSemaphores.size() == 1u )
+			checkEqual( submit.signalSemaphores.front(), timeline )
+			require( submit.signalValues.size() == 1u )
+			checkEqual( submit.signalValues.front(), frame + 1u )
+			require( submit.waitSemaphores.size() == 1u )
+			checkEqual( submit.waitSemaphores.front(), external )
+			require( submit.waitValues.size() == 1u )
+			checkEqual( submit.waitValues.front(), 100u + frame )
+			// The CPU waits for the value signaled by the reused frame, frames in flight ago.
+			check( std::all_of( waitedValues.begin(), waitedValues.end()
+				, [frame]( uint64_t lookup )
+				{
+					return frame >= 2u && lookup == frame - 1u;
+				} ) )
+			check( ( frame >= 2u ) == !waitedValues.empty() )
+		}
+
+		checkEqual( waitedFences, 0u )
+	}
+	testEnd()
+}
+#endif
+
+TEST( RenderGraph, NonBlockingTimers )
+{
+	testBegin( "testNonBlockingTimers" )
+	static bool available{};
+	static bool waited{};
+	static uint32_t reads{};
+	static uint32_t hostResets{};
+	auto & context = getContext();
+	test::ScopedOverride nonBlockingTimers{ context.nonBlockingTimers, true };
+	test::ScopedOverride timestampPeriod{ context.timestampPeriod, 2.0f };
+	test::ScopedOverride hostQueryReset{ context.hostQueryReset, false };
+	test::ScopedOverride vkGetQueryPoolResults{ context.vkGetQueryPoolResults, PFN_vkGetQueryPoolResults( []( VkDevice, VkQueryPool, uint32_t firstQuery, uint32_t, size_t, void * data, VkDeviceSize, VkQueryResultFlags flags )
+		{
+			++reads;
+			waited = waited || ( flags & VK_QUERY_RESULT_WAIT_BIT ) != 0u;
+			auto values = static_cast< uint64_t * >( data );
+			values[0] = firstQuery * 10u;
+			values[1] = available ? 1u : 0u;
+			values[2] = firstQuery * 10u + 5u;
+			values[3] = available ? 1u : 0u;
+			return available ? VK_SUCCESS : VK_NOT_READY;
+		} ) };
+	test::ScopedOverride vkResetQueryPool{ context.vkResetQueryPool, PFN_vkResetQueryPool( []( VkDevice, VkQueryPool, uint32_t, uint32_t )
+		{
+			++hostResets;
+		} ) };
+	{
+		crg::ResourceHandler handler;
+		crg::FrameGraph graph{ handler, testCounts.testName };
+		crg::RunnablePass * runPass{};
+		auto result = graph.createImage( test::createImage( "result", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+		auto resultv = graph.createView( test::createView( "resultv", result ) );
+		auto & pass = graph.createPass( "pass", test::createDummyCreator( testCounts, runPass ) );
+		pass.addOutputColourTarget( resultv );
+		graph.setFramesInFlight( 2u );
+
+		auto runnable = graph.compile( context );
+		require( runPass != nullptr )
+		auto & timer = runPass->getTimer();
+		auto queue = reinterpret_cast< VkQueue >( 1u );
+		available = false;
+		waited = false;
+		reads = 0u;
+		hostResets = 0u;
+
+		// The results are not available yet, the previous GPU time is kept.
+		checkNoThrow( runnable->run( queue ) )
+		timer.retrieveGpuTime();
+		checkEqual( timer.getGpuTime(), crg::Nanoseconds{ 0u } )
+		checkEqual( timer.getGpuTimeFrameId(), 0u )
+
+		// Without host reset, the available results of pending frames may be the previous submission's ones, they are not read.
+		checkNoThrow( runnable->run( queue ) )
+		available = true;
+		timer.retrieveGpuTime();
+		checkEqual( timer.getGpuTimeFrameId(), 0u )
+		checkEqual( reads, 0u )
+		checkEqual( runnable->getFrameId(), 2u )
+
+		// Reusing the queries of a frame, its submission is complete, its results are reported.
+		checkNoThrow( runnable->run( queue ) )
+		check( reads > 0u )
+		timer.retrieveGpuTime();
+		checkEqual( timer.getGpuTime(), crg::Nanoseconds{ 10u } )
+		checkEqual( timer.getGpuTimeFrameId(), 1u )
+
+		// Nothing new to read.
+		timer.retrieveGpuTime();
+		checkEqual( timer.getGpuTimeFrameId(), 1u )
+
+		checkNoThrow( runnable->run( queue ) )
+		timer.retrieveGpuTime();
+		checkEqual( timer.getGpuTimeFrameId(), 2u )
+		check( !waited )
+		checkEqual( hostResets, 0u )
+
+		// With host reset, the reused queries are reset before the submission, the available results are the submission's ones.
+		context.hostQueryReset = true;
+		checkNoThrow( runnable->run( queue ) )
+		check( hostResets > 0u )
+		timer.retrieveGpuTime();
+		checkEqual( timer.getGpuTimeFrameId(), runnable->getFrameId() )
+		checkEqual( timer.getGpuTimeFrameId(), 5u )
+	}
+	testEnd()
+}
+
+TEST( RenderGraph, RecordCounters )
+{
+	testBegin( "testRecordCounters" )
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	// The dummy pass commands only depend on the graph resources.
+	crg::ru::Config ruConfig;
+	ruConfig.recordEachRun = false;
+	auto creator = test::createDummyCreator( testCounts, true, ruConfig );
+	auto createView = [&graph]( std::string const & name )
+	{
+		return graph.createView( test::createView( name + "v"
+			, graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+	};
+	auto & pass0 = graph.createPass( "pass0", creator );
+	auto interAttach = pass0.addOutputColourTarget( createView( "inter" ) );
+	crg::ComputePass * computePass{};
+	auto & pass1 = graph.createPass( "pass1"
+		, [&computePass]( crg::FramePass const & framePass
+			, crg::GraphContext & ctx
+			, crg::RunnableGraph & runGraph )
+		{
+			crg::cp::Config cfg;
+			cfg.baseConfig( crg::pp::Config{}
+				.programCreator( crg::ProgramCreator{ 1u
+					, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } } ) );
+			auto result = std::make_unique< crg::ComputePass >( framePass, ctx, runGraph
+				, crg::ru::Config{ 1u, true }, std::move( cfg ) );
+			computePass = result.get();
+			return result;
+		} );
+	pass1.addInputSampled( *interAttach, 0u );
+	pass1.addOutputStorageImage( createView( "result" ), 1u );
+
+	auto runnable = graph.compile( getContext() );
+	auto queue = reinterpret_cast< VkQueue >( 1u );
+	checkNoThrow( runnable->run( queue ) )
+	auto counters = runnable->getCounters();
+	checkEqual( counters.pipelines, 1u )
+	checkEqual( counters.descriptorSetUpdates, 1u )
+	check( counters.barrierCommands > 0u )
+	check( counters.imageBarriers >= counters.layoutTransitions )
+	check( counters.layoutTransitions > 0u )
+	checkEqual( counters.bufferBarriers, 0u )
+	checkEqual( counters.renderPasses, 0u )
+	checkEqual( counters.reRecords, 0u )
+
+	// Once the states are stable, the command buffers are replayed, and nothing is counted.
+	for ( uint32_t frame = 0u; frame < 3u; ++frame )
+		checkNoThrow( runnable->run( queue ) )
+
+	require( !runnable->isRecordDirty() )
+	checkNoThrow( runnable->run( queue ) )
+	counters = runnable->getCounters();
+	checkEqual( counters.barrierCommands, 0u )
+	checkEqual( counters.pipelines, 0u )
+	checkEqual( counters.descriptorSetUpdates, 0u )
+
+	// A pipeline reset between two frames is counted in the next one.
+	require( computePass != nullptr )
+	checkNoThrow( computePass->resetPipeline( crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }, 0u ) )
+	checkEqual( runnable->getCurrentCounters().get().pipelines, 1u )
+	checkEqual( runnable->getCurrentCounters().get().reRecords, 1u )
+	checkNoThrow( runnable->run( queue ) )
+	counters = runnable->getCounters();
+	checkEqual( counters.pipelines, 1u )
+	checkEqual( counters.reRecords, 1u )
+	check( counters.barrierCommands > 0u )
+	checkEqual( runnable->getCurrentCounters().get().barrierCommands, 0u )
+	testEnd()
+}
+
+TEST( RenderGraph, NextImageLayouts )
+{
+	testBegin( "testNextImageLayouts" )
+	static std::vector< crg::ImageLayout > nextLayouts;
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	auto createView = [&graph]( std::string const & name )
+	{
+		return graph.createView( test::createView( name + "v"
+			, graph.createImage( test::createImage( name, crg::PixelFormat::eR32G32B32A32_SFLOAT ) ) ) );
+	};
+	auto av = createView( "a" );
+	auto bv = createView( "b" );
+	auto & pass0 = graph.createPass( "pass0"
+		, [&testCounts, av, bv]( crg::FramePass const & framePass
+			, crg::GraphContext & ctx
+			, crg::RunnableGraph & runGraph )
+		{
+			return createDummy( testCounts
+				, framePass, ctx, runGraph, crg::PipelineStageFlags::eFragmentShader
+				, [av, bv]( test::TestCounts const &, crg::FramePass const &, crg::RunnableGraph const &, crg::RecordContext & context, uint32_t )
+				{
+					nextLayouts = { context.getNextLayoutState( av ).layout
+						, context.getNextLayoutState( bv ).layout };
+				} );
+		} );
+	auto aAttach = pass0.addOutputColourTarget( av );
+	auto bAttach = pass0.addOutputColourTarget( bv );
+	// pass1 is disabled, its use of a is skipped.
+	auto & pass1 = graph.createPass( "pass1"
+		, [&testCounts]( crg::FramePass const & framePass
+			, crg::GraphContext & ctx
+			, crg::RunnableGraph & runGraph )
+		{
+			return createDummy( testCounts
+				, framePass, ctx, runGraph, crg::PipelineStageFlags::eTransfer
+				, test::checkDummy, 0u, false );
+		} );
+	pass1.addInputTransfer( *aAttach );
+	pass1.addOutputColourTarget( createView( "c" ) );
+	// pass2 uses both images, both get their layout from it.
+	auto & pass2 = graph.createPass( "pass2"
+		, test::createDummyCreator( testCounts ) );
+	pass2.addInputSampled( *aAttach, 0u );
+	pass2.addInputSampled( *bAttach, 1u );
+	pass2.addOutputColourTarget( createView( "d" ) );
+
+	auto runnable = graph.compile( getContext() );
+	checkNoThrow( runnable->record() )
+	require( nextLayouts.size() == 2u )
+	checkEqual( nextLayouts[0], crg::ImageLayout::eShaderReadOnly )
+	checkEqual( nextLayouts[1], crg::ImageLayout::eShaderReadOnly )
+	testEnd()
+}
+
+TEST( RenderGraph, TransientImages )
+{
+	testBegin( "testTransientImages" )
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	auto hist = graph.createTransientImage( test::createImage( "hist", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto histv = graph.createView( test::createView( "histv", hist ) );
+	auto rt1 = graph.createTransientImage( test::createImage( "rt1", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv1 = graph.createView( test::createView( "rtv1", rt1 ) );
+	auto & pass1 = graph.createPass( "pass1"
+		, test::createDummyCreator( testCounts ) );
+	// The history image is read before being written, its memory can't be shared.
+	pass1.addInputSampledImage( histv, 0u );
+	auto rt1Attach = pass1.addOutputColourTarget( rtv1 );
+
+	auto rt2 = graph.createTransientImage( test::createImage( "rt2", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv2 = graph.createView( test::createView( "rtv2", rt2 ) );
+	auto & pass2 = graph.createPass( "pass2"
+		, test::createDummyCreator( testCounts ) );
+	pass2.addInputSampled( *rt1Attach, 0u );
+	auto rt2Attach = pass2.addOutputColourTarget( rtv2 );
+
+	auto rt3 = graph.createTransientImage( test::createImage( "rt3", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto rtv3 = graph.createView( test::createView( "rtv3", rt3 ) );
+	auto & pass3 = graph.createPass( "pass3"
+		, test::createDummyCreator( testCounts ) );
+	pass3.addInputSampled( *rt2Attach, 0u );
+	auto rt3Attach = pass3.addOutputColourTarget( rtv3 );
+
+	auto out = graph.createImage( test::createImage( "out", crg::PixelFormat::eR32G32B32A32_SFLOAT ) );
+	auto outv = graph.createView( test::createView( "outv", out ) );
+	auto & pass4 = graph.createPass( "pass4"
+		, test::createDummyCreator( testCounts ) );
+	pass4.addInputSampled( *rt3Attach, 0u );
+	pass4.addOutputColourTarget( outv );
+	pass4.addOutputColourTarget( histv );
+
+	auto runnable = graph.compile( getContext() );
+	auto & transients = runnable->getTransientImages();
+	require( transients.size() == 3u )
+	checkEqual( transients[0].image.id, rt1.id )
+	checkEqual( transients[1].image.id, rt2.id )
+	checkEqual( transients[2].image.id, rt3.id )
+	checkEqual( transients[0].firstPass, 0u )
+	checkEqual( transients[0].lastPass, 1u )
+	checkEqual( transients[2].firstPass, 2u )
+	checkEqual( transients[2].lastPass, 3u )
+	// rt1 and rt3 are never alive at the same time, rt2 overlaps both.
+	checkEqual( transients[0].offset, transients[2].offset )
+	check( transients[1].offset != transients[0].offset )
+	auto & stats = runnable->getTransientMemoryStats();
+	checkEqual( stats.requiredSize, 3u * transients[0].size )
+	checkEqual( stats.allocatedSize, 2u * transients[0].size )
+	checkEqual( stats.getSavedSize(), transients[0].size )
+	checkNoThrow( runnable->record() )
+
+	// Recompiling an unchanged graph keeps the placements.
+	checkNoThrow( graph.recompile( *runnable ) )
+	checkEqual( runnable->getTransientImages().size(), 3u )
+	checkEqual( runnable->getTransientMemoryStats().allocatedSize, 2u * transients[0].size )
+	checkNoThrow( runnable->record() )
+	testEnd()
+}
+
+TEST( RenderGraph, GraphCache )
+{
+	testBegin( "testGraphCache" )
+	auto cacheFile = testCounts.testName + ".crgcache";
+	std::remove( cacheFile.c_str() );
+	crg::ResourceHandler handler;
+	crg::FrameGraph graph{ handler, testCounts.testName };
+	auto source = buildMipChain( testCounts, graph, 4u );
+	auto ref = test::checkRunnable( testCounts, graph.compile( getContext() ) );
+	auto depthFirstCount = graph.getCompileReport().depthFirstTransitionCount;
+	check( depthFirstCount > 0u )
+
+	// No cache file yet: full build, then cache file written.
+	check( !graph.getCompileReport().loadedFromCache )
+	auto built = test::checkRunnable( testCounts, graph.compile( getContext(), cacheFile ) );
+	check( !graph.getCompileReport().loadedFromCache )
+	checkEqualSortedLines( built, ref )
+	// Cache file matching the graph: nodes and transitions loaded.
+	auto loaded = test::checkRunnable( testCounts, graph.compile( getContext(), cacheFile ) );
+	check( graph.getCompileReport().loadedFromCache )
+	checkEqualSortedLines( loaded, ref )
+	checkEqual( graph.getCompileReport().depthFirstTransitionCount, depthFirstCount )
+
+	// Same structure in another graph gives the same hash.
+	crg::ResourceHandler otherHandler;
+	crg::FrameGraph other{ otherHandler, testCounts.testName };
+	auto otherSource = buildMipChain( testCounts, other, 4u );
+	checkEqual( other.getStructuralHash(), graph.getStructuralHash() )
+
+	// Different structure: hash mismatch, full build.
+	crg::ResourceHandler longerHandler;
+	crg::FrameGraph longer{ longerHandler, testCounts.testName };
+	auto longerSource = buildMipChain( testCounts, longer, 5u );
+	check( longer.getStructuralHash() != graph.getStructuralHash() )
+	auto longerRef = test::checkRunnable( testCounts, longer.compile( getContext() ) );
+	auto longerBuilt = test::checkRunnable( testCounts, longer.compile( getContext(), cacheFile ) );
+	check( !longer.getCompileReport().loadedFromCache )
+	checkEqualSortedLines( longerBuilt, longerRef )
+	// The cache file now holds the longer graph.
+	auto longerLoaded = test::checkRunnable( testCounts, longer.compile( getContext(), cacheFile ) );
+	check( longer.getCompileReport().loadedFromCache )
+	checkEqualSortedLines( longerLoaded, longerRef )
+
+	// Invalid cache file: full build.
+	{
+		std::ofstream file{ cacheFile, std::ios::binary | std::ios::trunc };
+		file << "invalid";
+	}
+	auto rebuilt = test::checkRunnable( testCounts, graph.compile( getContext(), cacheFile ) );
+	check( !graph.getCompileReport().loadedFromCache )
+	checkEqualSortedLines( rebuilt, ref )
+	std::remove( cacheFile.c_str() );
+	testEnd()
+}
+
 testSuiteMain()
@@ -16,6 +16,7 @@
 #include <RenderGraph/RunnablePasses/RenderPass.hpp>
 #include <RenderGraph/RunnablePasses/RenderQuad.hpp>
 
+#include <array>
 #include <sstream>
 
 namespace
@@ -1025,6 +1026,74 @@ namespace
 		testEnd()
 	}
 
+	TEST( RunnablePass, RenderQuad_RecordEachRun )
+	{
+		testBegin( "testRenderQuad_RecordEachRun" )
+		crg::ResourceHandler handler;
+		{
+			crg::FrameGraph graph{ handler, testCounts.testName };
+			std::array< crg::RunnablePass *, 3u > passes{};
+			auto programCreator = crg::ProgramCreator{ 1u
+				, []( uint32_t ){ return crg::VkPipelineShaderStageCreateInfoArray{ VkPipelineShaderStageCreateInfo{} }; } };
+			auto createTarget = [&graph]( std::string const & name )
+			{
+				auto image = graph.createImage( test::createImage( name, crg::PixelFormat::eR16G16B16A16_SFLOAT ) );
+				return graph.createView( test::createView( name + "v", image, crg::PixelFormat::eR16G16B16A16_SFLOAT, 0u, 1u, 0u, 1u ) );
+			};
+			auto & staticPass = graph.createPass( "Static"
+				, [&passes, &programCreator]( crg::FramePass const & pass
+					, crg::GraphContext & context
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::rq::Config cfg;
+					cfg.baseConfig( crg::pp::Config{}.programCreator( programCreator ) );
+					auto res = std::make_unique< crg::RenderQuad >( pass, context, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+					passes[0] = res.get();
+					return res;
+				} );
+			staticPass.addOutputColourTarget( createTarget( "static" ) );
+			auto & quadPass = graph.createPass( "Quad"
+				, [&passes, &programCreator]( crg::FramePass const & pass
+					, crg::GraphContext & context
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::rq::Config cfg;
+					cfg.baseConfig( crg::pp::Config{}.programCreator( programCreator ) );
+					cfg.recordInto( crg::RunnablePass::RecordCallback( []( crg::RecordContext &, VkCommandBuffer, uint32_t ){} ) );
+					auto res = std::make_unique< crg::RenderQuad >( pass, context, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+					passes[1] = res.get();
+					return res;
+				} );
+			quadPass.addOutputColourTarget( createTarget( "quad" ) );
+			auto & meshPass = graph.createPass( "Mesh"
+				, [&passes, &programCreator]( crg::FramePass const & pass
+					, crg::GraphContext & context
+					, crg::RunnableGraph & runGraph )
+				{
+					crg::rm::Config cfg;
+					cfg.baseConfig( crg::pp::Config{}.programCreator( programCreator ) );
+					cfg.getVertexCount( crg::GetVertexCountCallback( [](){ return 3u; } ) );
+					auto res = std::make_unique< crg::RenderMesh >( pass, context, runGraph
+						, crg::ru::Config{}, std::move( cfg ) );
+					passes[2] = res.get();
+					return res;
+				} );
+			meshPass.addOutputColourTarget( createTarget( "mesh" ) );
+
+			auto runnable = graph.compile( getContext() );
+			test::checkRunnable( testCounts, runnable );
+			checkNoThrow( runnable->record() )
+			require( passes[0] && passes[1] && passes[2] )
+			// The passes reading values from their callbacks are recorded at each run.
+			check( !passes[0]->isDirty() )
+			check( passes[1]->isDirty() )
+			check( passes[2]->isDirty() )
+		}
+		testEnd()
+	}
+
 	TEST( RunnablePass, RenderMesh )
 	{
 		testBegin( "testRenderMesh" )